@@ -0,0 +1,29 @@
+import numpy as np
+
+DIM_IN = 256 * 1024
+
+
+# numpy has no bfloat16, BF16 data is saved as its raw bits in a float16 array
+def to_bf16(x):
+    b = x.astype('float32').view('uint32')
+    return ((b + 0x7fff + ((b >> 16) & 1)) >> 16).astype('uint16')
+
+
+def from_bf16(h):
+    return (h.astype('uint32') << 16).view('float32')
+
+
+np.set_printoptions(precision=20)
+np.random.seed(1113)
+data_in1 = to_bf16(np.random.rand(DIM_IN))
+data_in2 = to_bf16(np.random.rand(DIM_IN))
+
+data_out = to_bf16(from_bf16(data_in1) + from_bf16(data_in2))
+
+np.save("resadd_bf16_input0_" + str(DIM_IN), data_in1.view('float16'))
+np.save("resadd_bf16_input1_" + str(DIM_IN), data_in2.view('float16'))
+np.save("resadd_bf16_output_" + str(DIM_IN), data_out.view('float16'))
+
+print(from_bf16(data_in1))
+print(from_bf16(data_in2))
+print(from_bf16(data_out))
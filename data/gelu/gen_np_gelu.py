@@ -0,0 +1,23 @@
+import numpy as np
+
+DIM_IN = 256 * 1024
+
+np.set_printoptions(precision=20)
+np.random.seed(1113)
+data_in = (np.random.randn(DIM_IN) * 2).astype('float16')
+data_out = np.zeros(DIM_IN).astype('float16')
+
+
+# tanh approximation, as in lut_table
+def GELU(x):
+    x = x.astype('float32')
+    return 0.5 * x * (1 + np.tanh(np.sqrt(2 / np.pi) * (x + 0.044715 * x ** 3)))
+
+
+data_out = GELU(data_in).astype('float16')
+
+np.save("gelu_input_" + str(DIM_IN), data_in)
+np.save("gelu_output_" + str(DIM_IN), data_out)
+
+print("data in : ", data_in)
+print("data out : ", data_out)
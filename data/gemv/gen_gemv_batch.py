@@ -0,0 +1,28 @@
+import numpy as np
+
+# min dim_in = 128 -> 256bit / 16bit
+# min dim_out = 8 PIM block
+BATCH = 4
+DIM_IN = 256
+DIM_OUT = 1024
+
+np.set_printoptions(precision=20)
+np.random.seed(1113)
+
+batch_in = np.random.standard_normal(size=(DIM_IN, BATCH)).astype('float16')
+data_w = np.random.standard_normal(size=(DIM_OUT, DIM_IN)).astype('float16')
+
+# exact dot products, rounded once to FP16
+batch_out = np.matmul(data_w.astype('float64'), batch_in.astype('float64')).astype('float16')
+
+batch_in = batch_in.T.copy()
+batch_out = batch_out.T.copy()
+
+suffix = str(BATCH) + "_" + str(DIM_OUT) + "x" + str(DIM_IN)
+np.save("gemv_input_batch_" + suffix, batch_in)
+np.save("gemv_weight_batch_" + suffix, data_w)
+np.save("gemv_output_batch_" + suffix, batch_out)
+print(batch_in)
+print(batch_out)
+print(batch_in.shape)
+print(batch_out.shape)
@@ -0,0 +1,39 @@
+import numpy as np
+
+# min dim_in = 128 -> 256bit / 16bit
+# min dim_out = 8 PIM block
+BATCH = 1
+DIM_IN = 256
+DIM_OUT = 4096
+
+
+# numpy has no bfloat16, BF16 data is saved as its raw bits in a float16 array
+def to_bf16(x):
+    b = x.astype('float32').view('uint32')
+    return ((b + 0x7fff + ((b >> 16) & 1)) >> 16).astype('uint16')
+
+
+def from_bf16(h):
+    return (h.astype('uint32') << 16).view('float32')
+
+
+np.set_printoptions(precision=20)
+np.random.seed(1113)
+
+batch_in = to_bf16(np.random.standard_normal(size=(DIM_IN, BATCH)))
+data_w = to_bf16(np.random.standard_normal(size=(DIM_OUT, DIM_IN)))
+
+# exact dot products, rounded once to BF16
+batch_out = to_bf16(np.matmul(from_bf16(data_w).astype('float64'),
+                              from_bf16(batch_in).astype('float64')))
+
+batch_in = batch_in.T.copy()
+batch_out = batch_out.T.copy()
+
+np.save("gemv_bf16_input_" + str(DIM_OUT) + "x" + str(DIM_IN), batch_in.view('float16'))
+np.save("gemv_bf16_weight_" + str(DIM_OUT) + "x" + str(DIM_IN), data_w.view('float16'))
+np.save("gemv_bf16_output_" + str(DIM_OUT) + "x" + str(DIM_IN), batch_out.view('float16'))
+print(from_bf16(batch_in))
+print(from_bf16(batch_out))
+print(batch_in.shape)
+print(batch_out.shape)
@@ -0,0 +1,30 @@
+import numpy as np
+
+NUM_ROWS = 64
+DIM_IN = 4096
+EPS = 1e-5
+
+np.set_printoptions(precision=20)
+np.random.seed(1113)
+data_in = (np.random.randn(NUM_ROWS, DIM_IN) + 0.5).astype('float16')
+gamma = (np.random.randn(DIM_IN) * 0.5 + 1).astype('float16')
+beta = (np.random.randn(DIM_IN) * 0.1).astype('float16')
+data_out = np.zeros((NUM_ROWS, DIM_IN)).astype('float16')
+
+
+def LayerNorm(x, g, b):
+    x = x.astype('float32')
+    mean = np.mean(x, axis=1, keepdims=True)
+    var = np.var(x, axis=1, keepdims=True)
+    return (x - mean) / np.sqrt(var + EPS) * g.astype('float32') + b.astype('float32')
+
+
+data_out = LayerNorm(data_in, gamma, beta).astype('float16')
+
+np.save("layernorm_input_" + str(NUM_ROWS) + "x" + str(DIM_IN), data_in)
+np.save("layernorm_gamma_" + str(DIM_IN), gamma)
+np.save("layernorm_beta_" + str(DIM_IN), beta)
+np.save("layernorm_output_" + str(NUM_ROWS) + "x" + str(DIM_IN), data_out)
+
+print("data in : ", data_in)
+print("data out : ", data_out)
@@ -0,0 +1,27 @@
+import numpy as np
+
+NUM_ROWS = 64
+DIM_IN = 4096
+EPS = 1e-5
+
+np.set_printoptions(precision=20)
+np.random.seed(1113)
+data_in = np.random.randn(NUM_ROWS, DIM_IN).astype('float16')
+gamma = (np.random.randn(DIM_IN) * 0.5 + 1).astype('float16')
+data_out = np.zeros((NUM_ROWS, DIM_IN)).astype('float16')
+
+
+def RMSNorm(x, g):
+    x = x.astype('float32')
+    ms = np.mean(x * x, axis=1, keepdims=True)
+    return x / np.sqrt(ms + EPS) * g.astype('float32')
+
+
+data_out = RMSNorm(data_in, gamma).astype('float16')
+
+np.save("rmsnorm_input_" + str(NUM_ROWS) + "x" + str(DIM_IN), data_in)
+np.save("rmsnorm_gamma_" + str(DIM_IN), gamma)
+np.save("rmsnorm_output_" + str(NUM_ROWS) + "x" + str(DIM_IN), data_out)
+
+print("data in : ", data_in)
+print("data out : ", data_out)
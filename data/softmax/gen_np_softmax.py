@@ -0,0 +1,24 @@
+import numpy as np
+
+NUM_ROWS = 64
+DIM_IN = 4096
+
+np.set_printoptions(precision=20)
+np.random.seed(1113)
+data_in = (np.random.randn(NUM_ROWS, DIM_IN) * 2).astype('float16')
+data_out = np.zeros((NUM_ROWS, DIM_IN)).astype('float16')
+
+
+def Softmax(x):
+    x = x.astype('float32')
+    e = np.exp(x - np.max(x, axis=1, keepdims=True))
+    return e / np.sum(e, axis=1, keepdims=True)
+
+
+data_out = Softmax(data_in).astype('float16')
+
+np.save("softmax_input_" + str(NUM_ROWS) + "x" + str(DIM_IN), data_in)
+np.save("softmax_output_" + str(NUM_ROWS) + "x" + str(DIM_IN), data_out)
+
+print("data in : ", data_in)
+print("data out : ", data_out)
@@ -28,8 +28,11 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************************/
 
+#include <algorithm>
 #include <bitset>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 #include "AddressMapping.h"
 #include "SystemConfiguration.h"
@@ -39,6 +42,8 @@ using namespace std;
 
 namespace DRAMSim
 {
+static const char* addrFieldNames[NUM_ADDR_FIELDS] = {"chan", "rank", "bank", "row", "col"};
+
 AddrMapping::AddrMapping()
 {
     transactionSize = getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") / 8 * getConfigParam(UINT, "BL");
@@ -58,6 +63,159 @@ AddrMapping::AddrMapping()
     num_chans_ = getConfigParam(UINT, "NUM_CHANS");
     num_bank_per_bg_ = getConfigParam(UINT, "NUM_BANKS") / getConfigParam(UINT, "NUM_BANK_GROUPS");
     addressMappingScheme = PIMConfiguration::getAddressMappingScheme();
+
+    string fields = getConfigParam(STRING, "ADDRESS_MAPPING");
+    compile(fields.empty() ? schemeFields(addressMappingScheme) : fields,
+            getConfigParam(STRING, "ADDRESS_XOR_HASH"));
+}
+
+// bit-field lists of the fixed schemes, MSB first
+string AddrMapping::schemeFields(AddressMappingScheme scheme)
+{
+    switch (scheme)
+    {
+        case Scheme1:
+            return "chan:rank:row:col:bank";
+        case Scheme2:
+            return "chan:row:col:bank:rank";
+        case Scheme3:
+            return "chan:rank:bank:col:row";
+        case Scheme4:
+            return "chan:rank:bank:row:col";
+        case Scheme5:
+            return "chan:row:col:rank:bank";
+        case Scheme6:
+            return "chan:row:bank:rank:col";
+        case Scheme7:  // clone of scheme 5, but channel moved to lower bits
+            return "row:col:rank:bank:chan";
+        case Scheme8:
+            return "rank:row:col:bg:bank:chan";
+        default:
+            throw invalid_argument("Invalid address mapping scheme");
+    }
+}
+
+void AddrMapping::compile(const string& fields, const string& hashes)
+{
+    mappingFields = fields;
+    mappingHashes = hashes;
+    bitFields.clear();
+    xorHashes.clear();
+
+    vector<string> tokens;
+    stringstream fieldStream(fields);
+    for (string token; getline(fieldStream, token, ':');) tokens.push_back(token);
+    bool hasBankgroup = false;
+    for (auto& token : tokens) hasBankgroup = hasBankgroup || token.compare(0, 2, "bg") == 0;
+
+    // next unassigned bit and bit count of each field; "bg" is a fifth cursor on the bank bits
+    // above the bank-in-group ones
+    unsigned next[NUM_ADDR_FIELDS + 1] = {
+        0, 0, 0, 0, 0, unsigned(hasBankgroup ? bankBitWidth - bankgroupBitWidth : bankBitWidth)};
+    unsigned limit[NUM_ADDR_FIELDS + 1] = {
+        unsigned(channelBitWidth),
+        unsigned(rankBitWidth),
+        unsigned(hasBankgroup ? bankBitWidth - bankgroupBitWidth : bankBitWidth),
+        unsigned(rowBitWidth),
+        unsigned(colHighBitWidth),
+        unsigned(bankBitWidth)};
+
+    // the byte offset and the column bits of a burst stay below the mapped fields
+    unsigned addrShift = byteOffsetWidth + colLowBitWidth;
+    for (auto it = tokens.rbegin(); it != tokens.rend(); ++it)
+    {
+        size_t digits = it->find_first_of("0123456789");
+        string name = it->substr(0, digits);
+        unsigned cursor = NUM_ADDR_FIELDS;
+        if (name != "bg")
+        {
+            cursor = find(addrFieldNames, addrFieldNames + NUM_ADDR_FIELDS, name) - addrFieldNames;
+            if (cursor == NUM_ADDR_FIELDS)
+                throw invalid_argument("Invalid address mapping field " + *it + " in " + fields);
+        }
+        unsigned width = digits == string::npos ? limit[cursor] - next[cursor]
+                                                : stoul(it->substr(digits));
+        if (next[cursor] + width > limit[cursor])
+            throw invalid_argument("Address mapping " + fields + " has too many " + name + " bits");
+        if (width > 0)
+            bitFields.push_back({cursor == NUM_ADDR_FIELDS ? FIELD_BANK : AddrField(cursor),
+                                 addrShift, next[cursor], (uint64_t(1) << width) - 1});
+        next[cursor] += width;
+        addrShift += width;
+    }
+    for (unsigned f = 0; f <= NUM_ADDR_FIELDS; f++)
+    {
+        if (next[f] != limit[f])
+            throw invalid_argument("Address mapping " + fields + " misses " +
+                                   (f == NUM_ADDR_FIELDS ? "bg" : addrFieldNames[f]) + " bits");
+    }
+
+    stringstream hashStream(hashes);
+    for (string term; getline(hashStream, term, ',');)
+    {
+        term.erase(remove(term.begin(), term.end(), ' '), term.end());
+        size_t xorPos = term.find('^');
+        size_t shiftPos = term.find(">>");
+        if (xorPos == string::npos)
+            throw invalid_argument("Invalid address hash " + term + ", expected target^source");
+        string target = term.substr(0, xorPos);
+        string source = term.substr(xorPos + 1, shiftPos == string::npos ? string::npos
+                                                                         : shiftPos - xorPos - 1);
+        AddrXorHash hash;
+        hash.target = FIELD_BANK;
+        hash.targetShift = 0;
+        unsigned width = bankBitWidth;
+        if (target == "chan")
+        {
+            hash.target = FIELD_CHAN;
+            width = channelBitWidth;
+        }
+        else if (target == "rank")
+        {
+            hash.target = FIELD_RANK;
+            width = rankBitWidth;
+        }
+        else if (target == "bg")
+        {
+            hash.targetShift = bankBitWidth - bankgroupBitWidth;
+            width = bankgroupBitWidth;
+        }
+        else if (target != "bank")
+        {
+            throw invalid_argument("Invalid address hash target " + target +
+                                   ", expected chan, rank, bank or bg");
+        }
+        if (source == "row")
+            hash.source = FIELD_ROW;
+        else if (source == "col")
+            hash.source = FIELD_COL;
+        else
+            throw invalid_argument("Invalid address hash source " + source + ", expected row or col");
+        hash.sourceShift = shiftPos == string::npos ? 0 : stoul(term.substr(shiftPos + 2));
+        hash.mask = (uint64_t(1) << width) - 1;
+        if (width > 0)
+            xorHashes.push_back(hash);
+    }
+
+    channelBitFields.clear();
+    channelXorHashes.clear();
+    for (auto& hash : xorHashes)
+    {
+        if (hash.target == FIELD_CHAN)
+            channelXorHashes.push_back(hash);
+    }
+    for (auto& field : bitFields)
+    {
+        bool hashSource = false;
+        for (auto& hash : channelXorHashes) hashSource = hashSource || hash.source == field.field;
+        if (field.field == FIELD_CHAN || hashSource)
+            channelBitFields.push_back(field);
+    }
+}
+
+string AddrMapping::toString() const
+{
+    return mappingHashes.empty() ? mappingFields : mappingFields + " (" + mappingHashes + ")";
 }
 
 unsigned AddrMapping::bankgroupId(int bank)
@@ -93,30 +251,9 @@ void AddrMapping::addressMapping(uint64_t physicalAddress, unsigned& newTransact
                                     << " is not aligned to the request size of "
                                     << transactionSize);
     }
-    // each burst will contain JEDEC_DATA_BUS_BITS/8 bytes of data, so the bottom
-    // bits (3 bits for a single channel DDR system) are thrown away before mapping the other bits
-    physicalAddress >>= byteOffsetWidth;
-
-    // The next thing we have to consider is that when a request is made for a
-    // we've taken into account the granulaity of a single burst by shifting
-    // off the bottom 3 bits, but a transaction has to take into account the
-    // burst length (i.e. the requests will be aligned to cache line sizes which
-    // should be equal to transactionSize above).
-    //
-    // Since the column address increments internally on bursts, the bottom n
-    // bits of the column (colLow) have to be zero in order to account for the
-    // total size of the transaction. These n bits should be shifted off the
-    // address and also subtracted from the total column width.
-    //
-    // I am having a hard time explaining the reasoning here, but it comes down
-    // this: for a 64 byte transaction, the bottom 6 bits of the address must be
-    // zero. These zero bits must be made up of the byte offset (3 bits) and
-    // also
-    // from the bottom bits of the column
-    //
-    // For example: cowLowBits = log2(64bytes) - 3 bits = 3 bits
-
-    physicalAddress >>= colLowBitWidth;
+    // each burst will contain JEDEC_DATA_BUS_BITS/8 bytes of data, and the bottom colLow bits
+    // of the column have to be zero for a transaction of BL bursts, so the mapped fields start
+    // above log2(transactionSize) (see compile)
 
     if (DEBUG_ADDR_MAP)
     {
@@ -125,91 +262,21 @@ void AddrMapping::addressMapping(uint64_t physicalAddress, unsigned& newTransact
                                 << " colHigh:" << colHighBitWidth << " off:" << byteOffsetWidth
                                 << " Total:"
                                 << (channelBitWidth + rankBitWidth + bankBitWidth + rowBitWidth +
-                                    colLowBitWidth + colHighBitWidth + byteOffsetWidth));
+                                    colLowBitWidth + colHighBitWidth + byteOffsetWidth)
+                                << " mapping: " << toString());
     }
 
-    // perform various address mapping schemes
-    if (addressMappingScheme == Scheme1)
-    {
-        // chan:rank:row:col:bank
-        newTransactionBank = diffBitWidth(&physicalAddress, bankBitWidth);
-        newTransactionColumn = diffBitWidth(&physicalAddress, colHighBitWidth);
-        newTransactionRow = diffBitWidth(&physicalAddress, rowBitWidth);
-        newTransactionRank = diffBitWidth(&physicalAddress, rankBitWidth);
-        newTransactionChan = diffBitWidth(&physicalAddress, channelBitWidth);
-    }
-    else if (addressMappingScheme == Scheme2)
-    {
-        // chan:row:col:bank:rank
-        newTransactionRank = diffBitWidth(&physicalAddress, rankBitWidth);
-        newTransactionBank = diffBitWidth(&physicalAddress, bankBitWidth);
-        newTransactionColumn = diffBitWidth(&physicalAddress, colHighBitWidth);
-        newTransactionRow = diffBitWidth(&physicalAddress, rowBitWidth);
-        newTransactionChan = diffBitWidth(&physicalAddress, channelBitWidth);
-    }
-    else if (addressMappingScheme == Scheme3)
-    {
-        // chan:rank:bank:col:row
-        newTransactionRow = diffBitWidth(&physicalAddress, rowBitWidth);
-        newTransactionColumn = diffBitWidth(&physicalAddress, colHighBitWidth);
-        newTransactionBank = diffBitWidth(&physicalAddress, bankBitWidth);
-        newTransactionRank = diffBitWidth(&physicalAddress, rankBitWidth);
-        newTransactionChan = diffBitWidth(&physicalAddress, channelBitWidth);
-    }
-    else if (addressMappingScheme == Scheme4)
-    {
-        // chan:rank:bank:row:col
-        newTransactionColumn = diffBitWidth(&physicalAddress, colHighBitWidth);
-        newTransactionRow = diffBitWidth(&physicalAddress, rowBitWidth);
-        newTransactionBank = diffBitWidth(&physicalAddress, bankBitWidth);
-        newTransactionRank = diffBitWidth(&physicalAddress, rankBitWidth);
-        newTransactionChan = diffBitWidth(&physicalAddress, channelBitWidth);
-    }
-    else if (addressMappingScheme == Scheme5)
-    {
-        // chan:row:col:rank:bank
-        newTransactionBank = diffBitWidth(&physicalAddress, bankBitWidth);
-        newTransactionRank = diffBitWidth(&physicalAddress, rankBitWidth);
-        newTransactionColumn = diffBitWidth(&physicalAddress, colHighBitWidth);
-        newTransactionRow = diffBitWidth(&physicalAddress, rowBitWidth);
-        newTransactionChan = diffBitWidth(&physicalAddress, channelBitWidth);
-    }
-    else if (addressMappingScheme == Scheme6)
-    {
-        // chan:row:bank:rank:col
-        newTransactionColumn = diffBitWidth(&physicalAddress, colHighBitWidth);
-        newTransactionRank = diffBitWidth(&physicalAddress, rankBitWidth);
-        newTransactionBank = diffBitWidth(&physicalAddress, bankBitWidth);
-        newTransactionRow = diffBitWidth(&physicalAddress, rowBitWidth);
-        newTransactionChan = diffBitWidth(&physicalAddress, channelBitWidth);
-    }
-    // clone of scheme 5, but channel moved to lower bits
-    else if (addressMappingScheme == Scheme7) //how about using this logic?
-    {
-        // row:col:rank:bank:chan
-        newTransactionChan = diffBitWidth(&physicalAddress, channelBitWidth);
-        newTransactionBank = diffBitWidth(&physicalAddress, bankBitWidth);
-        newTransactionRank = diffBitWidth(&physicalAddress, rankBitWidth);
-        newTransactionColumn = diffBitWidth(&physicalAddress, colHighBitWidth);
-        newTransactionRow = diffBitWidth(&physicalAddress, rowBitWidth);
-    }
-    else if (addressMappingScheme == Scheme8)
-    {
-        // rank:row:col:bg:bank:chan
-        newTransactionChan = diffBitWidth(&physicalAddress, channelBitWidth);
-        newTransactionBank = diffBitWidth(&physicalAddress, bankBitWidth - bankgroupBitWidth);
-        newTransactionBank |= diffBitWidth(&physicalAddress, bankgroupBitWidth)
-                              << (bankBitWidth - bankgroupBitWidth);
-        newTransactionColumn = diffBitWidth(&physicalAddress, colHighBitWidth);
-        newTransactionRow = diffBitWidth(&physicalAddress, rowBitWidth);
-        newTransactionRank = diffBitWidth(&physicalAddress, rankBitWidth);
-    }
+    uint64_t fields[NUM_ADDR_FIELDS] = {0};
+    for (auto& f : bitFields)
+        fields[f.field] |= ((physicalAddress >> f.addrShift) & f.mask) << f.fieldShift;
+    for (auto& h : xorHashes)
+        fields[h.target] ^= ((fields[h.source] >> h.sourceShift) & h.mask) << h.targetShift;
 
-    else
-    {
-        ERROR("== Error - Unknown Address Mapping Scheme");
-        exit(-1);
-    }
+    newTransactionChan = fields[FIELD_CHAN];
+    newTransactionRank = fields[FIELD_RANK];
+    newTransactionBank = fields[FIELD_BANK];
+    newTransactionRow = fields[FIELD_ROW];
+    newTransactionColumn = fields[FIELD_COL];
 
     if (DEBUG_ADDR_MAP)
     {
@@ -218,4 +285,19 @@ void AddrMapping::addressMapping(uint64_t physicalAddress, unsigned& newTransact
                            << " Col=" << newTransactionColumn << "\n");
     }
 }
+
+// byte address of a burst; the hash sources (row, col) are never hashed themselves, so
+// applying the hashes again undoes them
+uint64_t AddrMapping::encode(unsigned channel, unsigned rank, unsigned bank, unsigned row,
+                             unsigned col) const
+{
+    uint64_t fields[NUM_ADDR_FIELDS] = {channel, rank, bank, row, col};
+    for (auto& h : xorHashes)
+        fields[h.target] ^= ((fields[h.source] >> h.sourceShift) & h.mask) << h.targetShift;
+
+    uint64_t physicalAddress = 0;
+    for (auto& f : bitFields)
+        physicalAddress |= ((fields[f.field] >> f.fieldShift) & f.mask) << f.addrShift;
+    return physicalAddress;
+}
 };  // namespace DRAMSim
@@ -34,31 +34,82 @@
 #define ADDRESS_MAPPING_H
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 #include "SystemConfiguration.h"
 
 namespace DRAMSim
 {
+enum AddrField
+{
+    FIELD_CHAN,
+    FIELD_RANK,
+    FIELD_BANK,
+    FIELD_ROW,
+    FIELD_COL,  // column in bursts (col high)
+    NUM_ADDR_FIELDS
+};
+
+// bits [fieldShift, fieldShift + width) of a field sit at bit addrShift of the byte address
+struct AddrBitField
+{
+    AddrField field;
+    unsigned addrShift;
+    unsigned fieldShift;
+    uint64_t mask;  // (1 << width) - 1
+};
+
+// target bits [targetShift, targetShift + width) ^= source bits [sourceShift, sourceShift + width)
+struct AddrXorHash
+{
+    AddrField target;
+    unsigned targetShift;
+    AddrField source;
+    unsigned sourceShift;
+    uint64_t mask;
+};
+
+/*
+ * The mapping is an ordered bit-field list, MSB first, e.g. "rank:row:col:bg:bank:chan" for
+ * Scheme8 (ADDRESS_MAPPING, or the list of ADDRESS_MAPPING_SCHEME when it is empty). A field
+ * may be split with a width suffix, "row:col3:bank:col2:chan" puts the 2 low column bits below
+ * the bank; "bg" names the top NUM_BANK_GROUPS bits of the bank. ADDRESS_XOR_HASH lists
+ * "target^source[>>shift]" terms, e.g. "bank^row,chan^row>>4" xors the bank with the low row
+ * bits and the channel with the row bits from bit 4 up; sources are row or col. The list is
+ * compiled once into mask/shift tables, and a hashed field is recovered by xoring it again,
+ * so encode() is the exact inverse of addressMapping().
+ */
 class AddrMapping
 {
   public:
     AddrMapping();
     void addressMapping(uint64_t physicalAddress, unsigned& channel, unsigned& rank, unsigned& bank,
                         unsigned& row, unsigned& col);
+    uint64_t encode(unsigned channel, unsigned rank, unsigned bank, unsigned row,
+                    unsigned col) const;
 
-    uint64_t inline diffBitWidth(uint64_t* physicalAddress, uint64_t BitWidth)
+    // channel bits (and the sources of a channel hash) only, for routing a transaction
+    unsigned inline channel(uint64_t physicalAddress) const
     {
-        uint64_t tempA = *physicalAddress;
-        *physicalAddress = *physicalAddress >> BitWidth;
-        uint64_t tempB = *physicalAddress << BitWidth;
-        return tempA ^ tempB;
+        uint64_t fields[NUM_ADDR_FIELDS] = {0};
+        for (auto& f : channelBitFields)
+            fields[f.field] |= ((physicalAddress >> f.addrShift) & f.mask) << f.fieldShift;
+        for (auto& h : channelXorHashes)
+            fields[FIELD_CHAN] ^= ((fields[h.source] >> h.sourceShift) & h.mask) << h.targetShift;
+        return fields[FIELD_CHAN];
     }
 
+    static std::string schemeFields(AddressMappingScheme scheme);
+    std::string toString() const;
+
     unsigned bankgroupId(int bank);
     static unsigned findsubarray(unsigned row);
     bool isSameBankgroup(int bank0, int bank1);
     bool isSameSubarray(int row, int sub);
   private:
+    void compile(const std::string& fields, const std::string& hashes);
+
     uint64_t transactionSize;
     uint64_t transactionMask;
     uint64_t channelBitWidth;
@@ -75,6 +126,12 @@ class AddrMapping
     unsigned num_chans_;
     int num_bank_per_bg_;
     AddressMappingScheme addressMappingScheme;
+
+    std::string mappingFields, mappingHashes;
+    std::vector<AddrBitField> bitFields;
+    std::vector<AddrXorHash> xorHashes;
+    std::vector<AddrBitField> channelBitFields;
+    std::vector<AddrXorHash> channelXorHashes;
 };
 }  // namespace DRAMSim
 
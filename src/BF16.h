@@ -0,0 +1,52 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __BF16__HPP__
+#define __BF16__HPP__
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * BF16 values are kept as their raw bits, the upper half of the FP32 encoding, so they live in
+ * the uint16_t lanes of a burst. Narrowing rounds to nearest even; every NaN becomes the quiet
+ * NaN 0x7fc0 so results do not depend on how the host propagates NaN payloads.
+ */
+inline float convertBF2F(uint16_t val)
+{
+    uint32_t bits = uint32_t(val) << 16;
+    float ret;
+    memcpy(&ret, &bits, sizeof(ret));
+    return ret;
+}
+
+inline uint16_t convertF2BF(float val)
+{
+    uint32_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    if ((bits & 0x7fffffff) > 0x7f800000)
+        return 0x7fc0;
+    return (bits + 0x7fff + ((bits >> 16) & 1)) >> 16;
+}
+
+// same criterion as fp16Equal: within maxUlpsDiff units in the last place or maxFsdiff apart
+inline bool bf16Equal(uint16_t A, uint16_t B, int maxUlpsDiff, float maxFsdiff)
+{
+    if ((A & (1 << 15)) != (B & (1 << 15)) && convertBF2F(A) == convertBF2F(B))
+        return true;
+    return std::abs(int(A) - int(B)) <= maxUlpsDiff ||
+           std::fabs(convertBF2F(A) - convertBF2F(B)) < maxFsdiff;
+}
+
+#endif
@@ -28,8 +28,6 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************************/
 
-#include <memory>
-
 #include "Bank.h"
 #include "BusPacket.h"
 
@@ -37,7 +35,9 @@ using namespace std;
 using namespace DRAMSim;
 
 Bank::Bank(ostream& simLog)
-    : currentState(simLog), rowEntries(getConfigParam(UINT, "NUM_COLS")), dramsimLog(simLog)
+    : currentState(simLog),
+      storage(getConfigParam(UINT, "NUM_ROWS"), getConfigParam(UINT, "NUM_COLS")),
+      dramsimLog(simLog)
 {
     numCols = getConfigParam(UINT, "NUM_COLS");
 }
@@ -46,48 +46,39 @@ Bank::Bank(ostream& simLog)
  * that keeps track of written data in case the simulator wants a
  * function DRAM model
  *
- * A vector of size NUM_COLS keeps a linked list of rows and their
- * associated values.
- *
- * write() adds an entry to the proper linked list or replaces the
- *     value in a row that was already written
+ * Data lives in a BankStorage: rows are allocated lazily in fixed-size
+ * pages and every burst is addressed directly by (row, column).
  *
- * read() searches for a node with the right row value, if not found
- *     returns the tracer value 0xDEADBEEF
+ * write() stores the burst, allocating its page on first touch
  *
- *    TODO: if anyone wants to actually store data, see the 'data_storage'
- *branch and perhaps try to merge that into master
+ * read() copies the stored burst into the packet, if the burst was
+ *     never written the packet data is left untouched
  */
 
-shared_ptr<Bank::DataStruct> Bank::searchForRow(unsigned row, shared_ptr<DataStruct> head)
+void Bank::read(BusPacket* busPacket)
 {
-    while (head != NULL)
+    if (busPacket->column >= numCols)
     {
-        if (head->row == row)
-        {
-            // found it
-            return head;
-        }
-        // keep looking
-        head = head->next;
+        return;
     }
-    // if we get here, didn't find it
-    return NULL; 
+    storage.read(busPacket->row, busPacket->column, busPacket->data);
+}
+// hand the bursts over to a region of a BankStorageFile (BANK_STORAGE=mmap)
+void Bank::attachStorage(uint8_t* base)
+{
+    storage.attachMapping(base);
 }
 
-void Bank::read(BusPacket* busPacket)
+void Bank::saveState(ostream& out) const
 {
-    //cout<<"Bank::read() and busPacket->bank is "<<busPacket->bank<<" and row is "<<busPacket->row<<" and col is " <<busPacket->column<<" and bank's entry is "<<numCols<<endl;
-    shared_ptr<DataStruct> rowHeadNode = rowEntries[busPacket->column];
-    shared_ptr<DataStruct> foundNode = NULL;
-    if ((foundNode = Bank::searchForRow(busPacket->row, rowHeadNode)) == NULL)
-    {
-    }
-    else  // found it
-    {
-        *(busPacket->data) = foundNode->data;
-    }
+    storage.saveState(out);
 }
+
+void Bank::loadState(istream& in)
+{
+    storage.loadState(in);
+}
+
 //i'd like to use this logic same as subarray....
 void Bank::write(const BusPacket* busPacket)
 {
@@ -101,39 +92,16 @@ void Bank::write(const BusPacket* busPacket)
         //exit(-1);
         return;
     }
-    // head of the list we need to search
-    shared_ptr<DataStruct> rowHeadNode = rowEntries[busPacket->column];
-    shared_ptr<DataStruct> foundNode = NULL;
-    uintptr_t const_addr = 0x55ffffff;
-    uintptr_t addr = reinterpret_cast<uintptr_t>(busPacket->data);
-    //cout<<"busPacket->row: "<<busPacket->row<<" and bank is "<<busPacket->bank<<" and col is "<<busPacket->column<<endl;
-    if(addr>const_addr)
-    {    
-        if ((foundNode = Bank::searchForRow(busPacket->row, rowHeadNode)) == NULL)
-        {
-            // not found
-            shared_ptr<DataStruct> newRowNode = make_shared<DataStruct>();
-            // DataStruct* newRowNode = (DataStruct*)malloc(sizeof(DataStruct));
-
-            // insert at the head for speed
-            // TODO: Optimize this data structure for speedier lookups?
-            newRowNode->row = busPacket->row;
-            if(busPacket->data)
-                newRowNode->data = *(busPacket->data);
-            newRowNode->next = rowHeadNode;
-            rowEntries[busPacket->column] = newRowNode;
-        }
-        else
-        {
-            // found it, just plaster in the new data
-            foundNode->data = *(busPacket->data);
-            if (DEBUG_BANKS)
-            {
-                PRINTN(" -- Bank " << busPacket->bank << " writing to physical address 0x" << hex
-                                << busPacket->physicalAddress << dec << ":");
-                busPacket->printData();
-                PRINT("");
-            }
-        }
+    if (busPacket->data == NULL)
+    {
+        return;
+    }
+    storage.write(busPacket->row, busPacket->column, *(busPacket->data));
+    if (DEBUG_BANKS)
+    {
+        PRINTN(" -- Bank " << busPacket->bank << " writing to physical address 0x" << hex
+                           << busPacket->physicalAddress << dec << ":");
+        busPacket->printData();
+        PRINT("");
     }
 }
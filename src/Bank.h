@@ -32,41 +32,35 @@
 #define BANK_H
 
 #include <iostream>
-#include <memory>
 #include <vector>
 
 #include "BankState.h"
+#include "BankStorage.h"
 #include "Burst.h"
 #include "BusPacket.h"
 #include "SimulatorObject.h"
 #include "SystemConfiguration.h"
-#include "SubArray.h"
 
 namespace DRAMSim
 {
 class Bank
 {
-    typedef struct _DataStruct
-    {
-        unsigned row;
-        BurstType data;
-        std::shared_ptr<struct _DataStruct> next;
-    } DataStruct;
-    //how about use this in subarray level logic?
   public:
     // functions
     Bank(ostream& simLog);
 
     void read(BusPacket* busPacket);
     void write(const BusPacket* busPacket);
+    void attachStorage(uint8_t* base);
+    void saveState(ostream& out) const;
+    void loadState(istream& in);
     BankState currentState;
     unsigned numCols;
 
   private:
     // private member
-    std::vector<std::shared_ptr<DataStruct>> rowEntries;
+    BankStorage storage;
     ostream& dramsimLog;
-    static std::shared_ptr<DataStruct> searchForRow(unsigned row, std::shared_ptr<DataStruct> head);
 };
 }  // namespace DRAMSim
 
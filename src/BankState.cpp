@@ -29,6 +29,7 @@
  *********************************************************************************/
 
 #include "BankState.h"
+#include "Checkpoint.h"
 
 using namespace std;
 using namespace DRAMSim;
@@ -41,6 +42,7 @@ BankState::BankState(ostream& simLog)
       nextRead(0),
       nextWrite(0),
       nextActivate(0),
+      nextSubSel(0),
       nextPrecharge(0),
       nextPowerUp(0),
       lastCommand(READ),
@@ -99,3 +101,31 @@ void BankState::showState()
         PRINTN("[lowp] ");
     }
 }
+
+void BankState::saveState(ostream& out) const
+{
+    ckptWrite(out, currentBankState);
+    ckptWrite(out, openRowAddress);
+    ckptWrite(out, nextRead);
+    ckptWrite(out, nextWrite);
+    ckptWrite(out, nextActivate);
+    ckptWrite(out, nextSubSel);
+    ckptWrite(out, nextPrecharge);
+    ckptWrite(out, nextPowerUp);
+    ckptWrite(out, lastCommand);
+    ckptWrite(out, stateChangeCountdown);
+}
+
+void BankState::loadState(istream& in)
+{
+    ckptRead(in, currentBankState);
+    ckptRead(in, openRowAddress);
+    ckptRead(in, nextRead);
+    ckptRead(in, nextWrite);
+    ckptRead(in, nextActivate);
+    ckptRead(in, nextSubSel);
+    ckptRead(in, nextPrecharge);
+    ckptRead(in, nextPowerUp);
+    ckptRead(in, lastCommand);
+    ckptRead(in, stateChangeCountdown);
+}
@@ -43,7 +43,7 @@ enum CurrentBankState
 {
     Idle,
     RowActive,
-    Precharging,
+    Precharging,  // with lastCommand READ/WRITE: auto-precharge in flight
     Refreshing,
     PowerDown,
 };
@@ -70,6 +70,8 @@ class BankState
     BankState(ostream& simLog);
     void print();
     void showState();
+    void saveState(ostream& out) const;
+    void loadState(istream& in);
 };
 
 }  // namespace DRAMSim
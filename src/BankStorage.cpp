@@ -0,0 +1,317 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include "BankStorage.h"
+#include "Checkpoint.h"
+#include "PrintMacros.h"
+
+using namespace DRAMSim;
+
+BankStorage::BankStorage(unsigned numRows, unsigned numCols)
+    : numRows_(numRows),
+      numCols_(numCols),
+      numPages_(0),
+      pages_((numRows + ROWS_PER_PAGE - 1) >> ROW_PAGE_SHIFT),
+      mappedBursts_(NULL),
+      mappedValid_(NULL)
+{
+}
+
+BankStorage::BankStorage(const BankStorage& rhs)
+{
+    copyFrom(rhs);
+}
+
+BankStorage& BankStorage::operator=(const BankStorage& rhs)
+{
+    if (this != &rhs)
+        copyFrom(rhs);
+    return *this;
+}
+
+void BankStorage::copyFrom(const BankStorage& rhs)
+{
+    numRows_ = rhs.numRows_;
+    numCols_ = rhs.numCols_;
+    numPages_ = rhs.numPages_;
+    // a mapped region belongs to the file, copies see the same bursts
+    mappedBursts_ = rhs.mappedBursts_;
+    mappedValid_ = rhs.mappedValid_;
+    pages_.clear();
+    pages_.resize(rhs.pages_.size());
+    for (size_t i = 0; i < rhs.pages_.size(); i++)
+    {
+        if (rhs.pages_[i])
+            pages_[i].reset(new Page(*rhs.pages_[i]));
+    }
+}
+
+uint64_t BankStorage::getMappedBytes(unsigned numRows, unsigned numCols)
+{
+    uint64_t numBursts = static_cast<uint64_t>(numRows) * numCols;
+    uint64_t bytes = numBursts * sizeof(BurstType) + numBursts;
+    // keep every bank region page aligned
+    return (bytes + 4095) & ~static_cast<uint64_t>(4095);
+}
+
+void BankStorage::attachMapping(uint8_t* base)
+{
+    uint64_t numBursts = static_cast<uint64_t>(numRows_) * numCols_;
+    mappedBursts_ = reinterpret_cast<BurstType*>(base);
+    mappedValid_ = base + numBursts * sizeof(BurstType);
+
+    // migrate anything written before the mapping was attached
+    for (size_t i = 0; i < pages_.size(); i++)
+    {
+        if (!pages_[i])
+            continue;
+        for (unsigned r = 0; r < ROWS_PER_PAGE; r++)
+        {
+            unsigned row = (i << ROW_PAGE_SHIFT) + r;
+            for (unsigned c = 0; c < numCols_ && row < numRows_; c++)
+            {
+                unsigned burstIdx = getBurstIdx(row, c);
+                if (pages_[i]->valid[burstIdx])
+                    write(row, c, pages_[i]->bursts[burstIdx]);
+            }
+        }
+    }
+    pages_.clear();
+    numPages_ = 0;
+}
+
+bool BankStorage::read(unsigned row, unsigned col, BurstType* bst) const
+{
+    // a column past the row would alias the next row, or run off the end of the last one
+    if (col >= numCols_)
+        return false;
+    if (mappedBursts_)
+    {
+        if (row >= numRows_)
+            return false;
+        uint64_t idx = static_cast<uint64_t>(row) * numCols_ + col;
+        if (!mappedValid_[idx])
+            return false;
+        memcpy(bst, &mappedBursts_[idx], sizeof(BurstType));
+        return true;
+    }
+
+    unsigned pageIdx = getPageIdx(row);
+    if (pageIdx >= pages_.size() || !pages_[pageIdx])
+        return false;
+
+    const Page& page = *pages_[pageIdx];
+    unsigned burstIdx = getBurstIdx(row, col);
+    if (!page.valid[burstIdx])
+        return false;
+
+    *bst = page.bursts[burstIdx];
+    return true;
+}
+
+void BankStorage::write(unsigned row, unsigned col, const BurstType& bst)
+{
+    if (col >= numCols_)
+    {
+        ERROR("== Error - col " << col << " is out of the bank storage (NUM_COLS " << numCols_
+                                << ")");
+        exit(-1);
+    }
+    if (mappedBursts_)
+    {
+        if (row >= numRows_)
+        {
+            ERROR("== Error - row " << row << " is out of the mapped bank storage (NUM_ROWS "
+                                    << numRows_ << ")");
+            exit(-1);
+        }
+        uint64_t idx = static_cast<uint64_t>(row) * numCols_ + col;
+        memcpy(&mappedBursts_[idx], &bst, sizeof(BurstType));
+        mappedValid_[idx] = 1;
+        return;
+    }
+
+    unsigned pageIdx = getPageIdx(row);
+    // subarray-mode row addresses are not bounded by NUM_ROWS, so grow the directory on demand
+    if (pageIdx >= pages_.size())
+        pages_.resize(pageIdx + 1);
+    if (!pages_[pageIdx])
+    {
+        pages_[pageIdx].reset(new Page(ROWS_PER_PAGE * numCols_));
+        numPages_++;
+    }
+
+    Page& page = *pages_[pageIdx];
+    unsigned burstIdx = getBurstIdx(row, col);
+    page.bursts[burstIdx] = bst;
+    page.valid[burstIdx] = 1;
+}
+
+void BankStorage::saveState(ostream& out) const
+{
+    vector<pair<uint64_t, const BurstType*>> written;
+    if (mappedBursts_)
+    {
+        uint64_t numBursts = static_cast<uint64_t>(numRows_) * numCols_;
+        for (uint64_t idx = 0; idx < numBursts; idx++)
+        {
+            if (mappedValid_[idx])
+                written.push_back(make_pair(idx, &mappedBursts_[idx]));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < pages_.size(); i++)
+        {
+            if (!pages_[i])
+                continue;
+            for (unsigned burstIdx = 0; burstIdx < ROWS_PER_PAGE * numCols_; burstIdx++)
+            {
+                if (pages_[i]->valid[burstIdx])
+                    written.push_back(make_pair((static_cast<uint64_t>(i) << ROW_PAGE_SHIFT) *
+                                                        numCols_ + burstIdx,
+                                                &pages_[i]->bursts[burstIdx]));
+            }
+        }
+    }
+
+    ckptWrite(out, static_cast<uint64_t>(written.size()));
+    for (auto& it : written)
+    {
+        ckptWrite(out, static_cast<uint32_t>(it.first / numCols_));
+        ckptWrite(out, static_cast<uint32_t>(it.first % numCols_));
+        ckptWrite(out, *it.second);
+    }
+}
+
+void BankStorage::loadState(istream& in)
+{
+    // drop whatever was there before (e.g. a warm mmap file)
+    if (mappedBursts_)
+    {
+        memset(mappedValid_, 0, static_cast<uint64_t>(numRows_) * numCols_);
+    }
+    else
+    {
+        for (auto& page : pages_) page.reset();
+        numPages_ = 0;
+    }
+
+    uint64_t numWritten = 0;
+    ckptRead(in, numWritten);
+    for (uint64_t i = 0; i < numWritten; i++)
+    {
+        uint32_t row, col;
+        BurstType bst;
+        ckptRead(in, row);
+        ckptRead(in, col);
+        ckptRead(in, bst);
+        write(row, col, bst);
+    }
+}
+
+BankStorageFile::BankStorageFile(const string& path, unsigned numBanks, unsigned numRows,
+                                 unsigned numCols)
+    : path_(path),
+      fd_(-1),
+      base_(NULL),
+      bytesPerBank_(BankStorage::getMappedBytes(numRows, numCols)),
+      warm_(false)
+{
+    size_ = HEADER_BYTES + bytesPerBank_ * numBanks;
+
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0)
+    {
+        ERROR("== Error - cannot open bank storage file " << path_ << ": " << strerror(errno));
+        exit(-1);
+    }
+
+    Header expected;
+    memset(&expected, 0, sizeof(Header));
+    memcpy(expected.magic, "PIMBANK2", 8);
+    expected.numBanks = numBanks;
+    expected.numRows = numRows;
+    expected.numCols = numCols;
+    expected.burstBytes = sizeof(BurstType);
+    expected.bytesPerBank = bytesPerBank_;
+
+    struct stat st;
+    fstat(fd_, &st);
+    if (static_cast<uint64_t>(st.st_size) == size_)
+    {
+        Header found;
+        if (pread(fd_, &found, sizeof(Header), 0) == sizeof(Header) &&
+            memcmp(&found, &expected, offsetof(Header, preloaded)) == 0)
+        {
+            warm_ = true;
+            if (found.preloaded)
+                preloadTag_ = string(found.preloadTag, strnlen(found.preloadTag, MAX_TAG_LEN));
+        }
+    }
+
+    // a warm file keeps its bursts but loses the completion flag until markPreloaded()
+    if ((!warm_ && (ftruncate(fd_, 0) != 0 || ftruncate(fd_, size_) != 0)) ||
+        pwrite(fd_, &expected, sizeof(Header), 0) != sizeof(Header))
+    {
+        ERROR("== Error - cannot size bank storage file " << path_ << ": " << strerror(errno));
+        exit(-1);
+    }
+
+    void* addr = mmap(NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, fd_, 0);
+    if (addr == MAP_FAILED)
+    {
+        ERROR("== Error - cannot mmap bank storage file " << path_ << ": " << strerror(errno));
+        exit(-1);
+    }
+    base_ = static_cast<uint8_t*>(addr);
+}
+
+BankStorageFile::~BankStorageFile()
+{
+    if (base_)
+        munmap(base_, size_);
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+uint8_t* BankStorageFile::getBankBase(unsigned bank) const
+{
+    return base_ + HEADER_BYTES + bytesPerBank_ * bank;
+}
+
+bool BankStorageFile::isPreloaded(const string& tag) const
+{
+    return !tag.empty() && preloadTag_ == tag.substr(0, MAX_TAG_LEN);
+}
+
+void BankStorageFile::markPreloaded(const string& tag)
+{
+    Header* header = getHeader();
+    memset(header->preloadTag, 0, MAX_TAG_LEN);
+    memcpy(header->preloadTag, tag.data(), min<size_t>(tag.size(), MAX_TAG_LEN));
+    // bursts first, then the flag, so a crash in between never leaves a tagged partial file
+    msync(base_, size_, MS_SYNC);
+    header->preloaded = 1;
+    msync(base_, HEADER_BYTES, MS_SYNC);
+    preloadTag_ = tag.substr(0, MAX_TAG_LEN);
+}
@@ -0,0 +1,161 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __BANK_STORAGE_HPP__
+#define __BANK_STORAGE_HPP__
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Burst.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+/*
+ * Sparse burst storage shared by Bank and Subarray.
+ *
+ * Rows are grouped into pages of (1 << ROW_PAGE_SHIFT) rows x numCols bursts.
+ * A page is allocated the first time any burst inside it is written, so
+ * untouched rows cost one null pointer in the page directory. Inside a page
+ * bursts are laid out row-major and contiguously, which makes read() and
+ * write() a direct index instead of a list walk.
+ *
+ * With BANK_STORAGE=mmap the heap pages are replaced by a region of a
+ * BankStorageFile (see attachMapping()): numRows x numCols bursts followed by
+ * one valid byte per burst. The file is sparse, so only touched rows take
+ * disk blocks and the OS pages cold rows out.
+ */
+class BankStorage
+{
+  public:
+    static const unsigned ROW_PAGE_SHIFT = 4;
+    static const unsigned ROWS_PER_PAGE = 1 << ROW_PAGE_SHIFT;
+
+    BankStorage(unsigned numRows, unsigned numCols);
+    BankStorage(const BankStorage& rhs);
+    BankStorage& operator=(const BankStorage& rhs);
+
+    // returns false and leaves bst untouched if the burst was never written
+    bool read(unsigned row, unsigned col, BurstType* bst) const;
+    void write(unsigned row, unsigned col, const BurstType& bst);
+
+    // switch to file-backed storage, base must hold getMappedBytes() bytes
+    void attachMapping(uint8_t* base);
+    static uint64_t getMappedBytes(unsigned numRows, unsigned numCols);
+
+    // only written bursts go to the checkpoint, as (row, col, burst) records
+    void saveState(ostream& out) const;
+    void loadState(istream& in);
+
+    unsigned getNumCols() const
+    {
+        return numCols_;
+    }
+    uint64_t getNumPages() const
+    {
+        return numPages_;
+    }
+    bool isMapped() const
+    {
+        return mappedBursts_ != NULL;
+    }
+
+  private:
+    struct Page
+    {
+        explicit Page(unsigned numBursts) : bursts(numBursts), valid(numBursts, 0) {}
+        vector<BurstType> bursts;
+        vector<uint8_t> valid;
+    };
+
+    unsigned inline getPageIdx(unsigned row) const
+    {
+        return row >> ROW_PAGE_SHIFT;
+    }
+    unsigned inline getBurstIdx(unsigned row, unsigned col) const
+    {
+        return (row & (ROWS_PER_PAGE - 1)) * numCols_ + col;
+    }
+    void copyFrom(const BankStorage& rhs);
+
+    unsigned numRows_;
+    unsigned numCols_;
+    uint64_t numPages_;
+    vector<unique_ptr<Page>> pages_;
+
+    // file-backed mode, owned by a BankStorageFile
+    BurstType* mappedBursts_;
+    uint8_t* mappedValid_;
+};
+
+/*
+ * Sparse file mmap'd with MAP_SHARED that backs the banks of one rank.
+ * A small header records the geometry; if an existing file with the same
+ * geometry is opened again its contents are kept (isWarm() is true).
+ *
+ * Warm contents alone do not say what is in the file, so the header also
+ * carries a preload tag and a completion flag. markPreloaded(tag) sets both
+ * once the caller's preload has landed in the banks; opening the file clears
+ * the flag on disk, so a run that dies or preloads something else in between
+ * leaves the file untagged for the next one.
+ */
+class BankStorageFile
+{
+  public:
+    BankStorageFile(const string& path, unsigned numBanks, unsigned numRows, unsigned numCols);
+    ~BankStorageFile();
+
+    uint8_t* getBankBase(unsigned bank) const;
+    bool isWarm() const
+    {
+        return warm_;
+    }
+    bool isPreloaded(const string& tag) const;
+    void markPreloaded(const string& tag);
+
+  private:
+    static const uint64_t HEADER_BYTES = 4096;
+    static const unsigned MAX_TAG_LEN = 64;
+    struct Header
+    {
+        char magic[8];
+        uint64_t numBanks;
+        uint64_t numRows;
+        uint64_t numCols;
+        uint64_t burstBytes;
+        uint64_t bytesPerBank;
+        // everything above has to match for the file to be warm
+        uint64_t preloaded;
+        char preloadTag[MAX_TAG_LEN];
+    };
+    Header* getHeader() const
+    {
+        return reinterpret_cast<Header*>(base_);
+    }
+
+    string path_;
+    int fd_;
+    uint8_t* base_;
+    uint64_t size_;
+    uint64_t bytesPerBank_;
+    bool warm_;
+    // tag of a preload completed before this file was opened or since markPreloaded()
+    string preloadTag_;
+};
+}  // namespace DRAMSim
+
+#endif
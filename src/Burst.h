@@ -22,6 +22,7 @@
 #include <vector>
 #include <algorithm>
 
+#include "BF16.h"
 #include "FP16.h"
 #include "npy.h"
 
@@ -309,6 +310,15 @@ union BurstType
         }
         return convertF2H(maxValue);
     }
+    float bf16ReduceSum()
+    {
+        float sum = 0.0;
+        for (int i = 0; i < 16; i++)
+        {
+            sum += convertBF2F(u16Data_[i]);
+        }
+        return sum;
+    }
     float fp32ReduceSum()
     {
         float sum = 0.0;
@@ -318,6 +328,16 @@ union BurstType
         }
         return sum;
     }
+    // INT8/INT4 GEMV output: MAC leaves eight INT32 partial sums per burst, the host adds them
+    int64_t i32ReduceSum()
+    {
+        int64_t sum = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            sum += i32Data_[i];
+        }
+        return sum;
+    }
 
     bool operator==(const BurstType& rhs) const
     {
@@ -349,8 +369,10 @@ union BurstType
     }
 
     uint8_t u8Data_[32];
+    int8_t i8Data_[32];
     float fp32Data_[8];
     uint32_t u32Data_[8];
+    int32_t i32Data_[8];
     uint16_t u16Data_[16];
     fp16 fp16Data_[16];
 };
@@ -367,7 +389,8 @@ struct NumpyBurstType
     enum precision
     {
         FP32,
-        FP16
+        FP16,
+        BF16
     };
 
     BurstType& getBurst(int x, int y)
@@ -417,6 +440,12 @@ struct NumpyBurstType
         }
     }
 
+    // numpy has no BF16 type, BF16 arrays are saved as their raw bits in a float16 array
+    void loadBf16(string filename)
+    {
+        loadFp16(filename);
+    }
+
     void loadFp16FromFp32(string filename)
     {
         npy::LoadArrayFromNumpy(filename, shape, data);
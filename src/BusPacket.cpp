@@ -42,7 +42,8 @@ BusPacket::BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col
       bank(b),
       rank(r),
       physicalAddress(physicalAddr),
-      data(dat)
+      data(dat),
+      autoPrecharge(false)
 {
 }
 BusPacket::BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col, unsigned rw,
@@ -55,7 +56,8 @@ BusPacket::BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col
       rank(r),
       physicalAddress(physicalAddr),
       data(dat),
-      tag(tg)
+      tag(tg),
+      autoPrecharge(false)
 {
 }
 
@@ -80,11 +82,11 @@ void BusPacket::print(uint64_t currentClockCycle, bool dataStart)
         {
             case READ:
                 cmd_verify_out << currentClockCycle << ": read (" << rank << "," << bank << ","
-                               << column << ",0);" << endl;
+                               << column << "," << autoPrecharge << ");" << endl;
                 break;
             case WRITE:
                 cmd_verify_out << currentClockCycle << ": write (" << rank << "," << bank << ","
-                               << column << ",0 , 0, 'h0);" << endl;
+                               << column << "," << autoPrecharge << " , 0, 'h0);" << endl;
                 break;
             case ACTIVATE:
                 cmd_verify_out << currentClockCycle << ": activate (" << rank << "," << bank << ","
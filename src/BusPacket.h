@@ -34,6 +34,7 @@
 #include <string>
 
 #include "Burst.h"
+#include "ObjectPool.h"
 #include "SystemConfiguration.h"
 
 namespace DRAMSim
@@ -67,6 +68,7 @@ class BusPacket
     uint64_t physicalAddress;
     BurstType* data;
     std::string tag;
+    bool autoPrecharge;  // READ/WRITE that closes its row (close_page), set by CommandQueue::pop
 
     // Functions
     BusPacket(BusPacketType packtype, uint64_t physicalAddr, unsigned col, unsigned rw, unsigned r,
@@ -77,6 +79,9 @@ class BusPacket
     void print();
     void print(uint64_t currentClockCycle, bool dataStart);
     void printData() const;
+
+    // one per command, recycled through ObjectPool
+    DECLARE_POOLED_NEW(BusPacket)
 };
 
 }  // namespace DRAMSim
@@ -1,50 +1,77 @@
+#include <cmath>
+#include <stdexcept>
 #include <vector>
 
 #include "C_ALU.h"
-//#include "tests/KernelAddrGen.h"
 #include "Burst.h"
 
 using namespace std;
 using namespace DRAMSim;
 
-C_ALU::~C_ALU()
+// copies the slopes and intercepts of the table, header is lut_table::getHeader()
+void C_ALU::load(const BurstType& header, const BurstType* lut_bursts)
 {
-    delete C_REG;
-    delete S_REG;
-}
-/*void C_ALU::addertree(BurstType* result, int output_dim, int num_tile, int step, fp16* temp) //we got 16 types of things and measure
-//prototype: output_dim = 1, num_tile = 16, step = 0
-{
-    if (num_tile == 1)
-        return;
+    sec_num_ = header.u16Data_[0];
+    low_[0] = convertH2F(header.fp16Data_[1]);
+    up_[0] = convertH2F(header.fp16Data_[2]);
+    low_[1] = convertH2F(header.fp16Data_[3]);
+    up_[1] = convertH2F(header.fp16Data_[4]);
 
-    int iter = num_tile / 2; //example we got num_tile for 
-    if (step == 0)
+    // lut_table::sets: slopes, then intercepts of GELU and then of exp, size bursts each
+    int size = sec_num_ / 16;
+    for (int t = 0; t < 2; t++)
     {
-        for (int i = 0; i < iter; i++)
+        int offset = 2 * size * t;
+        slopes_[t].resize(sec_num_);
+        intercepts_[t].resize(sec_num_);
+        for (int s = 0; s < sec_num_; s++)
         {
-            
-            temp[i] = result[2 * i * output_dim].fp16AdderTree() +
-                      result[(2 * i + 1) * output_dim].fp16AdderTree();
+            slopes_[t][s] = lut_bursts[offset + s / 16].fp16Data_[s % 16];
+            intercepts_[t][s] = lut_bursts[offset + size + s / 16].fp16Data_[s % 16];
         }
     }
-    else
-    {
-        for (int i = 0; i < iter; i++) temp[i] = temp[i * 2] + temp[i * 2 + 1];
+}
 
-        if (num_tile % 2 == 1)
-            temp[iter] = temp[num_tile];
+/*
+ * burst = f(burst + bias) lane by lane with one FP16 multiply-add on the segment of x. Below the
+ * table both functions are 0, above it GELU is x and exp stays on the last segment.
+ */
+void C_ALU::lut(BurstType& burst, layerType layertype, fp16 bias)
+{
+    if (pim_precision_ != FP16)
+        throw invalid_argument("C_ALU evaluates the lut_table in FP16 only");
+    if (sec_num_ == 0)
+        throw invalid_argument("C_ALU has no lut_table loaded");
+
+    int t = (layertype == layerType::GELU) ? 0 : 1;
+    float width = (up_[t] - low_[t]) / sec_num_;
+    for (int fp = 0; fp < 16; fp++)
+    {
+        fp16 x = burst.fp16Data_[fp] + bias;
+        float xf = convertH2F(x);
+        if (isnan(xf))
+            continue;
+        if (xf < low_[t])
+        {
+            burst.fp16Data_[fp] = fp16(0.0f);
+            continue;
+        }
+        if (xf >= up_[t] && layertype == layerType::GELU)
+        {
+            burst.fp16Data_[fp] = x;
+            continue;
+        }
+        int seg = min((int)((xf - low_[t]) / width), sec_num_ - 1);
+        burst.fp16Data_[fp] = slopes_[t][seg] * x + intercepts_[t][seg];
     }
+}
 
-    adderTree(result, output_dim, ceil(double(num_tile) / (double)2), step + 1, temp);
-    return;
-}*/
 void C_ALU::adderTree()
 {
+    S_REG = 0.0f;
     for(int i = 0; i < 16; i++)
     {
-        if(S_REG != nullptr)
-            *S_REG = *S_REG + C_REG->fp16Data_[i];
+        S_REG += acc_[i];
     }
     return;
 }
@@ -52,40 +79,46 @@ void C_ALU::accum(BurstType& burst, bool is_neg){
     if(pim_precision_==FP16){
         for(int fp  = 0; fp < 16; fp++)
         {
-            if(is_neg)  C_REG->fp16Data_[fp] -= burst.fp16Data_[fp];
-            else    C_REG->fp16Data_[fp] += burst.fp16Data_[fp];
+            if(is_neg)  acc_[fp] -= convertH2F(burst.fp16Data_[fp]);
+            else    acc_[fp] += convertH2F(burst.fp16Data_[fp]);
         }
     }
     else if(pim_precision_ == FP32){
         for(int fp = 0; fp < 8; fp++)
         {
-            if(is_neg)  C_REG->fp32Data_[fp] -= burst.fp32Data_[fp];
-            else    C_REG->fp32Data_[fp] += burst.fp16Data_[fp];
+            if(is_neg)  acc_[fp] -= burst.fp32Data_[fp];
+            else    acc_[fp] += burst.fp32Data_[fp];
         }
-
     }
 }
 void C_ALU::zeroize()
 {
-    S_REG = 0;
+    C_REG = BurstType();
+    for (int i = 0; i < 16; i++) acc_[i] = 0.0f;
+    S_REG = 0.0f;
     return;
 }
 
+void C_ALU::setlowest()
+{
+    C_REG.set(convertF2H(-65504.0f));
+}
+
 void C_ALU::C_max(BurstType& src0Bst)
 {
     if(pim_precision_ == FP16)
     {
         for(int fp = 0; fp < 16; fp++)
         {
-            C_REG->fp16Data_[fp] = (C_REG->fp16Data_[fp] > src0Bst.fp16Data_[fp])?C_REG->fp16Data_[fp]:src0Bst.fp16Data_[fp];
+            C_REG.fp16Data_[fp] = (C_REG.fp16Data_[fp] > src0Bst.fp16Data_[fp])?C_REG.fp16Data_[fp]:src0Bst.fp16Data_[fp];
         }
     }
 }
 void C_ALU::setmax()
 {
-    for(int fp = 0; fp < 16; fp++)
+    S_REG = convertH2F(C_REG.fp16Data_[0]);
+    for(int fp = 1; fp < 16; fp++)
     {
-        S_REG = (C_REG->fp16Data_[fp] > *S_REG)?&C_REG->fp16Data_[fp]:S_REG;
+        S_REG = (convertH2F(C_REG.fp16Data_[fp]) > S_REG)?convertH2F(C_REG.fp16Data_[fp]):S_REG;
     }
 }
-//how about just put c_alu outside the bank...
\ No newline at end of file
@@ -4,42 +4,51 @@
 #include <vector>
 
 #include "Burst.h"
-#include "tests/KernelAddrGen.h"
+#include "lut_table.h"
 #include "SystemConfiguration.h"
 
 using namespace DRAMSim;
 using namespace std;
+
+/*
+ * Lane-wise table lookup and reduction unit. PIMRank keeps one to evaluate the GELU and EXP
+ * commands on the lut_table the host loads through WRIO_TO_LUT_. The kernels use it on the host
+ * side to fold the per-block partials of a row reduction: C_REG is a lane-wise max register,
+ * acc_ a lane-wise FP32 accumulator and S_REG the scalar that adderTree()/setmax() reduce them to.
+ */
 class C_ALU
 {
 public:
 
-    C_ALU(){
-        pim_precision_ = PIMConfiguration::getPIMPrecision();
-        C_REG = new BurstType();
-        S_REG = new fp16();
-    };    
+    C_ALU()
+        : pim_precision_(PIMConfiguration::getPIMPrecision()),
+          sec_num_(0)
+    {
+        zeroize();
+    };
     C_ALU(PIMPrecision pimprecision)
-        :pim_precision_(pimprecision)
+        :pim_precision_(pimprecision),
+         sec_num_(0)
     {
-        C_REG = new BurstType();
-        S_REG = new fp16();
+        zeroize();
     };
-    ~C_ALU();
-    void AdderTree(fp16 C_REG); //use from kernel.cpp
-    void load(); //how?
+    void load(const BurstType& header, const BurstType* lut_bursts);
+    void lut(BurstType& burst, layerType layertype, fp16 bias = fp16(0.0f));
     void accum(BurstType& burst, bool is_neg);
     void adderTree();
     void zeroize();
+    void setlowest();
     void C_max(BurstType& src0Bst);
     void setmax();
 
-    BurstType* C_REG;
+    BurstType C_REG;
     PIMPrecision pim_precision_;
-    fp16* S_REG;
+    float S_REG;
 private:
-    int chan_id;
-    int rank_id;
-    
-//main problem, how to add transaction to this channel level logic
+    float acc_[16];
+    // slopes and intercepts of layerType::GELU and layerType::EXP, lut_table layout
+    vector<fp16> slopes_[2], intercepts_[2];
+    float low_[2], up_[2];
+    int sec_num_;
 };
 #endif
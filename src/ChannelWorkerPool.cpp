@@ -0,0 +1,91 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#include "ChannelWorkerPool.h"
+#include "MemorySystem.h"
+
+using namespace DRAMSim;
+
+// spin this many times before yielding the core while waiting on the barrier
+static const unsigned SPIN_BEFORE_YIELD = 1024;
+
+ChannelWorkerPool::ChannelWorkerPool(vector<MemorySystem*>& channels, unsigned numThreads)
+    : channels_(channels), numThreads_(numThreads), generation_(0), numDone_(0), quit_(false)
+{
+    if (numThreads_ > channels_.size())
+        numThreads_ = channels_.size();
+    if (numThreads_ == 0)
+        numThreads_ = 1;
+
+    for (unsigned tid = 1; tid < numThreads_; tid++)
+    {
+        workers_.push_back(thread(&ChannelWorkerPool::workerLoop, this, tid));
+    }
+}
+
+ChannelWorkerPool::~ChannelWorkerPool()
+{
+    quit_.store(true, memory_order_relaxed);
+    generation_.fetch_add(1, memory_order_release);
+    for (auto& worker : workers_) worker.join();
+}
+
+void ChannelWorkerPool::updateSlice(unsigned tid)
+{
+    size_t begin = channels_.size() * tid / numThreads_;
+    size_t end = channels_.size() * (tid + 1) / numThreads_;
+    for (size_t i = begin; i < end; i++)
+    {
+        channels_[i]->update();
+    }
+}
+
+void ChannelWorkerPool::step()
+{
+    if (numThreads_ == 1)
+    {
+        updateSlice(0);
+        return;
+    }
+
+    generation_.fetch_add(1, memory_order_release);
+    updateSlice(0);
+
+    unsigned spin = 0;
+    while (numDone_.load(memory_order_acquire) != numThreads_ - 1)
+    {
+        if (++spin > SPIN_BEFORE_YIELD)
+            this_thread::yield();
+    }
+    numDone_.store(0, memory_order_relaxed);
+}
+
+void ChannelWorkerPool::workerLoop(unsigned tid)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        unsigned spin = 0;
+        uint64_t gen;
+        while ((gen = generation_.load(memory_order_acquire)) == seen)
+        {
+            if (++spin > SPIN_BEFORE_YIELD)
+                this_thread::yield();
+        }
+        seen = gen;
+        if (quit_.load(memory_order_relaxed))
+            return;
+
+        updateSlice(tid);
+        numDone_.fetch_add(1, memory_order_release);
+    }
+}
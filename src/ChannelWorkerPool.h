@@ -0,0 +1,65 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __CHANNEL_WORKER_POOL_HPP__
+#define __CHANNEL_WORKER_POOL_HPP__
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace DRAMSim
+{
+class MemorySystem;
+
+/*
+ * Persistent pool that steps all channels of a MultiChannelMemorySystem in parallel.
+ *
+ * Channels share no state inside a cycle, so each thread owns a fixed, contiguous slice
+ * of channels and updates it in the same order as the serial loop. The calling thread
+ * works on slice 0, then waits on a spinning barrier until every worker has finished
+ * its slice, so a call to step() is one full memory cycle and the results are the same
+ * as channels[i]->update() in a loop.
+ *
+ * Read/write callbacks registered with RegisterCallbacks() are invoked from the thread
+ * owning the channel and must be thread-safe.
+ */
+class ChannelWorkerPool
+{
+  public:
+    ChannelWorkerPool(vector<MemorySystem*>& channels, unsigned numThreads);
+    ~ChannelWorkerPool();
+
+    void step();
+    unsigned getNumThreads() const
+    {
+        return numThreads_;
+    }
+
+  private:
+    void workerLoop(unsigned tid);
+    void updateSlice(unsigned tid);
+
+    vector<MemorySystem*>& channels_;
+    unsigned numThreads_;
+    vector<thread> workers_;
+
+    // bumped once per step() to release the workers
+    atomic<uint64_t> generation_;
+    atomic<unsigned> numDone_;
+    atomic<bool> quit_;
+};
+}  // namespace DRAMSim
+
+#endif
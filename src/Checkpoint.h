@@ -0,0 +1,139 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __CHECKPOINT_HPP__
+#define __CHECKPOINT_HPP__
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "PrintMacros.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+/*
+ * Raw binary helpers for MultiChannelMemorySystem::saveCheckpoint()/loadCheckpoint().
+ * Every simulator object writes its own fields with ckptWrite() in saveState() and reads
+ * them back in the same order with ckptRead() in loadState(). Containers are prefixed with
+ * their size; on restore the size must match the one built from the ini files, except for
+ * ckptReadResize() which is meant for lists that grow at run time.
+ */
+template <typename T>
+inline void ckptWrite(ostream& out, const T& val)
+{
+    out.write(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+template <typename T>
+inline void ckptRead(istream& in, T& val)
+{
+    in.read(reinterpret_cast<char*>(&val), sizeof(T));
+}
+
+inline void ckptCheckSize(istream& in, uint64_t expected)
+{
+    uint64_t size = 0;
+    ckptRead(in, size);
+    if (!in || size != expected)
+    {
+        ERROR("== Error - checkpoint does not match the configured geometry (size "
+              << size << ", expected " << expected << ")");
+        exit(-1);
+    }
+}
+
+template <typename T>
+inline void ckptWrite(ostream& out, const vector<T>& vec)
+{
+    ckptWrite(out, static_cast<uint64_t>(vec.size()));
+    for (auto& val : vec) ckptWrite(out, val);
+}
+
+template <typename T>
+inline void ckptRead(istream& in, vector<T>& vec)
+{
+    ckptCheckSize(in, vec.size());
+    for (auto& val : vec) ckptRead(in, val);
+}
+
+inline void ckptWrite(ostream& out, const vector<bool>& vec)
+{
+    ckptWrite(out, static_cast<uint64_t>(vec.size()));
+    for (bool val : vec) ckptWrite(out, static_cast<uint8_t>(val));
+}
+
+inline void ckptRead(istream& in, vector<bool>& vec)
+{
+    ckptCheckSize(in, vec.size());
+    for (size_t i = 0; i < vec.size(); i++)
+    {
+        uint8_t val = 0;
+        ckptRead(in, val);
+        vec[i] = val;
+    }
+}
+
+template <typename T>
+inline void ckptReadResize(istream& in, vector<T>& vec)
+{
+    uint64_t size = 0;
+    ckptRead(in, size);
+    vec.resize(size);
+    for (auto& val : vec) ckptRead(in, val);
+}
+
+inline void ckptReadResize(istream& in, vector<bool>& vec)
+{
+    uint64_t size = 0;
+    ckptRead(in, size);
+    vec.resize(size);
+    for (size_t i = 0; i < vec.size(); i++)
+    {
+        uint8_t val = 0;
+        ckptRead(in, val);
+        vec[i] = val;
+    }
+}
+
+template <typename K, typename V>
+inline void ckptWrite(ostream& out, const map<K, V>& m)
+{
+    ckptWrite(out, static_cast<uint64_t>(m.size()));
+    for (auto& it : m)
+    {
+        ckptWrite(out, it.first);
+        ckptWrite(out, it.second);
+    }
+}
+
+template <typename K, typename V>
+inline void ckptRead(istream& in, map<K, V>& m)
+{
+    uint64_t size = 0;
+    ckptRead(in, size);
+    m.clear();
+    for (uint64_t i = 0; i < size; i++)
+    {
+        K key;
+        V val;
+        ckptRead(in, key);
+        ckptRead(in, val);
+        m[key] = val;
+    }
+}
+}  // namespace DRAMSim
+
+#endif
@@ -0,0 +1,293 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#include <cstring>
+
+#include "CmdTrace.h"
+#include "PIMCmd.h"
+#include "SystemConfiguration.h"
+
+namespace DRAMSim
+{
+/*
+ * File layout: header, records, tag table, then the offset of the tag table in the last 8 bytes
+ * so the decoder finds it without knowing the number of records.
+ */
+static const char TRACE_MAGIC[8] = {'P', 'I', 'M', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t TRACE_VERSION = 1;
+
+struct CmdTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+};
+
+enum CmdTraceLayout
+{
+    LAYOUT_ALL,        // ch ra bg b r c
+    LAYOUT_CH_RA,      // ch ra
+    LAYOUT_PRECHARGE,  // ch ra bg b r(open row)
+    LAYOUT_GRF_A,      // ch ra pb reg
+    LAYOUT_GRF_B,
+    LAYOUT_B_GRF_A,  // ch ra reg
+    LAYOUT_B_GRF_B,
+    LAYOUT_B_CRF,  // ch ra idx
+    LAYOUT_PIM     // ch ra bg b r c || [pc] cmd
+};
+
+static const struct
+{
+    const char* name;
+    CmdTraceLayout layout;
+    bool hasTag;
+} eventInfo[TRACE_EVENT_MAX] = {
+    {"READ", LAYOUT_ALL, false},
+    {"WRITE", LAYOUT_ALL, false},
+    {"ACTIVATE", LAYOUT_ALL, true},
+    {"PRECHARGE", LAYOUT_PRECHARGE, false},
+    {"REF", LAYOUT_CH_RA, false},
+    {"SB mode", LAYOUT_CH_RA, false},
+    {"HAB", LAYOUT_CH_RA, true},
+    {"HAB mode", LAYOUT_CH_RA, false},
+    {"HAB_PIM", LAYOUT_CH_RA, false},
+    {"BANK_TO_PIM", LAYOUT_ALL, false},
+    {"PIM_TO_BANK", LAYOUT_ALL, false},
+    {"GRF_A_ZEROIZE", LAYOUT_CH_RA, false},
+    {"GRF_B_ZEROIZE", LAYOUT_CH_RA, false},
+    {"GRF_ZEROIZE", LAYOUT_CH_RA, false},
+    {"READ_GRF_A", LAYOUT_GRF_A, false},
+    {"READ_GRF_B", LAYOUT_GRF_B, false},
+    {"READ_GRF_B", LAYOUT_B_GRF_B, false},
+    {"BWRITE_GRF_A", LAYOUT_B_GRF_A, false},
+    {"BWRITE_GRF_B", LAYOUT_B_GRF_B, false},
+    {"BWRITE_CRF", LAYOUT_B_CRF, false},
+    {"BWRITE_SRF", LAYOUT_CH_RA, false},
+    {"READ", LAYOUT_PIM, false},
+    {"WRITE", LAYOUT_PIM, false},
+    {"BWRITE_LUT", LAYOUT_CH_RA, false},
+};
+
+CmdTraceSink::CmdTraceSink()
+    : enabled_(false), file_(NULL), simLog_(NULL), numBuffered_(0), numRecords_(0)
+{
+    // tag id 0 is the empty tag
+    tags_.push_back("");
+    tagIds_[""] = 0;
+}
+
+CmdTraceSink::~CmdTraceSink()
+{
+    close();
+}
+
+void CmdTraceSink::open(const string& path, ostream& simLog)
+{
+    close();
+    simLog_ = &simLog;
+    if (path.empty())
+    {
+        // nothing would be printed anyway
+        enabled_ = SHOW_SIM_OUTPUT;
+        return;
+    }
+
+    file_ = fopen(path.c_str(), "wb");
+    if (file_ == NULL)
+    {
+        ERROR("Can't open command trace file " << path);
+        exit(-1);
+    }
+    CmdTraceHeader header;
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(CmdTraceRecord);
+    fwrite(&header, sizeof(header), 1, file_);
+    buffer_.resize(BUFFER_RECORDS);
+    enabled_ = true;
+}
+
+void CmdTraceSink::close()
+{
+    if (file_ != NULL)
+    {
+        flush();
+        uint64_t tagOffset = ftell(file_);
+        uint32_t numTags = tags_.size();
+        fwrite(&numTags, sizeof(numTags), 1, file_);
+        for (auto& tag : tags_)
+        {
+            uint32_t len = tag.size();
+            fwrite(&len, sizeof(len), 1, file_);
+            fwrite(tag.data(), 1, len, file_);
+        }
+        fwrite(&tagOffset, sizeof(tagOffset), 1, file_);
+        fclose(file_);
+        file_ = NULL;
+    }
+    enabled_ = false;
+}
+
+void CmdTraceSink::flush()
+{
+    if (numBuffered_ > 0)
+        fwrite(buffer_.data(), sizeof(CmdTraceRecord), numBuffered_, file_);
+    numBuffered_ = 0;
+}
+
+uint32_t CmdTraceSink::internTag(const string& tag)
+{
+    if (tag.empty())
+        return 0;
+    auto it = tagIds_.find(tag);
+    if (it != tagIds_.end())
+        return it->second;
+    uint32_t id = tags_.size();
+    tags_.push_back(tag);
+    tagIds_[tag] = id;
+    return id;
+}
+
+void CmdTraceSink::record(CmdTraceEvent event, uint64_t cycle, unsigned chan, unsigned rank,
+                          unsigned bankGroup, unsigned bank, unsigned row, unsigned column,
+                          uint32_t arg, unsigned pimPC)
+{
+    CmdTraceRecord rec;
+    rec.cycle = cycle;
+    rec.row = row;
+    rec.arg = arg;
+    rec.chan = chan;
+    rec.column = column;
+    rec.pimPC = pimPC;
+    rec.event = event;
+    rec.rank = rank;
+    rec.bankGroup = bankGroup;
+    rec.bank = bank;
+    memset(rec.reserved, 0, sizeof(rec.reserved));
+    numRecords_++;
+
+    if (file_ == NULL)
+    {
+        ostream& dramsimLog = *simLog_;
+        if (LOG_OUTPUT)
+        {
+            format(dramsimLog, rec, tags_[eventInfo[event].hasTag ? arg : 0]);
+            dramsimLog << endl;
+        }
+        else
+        {
+            format(cout, rec, tags_[eventInfo[event].hasTag ? arg : 0]);
+            cout << endl;
+        }
+        return;
+    }
+
+    buffer_[numBuffered_++] = rec;
+    if (numBuffered_ == BUFFER_RECORDS)
+        flush();
+}
+
+void CmdTraceSink::format(ostream& out, const CmdTraceRecord& rec, const string& tag)
+{
+    const auto& info = eventInfo[rec.event];
+    out << info.name << " ch" << rec.chan << " ra" << (unsigned)rec.rank;
+    switch (info.layout)
+    {
+        case LAYOUT_ALL:
+        case LAYOUT_PIM:
+            out << " bg" << (unsigned)rec.bankGroup << " b" << (unsigned)rec.bank << " r"
+                << rec.row << " c" << rec.column;
+            break;
+        case LAYOUT_PRECHARGE:
+            out << " bg" << (unsigned)rec.bankGroup << " b" << (unsigned)rec.bank << " r"
+                << rec.row;
+            break;
+        case LAYOUT_GRF_A:
+            out << " pb" << rec.bank / 2 << " reg" << (int)rec.column - 0x8;
+            break;
+        case LAYOUT_GRF_B:
+            out << " pb" << rec.bank / 2 << " reg" << (int)rec.column - 0x18;
+            break;
+        case LAYOUT_B_GRF_A:
+            out << " reg" << (int)rec.column - 0x8;
+            break;
+        case LAYOUT_B_GRF_B:
+            out << " reg" << (int)rec.column - 0x18;
+            break;
+        case LAYOUT_B_CRF:
+            out << " idx" << (int)rec.column - 0x4;
+            break;
+        case LAYOUT_CH_RA:
+            break;
+    }
+
+    if (info.layout == LAYOUT_PIM)
+    {
+        PIMCmd cmd;
+        cmd.fromInt(rec.arg);
+        out << "|| [" << rec.pimPC << "] " << cmd.toStr() << " @ " << rec.cycle;
+        return;
+    }
+    out << " @" << rec.cycle;
+    if (info.hasTag)
+        out << " tag : " << tag;
+}
+
+bool decodeCmdTrace(const string& path, ostream& out)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL)
+    {
+        ERROR("Can't open command trace file " << path);
+        return false;
+    }
+
+    CmdTraceHeader header;
+    uint64_t tagOffset;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) == 0 &&
+              header.version == TRACE_VERSION && header.recordSize == sizeof(CmdTraceRecord) &&
+              fseek(file, -(long)sizeof(tagOffset), SEEK_END) == 0 &&
+              fread(&tagOffset, sizeof(tagOffset), 1, file) == 1 &&
+              fseek(file, tagOffset, SEEK_SET) == 0;
+
+    vector<string> tags;
+    uint32_t numTags = 0;
+    ok = ok && fread(&numTags, sizeof(numTags), 1, file) == 1;
+    for (uint32_t i = 0; ok && i < numTags; i++)
+    {
+        uint32_t len;
+        ok = fread(&len, sizeof(len), 1, file) == 1;
+        string tag(len, '\0');
+        ok = ok && (len == 0 || fread(&tag[0], 1, len, file) == len);
+        tags.push_back(tag);
+    }
+
+    uint64_t numRecords = (tagOffset - sizeof(header)) / sizeof(CmdTraceRecord);
+    ok = ok && fseek(file, sizeof(header), SEEK_SET) == 0;
+    CmdTraceRecord rec;
+    for (uint64_t i = 0; ok && i < numRecords; i++)
+    {
+        ok = fread(&rec, sizeof(rec), 1, file) == 1 && rec.event < TRACE_EVENT_MAX;
+        if (!ok)
+            break;
+        uint32_t tagId = eventInfo[rec.event].hasTag ? rec.arg : 0;
+        CmdTraceSink::format(out, rec, tagId < tags.size() ? tags[tagId] : "");
+        out << endl;
+    }
+    fclose(file);
+
+    if (!ok)
+        ERROR("Corrupted command trace file " << path);
+    return ok;
+}
+}  // namespace DRAMSim
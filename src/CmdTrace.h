@@ -0,0 +1,146 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __CMD_TRACE_HPP__
+#define __CMD_TRACE_HPP__
+
+#include <stdint.h>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace DRAMSim
+{
+/*
+ * Command trace (DEBUG_CMD_TRACE).
+ *
+ * Rank and PIMRank log the commands they execute as fixed-size binary records instead of
+ * formatting text on the spot. Each channel owns one CmdTraceSink, and only the thread stepping
+ * that channel writes to it, so recording is a store into a buffer with no lock.
+ *
+ * - CMD_TRACE_FILE set: records go to <CMD_TRACE_FILE>.ch<N>. Decode the file offline with
+ *   decodeCmdTrace(), or run "sim --decode-cmd-trace=<file>".
+ * - CMD_TRACE_FILE empty: each record is rendered right away and printed to the sim output
+ *   (SHOW_SIM_OUTPUT / LOG_OUTPUT), as before.
+ *
+ * Building with -DNO_CMD_TRACE (scons NO_CMD_TRACE=1) removes the call sites.
+ */
+enum CmdTraceEvent : uint8_t
+{
+    TRACE_READ,
+    TRACE_WRITE,
+    TRACE_ACTIVATE,
+    TRACE_PRECHARGE,
+    TRACE_REF,
+    TRACE_SB_MODE,
+    TRACE_HAB,
+    TRACE_HAB_MODE,
+    TRACE_HAB_PIM,
+    TRACE_BANK_TO_PIM,
+    TRACE_PIM_TO_BANK,
+    TRACE_GRF_A_ZEROIZE,
+    TRACE_GRF_B_ZEROIZE,
+    TRACE_GRF_ZEROIZE,
+    TRACE_READ_GRF_A,
+    TRACE_READ_GRF_B,
+    TRACE_READ_SBLOCK_GRF_B,
+    TRACE_BWRITE_GRF_A,
+    TRACE_BWRITE_GRF_B,
+    TRACE_BWRITE_CRF,
+    TRACE_BWRITE_SRF,
+    TRACE_PIM_READ,
+    TRACE_PIM_WRITE,
+    TRACE_BWRITE_LUT,  // after the PIM events so that older trace files keep their event ids
+    TRACE_EVENT_MAX
+};
+
+struct CmdTraceRecord
+{
+    uint64_t cycle;
+    uint32_t row;
+    uint32_t arg;  // tag id (ACTIVATE, HAB) or CRF command (PIM_READ/PIM_WRITE)
+    uint16_t chan;
+    uint16_t column;
+    uint16_t pimPC;
+    uint8_t event;
+    uint8_t rank;
+    uint8_t bankGroup;
+    uint8_t bank;
+    uint8_t reserved[6];
+};
+static_assert(sizeof(CmdTraceRecord) == 32, "trace records are 32 bytes");
+
+class CmdTraceSink
+{
+  public:
+    CmdTraceSink();
+    ~CmdTraceSink();
+
+    // binary output to path, or text to simLog when path is empty
+    void open(const string& path, ostream& simLog);
+    void close();
+
+    bool isEnabled() const
+    {
+        return enabled_;
+    }
+
+    void record(CmdTraceEvent event, uint64_t cycle, unsigned chan, unsigned rank,
+                unsigned bankGroup, unsigned bank, unsigned row, unsigned column,
+                uint32_t arg = 0, unsigned pimPC = 0);
+    uint32_t internTag(const string& tag);
+    uint64_t getNumRecords() const
+    {
+        return numRecords_;
+    }
+
+    static void format(ostream& out, const CmdTraceRecord& rec, const string& tag);
+
+  private:
+    void flush();
+
+    static const size_t BUFFER_RECORDS = 4096;
+
+    bool enabled_;
+    FILE* file_;
+    ostream* simLog_;
+    vector<CmdTraceRecord> buffer_;
+    size_t numBuffered_;
+    uint64_t numRecords_;
+    vector<string> tags_;
+    unordered_map<string, uint32_t> tagIds_;
+};
+
+// renders a binary trace file written by CmdTraceSink as text, false if it can't be read
+bool decodeCmdTrace(const string& path, ostream& out);
+
+#ifdef NO_CMD_TRACE
+#define CMD_TRACE(sink, ...) \
+    do                       \
+    {                        \
+    } while (0)
+#else
+#define CMD_TRACE(sink, ...)                            \
+    do                                                  \
+    {                                                   \
+        if ((sink) != NULL && (sink)->isEnabled())      \
+            (sink)->record(__VA_ARGS__);                \
+    } while (0)
+#endif
+}  // namespace DRAMSim
+
+#endif
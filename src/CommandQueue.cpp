@@ -30,7 +30,10 @@
 
 #include <assert.h>
 
+#include <algorithm>
+
 #include "AddressMapping.h"
+#include "Checkpoint.h"
 #include "CommandQueue.h"
 #include "MemoryController.h"
 
@@ -42,10 +45,13 @@ CommandQueue::CommandQueue(vector<vector<BankState>>& states, ostream& simLog)
       bankStates_sub(emptyBankStatesSub),
       nextBank(0),
       nextRank(0),
+      nextSub(0),
       nextBankPRE(0),
       nextRankPRE(0),
+      nextSubPRE(0),
       refreshRank(0),
       refreshBank(0),
+      refreshSub(0),
       refreshWaiting(false),
       sendAct(true)
 {
@@ -60,6 +66,8 @@ CommandQueue::CommandQueue(vector<vector<BankState>>& states, ostream& simLog)
     cmd_queue_depth_ = getConfigParam(UINT, "CMD_QUEUE_DEPTH");
     xaw_ = getConfigParam(UINT, "XAW");
     total_row_accesses_ = getConfigParam(UINT, "TOTAL_ROW_ACCESSES");
+    row_buffer_timeout_ = getConfigParam(UINT, "ROW_BUFFER_TIMEOUT");
+    rowBufferPolicy_ = PIMConfiguration::getRowBufferPolicy();
     schedulingPolicy_ = PIMConfiguration::getSchedulingPolicy();
     queuingStructure_ = PIMConfiguration::getQueueingStructure();
 
@@ -82,6 +90,14 @@ CommandQueue::CommandQueue(vector<vector<BankState>>& states, ostream& simLog)
 
     // vector of counters used to ensure rows don't stay open too long
     rowAccessCounters = vector<vector<unsigned>>(num_ranks_, vector<unsigned>(num_banks_, 0));
+    rowHitPending = vector<vector<bool>>(num_ranks_, vector<bool>(num_banks_, false));
+    rowConflictWaiting = rowHitPending;
+    rowCmdClaimed = rowHitPending;
+    bankQueues = BusPacket3D(num_ranks_, BusPacket2D(num_banks_));
+    queuedBarriers = vector<unsigned>(num_ranks_, 0);
+    bankReady = vector<vector<bool>>(num_ranks_, vector<bool>(num_banks_, true));
+    lastColumnCycle = vector<vector<uint64_t>>(num_ranks_, vector<uint64_t>(num_banks_, 0));
+    useBankIndex = getConfigParam(BOOL, "CMD_QUEUE_BANK_INDEX");
     commandCounters.reserve(cmd_queue_depth_);
     processedCommands.reserve(cmd_queue_depth_);
     commandCounters.clear();
@@ -102,6 +118,8 @@ CommandQueue::CommandQueue(vector<vector<BankState>>& states, ostream& simLog)
         }
         queues.push_back(perBankQueue);
     }
+    barriers = vector<vector<vector<bool>>>(num_ranks_, vector<vector<bool>>(numBankQueues));
+    queuedBanks = vector<vector<vector<unsigned>>>(num_ranks_, vector<vector<unsigned>>(numBankQueues));
 
     // X-bank activation window
     //    this will count the number of activations within a given window
@@ -142,6 +160,8 @@ CommandQueue::CommandQueue(vector<vector<BankState>>& states, ostream& simLog, b
     cmd_queue_depth_ = getConfigParam(UINT, "CMD_QUEUE_DEPTH");
     xaw_ = getConfigParam(UINT, "XAW");
     total_row_accesses_ = getConfigParam(UINT, "TOTAL_ROW_ACCESSES");
+    row_buffer_timeout_ = getConfigParam(UINT, "ROW_BUFFER_TIMEOUT");
+    rowBufferPolicy_ = PIMConfiguration::getRowBufferPolicy();
     schedulingPolicy_ = PIMConfiguration::getSchedulingPolicy();
     queuingStructure_ = PIMConfiguration::getQueueingStructure();
 
@@ -210,16 +230,10 @@ CommandQueue::CommandQueue(vector<vector<BankState>>& states, ostream& simLog, b
 CommandQueue::~CommandQueue()
 {
     // ERROR("COMMAND QUEUE destructor");
-    size_t bankMax = num_ranks_;
-    size_t subarrayMax = 4;
-    if (queuingStructure_ == PerRank)
+    // walk the queues that were actually built, queues_sub is empty unless is_salp
+    for (size_t r = 0; r < queues.size(); r++)
     {
-        bankMax = 1;
-        subarrayMax = 1;
-    }
-    for (size_t r = 0; r < num_ranks_; r++)
-    {
-        for (size_t b = 0; b < bankMax; b++)
+        for (size_t b = 0; b < queues[r].size(); b++)
         {
             for (size_t i = 0; i < queues[r][b].size(); i++)
             {
@@ -227,7 +241,14 @@ CommandQueue::~CommandQueue()
                 delete (queues[r][b][i]);
                 
             }    
-            for (size_t s = 0; s< subarrayMax; s++)
+            queues[r][b].clear();
+        }
+    }
+    for (size_t r = 0; r < queues_sub.size(); r++)
+    {
+        for (size_t b = 0; b < queues_sub[r].size(); b++)
+        {
+            for (size_t s = 0; s < queues_sub[r][b].size(); s++)
             {
                 for(size_t j = 0; j < queues_sub[r][b][s].size(); j++)
                 {
@@ -236,7 +257,6 @@ CommandQueue::~CommandQueue()
                 }
                 queues_sub[r][b][s].clear();
             }        
-            queues[r][b].clear();
             queues_sub[r][b].clear();
         }
     }
@@ -258,6 +278,7 @@ void CommandQueue::enqueue(BusPacket* newBusPacket)
                 queues[rank][0].reserve(queues[rank][0].size() + 64);
             }
             queues[rank][0].push_back(newBusPacket);
+            indexPacket(newBusPacket, 0);
             //if(newBusPacket->chan!=0) cout<<"[commandqueue] enqueue: cycle is "<<currentClockCycle<<" and chan is "<<newBusPacket->chan<<endl;
             //commandCounters.push_back(0);
             //processedCommands.push_back(false);
@@ -275,6 +296,7 @@ void CommandQueue::enqueue(BusPacket* newBusPacket)
     else if (queuingStructure_ == PerRankPerBank)
     {
         queues[rank][bank].push_back(newBusPacket);
+        indexPacket(newBusPacket, bank);
         if (queues[rank][bank].size() > cmd_queue_depth_)
         {
             ERROR("== Error - Enqueued more than allowed in command queue");
@@ -348,6 +370,13 @@ bool CommandQueue::process_refresh(BusPacket** busPacket) //it's buspacket for c
                     //*busPacket = nullptr;
                 }
             }
+            // an auto-precharge still waits out tRTP/tWR with its row open
+            else if (bankStates[refreshRank][b].currentBankState == Precharging &&
+                     (bankStates[refreshRank][b].lastCommand == READ ||
+                      bankStates[refreshRank][b].lastCommand == WRITE))
+            {
+                sendREF = false;
+            }
         }
         if (sendREF)
         {
@@ -417,21 +446,28 @@ bool CommandQueue::process_refresh_sub(BusPacket** busPacket)
 }
 bool CommandQueue::process_command(BusPacket** busPacket)
 {
+    if (schedulingPolicy_ == FrFcfs || schedulingPolicy_ == FrFcfsCap)
+        return process_command_frfcfs(busPacket);
+
     unsigned startingRank = nextRank;
     unsigned startingBank = nextBank;
     // if(refreshWaiting)
     //         return false;
     do
     {
-        vector<BusPacket*>& queue = getCommandQueue(nextRank, nextBank);
+        unsigned queueIndex = queuingStructure_ == PerRankPerBank ? nextBank : 0;
+        vector<BusPacket*>& queue = queues[nextRank][queueIndex];
+        vector<bool>& barrier = barriers[nextRank][queueIndex];
+        vector<unsigned>& banks = queuedBanks[nextRank][queueIndex];
         for (size_t i = 0; i < queue.size(); i++)
         {
             if(queue[i]!=nullptr)
             {
                 BusPacket* packet = queue[i];
-                if (isIssuable(packet))
+                // the bank is cached next to the queue so unready banks cost no packet access
+                if (bankReady[nextRank][banks[i]] && isIssuable(packet))
                 {
-                    if (i != 0 && queue[i]->tag.find("BAR", 0) != std::string::npos)
+                    if (i != 0 && barrier[i])
                     {
                         break;
                     }
@@ -442,13 +478,13 @@ bool CommandQueue::process_command(BusPacket** busPacket)
                         {
                             if(queue[j]!=nullptr)
                             {
-                                if (queue[i]->bank == queue[j]->bank && queue[i]->row == queue[j]->row &&
+                                if (banks[i] == banks[j] && queue[i]->row == queue[j]->row &&
                                     queue[i]->column == queue[j]->column)
                                 {
                                     depend = true;
                                     break;
                                 }
-                                if (queue[j]->tag.find("BAR", 0) != std::string::npos)
+                                if (barrier[j])
                                 {
                                     depend = true;
                                     break;
@@ -458,7 +494,7 @@ bool CommandQueue::process_command(BusPacket** busPacket)
                         if (!depend)
                         {
                             *busPacket = queue[i];
-                            queues[0][0].erase(queues[0][0].begin() + i);
+                            dequeue(nextRank, queueIndex, i);
                             return true;
                         }
                     }
@@ -474,16 +510,17 @@ bool CommandQueue::process_command(BusPacket** busPacket)
         {
             if(queue[i]!=nullptr)  
             {
-                if (i != 0 && queue[i]->tag.find("BAR", 0) != std::string::npos)
+                if (i != 0 && barrier[i])
                 {
                     break;
                 }
 
-                BusPacket* packet = queue[i];
                 //if(packet->rank <= num_ranks_ && packet->bank <= num_banks_)
                 //{
-                    if (bankStates[packet->rank][packet->bank].currentBankState == Idle) //activate command!
+                    if (bankReady[nextRank][banks[i]] &&
+                        bankStates[nextRank][banks[i]].currentBankState == Idle) //activate command!
                     {
+                        BusPacket* packet = queue[i];
                         *busPacket =
                             new BusPacket(ACTIVATE, packet->physicalAddress, packet->column, packet->row,
                                         packet->rank, packet->bank, nullptr, dramsimLog, packet->tag);
@@ -514,6 +551,233 @@ bool CommandQueue::process_command(BusPacket** busPacket)
     return false;
 }
 
+/*
+ * FR-FCFS over the queues of all ranks, starting from nextRank. Column commands that can issue
+ * this cycle go first, oldest first. Otherwise the oldest request of each bank gets its row
+ * command: ACT on an idle bank, PRE when it misses the open row. FrFcfs precharges as soon as no
+ * older request hits the row, so younger hits cannot starve it. FrFcfsCap keeps the row open for
+ * every queued hit, but only for TOTAL_ROW_ACCESSES column commands after the activate once a
+ * conflicting request waits (isRowCapped). The scheduler never looks past a barrier.
+ */
+bool CommandQueue::process_command_frfcfs(BusPacket** busPacket)
+{
+    for (size_t r = 0; r < num_ranks_; r++)
+    {
+        fill(rowHitPending[r].begin(), rowHitPending[r].end(), false);
+        fill(rowConflictWaiting[r].begin(), rowConflictWaiting[r].end(), false);
+        fill(rowCmdClaimed[r].begin(), rowCmdClaimed[r].end(), false);
+    }
+    if (schedulingPolicy_ == FrFcfsCap)
+    {
+        for (size_t r = 0; r < queues.size(); r++)
+        {
+            for (size_t q = 0; q < queues[r].size(); q++)
+            {
+                vector<BusPacket*>& queue = queues[r][q];
+                size_t depth = schedulableDepth(barriers[r][q]);
+                for (size_t i = 0; i < depth; i++)
+                {
+                    BankState& state = bankStates[queue[i]->rank][queue[i]->bank];
+                    if (state.currentBankState != RowActive)
+                        continue;
+                    if (queue[i]->row == state.openRowAddress)
+                        rowHitPending[queue[i]->rank][queue[i]->bank] = true;
+                    else
+                        rowConflictWaiting[queue[i]->rank][queue[i]->bank] = true;
+                }
+            }
+        }
+    }
+
+    for (size_t n = 0; n < num_ranks_; n++)
+    {
+        unsigned rank = (nextRank + n) % num_ranks_;
+        for (size_t q = 0; q < queues[rank].size(); q++)
+        {
+            vector<BusPacket*>& queue = queues[rank][q];
+            size_t depth = schedulableDepth(barriers[rank][q]);
+            for (size_t i = 0; i < depth; i++)
+            {
+                if (!bankReady[rank][queuedBanks[rank][q][i]])
+                    continue;
+                BusPacket* packet = queue[i];
+                if (!isIssuable(packet))
+                    continue;
+                bool depend = false;
+                for (size_t j = 0; j < i; j++)
+                {
+                    if (packet->bank == queue[j]->bank && packet->row == queue[j]->row &&
+                        packet->column == queue[j]->column)
+                    {
+                        depend = true;
+                        break;
+                    }
+                }
+                if (!depend)
+                {
+                    *busPacket = packet;
+                    dequeue(rank, q, i);
+                    nextRank = (rank + 1) % num_ranks_;
+                    return true;
+                }
+            }
+        }
+    }
+
+    for (size_t n = 0; n < num_ranks_; n++)
+    {
+        unsigned rank = (nextRank + n) % num_ranks_;
+        for (size_t q = 0; q < queues[rank].size(); q++)
+        {
+            vector<BusPacket*>& queue = queues[rank][q];
+            size_t depth = schedulableDepth(barriers[rank][q]);
+            for (size_t i = 0; i < depth; i++)
+            {
+                if (!bankReady[rank][queuedBanks[rank][q][i]])
+                    continue;
+                BusPacket* packet = queue[i];
+                BankState& state = bankStates[packet->rank][packet->bank];
+                // a capped row is held for its conflict, not for its older hits
+                if (state.currentBankState == RowActive && packet->row == state.openRowAddress &&
+                    isRowCapped(packet->rank, packet->bank))
+                    continue;
+                if (rowCmdClaimed[packet->rank][packet->bank])
+                    continue;
+                rowCmdClaimed[packet->rank][packet->bank] = true;
+
+                if (state.currentBankState == Idle)
+                {
+                    *busPacket = new BusPacket(ACTIVATE, packet->physicalAddress, packet->column,
+                                               packet->row, packet->rank, packet->bank, nullptr,
+                                               dramsimLog, packet->tag);
+                }
+                else if (state.currentBankState == RowActive && packet->row != state.openRowAddress &&
+                         (schedulingPolicy_ == FrFcfs || !rowHitPending[packet->rank][packet->bank] ||
+                          isRowCapped(packet->rank, packet->bank)))
+                {
+                    *busPacket = new BusPacket(PRECHARGE, 0, 0, state.openRowAddress, packet->rank,
+                                               packet->bank, nullptr, dramsimLog);
+                }
+                else
+                {
+                    continue;
+                }
+                if (isIssuable(*busPacket))
+                {
+                    nextRank = (rank + 1) % num_ranks_;
+                    return true;
+                }
+                delete *busPacket;
+            }
+        }
+    }
+    return false;
+}
+
+// number of packets at the head of a queue the scheduler may pick from: a barrier-tagged packet
+// only issues from the head and holds back everything behind it
+size_t CommandQueue::schedulableDepth(vector<bool>& barrier)
+{
+    for (size_t i = 0; i < barrier.size(); i++)
+    {
+        if (barrier[i])
+            return (i == 0) ? 1 : i;
+    }
+    return barrier.size();
+}
+
+bool CommandQueue::isRowCapped(unsigned rank, unsigned bank)
+{
+    return rowConflictWaiting[rank][bank] && rowAccessCounters[rank][bank] >= total_row_accesses_;
+}
+
+/*
+ * ClosePage: a READ/WRITE auto-precharges its row when no other queued request hits the row.
+ * Only untagged single-bank-mode commands do, the PIM mode changes and all-bank commands keep
+ * their explicit precharges.
+ */
+bool CommandQueue::closesRow(BusPacket* packet)
+{
+    if (rowBufferPolicy_ != ClosePage || !packet->tag.empty() ||
+        (*ranks)[packet->rank]->mode_ != dramMode::SB)
+        return false;
+    for (auto queued : bankQueues[packet->rank][packet->bank])
+    {
+        if (queued->row == packet->row)
+            return false;
+    }
+    return true;
+}
+
+// earliest cycle process_precharge may close the open row of a bank no queued request hits;
+// AdaptivePage keeps it open for ROW_BUFFER_TIMEOUT cycles after its last access unless a
+// conflicting request waits; the timeout is fixed, it does not learn from past row hits
+uint64_t CommandQueue::rowCloseCycle(unsigned rank, unsigned bank)
+{
+    BankState& state = bankStates[rank][bank];
+    if (rowBufferPolicy_ == AdaptivePage && bankQueues[rank][bank].empty())
+        return max(state.nextPrecharge, lastColumnCycle[rank][bank] + row_buffer_timeout_);
+    return state.nextPrecharge;
+}
+
+// tags do not change once a packet is queued, so its barrier flag is worked out here only once
+void CommandQueue::indexPacket(BusPacket* packet, unsigned queueIndex)
+{
+    vector<bool>& barrier = barriers[packet->rank][queueIndex];
+    barrier.push_back(packet->tag.find("BAR", 0) != std::string::npos);
+    queuedBarriers[packet->rank] += barrier.back();
+    queuedBanks[packet->rank][queueIndex].push_back(packet->bank);
+    bankQueues[packet->rank][packet->bank].push_back(packet);
+}
+
+void CommandQueue::dequeue(unsigned rank, unsigned queueIndex, size_t index)
+{
+    vector<BusPacket*>& queue = queues[rank][queueIndex];
+    vector<bool>& barrier = barriers[rank][queueIndex];
+    vector<unsigned>& banks = queuedBanks[rank][queueIndex];
+    BusPacket* packet = queue[index];
+    BusPacket1D& bankQueue = bankQueues[packet->rank][packet->bank];
+    bankQueue.erase(find(bankQueue.begin(), bankQueue.end(), packet));
+    queuedBarriers[packet->rank] -= barrier[index];
+    queue.erase(queue.begin() + index);
+    barrier.erase(barrier.begin() + index);
+    banks.erase(banks.begin() + index);
+}
+
+/*
+ * Keys every bank with the earliest cycle any of its commands can meet the BankState timing:
+ * CAS or PRE on an open row with queued requests, ACT on an idle one (unless tXAW or the PIM mode
+ * rule it out for the whole cycle), PRE on an open row nobody waits for. The scans of
+ * process_command and process_precharge only look at banks whose key has passed, and pop() skips
+ * them altogether when no bank is ready. The keys are rebuilt from BankState each cycle, so they
+ * follow the timers the controller and Rank move without hooks.
+ */
+bool CommandQueue::updateReadyBanks()
+{
+    bool anyReady = false;
+    for (size_t r = 0; r < num_ranks_; r++)
+    {
+        bool xawFull = tXAWCountdown[r].size() >= xaw_;
+        bool pimMode = (*ranks)[r]->mode_ != dramMode::SB;
+        for (size_t b = 0; b < num_banks_; b++)
+        {
+            BankState& state = bankStates[r][b];
+            uint64_t key = UINT64_MAX;
+            if (!useBankIndex)
+                key = 0;
+            else if (state.currentBankState == RowActive)
+                key = !bankQueues[r][b].empty() ? min({state.nextRead, state.nextWrite, state.nextPrecharge})
+                                       : rowCloseCycle(r, b);
+            else if ((state.currentBankState == Idle || state.currentBankState == Refreshing) &&
+                     !bankQueues[r][b].empty() && !xawFull && !(pimMode && b >= 2))
+                key = state.nextActivate;
+            bankReady[r][b] = (key <= currentClockCycle);
+            anyReady = anyReady || bankReady[r][b];
+        }
+    }
+    return anyReady;
+}
+
 bool CommandQueue::process_command_sub(BusPacket** busPacket)
 {
     unsigned startingRank = nextRank;
@@ -629,29 +893,41 @@ bool CommandQueue::process_precharge(BusPacket** busPacket)
     //for this logic nextbankpre is constrained to 0..
     do
     {
+        // an open row whose tRAS/tRTP/tWR (or row buffer timeout) has not passed cannot be closed
+        if (!bankReady[nextRankPRE][nextBankPRE] ||
+            bankStates[nextRankPRE][nextBankPRE].currentBankState != RowActive ||
+            rowCloseCycle(nextRankPRE, nextBankPRE) > currentClockCycle)
+        {
+            nextRankAndBank(nextRankPRE, nextBankPRE);
+            continue;
+        }
         bool found = false;
-        vector<BusPacket*>& queue = getCommandQueue(nextRankPRE, nextBankPRE);
-        for (auto it = queues[0][0].begin(); it != queues[0][0].end(); it++)
+        unsigned openRow = bankStates[nextRankPRE][nextBankPRE].openRowAddress;
+        // only a queued request of this bank can keep its row open, the bank index has them all
+        // unless a barrier hides some of them
+        if (queuedBarriers[nextRankPRE] == 0)
         {
-            BusPacket* packet = *it;
-            auto index = it - queues[0][0].begin();
-            if(packet != nullptr)
+            for (auto packet : bankQueues[nextRankPRE][nextBankPRE])
             {
-                if(nextRankPRE == packet->rank && nextBankPRE == packet->bank &&
-                    bankStates[packet->rank][packet->bank].currentBankState == RowActive &&
-                    packet->row == bankStates[packet->rank][packet->bank].openRowAddress)
+                if (packet->row == openRow)
                 {
                     found = true;
                     break;
                 }
-                if (packet->tag.find("BAR", 0) != std::string::npos)
-                    break; 
             }
-            else
+        }
+        vector<BusPacket*>& queue = getCommandQueue(nextRankPRE, nextBankPRE);
+        vector<bool>& barrier = getBarrierFlags(nextRankPRE, nextBankPRE);
+        for (size_t i = 0; i < queue.size() && queuedBarriers[nextRankPRE] > 0; i++)
+        {
+            BusPacket* packet = queue[i];
+            if (nextRankPRE == packet->rank && nextBankPRE == packet->bank && packet->row == openRow)
             {
-                //*it = nullptr;
-                //queues[0][0].erase(queues[0][0].begin() + index);
+                found = true;
+                break;
             }
+            if (barrier[i])
+                break;
         }
         if (!found)
         {
@@ -738,16 +1014,20 @@ bool CommandQueue::pop(BusPacket** busPacket)
             tXAWCountdown[i].erase(tXAWCountdown[i].begin());
     }
 
-    if (process_refresh(busPacket))
-    {
-        return true;
-    }
-    else if (process_command(busPacket))
-    {
-        return true;
-    }
-    else if (process_precharge(busPacket))
+    bool anyReady = updateReadyBanks();
+    if (process_refresh(busPacket) ||
+        (anyReady && (process_command(busPacket) || process_precharge(busPacket))))
     {
+        // column commands since the last activate, see isRowCapped
+        BusPacket* packet = *busPacket;
+        if (packet->busPacketType == ACTIVATE)
+            rowAccessCounters[packet->rank][packet->bank] = 0;
+        else if (packet->busPacketType == READ || packet->busPacketType == WRITE)
+        {
+            rowAccessCounters[packet->rank][packet->bank]++;
+            lastColumnCycle[packet->rank][packet->bank] = currentClockCycle;
+            packet->autoPrecharge = closesRow(packet);
+        }
         return true;
     }
     else
@@ -815,7 +1095,7 @@ void CommandQueue::process_queue()
             {
                 if(commandCounters[i] >= 250)
                 {
-                    queues[0][0].erase(queues[0][0].begin() + i);
+                    dequeue(0, 0, i);
                     commandCounters.erase(commandCounters.begin() + i);
                 }
             }
@@ -917,6 +1197,12 @@ vector<BusPacket*>& CommandQueue::getCommandQueue(unsigned rank, unsigned bank)
     }
 }
 
+// barrier flags of the packets of getCommandQueue(rank, bank), index for index
+vector<bool>& CommandQueue::getBarrierFlags(unsigned rank, unsigned bank)
+{
+    return barriers[rank][queuingStructure_ == PerRankPerBank ? bank : 0];
+}
+
 vector<BusPacket*>& CommandQueue::getCommandQueue(unsigned rank, unsigned bank, unsigned sub)
 {
     if(queuingStructure_ == PerRankPerBankPerSubarray)
@@ -966,7 +1252,7 @@ bool CommandQueue::isIssuable(BusPacket* busPacket)
             if (bankStates[busPacket->rank][busPacket->bank].currentBankState == RowActive &&
                 currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextWrite &&
                 busPacket->row == bankStates[busPacket->rank][busPacket->bank].openRowAddress &&
-                rowAccessCounters[busPacket->rank][busPacket->bank] < total_row_accesses_)
+                !isRowCapped(busPacket->rank, busPacket->bank))
             {
                 return true;
             }
@@ -981,7 +1267,7 @@ bool CommandQueue::isIssuable(BusPacket* busPacket)
                 if (bankStates[busPacket->rank][busPacket->bank].currentBankState == RowActive &&
                     currentClockCycle >= bankStates[busPacket->rank][busPacket->bank].nextRead &&
                     busPacket->row == bankStates[busPacket->rank][busPacket->bank].openRowAddress &&
-                    rowAccessCounters[busPacket->rank][busPacket->bank] < total_row_accesses_)
+                    !isRowCapped(busPacket->rank, busPacket->bank))
                 {
                     return true;
                 }
@@ -1173,7 +1459,9 @@ void CommandQueue::needRefresh(unsigned rank)
 
 void CommandQueue::nextRankAndBank(unsigned& rank, unsigned& bank)
 {
-    if (schedulingPolicy_ == RankThenBankRoundRobin)
+    // the FR-FCFS policies only rotate the precharges of rows nobody waits for
+    if (schedulingPolicy_ == RankThenBankRoundRobin || schedulingPolicy_ == FrFcfs ||
+        schedulingPolicy_ == FrFcfsCap)
     {
         rank++;
         if (rank == num_ranks_)
@@ -1234,3 +1522,143 @@ void CommandQueue::update()
     // needed for SimulatorObject
     // TODO: make CommandQueue not a SimulatorObject
 }
+
+bool CommandQueue::isDrained()
+{
+    for (auto& rankQueues : queues)
+        for (auto& bankQueue : rankQueues)
+            if (!bankQueue.empty())
+                return false;
+    for (auto& rankQueues : queues_sub)
+        for (auto& bankQueues : rankQueues)
+            for (auto& subQueue : bankQueues)
+                if (!subQueue.empty())
+                    return false;
+    return true;
+}
+
+/*
+ * Earliest cycle at which pop() may issue a command. Until then pop() only counts down
+ * tXAWCountdown, so the caller may skip the cycles in between with fastForward().
+ * The bound is conservative: returning currentClockCycle just means "do not skip".
+ */
+uint64_t CommandQueue::nextEventCycle()
+{
+    if (refreshWaiting)
+        return currentClockCycle;
+
+    uint64_t next = UINT64_MAX;
+    // an idle queue still precharges every open row (see process_precharge)
+    for (size_t r = 0; r < num_ranks_; r++)
+    {
+        for (size_t b = 0; b < num_banks_; b++)
+        {
+            if (bankStates[r][b].currentBankState == RowActive)
+                next = min(next, rowCloseCycle(r, b));
+        }
+    }
+
+    for (auto& rankQueues : queues)
+    {
+        for (auto& bankQueue : rankQueues)
+        {
+            for (auto packet : bankQueue)
+            {
+                if (packet == nullptr)
+                    continue;
+                BankState& state = bankStates[packet->rank][packet->bank];
+                if (state.currentBankState == RowActive && state.openRowAddress == packet->row)
+                {
+                    next = min(next, packet->busPacketType == WRITE ? state.nextWrite
+                                                                   : state.nextRead);
+                }
+                else if (state.currentBankState == Idle || state.currentBankState == Refreshing)
+                {
+                    uint64_t activate = state.nextActivate;
+                    // head of tXAWCountdown is released by the pop() of its last cycle
+                    if (tXAWCountdown[packet->rank].size() >= xaw_)
+                        activate = max(activate,
+                                       currentClockCycle + tXAWCountdown[packet->rank][0] - 1);
+                    next = min(next, activate);
+                }
+            }
+        }
+    }
+    return max(next, currentClockCycle);
+}
+
+uint64_t CommandQueue::nextEventCycle_sub()
+{
+    if (refreshWaiting || !isDrained())
+        return currentClockCycle;
+
+    uint64_t next = UINT64_MAX;
+    for (auto& rankStates : bankStates_sub)
+    {
+        for (auto& state : rankStates)
+        {
+            if (state.currentBankState == RowActive)
+                next = min(next, state.nextPrecharge);
+        }
+    }
+    return max(next, currentClockCycle);
+}
+
+// skip cycles in which nothing can be issued, cycles must not go past nextEventCycle()
+void CommandQueue::fastForward(uint64_t cycles)
+{
+    for (auto& countdown : tXAWCountdown)
+    {
+        // entries are distinct and ascending, pop() retires one per cycle when it hits zero
+        while (!countdown.empty() && countdown[0] <= cycles) countdown.erase(countdown.begin());
+        for (auto& left : countdown) left -= cycles;
+    }
+    currentClockCycle += cycles;
+}
+
+// scheduler position and activation/row-access bookkeeping, the queues themselves must be
+// drained (see MultiChannelMemorySystem::saveCheckpoint)
+void CommandQueue::saveState(ostream& out)
+{
+    ckptWrite(out, currentClockCycle);
+    ckptWrite(out, nextBank);
+    ckptWrite(out, nextRank);
+    ckptWrite(out, nextSub);
+    ckptWrite(out, nextBankPRE);
+    ckptWrite(out, nextRankPRE);
+    ckptWrite(out, nextSubPRE);
+    ckptWrite(out, refreshRank);
+    ckptWrite(out, refreshBank);
+    ckptWrite(out, refreshSub);
+    ckptWrite(out, refreshWaiting);
+    ckptWrite(out, sendAct);
+    ckptWrite(out, commandCounters);
+    ckptWrite(out, processedCommands);
+    ckptWrite(out, tXAWCountdown);
+    ckptWrite(out, rowAccessCounters);
+    ckptWrite(out, rowAccessCounters_sub);
+    ckptWrite(out, lastColumnCycle);
+}
+
+void CommandQueue::loadState(istream& in)
+{
+    ckptRead(in, currentClockCycle);
+    ckptRead(in, nextBank);
+    ckptRead(in, nextRank);
+    ckptRead(in, nextSub);
+    ckptRead(in, nextBankPRE);
+    ckptRead(in, nextRankPRE);
+    ckptRead(in, nextSubPRE);
+    ckptRead(in, refreshRank);
+    ckptRead(in, refreshBank);
+    ckptRead(in, refreshSub);
+    ckptRead(in, refreshWaiting);
+    ckptRead(in, sendAct);
+    ckptReadResize(in, commandCounters);
+    ckptReadResize(in, processedCommands);
+    ckptCheckSize(in, tXAWCountdown.size());
+    for (auto& countdown : tXAWCountdown) ckptReadResize(in, countdown);
+    ckptRead(in, rowAccessCounters);
+    ckptRead(in, rowAccessCounters_sub);
+    ckptRead(in, lastColumnCycle);
+}
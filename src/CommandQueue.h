@@ -72,6 +72,7 @@ class CommandQueue : public SimulatorObject
     bool process_refresh(BusPacket** busPacket);
     bool process_refresh_sub(BusPacket** busPacket);
     bool process_command(BusPacket** busPacket);
+    bool process_command_frfcfs(BusPacket** busPacket);
     bool process_command_sub(BusPacket** busPacket);  
     bool process_precharge(BusPacket** busPacket);
     bool process_precharge_sub(BusPacket** busPacket);
@@ -86,7 +87,14 @@ class CommandQueue : public SimulatorObject
 
     void print();
     void update();  // SimulatorObject requirement
+    bool isDrained();
+    uint64_t nextEventCycle();
+    uint64_t nextEventCycle_sub();
+    void fastForward(uint64_t cycles);
+    void saveState(ostream& out);
+    void loadState(istream& in);
     vector<BusPacket*>& getCommandQueue(unsigned rank, unsigned bank);
+    vector<bool>& getBarrierFlags(unsigned rank, unsigned bank);
     vector<BusPacket*>& getCommandQueue(unsigned rank, unsigned bank, unsigned sub);
 
     // fields
@@ -101,6 +109,13 @@ class CommandQueue : public SimulatorObject
 
   private:
     void nextRankAndBank(unsigned& rank, unsigned& bank);
+    size_t schedulableDepth(vector<bool>& barrier);
+    void indexPacket(BusPacket* packet, unsigned queueIndex);
+    void dequeue(unsigned rank, unsigned queueIndex, size_t index);
+    bool updateReadyBanks();
+    bool isRowCapped(unsigned rank, unsigned bank);
+    bool closesRow(BusPacket* packet);
+    uint64_t rowCloseCycle(unsigned rank, unsigned bank);
     void nextRankAndBankandSubarray(unsigned& rank, unsigned& bank, unsigned& sub);
     // fields
 
@@ -122,6 +137,18 @@ class CommandQueue : public SimulatorObject
     vector<bool> processedCommands;
     vector<vector<unsigned>> tXAWCountdown;
     vector<vector<unsigned>> rowAccessCounters;
+    // per-cycle view of the queued requests, rebuilt by process_command_frfcfs
+    vector<vector<bool>> rowHitPending;
+    vector<vector<bool>> rowConflictWaiting;
+    vector<vector<bool>> rowCmdClaimed;
+    // per-bank index of the queued commands, see updateReadyBanks
+    BusPacket3D bankQueues;                 // queued packets of each rank/bank, oldest first
+    vector<vector<vector<bool>>> barriers;  // "BAR" tag of each queued packet, parallel to queues
+    vector<vector<vector<unsigned>>> queuedBanks;  // bank of each queued packet, parallel to queues
+    vector<unsigned> queuedBarriers;        // number of barrier packets queued per rank
+    vector<vector<bool>> bankReady;
+    vector<vector<uint64_t>> lastColumnCycle;  // last READ/WRITE per bank, for AdaptivePage
+    bool useBankIndex;
     vector<vector<vector<unsigned>>> rowAccessCounters_sub;
 
     bool sendAct;
@@ -134,6 +161,8 @@ class CommandQueue : public SimulatorObject
     unsigned cmd_queue_depth_;
     unsigned xaw_;
     unsigned total_row_accesses_;
+    unsigned row_buffer_timeout_;
+    RowBufferPolicy rowBufferPolicy_;
     SchedulingPolicy schedulingPolicy_;
     QueuingStructure queuingStructure_;
 };
@@ -72,6 +72,8 @@ class Configuration
         tXP = getConfigParam(UINT, "tXP");
         TOTAL_ROW_ACCESSES = getConfigParam(UINT, "TOTAL_ROW_ACCESSES");
         TRANS_QUEUE_DEPTH = getConfigParam(UINT, "TRANS_QUEUE_DEPTH");
+        WRITE_HIGH_WATERMARK = getConfigParam(UINT, "WRITE_HIGH_WATERMARK");
+        WRITE_LOW_WATERMARK = getConfigParam(UINT, "WRITE_LOW_WATERMARK");
         WL = getConfigParam(UINT, "WL");
         XAW = getConfigParam(UINT, "XAW");
 
@@ -97,6 +99,11 @@ class Configuration
         {
             throw invalid_argument("Not allowed zero channel");
         }
+        if (WRITE_HIGH_WATERMARK != 0 &&
+            (WRITE_LOW_WATERMARK >= WRITE_HIGH_WATERMARK || WRITE_HIGH_WATERMARK > TRANS_QUEUE_DEPTH))
+        {
+            throw invalid_argument("WRITE_LOW_WATERMARK < WRITE_HIGH_WATERMARK <= TRANS_QUEUE_DEPTH");
+        }
 
         setDebugConfiguration();
         setOutputConfiguration();
@@ -173,6 +180,8 @@ class Configuration
     unsigned tXP;
     unsigned TOTAL_ROW_ACCESSES;
     unsigned TRANS_QUEUE_DEPTH;
+    unsigned WRITE_HIGH_WATERMARK;
+    unsigned WRITE_LOW_WATERMARK;
     unsigned WL;
     unsigned XAW;
 
@@ -13,6 +13,7 @@
 #ifndef CONFIGURATION_DB_H_
 #define CONFIGURATION_DB_H_
 
+#include <atomic>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -52,6 +53,9 @@ class ConfigurationDB
 
     const ConfigurationData* find(const string& key)
     {
+#ifdef CONFIG_LOOKUP_COUNT
+        numLookups_.fetch_add(1, memory_order_relaxed);
+#endif
         auto found = _dbMap.find(key);
         return found != _dbMap.end() ? &found->second : nullptr;
     }
@@ -110,8 +114,18 @@ class ConfigurationDB
         visDataOut << "!!EPOCH_DATA" << endl;
     }
 
+    // number of find() calls so far, only counted in CONFIG_LOOKUP_COUNT builds;
+    // simulation code should read Configuration instead
+    uint64_t getNumLookups() const
+    {
+        return numLookups_.load(memory_order_relaxed);
+    }
+
   private:
+    ConfigurationDB() : numLookups_(0) {}
+
     unordered_map<string, ConfigurationData> _dbMap;
+    atomic<uint64_t> numLookups_;
 };
 };  // namespace DRAMSim
 
@@ -198,7 +198,33 @@ const static ConfigurationData defaultConfiguration[] = {
     DEFINE_DEFAULT_CONFIG(ROW_BUFFER_POLICY, STRING, SYS_PARAM, "open_page"),
     //DEFINE_DEFAULT_CONFIG(SCHEDULING_POLICY, STRING, SYS_PARAM, "rank_then_bank_round_robin"),
     DEFINE_DEFAULT_CONFIG(QUEUING_STRUCTURE, STRING, SYS_PARAM, "per_rank"),
+    // Bank storage related
+    DEFINE_DEFAULT_CONFIG(BANK_STORAGE, STRING, SYS_PARAM, "heap"),
+    DEFINE_DEFAULT_CONFIG(BANK_STORAGE_PATH, STRING, SYS_PARAM, "."),
+    // restore the whole simulator from this checkpoint at startup (empty: cold start)
+    DEFINE_STRING_CONFIG(CHECKPOINT_FILE, SYS_PARAM),
+    // number of threads stepping the channels (1: serial)
+    DEFINE_DEFAULT_CONFIG(NUM_SIM_THREADS, UINT, SYS_PARAM, "1"),
+    // let the run loops jump over cycles in which every channel only counts down timers
+    DEFINE_DEFAULT_CONFIG(IDLE_FAST_FORWARD, BOOL, SYS_PARAM, "true"),
+    // skip command queue scans for banks whose BankState timing cannot be met this cycle
+    DEFINE_DEFAULT_CONFIG(CMD_QUEUE_BANK_INDEX, BOOL, SYS_PARAM, "true"),
+    // hold writes back until WRITE_HIGH_WATERMARK of them wait, then drain them down to
+    // WRITE_LOW_WATERMARK (0: transactions reach the command queue in arrival order)
+    DEFINE_DEFAULT_CONFIG(WRITE_HIGH_WATERMARK, UINT, SYS_PARAM, "0"),
+    DEFINE_DEFAULT_CONFIG(WRITE_LOW_WATERMARK, UINT, SYS_PARAM, "0"),
+    // ROW_BUFFER_POLICY=adaptive: cycles an open row without queued hits waits for one (a fixed
+    // hold-open timer, no row-hit prediction)
+    DEFINE_DEFAULT_CONFIG(ROW_BUFFER_TIMEOUT, UINT, SYS_PARAM, "64"),
+    // execute transactions in order as they arrive, without DRAM timing (functional model)
+    DEFINE_DEFAULT_CONFIG(PIM_FUNCTIONAL, BOOL, SYS_PARAM, "false"),
+    // DEBUG_CMD_TRACE records go to <file>.ch<N> in binary (empty: printed as text)
+    DEFINE_STRING_CONFIG(CMD_TRACE_FILE, SYS_PARAM),
     DEFINE_DEFAULT_CONFIG(ADDRESS_MAPPING_SCHEME, STRING, SYS_PARAM, "Scheme8"),  // shcha
+    // bit-field list replacing ADDRESS_MAPPING_SCHEME, MSB first, and its XOR hashes
+    // (see AddrMapping), e.g. "rank:row:col:bg:bank:chan" and "chan^row,bank^row>>4"
+    DEFINE_STRING_CONFIG(ADDRESS_MAPPING, SYS_PARAM),
+    DEFINE_STRING_CONFIG(ADDRESS_XOR_HASH, SYS_PARAM),
     // WARNING, do not remove end of config macro
     DEFINE_ENDOF_CONFIG};
 };  // namespace DRAMSim
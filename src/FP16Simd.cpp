@@ -0,0 +1,359 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#include "FP16Simd.h"
+
+#include "BF16.h"
+
+#if !defined(NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FP16_SIMD_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+using namespace DRAMSim;
+
+namespace
+{
+void addScalar(fp16* dst, const fp16* src0, const fp16* src1, int numBursts)
+{
+    for (int i = 0; i < 16 * numBursts; i++) dst[i] = src0[i] + src1[i];
+}
+
+void mulScalar(fp16* dst, const fp16* src0, const fp16* src1, int numBursts)
+{
+    for (int i = 0; i < 16 * numBursts; i++) dst[i] = src0[i] * src1[i];
+}
+
+void madScalar(fp16* dst, const fp16* src0, const fp16* src1, const fp16* src2, int numBursts)
+{
+    for (int i = 0; i < 16 * numBursts; i++) dst[i] = src0[i] * src1[i] + src2[i];
+}
+
+void addBf16Scalar(uint16_t* dst, const uint16_t* src0, const uint16_t* src1, int numBursts)
+{
+    for (int i = 0; i < 16 * numBursts; i++)
+        dst[i] = convertF2BF(convertBF2F(src0[i]) + convertBF2F(src1[i]));
+}
+
+void mulBf16Scalar(uint16_t* dst, const uint16_t* src0, const uint16_t* src1, int numBursts)
+{
+    for (int i = 0; i < 16 * numBursts; i++)
+        dst[i] = convertF2BF(convertBF2F(src0[i]) * convertBF2F(src1[i]));
+}
+
+void madBf16Scalar(uint16_t* dst, const uint16_t* src0, const uint16_t* src1,
+                   const uint16_t* src2, int numBursts)
+{
+    for (int i = 0; i < 16 * numBursts; i++)
+    {
+        float prod = convertBF2F(convertF2BF(convertBF2F(src0[i]) * convertBF2F(src1[i])));
+        dst[i] = convertF2BF(prod + convertBF2F(src2[i]));
+    }
+}
+
+#ifdef FP16_SIMD_X86
+/*
+ * FP16 operands widen exactly to FP32, and FP32 carries more than 2 * 11 + 2 significand
+ * bits, so a single FP32 add or mul rounded once more to FP16 is the correctly rounded FP16
+ * result, same as half_float. NaN payloads and the sign of generated NaNs differ between
+ * x86 and half_float, so a burst producing any NaN is redone with the scalar kernel.
+ */
+#define FP16_AVX2 __attribute__((target("avx2,f16c")))
+#define FP16_AVX512 __attribute__((target("avx512f")))
+#define FP16_ROUND (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)
+// the unmasked AVX-512 conversions and shifts pass GCC an undefined merge operand, which
+// -Wmaybe-uninitialized reports; their zero-masked forms with every lane set are the same op
+#define ALL_LANES static_cast<__mmask16>(0xffff)
+
+FP16_AVX2 inline __m256 load8(const fp16* p)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+FP16_AVX2 inline __m256 round8(__m256 v)
+{
+    return _mm256_cvtph_ps(_mm256_cvtps_ph(v, FP16_ROUND));
+}
+
+FP16_AVX2 inline bool store16(fp16* dst, __m256 lo, __m256 hi)
+{
+    if (_mm256_movemask_ps(_mm256_cmp_ps(lo, hi, _CMP_UNORD_Q)))
+        return false;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_cvtps_ph(lo, FP16_ROUND));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm256_cvtps_ph(hi, FP16_ROUND));
+    return true;
+}
+
+FP16_AVX2 void addAvx2(fp16* dst, const fp16* src0, const fp16* src1, int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16)
+    {
+        __m256 lo = _mm256_add_ps(load8(src0), load8(src1));
+        __m256 hi = _mm256_add_ps(load8(src0 + 8), load8(src1 + 8));
+        if (!store16(dst, lo, hi))
+            addScalar(dst, src0, src1, 1);
+    }
+}
+
+FP16_AVX2 void mulAvx2(fp16* dst, const fp16* src0, const fp16* src1, int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16)
+    {
+        __m256 lo = _mm256_mul_ps(load8(src0), load8(src1));
+        __m256 hi = _mm256_mul_ps(load8(src0 + 8), load8(src1 + 8));
+        if (!store16(dst, lo, hi))
+            mulScalar(dst, src0, src1, 1);
+    }
+}
+
+FP16_AVX2 void madAvx2(fp16* dst, const fp16* src0, const fp16* src1, const fp16* src2,
+                       int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16, src2 += 16)
+    {
+        __m256 lo = _mm256_add_ps(round8(_mm256_mul_ps(load8(src0), load8(src1))), load8(src2));
+        __m256 hi = _mm256_add_ps(round8(_mm256_mul_ps(load8(src0 + 8), load8(src1 + 8))),
+                                  load8(src2 + 8));
+        if (!store16(dst, lo, hi))
+            madScalar(dst, src0, src1, src2, 1);
+    }
+}
+
+FP16_AVX512 inline __m512 load16(const fp16* p)
+{
+    return _mm512_maskz_cvtph_ps(ALL_LANES,
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+}
+
+FP16_AVX512 inline bool store16(fp16* dst, __m512 v)
+{
+    if (_mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q))
+        return false;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                        _mm512_maskz_cvtps_ph(ALL_LANES, v, FP16_ROUND));
+    return true;
+}
+
+FP16_AVX512 void addAvx512(fp16* dst, const fp16* src0, const fp16* src1, int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16)
+    {
+        if (!store16(dst, _mm512_add_ps(load16(src0), load16(src1))))
+            addScalar(dst, src0, src1, 1);
+    }
+}
+
+FP16_AVX512 void mulAvx512(fp16* dst, const fp16* src0, const fp16* src1, int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16)
+    {
+        if (!store16(dst, _mm512_mul_ps(load16(src0), load16(src1))))
+            mulScalar(dst, src0, src1, 1);
+    }
+}
+
+FP16_AVX512 void madAvx512(fp16* dst, const fp16* src0, const fp16* src1, const fp16* src2,
+                           int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16, src2 += 16)
+    {
+        // the FP16 round trip keeps the product from being contracted into an FMA
+        __m512 prod = _mm512_maskz_cvtph_ps(
+            ALL_LANES, _mm512_maskz_cvtps_ph(ALL_LANES, _mm512_mul_ps(load16(src0), load16(src1)),
+                                             FP16_ROUND));
+        if (!store16(dst, _mm512_add_ps(prod, load16(src2))))
+            madScalar(dst, src0, src1, src2, 1);
+    }
+}
+
+/*
+ * BF16 widens to FP32 with a shift and narrows with the integer round-to-nearest-even of
+ * convertF2BF, NaNs included, so no scalar fallback is needed.
+ */
+FP16_AVX2 inline __m256 loadBf8(const uint16_t* p)
+{
+    __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(v, 16));
+}
+
+// BF16 bits in the low half of each 32-bit lane
+FP16_AVX2 inline __m256i narrowBf8(__m256 v)
+{
+    __m256i bits = _mm256_castps_si256(v);
+    __m256i odd = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    __m256i ret = _mm256_srli_epi32(
+        _mm256_add_epi32(bits, _mm256_add_epi32(odd, _mm256_set1_epi32(0x7fff))), 16);
+    __m256i nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+    return _mm256_blendv_epi8(ret, _mm256_set1_epi32(0x7fc0), nan);
+}
+
+FP16_AVX2 inline __m256 roundBf8(__m256 v)
+{
+    return _mm256_castsi256_ps(_mm256_slli_epi32(narrowBf8(v), 16));
+}
+
+FP16_AVX2 inline void storeBf16(uint16_t* dst, __m256 lo, __m256 hi)
+{
+    __m256i packed = _mm256_packus_epi32(narrowBf8(lo), narrowBf8(hi));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                        _mm256_permute4x64_epi64(packed, 0xd8));
+}
+
+FP16_AVX2 void addBf16Avx2(uint16_t* dst, const uint16_t* src0, const uint16_t* src1,
+                           int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16)
+        storeBf16(dst, _mm256_add_ps(loadBf8(src0), loadBf8(src1)),
+                  _mm256_add_ps(loadBf8(src0 + 8), loadBf8(src1 + 8)));
+}
+
+FP16_AVX2 void mulBf16Avx2(uint16_t* dst, const uint16_t* src0, const uint16_t* src1,
+                           int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16)
+        storeBf16(dst, _mm256_mul_ps(loadBf8(src0), loadBf8(src1)),
+                  _mm256_mul_ps(loadBf8(src0 + 8), loadBf8(src1 + 8)));
+}
+
+FP16_AVX2 void madBf16Avx2(uint16_t* dst, const uint16_t* src0, const uint16_t* src1,
+                           const uint16_t* src2, int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16, src2 += 16)
+    {
+        __m256 lo = _mm256_add_ps(roundBf8(_mm256_mul_ps(loadBf8(src0), loadBf8(src1))),
+                                  loadBf8(src2));
+        __m256 hi = _mm256_add_ps(roundBf8(_mm256_mul_ps(loadBf8(src0 + 8), loadBf8(src1 + 8))),
+                                  loadBf8(src2 + 8));
+        storeBf16(dst, lo, hi);
+    }
+}
+
+FP16_AVX512 inline __m512 loadBf16(const uint16_t* p)
+{
+    __m512i v = _mm512_maskz_cvtepu16_epi32(
+        ALL_LANES, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(ALL_LANES, v, 16));
+}
+
+FP16_AVX512 inline __m512i narrowBf16(__m512 v)
+{
+    __m512i bits = _mm512_castps_si512(v);
+    __m512i odd =
+        _mm512_and_si512(_mm512_maskz_srli_epi32(ALL_LANES, bits, 16), _mm512_set1_epi32(1));
+    __m512i ret = _mm512_maskz_srli_epi32(
+        ALL_LANES, _mm512_add_epi32(bits, _mm512_add_epi32(odd, _mm512_set1_epi32(0x7fff))), 16);
+    return _mm512_mask_mov_epi32(ret, _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q),
+                                 _mm512_set1_epi32(0x7fc0));
+}
+
+FP16_AVX512 inline void storeBf16(uint16_t* dst, __m512 v)
+{
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                        _mm512_maskz_cvtepi32_epi16(ALL_LANES, narrowBf16(v)));
+}
+
+FP16_AVX512 void addBf16Avx512(uint16_t* dst, const uint16_t* src0, const uint16_t* src1,
+                               int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16)
+        storeBf16(dst, _mm512_add_ps(loadBf16(src0), loadBf16(src1)));
+}
+
+FP16_AVX512 void mulBf16Avx512(uint16_t* dst, const uint16_t* src0, const uint16_t* src1,
+                               int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16)
+        storeBf16(dst, _mm512_mul_ps(loadBf16(src0), loadBf16(src1)));
+}
+
+FP16_AVX512 void madBf16Avx512(uint16_t* dst, const uint16_t* src0, const uint16_t* src1,
+                               const uint16_t* src2, int numBursts)
+{
+    for (int b = 0; b < numBursts; b++, dst += 16, src0 += 16, src1 += 16, src2 += 16)
+    {
+        __m512 prod = _mm512_castsi512_ps(_mm512_maskz_slli_epi32(
+            ALL_LANES, narrowBf16(_mm512_mul_ps(loadBf16(src0), loadBf16(src1))), 16));
+        storeBf16(dst, _mm512_add_ps(prod, loadBf16(src2)));
+    }
+}
+
+bool cpuHasF16c()
+{
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C);
+}
+#endif
+
+const FP16BurstKernels kernelTable[FP16_ISA_MAX] = {
+    {FP16_ISA_SCALAR, "scalar", addScalar, mulScalar, madScalar},
+#ifdef FP16_SIMD_X86
+    {FP16_ISA_AVX2, "avx2", addAvx2, mulAvx2, madAvx2},
+    {FP16_ISA_AVX512, "avx512", addAvx512, mulAvx512, madAvx512},
+#endif
+};
+
+const BF16BurstKernels bf16KernelTable[FP16_ISA_MAX] = {
+    {FP16_ISA_SCALAR, "scalar", addBf16Scalar, mulBf16Scalar, madBf16Scalar},
+#ifdef FP16_SIMD_X86
+    {FP16_ISA_AVX2, "avx2", addBf16Avx2, mulBf16Avx2, madBf16Avx2},
+    {FP16_ISA_AVX512, "avx512", addBf16Avx512, mulBf16Avx512, madBf16Avx512},
+#endif
+};
+
+bool isSupported(FP16KernelIsa isa)
+{
+    switch (isa)
+    {
+        case FP16_ISA_SCALAR:
+            return true;
+#ifdef FP16_SIMD_X86
+        case FP16_ISA_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && cpuHasF16c();
+        case FP16_ISA_AVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+}  // namespace
+
+const FP16BurstKernels* DRAMSim::getFP16BurstKernels(FP16KernelIsa isa)
+{
+    return isSupported(isa) ? &kernelTable[isa] : nullptr;
+}
+
+const FP16BurstKernels& DRAMSim::getFP16BurstKernels()
+{
+    static const FP16BurstKernels* best = []() {
+        for (int isa = FP16_ISA_MAX - 1; isa > FP16_ISA_SCALAR; isa--)
+        {
+            if (isSupported(static_cast<FP16KernelIsa>(isa)))
+                return &kernelTable[isa];
+        }
+        return &kernelTable[FP16_ISA_SCALAR];
+    }();
+    return *best;
+}
+
+const BF16BurstKernels* DRAMSim::getBF16BurstKernels(FP16KernelIsa isa)
+{
+    return isSupported(isa) ? &bf16KernelTable[isa] : nullptr;
+}
+
+const BF16BurstKernels& DRAMSim::getBF16BurstKernels()
+{
+    return bf16KernelTable[getFP16BurstKernels().isa];
+}
@@ -0,0 +1,70 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __FP16_SIMD_HPP__
+#define __FP16_SIMD_HPP__
+
+#include <cstdint>
+
+#include "FP16.h"
+
+namespace DRAMSim
+{
+/*
+ * FP16 kernels used by the PIM ALUs, each over numBursts consecutive 16-lane bursts. Every
+ * variant rounds each operation to FP16 exactly like half_float, so results are
+ * bit-identical whichever variant the CPU dispatch picks. mad computes src0 * src1 + src2
+ * with the product rounded to FP16 first, as the scalar expression does; dst may alias any
+ * source burst for burst.
+ */
+enum FP16KernelIsa
+{
+    FP16_ISA_SCALAR,
+    FP16_ISA_AVX2,
+    FP16_ISA_AVX512,
+    FP16_ISA_MAX
+};
+
+struct FP16BurstKernels
+{
+    FP16KernelIsa isa;
+    const char* name;
+    void (*add)(fp16* dst, const fp16* src0, const fp16* src1, int numBursts);
+    void (*mul)(fp16* dst, const fp16* src0, const fp16* src1, int numBursts);
+    void (*mad)(fp16* dst, const fp16* src0, const fp16* src1, const fp16* src2, int numBursts);
+};
+
+// widest variant supported by this CPU (scalar when built with NO_SIMD)
+const FP16BurstKernels& getFP16BurstKernels();
+// nullptr when the CPU or the build does not support isa
+const FP16BurstKernels* getFP16BurstKernels(FP16KernelIsa isa);
+
+/*
+ * BF16 kernels with the same contract on raw BF16 lanes (see BF16.h). Sums and products of
+ * two BF16 values are formed in FP32 and rounded once to BF16, which is the correctly rounded
+ * result since FP32 carries more than 2 * 8 + 2 significand bits.
+ */
+struct BF16BurstKernels
+{
+    FP16KernelIsa isa;
+    const char* name;
+    void (*add)(uint16_t* dst, const uint16_t* src0, const uint16_t* src1, int numBursts);
+    void (*mul)(uint16_t* dst, const uint16_t* src0, const uint16_t* src1, int numBursts);
+    void (*mad)(uint16_t* dst, const uint16_t* src0, const uint16_t* src1, const uint16_t* src2,
+                int numBursts);
+};
+
+const BF16BurstKernels& getBF16BurstKernels();
+const BF16BurstKernels* getBF16BurstKernels(FP16KernelIsa isa);
+
+}  // namespace DRAMSim
+#endif
@@ -0,0 +1,116 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#include "IntBurst.h"
+
+#include <algorithm>
+
+using namespace DRAMSim;
+
+namespace
+{
+int64_t saturate(int64_t value, int bits)
+{
+    const int64_t hi = (int64_t(1) << (bits - 1)) - 1;
+    return std::min(std::max(value, -hi - 1), hi);
+}
+
+int laneBits(PIMPrecision precision)
+{
+    return (precision == INT4) ? 4 : 8;
+}
+}  // namespace
+
+int DRAMSim::getIntLanes(PIMPrecision precision)
+{
+    return 256 / laneBits(precision);
+}
+
+int DRAMSim::getIntLane(const BurstType& bst, PIMPrecision precision, int lane)
+{
+    if (precision == INT8)
+        return bst.i8Data_[lane];
+    int nibble = (bst.u8Data_[lane / 2] >> (4 * (lane % 2))) & 0xf;
+    return (nibble ^ 0x8) - 0x8;
+}
+
+void DRAMSim::setIntLane(BurstType& bst, PIMPrecision precision, int lane, int64_t value)
+{
+    value = saturate(value, laneBits(precision));
+    if (precision == INT8)
+    {
+        bst.i8Data_[lane] = (int8_t)value;
+        return;
+    }
+    int shift = 4 * (lane % 2);
+    uint8_t& byte = bst.u8Data_[lane / 2];
+    byte = (byte & ~(0xf << shift)) | ((value & 0xf) << shift);
+}
+
+void DRAMSim::intBurstAdd(PIMPrecision precision, BurstType* dst, const BurstType* src0,
+                          const BurstType* src1, int numBursts)
+{
+    const int lanes = getIntLanes(precision);
+    for (int b = 0; b < numBursts; b++)
+    {
+        BurstType ret;
+        for (int i = 0; i < lanes; i++)
+            setIntLane(ret, precision, i,
+                       getIntLane(src0[b], precision, i) + getIntLane(src1[b], precision, i));
+        dst[b] = ret;
+    }
+}
+
+void DRAMSim::intBurstMul(PIMPrecision precision, BurstType* dst, const BurstType* src0,
+                          const BurstType* src1, int numBursts)
+{
+    const int lanes = getIntLanes(precision);
+    for (int b = 0; b < numBursts; b++)
+    {
+        BurstType ret;
+        for (int i = 0; i < lanes; i++)
+            setIntLane(ret, precision, i,
+                       getIntLane(src0[b], precision, i) * getIntLane(src1[b], precision, i));
+        dst[b] = ret;
+    }
+}
+
+void DRAMSim::intBurstMad(PIMPrecision precision, BurstType* dst, const BurstType* src0,
+                          const BurstType* src1, const BurstType* src2, int numBursts)
+{
+    const int perAcc = getIntLanes(precision) / 8;
+    for (int b = 0; b < numBursts; b++)
+    {
+        BurstType ret;
+        for (int j = 0; j < 8; j++)
+        {
+            int64_t acc = src2[b].i32Data_[j];
+            for (int i = j * perAcc; i < (j + 1) * perAcc; i++)
+                acc += getIntLane(src0[b], precision, i) * getIntLane(src1[b], precision, i);
+            ret.i32Data_[j] = (int32_t)saturate(acc, 32);
+        }
+        dst[b] = ret;
+    }
+}
+
+void DRAMSim::intBurstRelu(PIMPrecision precision, BurstType* dst, int numBursts)
+{
+    const int lanes = getIntLanes(precision);
+    for (int b = 0; b < numBursts; b++)
+    {
+        for (int i = 0; i < lanes; i++)
+        {
+            if (getIntLane(dst[b], precision, i) < 0)
+                setIntLane(dst[b], precision, i, 0);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __INT_BURST_HPP__
+#define __INT_BURST_HPP__
+
+#include "Burst.h"
+#include "SystemConfiguration.h"
+
+namespace DRAMSim
+{
+/*
+ * Packed integer kernels used by the PIM ALUs for INT8 (32 lanes per burst) and INT4 (64 lanes,
+ * lane 2i in the low nibble of byte i), all two's complement, each over numBursts consecutive
+ * bursts. add and mul saturate every lane to its width. mad multiplies the lanes of src0 and
+ * src1 and accumulates the products into eight INT32 lanes taken from src2: accumulator lane j
+ * sums input lanes [j * k, (j + 1) * k) with k = lanes / 8 and saturates to INT32. dst may
+ * alias any source burst for burst.
+ */
+int getIntLanes(PIMPrecision precision);
+int getIntLane(const BurstType& bst, PIMPrecision precision, int lane);
+// saturates value to the lane width
+void setIntLane(BurstType& bst, PIMPrecision precision, int lane, int64_t value);
+
+void intBurstAdd(PIMPrecision precision, BurstType* dst, const BurstType* src0,
+                 const BurstType* src1, int numBursts);
+void intBurstMul(PIMPrecision precision, BurstType* dst, const BurstType* src0,
+                 const BurstType* src1, int numBursts);
+void intBurstMad(PIMPrecision precision, BurstType* dst, const BurstType* src0,
+                 const BurstType* src1, const BurstType* src2, int numBursts);
+void intBurstRelu(PIMPrecision precision, BurstType* dst, int numBursts);
+
+}  // namespace DRAMSim
+#endif
@@ -31,6 +31,7 @@
 #include <iostream>
 
 #include "AddressMapping.h"
+#include "Checkpoint.h"
 #include "MemoryController.h"
 #include "MemorySystem.h"
 
@@ -58,8 +59,16 @@ MemoryController::MemoryController(MemorySystem* parent, CSVWriter& csvOut_, ost
       totalRefreshes(0),
       refreshRank(0),
       refreshBank(0),
+      refreshSubarray(0),
+      writeDrain(false),
+      lastColumnCommand(ACTIVATE),
       totalReads(0),
-      totalWrites(0)
+      totalWrites(0),
+      totalTurnarounds(0),
+      totalWriteDrains(0),
+      dataBusCycles(0),
+      totalActivates(0),
+      totalPrecharges(0)
 {
     // get handle on parent
     parentMemorySystem = parent;
@@ -74,8 +83,6 @@ MemoryController::MemoryController(MemorySystem* parent, CSVWriter& csvOut_, ost
         vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
     totalReadsPerRank = totalWritesPerRank = totalActivatesPerRank =
         vector<uint64_t>(config.NUM_RANKS, 0);
-        writeDataCountdown.reserve(config.NUM_RANKS);
-    writeDataToSend.reserve(config.NUM_RANKS);
     refreshCountdown.reserve(config.NUM_RANKS);
     refreshCountdownBank.reserve(config.NUM_BANKS);
 
@@ -97,7 +104,7 @@ MemoryController::MemoryController(MemorySystem* parent, CSVWriter& csvOut_, ost
         parentMemorySystem, csvOut, dramsimLog, config, totalTransactions, grandTotalBankAccesses,
         totalReadsPerRank, totalWritesPerRank, totalReadsPerBank, totalWritesPerBank,
         totalActivatesPerRank, totalActivatesPerBank, totalRefreshes, backgroundEnergy, burstEnergy,
-        actpreEnergy, refreshEnergy, aluPIMEnergy, refreshEnergy, pendingReadTransactions, false);
+        actpreEnergy, refreshEnergy, aluPIMEnergy, refreshEnergy, pendingReads, false);
 }
     
 MemoryController::MemoryController(MemorySystem* parent, CSVWriter& csvOut_, ostream& simLog,
@@ -120,8 +127,16 @@ MemoryController::MemoryController(MemorySystem* parent, CSVWriter& csvOut_, ost
       totalRefreshes(0),
       refreshRank(0),
       refreshBank(0),
+      refreshSubarray(0),
+      writeDrain(false),
+      lastColumnCommand(ACTIVATE),
       totalReads(0),
       totalWrites(0),
+      totalTurnarounds(0),
+      totalWriteDrains(0),
+      dataBusCycles(0),
+      totalActivates(0),
+      totalPrecharges(0),
       is_salp_(is_salp)
 {
     // get handle on parent
@@ -137,8 +152,6 @@ MemoryController::MemoryController(MemorySystem* parent, CSVWriter& csvOut_, ost
     totalReadsPerRank = totalWritesPerRank = totalActivatesPerRank =
         vector<uint64_t>(config.NUM_RANKS, 0);
 
-    writeDataCountdown.reserve(config.NUM_RANKS);
-    writeDataToSend.reserve(config.NUM_RANKS);
     refreshCountdown.reserve(config.NUM_RANKS);
     refreshCountdownBank.reserve(config.NUM_BANKS);
 
@@ -155,15 +168,14 @@ MemoryController::MemoryController(MemorySystem* parent, CSVWriter& csvOut_, ost
         refreshCountdown.push_back((int)((config.tREFI / config.tCK) / config.NUM_RANKS) * (i + 1));
     for (size_t i = 0; i < config.NUM_BANKS; i++)
         refreshCountdownBank.push_back((int)((config.tREFISB / config.tCK)) * (i + 1));
-    pendingReadTransactions.reserve(32);
-    pendingReadTransactions.clear();
+    pendingReads.reserve(config.TRANS_QUEUE_DEPTH * 2);
     returnTransaction.reserve(32); 
     returnTransaction.clear();
     memoryContStats = new MemoryControllerStats(
         parentMemorySystem, csvOut, dramsimLog, config, totalTransactions, grandTotalBankAccesses,
         totalReadsPerRank, totalWritesPerRank, totalReadsPerBank, totalWritesPerBank,
         totalActivatesPerRank, totalActivatesPerBank, totalRefreshes, backgroundEnergy, burstEnergy,
-        actpreEnergy, refreshEnergy, aluPIMEnergy, refreshEnergy, pendingReadTransactions, is_salp_);
+        actpreEnergy, refreshEnergy, aluPIMEnergy, refreshEnergy, pendingReads, is_salp_);
 }
 
 //do we need subarray controller?
@@ -254,19 +266,28 @@ void MemoryController::setBankStates(size_t rank, size_t bank, size_t sub, Curre
     bankStates_SUB[rank][bank*4+sub].nextActivate = nextActivate;
 }
 
+// READ/WRITE with auto-precharge: the bank closes its row by itself once the burst and tRP are
+// over, so it stays Precharging (lastCommand READ/WRITE) until it can be activated again
+void MemoryController::autoPrecharge(unsigned rank, unsigned bank, uint64_t autoPrechargeDelay)
+{
+    BankState& state = bankStates[rank][bank];
+    uint64_t idleCycle =
+        max(currentClockCycle + autoPrechargeDelay, state.nextPrecharge + config.tRP);
+    state.currentBankState = Precharging;
+    state.stateChangeCountdown = idleCycle - currentClockCycle;
+    state.nextActivate = max(state.nextActivate, idleCycle);
+    totalPrecharges++;
+}
+
 void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
 {
     if (poppedBusPacket!=nullptr && poppedBusPacket->busPacketType == WRITE)
     {   
-        if(writeDataToSend.capacity() == writeDataToSend.size())
-        {
-            writeDataToSend.reserve(writeDataToSend.size() + 32);
-            writeDataCountdown.reserve(writeDataCountdown.size() + 32);
-        }
-        writeDataToSend.push_back(new BusPacket(
-            DATA, poppedBusPacket->physicalAddress, poppedBusPacket->column, poppedBusPacket->row,
-            poppedBusPacket->rank, poppedBusPacket->bank, poppedBusPacket->data, dramsimLog));
-        writeDataCountdown.push_back(config.WL);
+        writeDataQueue.push(currentClockCycle + config.WL,
+                            new BusPacket(DATA, poppedBusPacket->physicalAddress,
+                                          poppedBusPacket->column, poppedBusPacket->row,
+                                          poppedBusPacket->rank, poppedBusPacket->bank,
+                                          poppedBusPacket->data, dramsimLog));
     }
     
     // update each bank's state based on the command that was just popped
@@ -275,7 +296,7 @@ void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
     unsigned rank = poppedBusPacket->rank;
     unsigned bank = poppedBusPacket->bank;
     unsigned sub = (poppedBusPacket->row < 0x2000)? 0 : (poppedBusPacket->row < 0x4000)? 1 : (poppedBusPacket->row < 0x6000)? 2 : 3;
-    auto am = config.addrMapping;
+    auto& am = config.addrMapping;
     switch (poppedBusPacket->busPacketType)
     {
         case READ:
@@ -284,6 +305,9 @@ void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
                 bankStates[rank][bank].nextPrecharge = max(currentClockCycle + config.READ_TO_PRE_DELAY,
                                                        bankStates[rank][bank].nextPrecharge);
                 bankStates[rank][bank].lastCommand = READ;
+                totalReadsPerBank[SEQUENTIAL(rank, bank)]++;
+                if (poppedBusPacket->autoPrecharge)
+                    autoPrecharge(rank, bank, config.READ_AUTOPRE_DELAY);
             }
             else{          
                 bankStates_SUB[rank][4*bank + sub].lastCommand = READ;
@@ -332,6 +356,9 @@ void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
                 }
             }
             totalReads++;
+            totalTurnarounds += (lastColumnCommand == WRITE);
+            lastColumnCommand = READ;
+            dataBusCycles += config.BL / 2;
             break;
 
         case WRITE:
@@ -341,6 +368,9 @@ void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
                 max(currentClockCycle + config.WRITE_TO_PRE_DELAY,
                     bankStates[rank][bank].nextPrecharge);
                 bankStates[rank][bank].lastCommand = WRITE;
+                totalWritesPerBank[SEQUENTIAL(rank, bank)]++;
+                if (poppedBusPacket->autoPrecharge)
+                    autoPrecharge(rank, bank, config.WRITE_AUTOPRE_DELAY);
             }
             else{
                 bankStates_SUB[rank][4*bank + sub].nextPrecharge = 
@@ -403,6 +433,9 @@ void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
                 }
             }
             totalWrites++;
+            totalTurnarounds += (lastColumnCommand == READ);
+            lastColumnCommand = WRITE;
+            dataBusCycles += config.BL / 2;
             //cout<<"[MC] updatecommand for write and type is "<<poppedBusPacket->busPacketType<<" and clock is "<<currentClockCycle<<" and openrow is "<<
             //bankStates_SUB[poppedBusPacket->rank][poppedBusPacket->bank][AddrMapping::findsubarray(poppedBusPacket->row)].openRowAddress<<
             //" and bank is "<<poppedBusPacket->bank<<" and sub is "<<AddrMapping::findsubarray(poppedBusPacket->row)<<" and nextpre is "<<
@@ -418,6 +451,7 @@ void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
                 bankStates[rank][bank].nextPrecharge =
                     max(currentClockCycle + config.tRAS, bankStates[rank][bank].nextPrecharge);
                 setBankStatesRW(rank, bank, (config.tRCDRD - config.AL), (config.tRCDWR - config.AL));
+                totalActivatesPerBank[SEQUENTIAL(rank, bank)]++;
             }
             else{
                 //bool cond = (poppedBusPacket->row!=bankStates_SUB[rank][4*bank + sub].openRowAddress);
@@ -455,8 +489,10 @@ void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
             //cout<<"[MC] updatecommand and type is "<<poppedBusPacket->busPacketType<<" and clock is "<<currentClockCycle<<" and openrow is "<<
             //bankStates_SUB[poppedBusPacket->rank][poppedBusPacket->bank][AddrMapping::findsubarray(poppedBusPacket->row)].openRowAddress<<
             //" and bank is "<<poppedBusPacket->bank<<" and sub is "<<AddrMapping::findsubarray(poppedBusPacket->row)<<endl;
+            totalActivates++;
             break;
         case PRECHARGE:
+            totalPrecharges++;
             if(!is_salp_)
             {
                 setBankStates(rank, bank, Precharging, PRECHARGE, config.tRP,
@@ -515,22 +551,80 @@ void MemoryController::updateCommandQueue(BusPacket* poppedBusPacket)
     cmdCyclesLeft = config.tCMD;
 }
 
+/*
+ * Write-drain mode, on when WRITE_HIGH_WATERMARK is set. Reads go to the command queue ahead of
+ * older writes until WRITE_HIGH_WATERMARK writes are waiting (or no read is left). Writes then go
+ * ahead of reads until WRITE_LOW_WATERMARK or fewer are left, so the data bus turns around once
+ * per drain instead of at every read/write switch of the arrival order.
+ * Only plain reads and writes in single-bank mode are reordered. The window ends at the first
+ * tagged transaction (a barrier or a PIM mode change), and the oldest read or write of the
+ * preferred type only goes ahead when no older held request has the same address.
+ * Returns how many transactions at the head of the queue are scanned for the preferred type;
+ * the held type among them waits this cycle, and when the preferred one has no room in the
+ * command queue nothing behind it is scheduled either.
+ */
+size_t MemoryController::updateWriteDrain()
+{
+    if (config.WRITE_HIGH_WATERMARK == 0 || is_salp_)
+        return 0;
+    for (auto rank : *ranks)
+    {
+        if (rank->mode_ != dramMode::SB)
+            return 0;
+    }
+
+    size_t window = 0, reads = 0, writes = 0;
+    for (; window < transactionQueue.size(); window++)
+    {
+        Transaction* transaction = transactionQueue[window];
+        if (!transaction->tag.empty())
+            break;
+        if (transaction->transactionType == DATA_READ)
+            reads++;
+        else if (transaction->transactionType == DATA_WRITE)
+            writes++;
+        else
+            break;
+    }
+
+    if (!writeDrain && writes > 0 && (writes >= config.WRITE_HIGH_WATERMARK || reads == 0))
+    {
+        writeDrain = true;
+        totalWriteDrains++;
+    }
+    else if (writeDrain && (writes == 0 || (writes <= config.WRITE_LOW_WATERMARK && reads > 0)))
+    {
+        writeDrain = false;
+    }
+
+    TransactionType heldType = writeDrain ? DATA_READ : DATA_WRITE;
+    size_t first = 0;
+    while (first < window && transactionQueue[first]->transactionType == heldType) first++;
+    if (first == window)
+        return 0;
+    for (size_t i = 0; i < first; i++)
+    {
+        if (transactionQueue[i]->address == transactionQueue[first]->address)
+            return 0;
+    }
+    return first + 1;
+}
+
 void MemoryController::updateTransactionQueue()
 {
     //if(transactionQueue.size() < 10)    cout<<"clock is "<<currentClockCycle<<" and Transaction Queue Size: "<<transactionQueue.size()<<endl;
-    auto am = config.addrMapping;
+    size_t drainWindow = updateWriteDrain();
+    TransactionType heldType = writeDrain ? DATA_READ : DATA_WRITE;
     for (size_t i = 0; i < transactionQueue.size(); i++)
     {
         // pop off top transaction from queue assuming simple scheduling at the moment
         // will eventually add policies here
         Transaction* transaction = transactionQueue[i];
-        // map address to rank,bank,row,col
-        unsigned newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow,
-            newTransactionColumn;
-
-        // pass these in as references so they get set by the addressMapping function
-        am.addressMapping(transaction->address, newTransactionChan, newTransactionRank,
-                          newTransactionBank, newTransactionRow, newTransactionColumn);
+        if (i < drainWindow && transaction->transactionType == heldType)
+            continue;
+        // rank,bank,row,col were mapped when the transaction was added
+        unsigned newTransactionRank = transaction->rank, newTransactionBank = transaction->bank,
+                 newTransactionRow = transaction->row, newTransactionColumn = transaction->col;
         //if(transaction->tag!="" && currentClockCycle == 77091)    cout<<"[MC] tag is "<<transaction->tag<<" and cycle is "<<currentClockCycle<<endl;
         if ((!is_salp_) && (commandQueue.hasRoomFor(1, newTransactionRank, newTransactionBank)) || 
         (is_salp_) && (commandQueue_SUB.hasRoomFor(1, newTransactionRank, newTransactionBank, AddrMapping::findsubarray(newTransactionRow))))
@@ -582,11 +676,11 @@ void MemoryController::updateTransactionQueue()
                 // in a bus packet, we can staple it back into a transaction and return it
                 if (transaction->transactionType == DATA_READ && transaction!= nullptr)
                 {
-                    if(pendingReadTransactions.capacity() == pendingReadTransactions.size())
-                    {
-                        pendingReadTransactions.reserve(pendingReadTransactions.size() + 32);
-                    }
-                    pendingReadTransactions.push_back(transaction);  
+                    unsigned sub = (newTransactionRow < 0x2000)   ? 0
+                                   : (newTransactionRow < 0x4000) ? 1
+                                   : (newTransactionRow < 0x6000) ? 2
+                                                                  : 3;
+                    pendingReads.insert(transaction, newTransactionRank, newTransactionBank, sub);
                 }
                 else
                 {
@@ -609,6 +703,12 @@ void MemoryController::updateTransactionQueue()
                 break;
             }
         }
+        else if (i + 1 == drainWindow)
+        {
+            // the preferred transaction has no room; the ones behind it were not checked against
+            // the held ones, so they wait as well
+            break;
+        }
         else // no room, do nothing this cycle
         {
             // PRINT( "== Warning - No room in command queue" << endl;
@@ -674,6 +774,8 @@ void MemoryController::updateBankState()
                     {
                         switch (bankStates[i][j].lastCommand)
                         {
+                            case READ:   // auto-precharge
+                            case WRITE:
                             case REF:
                             case RFCSB:
                             case PRECHARGE:
@@ -748,7 +850,7 @@ void MemoryController::update()
         if (cmdCyclesLeft == 0)  // packet is ready to be received by rank
         {
             //cout<<"[MC] cmdCyclesLeft is 0 and clock is "<<currentClockCycle<<" and bank is "<<outgoingCmdPacket->bank<<" and row is "<<outgoingCmdPacket->row<<endl;
-            //(*ranks)[outgoingCmdPacket->rank]->receiveFromBus(outgoingCmdPacket);
+            (*ranks)[outgoingCmdPacket->rank]->receiveFromBus(outgoingCmdPacket);
             outgoingCmdPacket = NULL;
         }
     }
@@ -776,36 +878,28 @@ void MemoryController::update()
     //
     // write data held in fifo vector along with countdowns
     //if((*ranks)[0]->getChanId() == 1)   cout<<"[MC] update and clock is "<<currentClockCycle<<" and state is "<<(*ranks)[0]->bankStates_SUB[4*4+3].currentBankState<<endl;
-    if (writeDataCountdown.size() > 0)
+    if (writeDataQueue.isReady(currentClockCycle))
     {
-        for (size_t i = 0; i < writeDataCountdown.size(); i++) writeDataCountdown[i]--;
-
-        if (writeDataCountdown[0] == 0)
+        // send to bus and print debug stuff
+        if (DEBUG_BUS)
         {
-            // send to bus and print debug stuff
-            if (DEBUG_BUS)
-            {
-                PRINTN(" -- MC Issuing On Data Bus    : ");
-                writeDataToSend[0]->print();
-            }
+            PRINTN(" -- MC Issuing On Data Bus    : ");
+            writeDataQueue.front()->print();
+        }
 
-            // queue up the packet to be sent
-            if (outgoingDataPacket != NULL)
-            {
-                ERROR("== Error - Data Bus Collision");
-                exit(-1);
-            }
+        // queue up the packet to be sent
+        if (outgoingDataPacket != NULL)
+        {
+            ERROR("== Error - Data Bus Collision");
+            exit(-1);
+        }
 
-            outgoingDataPacket = writeDataToSend[0];
-            dataCyclesLeft = config.BL / 2;   //which is the bitline 
+        outgoingDataPacket = writeDataQueue.front();
+        dataCyclesLeft = config.BL / 2;   //which is the bitline 
 
-            totalTransactions++;
+        totalTransactions++;
 
-            writeDataCountdown.erase(writeDataCountdown.begin());
-            writeDataToSend.erase(writeDataToSend.begin());
-            //cout<<"[MC] writeDataCountdown is 0 and clock is "<<currentClockCycle<<" and bank is "<<outgoingDataPacket->bank<<" and row is "
-            //<<outgoingDataPacket->row<<endl;
-        }
+        writeDataQueue.pop();
     }
     // if its time for a refresh issue a refresh
     // else pop from command queue if it's not empty
@@ -835,36 +929,20 @@ void MemoryController::update()
 
         bool foundMatch = false;
         // find the pending read transaction to calculate latency
-        for (size_t i = 0; i < pendingReadTransactions.size(); i++)
+        PendingReadTable::Entry pending;
+        if (returnTransaction[0] != nullptr && pendingReads.take(returnTransaction[0]->address, pending))
         {
-            if(pendingReadTransactions[i] != nullptr && returnTransaction[0] != nullptr)
-            {
-                if (pendingReadTransactions[i]->address == returnTransaction[0]->address)
-                {
-                    unsigned chan, rank, bank, row, col, sub;
-                    config.addrMapping.addressMapping(returnTransaction[0]->address, chan, rank, bank,
-                                                    row, col);
-                    sub = (row < 0x2000)? 0 : (row < 0x4000)? 1 : (row < 0x6000)? 2 : 3;
-                    //if(!is_salp_)   memoryContStats->insertHistogram(currentClockCycle - pendingReadTransactions[i]->timeAdded, rank, bank);
-                    //else    memoryContStats->insertHistogram(currentClockCycle - pendingReadTransactions[i]->timeAdded, rank, bank, sub);
-                    // FIXME. Is it correct?
-                    // memcpy(pendingReadTransactions[i]->data,
-                    // returnTransaction[0]->data, config.BL * (JEDEC_DATA_BUS_BITS / 8));
-                    returnReadData(pendingReadTransactions[i]);
-                    pendingReadTransactions[i] = nullptr;
-                    delete pendingReadTransactions[i];
-                    pendingReadTransactions.erase(pendingReadTransactions.begin() + i);
-                    foundMatch = true;
-                    break;
-                }
-            }
+            uint64_t latency = currentClockCycle - pending.trans->timeAdded;
+            if (!is_salp_)
+                memoryContStats->insertHistogram(latency, pending.rank, pending.bank);
             else
-            {
-                //delete pendingReadTransactions[i];
-                //pendingReadTransactions.erase(pendingReadTransactions.begin() + i);
-                //foundMatch = true;
-                //break;
-            }
+                memoryContStats->insertHistogram(latency, pending.rank, pending.bank, pending.sub);
+            // FIXME. Is it correct?
+            // memcpy(pending.trans->data,
+            // returnTransaction[0]->data, config.BL * (JEDEC_DATA_BUS_BITS / 8));
+            returnReadData(pending.trans);
+            delete pending.trans;
+            foundMatch = true;
         }
         if (!foundMatch)
         {
@@ -887,21 +965,19 @@ void MemoryController::update()
 
 bool MemoryController::WillAcceptTransaction()
 {
-    return transactionQueue.size() < getConfigParam(UINT, "TRANS_QUEUE_DEPTH");
+    return transactionQueue.size() < config.TRANS_QUEUE_DEPTH;
 }
 
 // allows outside source to make request of memory system
 bool MemoryController::addTransaction(Transaction* trans)
 {
-    auto am = config.addrMapping;
-    unsigned newTransactionChan, newTransactionRank, newTransactionBank, newTransactionRow,
-            newTransactionColumn;
-
-        // pass these in as references so they get set by the addressMapping function
-    am.addressMapping(trans->address, newTransactionChan, newTransactionRank,
-        newTransactionBank, newTransactionRow, newTransactionColumn);
     if (WillAcceptTransaction())
     {
+        // decode once here, the scheduler and nextEventCycle() look at queued transactions
+        // every cycle
+        unsigned chan;
+        config.addrMapping.addressMapping(trans->address, chan, trans->rank, trans->bank,
+                                          trans->row, trans->col);
         parentMemorySystem->numOnTheFlyTransactions++;
         trans->timeAdded = currentClockCycle;
         transactionQueue.push_back(trans);
@@ -923,13 +999,18 @@ void MemoryController::resetStats()
 void MemoryController::printStats(bool finalStats)
 {
     memoryContStats->printStats(finalStats, parentMemorySystem->systemID, currentClockCycle);
+    PRINTC(PRINT_CHAN_STAT, "   Read/Write Turnarounds : " << totalTurnarounds << " (write drains "
+                                                           << totalWriteDrains << ")");
+    PRINTC(PRINT_CHAN_STAT, "   Data Bus Utilization : "
+                                << (currentClockCycle ? (double)dataBusCycles / currentClockCycle : 0.0));
+    PRINTC(PRINT_CHAN_STAT, "   Activates/Precharges : " << totalActivates << "/" << totalPrecharges);
 }
 
 MemoryController::~MemoryController()
 {
     // ERROR("MEMORY CONTROLLER DESTRUCTOR");
     // abort();
-    for (size_t i = 0; i < pendingReadTransactions.size(); i++) delete pendingReadTransactions[i];
+    pendingReads.clear();
     for (size_t i = 0; i < returnTransaction.size(); i++) delete returnTransaction[i];
     delete memoryContStats;
 }
@@ -939,16 +1020,14 @@ void MemoryControllerStats::insertHistogram(unsigned latencyValue, unsigned rank
 {
     totalEpochLatency[SEQUENTIAL(rank, bank)] += latencyValue;
     // poor man's way to bin things.
-    unsigned histogram_bin_size = getConfigParam(UINT, "HISTOGRAM_BIN_SIZE");
-    latencies[(latencyValue / histogram_bin_size) * histogram_bin_size]+=1;
+    latencies[(latencyValue / config.HISTOGRAM_BIN_SIZE) * config.HISTOGRAM_BIN_SIZE]+=1;
 }
 
 void MemoryControllerStats::insertHistogram(unsigned latencyValue, unsigned rank, unsigned bank, unsigned sub)
 {
     totalEpochLatency[SEQUENTIAL_SUB(rank, bank, sub)] += latencyValue;
     // poor man's way to bin things.
-    unsigned histogram_bin_size = getConfigParam(UINT, "HISTOGRAM_BIN_SIZE");
-    auto key = (latencyValue / histogram_bin_size) * histogram_bin_size;
+    auto key = (latencyValue / config.HISTOGRAM_BIN_SIZE) * config.HISTOGRAM_BIN_SIZE;
     latencies[key]++;
 }
 void MemoryControllerStats::printStats(bool finalStats, unsigned myChannel,
@@ -959,7 +1038,7 @@ void MemoryControllerStats::printStats(bool finalStats, unsigned myChannel,
     uint64_t cyclesElapsed = (currentClockCycle % config.EPOCH_LENGTH == 0)
                                  ? config.EPOCH_LENGTH
                                  : currentClockCycle % config.EPOCH_LENGTH;
-    unsigned bytesPerTransaction = (getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") * config.BL) / 8;
+    unsigned bytesPerTransaction = (config.JEDEC_DATA_BUS_BITS * config.BL) / 8;
     uint64_t totalBytesTransferred = totalTransactions * bytesPerTransaction;
     double secondsThisEpoch = (double)cyclesElapsed * config.tCK * 1E-9;
 
@@ -1100,9 +1179,8 @@ void MemoryControllerStats::printStats(bool finalStats, unsigned myChannel,
         map<unsigned, unsigned>::iterator it;
         for (it = latencies.begin(); it != latencies.end(); it++)
         {
-            auto histogram_bin_size = getConfigParam(UINT, "HISTOGRAM_BIN_SIZE");
             PRINTC(PRINT_CHAN_STAT, "       [" << it->first << "-"
-                                               << it->first + (histogram_bin_size - 1)
+                                               << it->first + (config.HISTOGRAM_BIN_SIZE - 1)
                                                << "] : " << it->second);
             if (VIS_FILE_OUTPUT)
                 csvOut.getOutputStream() << it->first << "=" << it->second << endl;
@@ -1130,7 +1208,7 @@ void MemoryControllerStats::printStats(bool finalStats, unsigned myChannel,
         }
     }
 
-    PRINTC(PRINT_CHAN_STAT, endl << " == Pending Transactions : " << pendingReadTransactions.size()
+    PRINTC(PRINT_CHAN_STAT, endl << " == Pending Transactions : " << pendingReads.size()
                                  << " (" << currentClockCycle << ")==");
 
     if (LOG_OUTPUT)
@@ -1140,6 +1218,199 @@ void MemoryControllerStats::printStats(bool finalStats, unsigned myChannel,
     // resetStats();
 }
 
+bool MemoryController::isDrained()
+{
+    return transactionQueue.empty() && writeDataQueue.empty() && returnTransaction.empty() &&
+           pendingReads.empty() && outgoingCmdPacket == NULL &&
+           outgoingDataPacket == NULL && commandQueue.isDrained() && commandQueue_SUB.isDrained();
+}
+
+// cycle whose update() sees a countdown that is now "left" run out
+static uint64_t countdownExpiry(uint64_t now, unsigned left)
+{
+    return left > 0 ? now + left - 1 : now;
+}
+
+/*
+ * Earliest cycle at which update() may do more than count down timers: a command issue,
+ * a bus transfer completing, a refresh coming due or a transaction moving to the command
+ * queue. Cycles before it can be skipped with fastForward().
+ */
+uint64_t MemoryController::nextEventCycle()
+{
+    uint64_t now = currentClockCycle;
+    if (!returnTransaction.empty())
+        return now;
+
+    for (auto transaction : transactionQueue)
+    {
+        unsigned rank = transaction->rank, bank = transaction->bank;
+        if ((!is_salp_ && commandQueue.hasRoomFor(1, rank, bank)) ||
+            (is_salp_ &&
+             commandQueue_SUB.hasRoomFor(1, rank, bank, AddrMapping::findsubarray(transaction->row))))
+            return now;
+    }
+
+    // updateRefresh() fires when the countdown is already zero at the start of update()
+    uint64_t next = now + refreshCountdown[refreshRank];
+    if (outgoingCmdPacket != NULL)
+        next = min(next, countdownExpiry(now, cmdCyclesLeft));
+    if (outgoingDataPacket != NULL)
+        next = min(next, countdownExpiry(now, dataCyclesLeft));
+    if (!writeDataQueue.empty())
+        next = min(next, max(writeDataQueue.frontReadyCycle(), now));
+
+    for (auto& rankStates : (is_salp_ ? bankStates_SUB : bankStates))
+    {
+        for (auto& state : rankStates)
+        {
+            if (state.stateChangeCountdown > 0)
+                next = min(next, countdownExpiry(now, state.stateChangeCountdown));
+        }
+    }
+
+    return min(next, is_salp_ ? commandQueue_SUB.nextEventCycle_sub() : commandQueue.nextEventCycle());
+}
+
+// same as calling update()/step() "cycles" times, cycles must not go past nextEventCycle()
+void MemoryController::fastForward(uint64_t cycles)
+{
+    for (auto& rankStates : (is_salp_ ? bankStates_SUB : bankStates))
+    {
+        for (auto& state : rankStates)
+        {
+            if (state.stateChangeCountdown > 0)
+                state.stateChangeCountdown -= cycles;
+        }
+    }
+    if (outgoingCmdPacket != NULL)
+        cmdCyclesLeft -= cycles;
+    if (outgoingDataPacket != NULL)
+        dataCyclesLeft -= cycles;
+    for (auto& left : refreshCountdown) left -= cycles;
+    for (auto& left : refreshCountdownBank) left -= cycles;
+
+    if (is_salp_)
+        commandQueue_SUB.fastForward(cycles);
+    else
+        commandQueue.fastForward(cycles);
+    currentClockCycle += cycles;
+}
+
+// timing state (bank states, refresh countdowns, command queues) and the running counters
+// printStats() and the energy model read from
+void MemoryController::saveState(ostream& out)
+{
+    ckptWrite(out, currentClockCycle);
+    ckptWrite(out, static_cast<uint64_t>(bankStates.size()));
+    for (auto& rankStates : bankStates)
+    {
+        ckptWrite(out, static_cast<uint64_t>(rankStates.size()));
+        for (auto& state : rankStates) state.saveState(out);
+    }
+    ckptWrite(out, static_cast<uint64_t>(bankStates_SUB.size()));
+    for (auto& rankStates : bankStates_SUB)
+    {
+        ckptWrite(out, static_cast<uint64_t>(rankStates.size()));
+        for (auto& state : rankStates) state.saveState(out);
+    }
+    commandQueue.saveState(out);
+    commandQueue_SUB.saveState(out);
+
+    ckptWrite(out, cmdCyclesLeft);
+    ckptWrite(out, dataCyclesLeft);
+    ckptWrite(out, refreshRank);
+    ckptWrite(out, refreshBank);
+    ckptWrite(out, refreshSubarray);
+    ckptWrite(out, refreshCountdown);
+    ckptWrite(out, refreshCountdownBank);
+    ckptWrite(out, powerDown);
+    ckptWrite(out, writeDrain);
+    ckptWrite(out, lastColumnCommand);
+
+    ckptWrite(out, totalTransactions);
+    ckptWrite(out, totalRefreshes);
+    ckptWrite(out, totalReads);
+    ckptWrite(out, totalWrites);
+    ckptWrite(out, totalTurnarounds);
+    ckptWrite(out, totalWriteDrains);
+    ckptWrite(out, dataBusCycles);
+    ckptWrite(out, totalActivates);
+    ckptWrite(out, totalPrecharges);
+    ckptWrite(out, totalBandwidth);
+    ckptWrite(out, grandTotalBankAccesses);
+    ckptWrite(out, totalReadsPerBank);
+    ckptWrite(out, totalWritesPerBank);
+    ckptWrite(out, totalReadsPerRank);
+    ckptWrite(out, totalWritesPerRank);
+    ckptWrite(out, totalActivatesPerBank);
+    ckptWrite(out, totalActivatesPerRank);
+    ckptWrite(out, totalEpochLatency);
+    ckptWrite(out, latencies);
+    ckptWrite(out, backgroundEnergy);
+    ckptWrite(out, burstEnergy);
+    ckptWrite(out, actpreEnergy);
+    ckptWrite(out, refreshEnergy);
+    ckptWrite(out, aluPIMEnergy);
+    ckptWrite(out, readPIMEnergy);
+}
+
+void MemoryController::loadState(istream& in)
+{
+    ckptRead(in, currentClockCycle);
+    ckptCheckSize(in, bankStates.size());
+    for (auto& rankStates : bankStates)
+    {
+        ckptCheckSize(in, rankStates.size());
+        for (auto& state : rankStates) state.loadState(in);
+    }
+    ckptCheckSize(in, bankStates_SUB.size());
+    for (auto& rankStates : bankStates_SUB)
+    {
+        ckptCheckSize(in, rankStates.size());
+        for (auto& state : rankStates) state.loadState(in);
+    }
+    commandQueue.loadState(in);
+    commandQueue_SUB.loadState(in);
+
+    ckptRead(in, cmdCyclesLeft);
+    ckptRead(in, dataCyclesLeft);
+    ckptRead(in, refreshRank);
+    ckptRead(in, refreshBank);
+    ckptRead(in, refreshSubarray);
+    ckptRead(in, refreshCountdown);
+    ckptRead(in, refreshCountdownBank);
+    ckptRead(in, powerDown);
+    ckptRead(in, writeDrain);
+    ckptRead(in, lastColumnCommand);
+
+    ckptRead(in, totalTransactions);
+    ckptRead(in, totalRefreshes);
+    ckptRead(in, totalReads);
+    ckptRead(in, totalWrites);
+    ckptRead(in, totalTurnarounds);
+    ckptRead(in, totalWriteDrains);
+    ckptRead(in, dataBusCycles);
+    ckptRead(in, totalActivates);
+    ckptRead(in, totalPrecharges);
+    ckptRead(in, totalBandwidth);
+    ckptRead(in, grandTotalBankAccesses);
+    ckptRead(in, totalReadsPerBank);
+    ckptRead(in, totalWritesPerBank);
+    ckptRead(in, totalReadsPerRank);
+    ckptRead(in, totalWritesPerRank);
+    ckptRead(in, totalActivatesPerBank);
+    ckptRead(in, totalActivatesPerRank);
+    ckptRead(in, totalEpochLatency);
+    ckptRead(in, latencies);
+    ckptRead(in, backgroundEnergy);
+    ckptRead(in, burstEnergy);
+    ckptRead(in, actpreEnergy);
+    ckptRead(in, refreshEnergy);
+    ckptRead(in, aluPIMEnergy);
+    ckptRead(in, readPIMEnergy);
+}
+
 void MemoryControllerStats::resetStats()
 {
     totalRefreshes = 0;
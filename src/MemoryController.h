@@ -39,7 +39,9 @@
 #include "CSVWriter.h"
 #include "CommandQueue.h"
 #include "Configuration.h"
+#include "PendingReadTable.h"
 #include "Rank.h"
+#include "ReadyQueue.h"
 #include "SimulatorObject.h"
 #include "SystemConfiguration.h"
 #include "Transaction.h"
@@ -70,6 +72,11 @@ class MemoryController : public SimulatorObject
     void resetStats();
     bool WillAcceptTransaction();
     bool addBarrier();
+    bool isDrained();
+    uint64_t nextEventCycle();
+    void fastForward(uint64_t cycles);
+    void saveState(ostream& out);
+    void loadState(istream& in);
 
     // fields
     vector<Transaction*> transactionQueue;
@@ -84,6 +91,8 @@ class MemoryController : public SimulatorObject
     void insertHistogram(unsigned latencyValue, unsigned rank, unsigned bank);
     void updateCommandQueue(BusPacket* poppedBusPacket);
     void updateTransactionQueue();
+    size_t updateWriteDrain();
+    void autoPrecharge(unsigned rank, unsigned bank, uint64_t autoPrechargeDelay);
     void updateBankState();
     void updateRefresh();
     void setBankStatesRW(size_t rank, size_t bank, uint64_t nextRead, uint64_t nextWrite);
@@ -98,10 +107,10 @@ class MemoryController : public SimulatorObject
 
     CommandQueue commandQueue;
     CommandQueue commandQueue_SUB;
-    vector<BusPacket*> writeDataToSend;
-    vector<unsigned> writeDataCountdown;
+    // write data waiting out WL, keyed by the cycle it goes on the bus
+    ReadyQueue<BusPacket*> writeDataQueue;
     vector<Transaction*> returnTransaction;
-    vector<Transaction*> pendingReadTransactions;
+    PendingReadTable pendingReads;
     map<unsigned, unsigned> latencies;  // latencyValue -> latencyCount
     vector<bool> powerDown;
     vector<Rank*>* ranks;
@@ -118,6 +127,8 @@ class MemoryController : public SimulatorObject
     vector<uint64_t> totalReadsPerRank, totalWritesPerRank;
     vector<uint64_t> totalActivatesPerBank, totalActivatesPerRank, totalEpochLatency;
     unsigned refreshRank, refreshBank, refreshSubarray;
+    bool writeDrain;                  // writes go ahead of reads, see updateWriteDrain
+    BusPacketType lastColumnCommand;  // READ or WRITE, for the turnaround count
     vector<unsigned> refreshCountdown, refreshCountdownBank;
     Configuration& config;
     MemoryControllerStats* memoryContStats;
@@ -130,6 +141,11 @@ class MemoryController : public SimulatorObject
     BusPacket* poppedBusPacket;
 
     uint64_t totalReads, totalWrites;
+    // read<->write switches of the column commands, write drains started and cycles the data
+    // bus carries a burst, since the start of the simulation
+    uint64_t totalTurnarounds, totalWriteDrains, dataBusCycles;
+    // row commands since the start of the simulation, auto-precharges included
+    uint64_t totalActivates, totalPrecharges;
 };
 
 class MemoryControllerStats
@@ -144,7 +160,7 @@ class MemoryControllerStats
                           vector<uint64_t>& backgroundE, vector<uint64_t>& burstE,
                           vector<uint64_t>& actpreE, vector<uint64_t>& refreshE,
                           vector<uint64_t>& aluPIME, vector<uint64_t>& readPIME,
-                          vector<Transaction*>& pendingReadTrans, bool is_salp_ = false)
+                          PendingReadTable& pendingReadTable, bool is_salp_ = false)
         : csvOut(csvOut_),
           dramsimLog(simLog),
           config(configuration),
@@ -163,7 +179,7 @@ class MemoryControllerStats
           refreshEnergy(refreshE),
           aluPIMEnergy(aluPIME),
           readPIMEnergy(readPIME),
-          pendingReadTransactions(pendingReadTrans),
+          pendingReads(pendingReadTable),
           is_salp_(is_salp_)
     {
         parentMemorySystem = parent;
@@ -197,7 +213,7 @@ class MemoryControllerStats
     vector<uint64_t>& refreshEnergy;
     vector<uint64_t>& aluPIMEnergy;
     vector<uint64_t>& readPIMEnergy;
-    vector<Transaction*>& pendingReadTransactions;
+    PendingReadTable& pendingReads;
 
     uint64_t currentClockCycle;
     double totalBandwidth;
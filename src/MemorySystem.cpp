@@ -30,6 +30,7 @@
 
 #include <unistd.h>
 
+#include "Checkpoint.h"
 #include "MemorySystem.h"
 
 using namespace std;
@@ -49,7 +50,8 @@ MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, CSVWriter& cs
       csvOut(csvOut_),
       numOnTheFlyTransactions(0),
       config(configuration),
-      is_salp_(is_salp)
+      is_salp_(is_salp),
+      functional_(false)
 {
     currentClockCycle = 0;
     //maybe i need some boolean salp logic to figure whether use subarray level or not
@@ -132,6 +134,13 @@ MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, CSVWriter& cs
 
     memoryController = new MemoryController(this, csvOut, dramsimLog, config, is_salp_);
 
+    if (DEBUG_CMD_TRACE)
+    {
+        string traceFile = getConfigParam(STRING, "CMD_TRACE_FILE");
+        cmdTrace.open(traceFile.empty() ? traceFile : traceFile + ".ch" + to_string(systemID),
+                      dramsimLog);
+    }
+
     // TODO: change to other vector constructor?
     ranks = new vector<Rank*>();    
 
@@ -141,8 +150,14 @@ MemorySystem::MemorySystem(unsigned id, unsigned int megsOfMemory, CSVWriter& cs
         r->setChanId(systemID);
         r->setRankId(i);
         r->attachMemoryController(memoryController);
+        r->attachCmdTrace(&cmdTrace);
         r->pimRank->setChanId(systemID);
         r->pimRank->setRankId(i);
+        if (PIMConfiguration::getBankStorageMode() == MmapStorage)
+        {
+            r->attachStorageFile(getConfigParam(STRING, "BANK_STORAGE_PATH") + "/bank_ch" +
+                                 to_string(systemID) + "_ra" + to_string(i) + ".bin");
+        }
         ranks->push_back(r);
     }
 
@@ -190,26 +205,27 @@ bool MemorySystem::addTransaction(bool isWrite, uint64_t addr, const std::string
 
 bool MemorySystem::addBarrier()
 {
-    if (memoryController->WillAcceptTransaction())
+    if (functional_)
     {
-        return memoryController->addBarrier();
+        closeRowsFunctional();
+        return true;
     }
-    else
+    // the barrier goes after the youngest transaction, which is only in the controller when
+    // nothing is pending, even if the controller is full by now
+    if (pendingTransactions.size())
     {
-        if (pendingTransactions.size())
-        {
-            pendingTransactions.back()->tag += "BAR";
-            return true;
-        }
-        else
-        {
-            return false;
-        }
+        pendingTransactions.back()->tag += "BAR";
+        return true;
     }
+    return memoryController->addBarrier();
 }
 
 bool MemorySystem::addTransaction(Transaction* trans)
 {
+    if (functional_)
+    {
+        return executeFunctional(trans);
+    }
     if (memoryController->WillAcceptTransaction())
     {
         return memoryController->addTransaction(trans);
@@ -221,6 +237,68 @@ bool MemorySystem::addTransaction(Transaction* trans)
     }
 }
 
+/*
+ * Functional model: the transaction goes straight to its rank as the ACT/RD/WR (and PRE on a
+ * row conflict) the controller would have issued for it, with no timing, queueing or refresh.
+ * Because the rank runs the same data path as for timed commands, bank contents, PIM registers
+ * and read data end up bit-identical to a timed run of the same transaction sequence.
+ */
+void MemorySystem::setFunctional(bool functional)
+{
+    if (functional != functional_ && (numOnTheFlyTransactions || pendingTransactions.size()))
+    {
+        ERROR("== Error - ch " << systemID << " switched PIM_FUNCTIONAL with transactions in flight");
+        exit(-1);
+    }
+    functional_ = functional;
+    functionalOpenRow_.assign(num_ranks_,
+                              vector<int>(config.NUM_BANKS * (is_salp_ ? 4 : 1), -1));
+}
+
+bool MemorySystem::executeFunctional(Transaction* trans)
+{
+    unsigned chan, rank, bank, row, col;
+    config.addrMapping.addressMapping(trans->address, chan, rank, bank, row, col);
+
+    Rank* r = (*ranks)[rank];
+    unsigned sub = is_salp_ ? AddrMapping::findsubarray(row) : 0;
+    int& openRow = functionalOpenRow_[rank][bank * (is_salp_ ? 4 : 1) + sub];
+    if (openRow != (int)row)
+    {
+        if (openRow >= 0)
+            r->executeFunctional(
+                new BusPacket(PRECHARGE, 0, 0, openRow, rank, bank, nullptr, dramsimLog));
+        r->executeFunctional(new BusPacket(ACTIVATE, trans->address, col, row, rank, bank,
+                                           nullptr, dramsimLog, trans->tag));
+        openRow = row;
+    }
+    r->executeFunctional(new BusPacket(trans->getBusPacketType(), trans->address, col, row, rank,
+                                       bank, trans->data, dramsimLog, trans->tag));
+
+    Callback_t* done = (trans->transactionType == DATA_READ) ? ReturnReadData : WriteDataDone;
+    if (done != NULL)
+        (*done)(systemID, trans->address, currentClockCycle);
+    delete trans;
+    return true;
+}
+
+// a barrier drains the queues in a timed run, after which the controller closes every row
+void MemorySystem::closeRowsFunctional()
+{
+    for (size_t rank = 0; rank < num_ranks_; rank++)
+    {
+        for (size_t i = 0; i < functionalOpenRow_[rank].size(); i++)
+        {
+            int& openRow = functionalOpenRow_[rank][i];
+            if (openRow < 0)
+                continue;
+            (*ranks)[rank]->executeFunctional(new BusPacket(
+                PRECHARGE, 0, 0, openRow, rank, i / (is_salp_ ? 4 : 1), nullptr, dramsimLog));
+            openRow = -1;
+        }
+    }
+}
+
 // prints statistics
 void MemorySystem::printStats(bool finalStats)
 {
@@ -230,8 +308,6 @@ void MemorySystem::printStats(bool finalStats)
 // update the memory systems state
 void MemorySystem::update()
 {
-    if(currentClockCycle % 100 == 0 && systemID == 0)
-        cout<<"MemorySystem::update() and clock is "<<currentClockCycle<<" and trsize is "<<pendingTransactions.size()<<endl;
     // PRINT(" ----------------- Memory System Update ------------------");
     // updates the state of each of the objects
     // NOTE - do not change order
@@ -287,6 +363,68 @@ void MemorySystem::RegisterCallbacks(Callback_t* readCB, Callback_t* writeCB,
     ReportPower = reportPower;
 }
 
+// earliest cycle at which update() may change anything but timer countdowns
+uint64_t MemorySystem::nextEventCycle()
+{
+    if (pendingTransactions.size() > 0 && memoryController->WillAcceptTransaction())
+        return currentClockCycle;
+
+    uint64_t next = memoryController->nextEventCycle();
+    for (size_t i = 0; i < num_ranks_; i++)
+    {
+        next = min(next, (*ranks)[i]->nextEventCycle());
+    }
+    return next;
+}
+
+// advance the channel by "cycles" idle cycles without ticking it, see nextEventCycle()
+void MemorySystem::fastForward(uint64_t cycles)
+{
+    for (size_t i = 0; i < num_ranks_; i++)
+    {
+        (*ranks)[i]->fastForward(cycles);
+    }
+    memoryController->fastForward(cycles);
+    currentClockCycle += cycles;
+}
+
+// a channel can be checkpointed only between transactions: the queues hold pointers into
+// caller-owned buffers that cannot be restored in another process
+bool MemorySystem::isDrained()
+{
+    if (numOnTheFlyTransactions != 0 || !pendingTransactions.empty() ||
+        !memoryController->isDrained())
+        return false;
+    for (size_t i = 0; i < num_ranks_; i++)
+    {
+        if (!(*ranks)[i]->isDrained())
+            return false;
+    }
+    return true;
+}
+
+void MemorySystem::saveState(ostream& out)
+{
+    ckptWrite(out, currentClockCycle);
+    memoryController->saveState(out);
+    ckptWrite(out, static_cast<uint64_t>(num_ranks_));
+    for (size_t i = 0; i < num_ranks_; i++)
+    {
+        (*ranks)[i]->saveState(out);
+    }
+}
+
+void MemorySystem::loadState(istream& in)
+{
+    ckptRead(in, currentClockCycle);
+    memoryController->loadState(in);
+    ckptCheckSize(in, num_ranks_);
+    for (size_t i = 0; i < num_ranks_; i++)
+    {
+        (*ranks)[i]->loadState(in);
+    }
+}
+
 bool MemorySystem::WillAcceptTransaction(uint64_t addr)
 {
     return memoryController->WillAcceptTransaction();
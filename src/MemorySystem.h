@@ -39,6 +39,7 @@
 #include "Burst.h"
 #include "CSVWriter.h"
 #include "Callback.h"
+#include "CmdTrace.h"
 #include "Configuration.h"
 #include "MemoryController.h"
 #include "MemoryObject.h"
@@ -73,6 +74,12 @@ class MemorySystem : public MemoryObject
     bool WillAcceptTransaction(uint64_t addr);
 
     void printStats(bool finalStats);
+    bool isDrained();
+    uint64_t nextEventCycle();
+    void fastForward(uint64_t cycles);
+    void saveState(ostream& out);
+    void loadState(istream& in);
+    void setFunctional(bool functional);
 
     void RegisterCallbacks(Callback_t* readDone, Callback_t* writeDone,
                            void (*reportPower)(double bgpower, double burstpower,
@@ -90,6 +97,7 @@ class MemorySystem : public MemoryObject
     static powerCallBack_t ReportPower;
     unsigned systemID;
     uint64_t numOnTheFlyTransactions;
+    CmdTraceSink cmdTrace;
 
   private:
     CSVWriter& csvOut;
@@ -99,6 +107,13 @@ class MemorySystem : public MemoryObject
     unsigned num_ranks_;
     Configuration& config;
     bool is_salp_;
+
+    // PIM_FUNCTIONAL: transactions bypass the controller and run in order on arrival
+    bool executeFunctional(Transaction* trans);
+    void closeRowsFunctional();
+    bool functional_;
+    // row each bank (each subarray with SALP) holds open in the functional model, -1: closed
+    vector<vector<int>> functionalOpenRow_;
 };
 }  // namespace DRAMSim
 
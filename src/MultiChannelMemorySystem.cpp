@@ -34,11 +34,13 @@
 #include <iomanip>
 #include <locale>
 #include <sstream>  // stringstream
+#include <stdexcept>
 // for directory operations
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include "AddressMapping.h"
+#include "Checkpoint.h"
 #include "MultiChannelMemorySystem.h"
 #include "ParameterReader.h"
 #include "SystemConfiguration.h"
@@ -59,7 +61,8 @@ MultiChannelMemorySystem::MultiChannelMemorySystem(const string& deviceIniFilena
                                                    const string& systemIniFilename_,
                                                    const string& pwd_, const string& traceFilename_,
                                                    unsigned megsOfMemory_, string* visFilename_,
-                                                   bool is_salp)
+                                                   bool is_salp,
+                                                   const vector<pair<string, string>>* paramOverrides)
     : megsOfMemory(megsOfMemory_),
       deviceIniFilename(deviceIniFilename_),
       systemIniFilename(systemIniFilename_),
@@ -85,6 +88,16 @@ MultiChannelMemorySystem::MultiChannelMemorySystem(const string& deviceIniFilena
     configDB.initialize();
     configDB.updatefromFile(deviceIniFilename);
     configDB.updatefromFile(systemIniFilename);
+    // ini keys to replace without a copy of the system ini, e.g. for a sweep over policies
+    configDB.update(paramOverrides);
+
+    if (PIMConfiguration::getBankStorageMode() == MmapStorage)
+    {
+        // subarray rows run past NUM_ROWS, which is all a bank region of the file holds
+        if (is_salp_)
+            throw invalid_argument("BANK_STORAGE=mmap does not support SALP");
+        mkdirIfNotExist(getConfigParam(STRING, "BANK_STORAGE_PATH"));
+    }
 
     addrMapping = new AddrMapping();
     configuration = new Configuration(*addrMapping);
@@ -97,6 +110,20 @@ MultiChannelMemorySystem::MultiChannelMemorySystem(const string& deviceIniFilena
         //cout<<"channel "<<i<<" created"<<" and bank size is "<<channel->ranks->front()->banks_sub.size()<<endl;       
         channels.push_back(channel);
     }
+
+    workerPool = NULL;
+    setNumSimThreads(getConfigParam(UINT, "NUM_SIM_THREADS"));
+    idleFastForward = getConfigParam(BOOL, "IDLE_FAST_FORWARD");
+    setFunctionalMode(getConfigParam(BOOL, "PIM_FUNCTIONAL"));
+
+    string checkpointFile = getConfigParam(STRING, "CHECKPOINT_FILE");
+    if (!checkpointFile.empty())
+    {
+        if (!loadCheckpoint(checkpointFile))
+        {
+            abort();
+        }
+    }
 }
 
 /* Initialize the ClockDomainCrosser to use the CPU speed
@@ -251,6 +278,14 @@ void MultiChannelMemorySystem::InitOutputFiles(string traceFilename)
             {
                 sched = "RtB";
             }
+            else if (configuration->SCHEDULING_POLICY == FrFcfs)
+            {
+                sched = "FrFcfs";
+            }
+            else if (configuration->SCHEDULING_POLICY == FrFcfsCap)
+            {
+                sched = "FrFcfsCap";
+            }
             if (configuration->QUEUING_STRUCTURE == PerRankPerBank)
             {
                 queue = "pRankpBank";
@@ -355,6 +390,7 @@ void MultiChannelMemorySystem::mkdirIfNotExist(string path)
 MultiChannelMemorySystem::~MultiChannelMemorySystem()
 {
     // delete clockDomainCrosser;
+    delete workerPool;
     delete[] numFence;
     delete addrMapping;
 
@@ -405,14 +441,83 @@ void MultiChannelMemorySystem::actual_update()
         csvOut->finalize();
     }*/
 
-    for (size_t i = 0; i < configuration->NUM_CHANS; i++)
+    if (workerPool != NULL)
+    {
+        workerPool->step();
+    }
+    else
     {
-        channels[i]->update();
+        for (size_t i = 0; i < configuration->NUM_CHANS; i++)
+        {
+            channels[i]->update();
+        }
     }
 
     currentClockCycle++;
 }
 
+/*
+ * Step the channels with numThreads threads (the calling thread included). 0 and 1 keep
+ * the serial loop. Must not be called from a callback while the system is updating.
+ */
+void MultiChannelMemorySystem::setNumSimThreads(unsigned numThreads)
+{
+    delete workerPool;
+    workerPool = NULL;
+    if (numThreads > 1 && configuration->NUM_CHANS > 1)
+    {
+        workerPool = new ChannelWorkerPool(channels, numThreads);
+    }
+}
+
+/*
+ * In functional mode (PIM_FUNCTIONAL) every transaction is executed on the spot, in program
+ * order, and barriers only close the open rows: nothing is ever in flight, so update() and the
+ * run loops have no work left and cycle counts and statistics stay at zero. Only switch
+ * between the modes while no transactions are pending.
+ */
+void MultiChannelMemorySystem::setFunctionalMode(bool functional)
+{
+    functionalMode = functional;
+    for (auto chan : channels)
+    {
+        chan->setFunctional(functional);
+    }
+}
+
+/*
+ * Jump over the memory cycles in which every channel only counts down timers (tRCD/tRP/tRFC,
+ * refresh interval, bus transfers) and return how many were skipped, the caller adds them to
+ * its own cycle count. Statistics and energy come out the same as calling update() for each
+ * of them. Only done with IDLE_FAST_FORWARD, a 1:1 CPU/memory clock ratio and transactions
+ * in flight.
+ */
+uint64_t MultiChannelMemorySystem::skipIdleCycles()
+{
+    // with nothing in flight the run loops stop, jumping ahead would only inflate their count
+    if (!idleFastForward || clockDomainCrosser.clock1 != clockDomainCrosser.clock2 ||
+        !hasPendingTransactions())
+        return 0;
+
+    uint64_t cycles = UINT64_MAX;
+    for (auto chan : channels)
+    {
+        uint64_t next = chan->nextEventCycle();
+        if (next <= chan->currentClockCycle)
+            return 0;
+        cycles = min(cycles, next - chan->currentClockCycle);
+    }
+    if (cycles == UINT64_MAX)
+        return 0;
+
+    for (auto chan : channels)
+    {
+        chan->fastForward(cycles);
+    }
+    currentClockCycle += cycles;
+    return cycles;
+}
+
 unsigned MultiChannelMemorySystem::findChannelNumber(uint64_t addr)
 {
     // Single channel case is a trivial shortcut case
@@ -429,9 +534,7 @@ unsigned MultiChannelMemorySystem::findChannelNumber(uint64_t addr)
         abort();
     }*/
 
-    // only chan is used from this set
-    unsigned channelNumber, rank, bank, row, col;
-    addrMapping->addressMapping(addr, channelNumber, rank, bank, row, col);
+    unsigned channelNumber = addrMapping->channel(addr);
     if (channelNumber >= configuration->NUM_CHANS)
     {
         ERROR("Got channel index " << channelNumber << " but only " << configuration->NUM_CHANS
@@ -509,13 +612,13 @@ void MultiChannelMemorySystem::printStats(bool finalStats)
         PRINTC(PRINT_CHAN_STAT, "//// Channel [" << i << "] ////");
     }
 
-    for (size_t i = 0; i < getConfigParam(UINT, "NUM_CHANS"); i++)
+    for (size_t i = 0; i < configuration->NUM_CHANS; i++)
     {
         mem_ctrl = channels[i]->memoryController;
         cyclesElapsed = (mem_ctrl->currentClockCycle % configuration->EPOCH_LENGTH == 0)
                             ? configuration->EPOCH_LENGTH
                             : mem_ctrl->currentClockCycle % configuration->EPOCH_LENGTH;
-        for (size_t r = 0; r < getConfigParam(UINT, "NUM_RANKS"); r++)
+        for (size_t r = 0; r < configuration->NUM_RANKS; r++)
         {
             total_burstEnergy += mem_ctrl->burstEnergy[r];
             total_actpreEnergy += mem_ctrl->actpreEnergy[r];
@@ -553,10 +656,9 @@ void MultiChannelMemorySystem::printStats(bool finalStats)
             PRINT("        Total Energy(mJ)     : " << total_energy * 1E-9);
         }
     }
-    unsigned JEDEC_DATA_BUS_BITS = getConfigParam(UINT, "JEDEC_DATA_BUS_BITS");
-    unsigned BL = getConfigParam(UINT, "BL");
-    PRINT("        Total Bandwidth(GB/s): " << (totalReads + totalWrites) * JEDEC_DATA_BUS_BITS *
-                                                   BL / 8 /
+    PRINT("        Total Bandwidth(GB/s): " << (totalReads + totalWrites) *
+                                                   configuration->JEDEC_DATA_BUS_BITS *
+                                                   configuration->BL / 8 /
                                                    (currentClockCycle * configuration->tCK));
     if (total_num_mac > 0)
     {
@@ -565,6 +667,15 @@ void MultiChannelMemorySystem::printStats(bool finalStats)
               << (total_num_mac * 2 / 1e12) / (currentClockCycle * configuration->tCK * 1E-9));
     }
 
+    PoolStats packetPool = ObjectPool<BusPacket>::getStats();
+    PoolStats transPool = ObjectPool<Transaction>::getStats();
+    PRINT("        BusPacket allocs     : " << FormatWithCommas<uint64_t>(packetPool.allocations)
+                                           << " (pooled objects: "
+                                           << packetPool.chunks * packetPool.objectsPerChunk << ")");
+    PRINT("        Transaction allocs   : " << FormatWithCommas<uint64_t>(transPool.allocations)
+                                           << " (pooled objects: "
+                                           << transPool.chunks * transPool.objectsPerChunk << ")");
+
     PRINT("");
 
     csvOut->finalize();
@@ -590,11 +701,140 @@ int MultiChannelMemorySystem::hasPendingTransactions()
     return num;
 }
 
+// true when every rank reopened a BANK_STORAGE=mmap file that a previous run marked with tag,
+// so the bank contents are already in place and the caller may skip that preload
+bool MultiChannelMemorySystem::isStoragePreloaded(const string& tag)
+{
+    for (auto chan : channels)
+    {
+        for (auto rank : *(chan->ranks))
+        {
+            if (!rank->isStoragePreloaded(tag))
+                return false;
+        }
+    }
+    return true;
+}
+
+// records that the preload named tag is complete, call it once its writes have been simulated
+void MultiChannelMemorySystem::markStoragePreloaded(const string& tag)
+{
+    if (hasPendingTransactions())
+    {
+        ERROR("== Error - storage marked as preloaded with pending transactions");
+        exit(-1);
+    }
+    for (auto chan : channels)
+    {
+        for (auto rank : *(chan->ranks)) rank->markStoragePreloaded(tag);
+    }
+}
+
+/* Checkpoint file layout:
+ *   magic | geometry (NUM_CHANS, NUM_BANKS, NUM_ROWS, NUM_COLS, is_salp) |
+ *   top-level clocks | per channel: MemoryController state, then per rank Rank state
+ *   (bank contents, bank states, PIMRank CRF/GRF/SRF/LUT)
+ * The system has to be drained (no pending transactions) when the checkpoint is taken.
+ */
+static const char checkpointMagic[8] = {'P', 'I', 'M', 'C', 'K', 'P', 'T', '4'};
+
+bool MultiChannelMemorySystem::saveCheckpoint(const string& path)
+{
+    for (auto chan : channels)
+    {
+        if (!chan->isDrained())
+        {
+            ERROR("== Error - cannot checkpoint channel " << chan->systemID
+                                                          << " while transactions are in flight");
+            return false;
+        }
+    }
+
+    ofstream out(path.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!out)
+    {
+        ERROR("== Error - cannot open checkpoint file " << path);
+        return false;
+    }
+
+    out.write(checkpointMagic, sizeof(checkpointMagic));
+    ckptWrite(out, configuration->NUM_CHANS);
+    ckptWrite(out, configuration->NUM_BANKS);
+    ckptWrite(out, getConfigParam(UINT, "NUM_ROWS"));
+    ckptWrite(out, getConfigParam(UINT, "NUM_COLS"));
+    ckptWrite(out, is_salp_);
+
+    ckptWrite(out, currentClockCycle);
+    ckptWrite(out, clockDomainCrosser.counter1);
+    ckptWrite(out, clockDomainCrosser.counter2);
+    for (size_t i = 0; i < configuration->NUM_CHANS; i++)
+    {
+        ckptWrite(out, numFence[i]);
+    }
+    for (auto chan : channels)
+    {
+        chan->saveState(out);
+    }
+
+    out.close();
+    if (!out)
+    {
+        ERROR("== Error - failed to write checkpoint file " << path);
+        return false;
+    }
+    return true;
+}
+
+bool MultiChannelMemorySystem::loadCheckpoint(const string& path)
+{
+    ifstream in(path.c_str(), ios::in | ios::binary);
+    if (!in)
+    {
+        ERROR("== Error - cannot open checkpoint file " << path);
+        return false;
+    }
+
+    char magic[8];
+    in.read(magic, sizeof(magic));
+    unsigned numChans, numBanks, numRows, numCols;
+    bool isSalp;
+    ckptRead(in, numChans);
+    ckptRead(in, numBanks);
+    ckptRead(in, numRows);
+    ckptRead(in, numCols);
+    ckptRead(in, isSalp);
+    if (!in || memcmp(magic, checkpointMagic, sizeof(magic)) != 0 ||
+        numChans != configuration->NUM_CHANS || numBanks != configuration->NUM_BANKS ||
+        numRows != getConfigParam(UINT, "NUM_ROWS") || numCols != getConfigParam(UINT, "NUM_COLS") ||
+        isSalp != is_salp_)
+    {
+        ERROR("== Error - checkpoint " << path << " was taken with a different configuration");
+        return false;
+    }
+
+    ckptRead(in, currentClockCycle);
+    ckptRead(in, clockDomainCrosser.counter1);
+    ckptRead(in, clockDomainCrosser.counter2);
+    for (size_t i = 0; i < configuration->NUM_CHANS; i++)
+    {
+        ckptRead(in, numFence[i]);
+    }
+    for (auto chan : channels)
+    {
+        chan->loadState(in);
+    }
+
+    if (!in)
+    {
+        ERROR("== Error - checkpoint file " << path << " is truncated");
+        return false;
+    }
+    return true;
+}
+
 bool MultiChannelMemorySystem::willAcceptTransaction(uint64_t addr)
 {
-    unsigned chan, rank, bank, row, col;
-    addrMapping->addressMapping(addr, chan, rank, bank, row, col);
-    return channels[chan]->WillAcceptTransaction();
+    return channels[findChannelNumber(addr)]->WillAcceptTransaction();
 }
 
 bool MultiChannelMemorySystem::willAcceptTransaction()
@@ -36,6 +36,7 @@
 
 #include "AddressMapping.h"
 #include "CSVWriter.h"
+#include "ChannelWorkerPool.h"
 #include "ClockDomain.h"
 #include "Configuration.h"
 #include "MemoryObject.h"
@@ -50,7 +51,8 @@ class MultiChannelMemorySystem : public MemoryObject
 {
   public:
     MultiChannelMemorySystem(const string& dev, const string& sys, const string& pwd,
-                             const string& trc, unsigned megsOfMemory, string* visFilename = NULL, bool is_salp = false);
+                             const string& trc, unsigned megsOfMemory, string* visFilename = NULL, bool is_salp = false,
+                             const vector<pair<string, string>>* paramOverrides = NULL);
     virtual ~MultiChannelMemorySystem();
 
     virtual bool addTransaction(Transaction* trans);
@@ -75,10 +77,27 @@ class MultiChannelMemorySystem : public MemoryObject
     void setCPUClockSpeed(uint64_t cpuClkFreqHz);
 
     int hasPendingTransactions();
+    bool isStoragePreloaded(const string& tag);
+    void markStoragePreloaded(const string& tag);
+    bool saveCheckpoint(const string& path);
+    bool loadCheckpoint(const string& path);
+    void setNumSimThreads(unsigned numThreads);
+    void setFunctionalMode(bool functional);
+    bool isFunctionalMode() const
+    {
+        return functionalMode;
+    }
+    uint64_t skipIdleCycles();
 
     bool willAcceptTransaction(uint64_t addr);
     bool willAcceptTransaction();
 
+    // parameters resolved once at construction, for use while simulating
+    const Configuration& getConfiguration() const
+    {
+        return *configuration;
+    }
+
     // output file
     std::ofstream visDataOut;
     ofstream dramsimLog;
@@ -122,6 +141,9 @@ class MultiChannelMemorySystem : public MemoryObject
 
     double backgroundPower;
     unsigned* numFence;
+    ChannelWorkerPool* workerPool;
+    bool idleFastForward;
+    bool functionalMode;
 
     bool is_salp_;
     Configuration* configuration;
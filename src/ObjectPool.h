@@ -0,0 +1,222 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __OBJECT_POOL_HPP__
+#define __OBJECT_POOL_HPP__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+namespace DRAMSim
+{
+struct PoolStats
+{
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t chunks;
+    uint64_t objectsPerChunk;
+};
+
+/*
+ * Free-list allocator behind the class-specific operator new/delete of the objects the
+ * simulator creates and destroys on every command (BusPacket, Transaction).
+ *
+ * Objects are carved from chunks of CHUNK_OBJECTS and recycled through a per-thread free
+ * list, so the channels a ChannelWorkerPool thread owns never take a lock. A thread hands
+ * half of its list to a shared depot once it caches more than MAX_CACHED_OBJECTS (e.g.
+ * transactions created by the host and deleted by the thread owning the channel) and
+ * refills from the depot before carving a new chunk. Chunks live until the process exits.
+ */
+template <typename T>
+class ObjectPool
+{
+  public:
+    static const size_t CHUNK_OBJECTS = 4096;
+    static const size_t MAX_CACHED_OBJECTS = 2 * CHUNK_OBJECTS;
+
+    static void* allocate(size_t size)
+    {
+        // derived classes are bigger than T and bypass the pool
+        if (size != sizeof(T))
+            return ::operator new(size);
+
+        ThreadCache& cache = getCache();
+        if (cache.head == nullptr)
+            cache.refill();
+        FreeNode* node = cache.head;
+        cache.head = node->next;
+        cache.count--;
+        cache.allocations.store(cache.allocations.load(memory_order_relaxed) + 1,
+                                memory_order_relaxed);
+        return node;
+    }
+
+    static void deallocate(void* ptr, size_t size)
+    {
+        if (ptr == nullptr)
+            return;
+        if (size != sizeof(T))
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        ThreadCache& cache = getCache();
+        FreeNode* node = static_cast<FreeNode*>(ptr);
+        node->next = cache.head;
+        cache.head = node;
+        cache.count++;
+        cache.frees.store(cache.frees.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        if (cache.count > MAX_CACHED_OBJECTS)
+            cache.spill(MAX_CACHED_OBJECTS / 2);
+    }
+
+    // totals over all threads, exact when no other thread is allocating
+    static PoolStats getStats()
+    {
+        Depot& depot = getDepot();
+        lock_guard<mutex> guard(depot.lock);
+        PoolStats stats = {depot.retiredAllocations, depot.retiredFrees, depot.chunks.size(),
+                           CHUNK_OBJECTS};
+        for (auto cache : depot.caches)
+        {
+            stats.allocations += cache->allocations.load(memory_order_relaxed);
+            stats.frees += cache->frees.load(memory_order_relaxed);
+        }
+        return stats;
+    }
+
+  private:
+    union FreeNode
+    {
+        FreeNode* next;
+        alignas(T) char storage[sizeof(T)];
+    };
+
+    struct ThreadCache;
+
+    struct Depot
+    {
+        mutex lock;
+        FreeNode* head = nullptr;
+        size_t count = 0;
+        vector<FreeNode*> chunks;
+        vector<ThreadCache*> caches;
+        uint64_t retiredAllocations = 0;
+        uint64_t retiredFrees = 0;
+    };
+
+    struct ThreadCache
+    {
+        FreeNode* head = nullptr;
+        size_t count = 0;
+        // written by the owning thread only, atomic so getStats() can read them
+        atomic<uint64_t> allocations;
+        atomic<uint64_t> frees;
+
+        ThreadCache() : allocations(0), frees(0)
+        {
+            Depot& depot = getDepot();
+            lock_guard<mutex> guard(depot.lock);
+            depot.caches.push_back(this);
+        }
+
+        ~ThreadCache()
+        {
+            spill(count);
+            Depot& depot = getDepot();
+            lock_guard<mutex> guard(depot.lock);
+            depot.retiredAllocations += allocations.load(memory_order_relaxed);
+            depot.retiredFrees += frees.load(memory_order_relaxed);
+            depot.caches.erase(find(depot.caches.begin(), depot.caches.end(), this));
+        }
+
+        void refill()
+        {
+            Depot& depot = getDepot();
+            {
+                lock_guard<mutex> guard(depot.lock);
+                size_t num = depot.count < CHUNK_OBJECTS ? depot.count : CHUNK_OBJECTS;
+                for (size_t i = 0; i < num; i++)
+                {
+                    FreeNode* node = depot.head;
+                    depot.head = node->next;
+                    node->next = head;
+                    head = node;
+                }
+                depot.count -= num;
+                count += num;
+            }
+            if (head != nullptr)
+                return;
+
+            FreeNode* chunk = static_cast<FreeNode*>(::operator new(CHUNK_OBJECTS * sizeof(FreeNode)));
+            for (size_t i = 0; i < CHUNK_OBJECTS; i++)
+            {
+                chunk[i].next = head;
+                head = &chunk[i];
+            }
+            count += CHUNK_OBJECTS;
+            lock_guard<mutex> guard(depot.lock);
+            depot.chunks.push_back(chunk);
+        }
+
+        void spill(size_t num)
+        {
+            Depot& depot = getDepot();
+            lock_guard<mutex> guard(depot.lock);
+            for (size_t i = 0; i < num; i++)
+            {
+                FreeNode* node = head;
+                head = node->next;
+                node->next = depot.head;
+                depot.head = node;
+            }
+            depot.count += num;
+            count -= num;
+        }
+    };
+
+    static ThreadCache& getCache()
+    {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    // never destroyed: objects may still be deleted from other static destructors
+    static Depot& getDepot()
+    {
+        static Depot* depot = new Depot;
+        return *depot;
+    }
+};
+
+// class-specific operator new/delete routing a class through ObjectPool
+#define DECLARE_POOLED_NEW(T)                           \
+    static void* operator new(size_t size)              \
+    {                                                   \
+        return ObjectPool<T>::allocate(size);           \
+    }                                                   \
+    static void operator delete(void* ptr, size_t size) \
+    {                                                   \
+        ObjectPool<T>::deallocate(ptr, size);           \
+    }
+}  // namespace DRAMSim
+
+#endif
@@ -13,6 +13,7 @@
 #include <sstream>
 #include <string>
 
+#include "IntBurst.h"
 #include "PIMBlock.h"
 #include "PrintMacros.h"
 #include "SystemConfiguration.h"
@@ -20,101 +21,164 @@
 //PIMBLOCK SEEMS LIKE BANK LEVEL LOGIC
 using namespace DRAMSim;
 
-void PIMBlock::add(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
+void PIMBlock::add(BurstType* dst, const BurstType* src0, const BurstType* src1, int numBlocks)
 {
     if (pimPrecision_ == FP16)
     {
-        for (int i = 0; i < 16; i++)
-        {
-            dstBst.fp16Data_[i] = src0Bst.fp16Data_[i] + src1Bst.fp16Data_[i];
-        }
+        fp16Kernels_->add(dst->fp16Data_, src0->fp16Data_, src1->fp16Data_, numBlocks);
+    }
+    else if (pimPrecision_ == BF16)
+    {
+        bf16Kernels_->add(dst->u16Data_, src0->u16Data_, src1->u16Data_, numBlocks);
     }
     else if (pimPrecision_ == FP32)
     {
-        for (int i = 0; i < 8; i++)
+        for (int pb = 0; pb < numBlocks; pb++)
         {
-            dstBst.fp32Data_[i] = src0Bst.fp32Data_[i] + src1Bst.fp32Data_[i];
+            for (int i = 0; i < 8; i++)
+                dst[pb].fp32Data_[i] = src0[pb].fp32Data_[i] + src1[pb].fp32Data_[i];
         }
     }
+    else if (pimPrecision_ == INT8 || pimPrecision_ == INT4)
+    {
+        intBurstAdd(pimPrecision_, dst, src0, src1, numBlocks);
+    }
     else
-        dstBst = src0Bst + src1Bst;
+    {
+        for (int pb = 0; pb < numBlocks; pb++) dst[pb] = src0[pb] + src1[pb];
+    }
 }
 
-void PIMBlock::mul(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
+void PIMBlock::mul(BurstType* dst, const BurstType* src0, const BurstType* src1, int numBlocks)
 {
     if (pimPrecision_ == FP16)
     {
-        for (int i = 0; i < 16; i++)
-        {
-            dstBst.fp16Data_[i] = src0Bst.fp16Data_[i] * src1Bst.fp16Data_[i];
-        }
+        fp16Kernels_->mul(dst->fp16Data_, src0->fp16Data_, src1->fp16Data_, numBlocks);
+    }
+    else if (pimPrecision_ == BF16)
+    {
+        bf16Kernels_->mul(dst->u16Data_, src0->u16Data_, src1->u16Data_, numBlocks);
     }
     else if (pimPrecision_ == FP32)
     {
-        for (int i = 0; i < 8; i++)
+        for (int pb = 0; pb < numBlocks; pb++)
         {
-            dstBst.fp32Data_[i] = src0Bst.fp32Data_[i] * src1Bst.fp32Data_[i];
+            for (int i = 0; i < 8; i++)
+                dst[pb].fp32Data_[i] = src0[pb].fp32Data_[i] * src1[pb].fp32Data_[i];
         }
     }
+    else if (pimPrecision_ == INT8 || pimPrecision_ == INT4)
+    {
+        intBurstMul(pimPrecision_, dst, src0, src1, numBlocks);
+    }
     else
-        dstBst = src0Bst * src1Bst;
+    {
+        for (int pb = 0; pb < numBlocks; pb++) dst[pb] = src0[pb] * src1[pb];
+    }
 }
 
-void PIMBlock::mac(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
+void PIMBlock::mac(BurstType* dst, const BurstType* src0, const BurstType* src1, int numBlocks)
 {
     if (pimPrecision_ == FP16)
     {
-        for (int i = 0; i < 16; i++)
-        {
-            dstBst.fp16Data_[i] = src0Bst.fp16Data_[i] * src1Bst.fp16Data_[i] + dstBst.fp16Data_[i];
-        }
+        fp16Kernels_->mad(dst->fp16Data_, src0->fp16Data_, src1->fp16Data_, dst->fp16Data_,
+                          numBlocks);
 
-        DEBUG("MAC " << src0Bst.hexToStr2() << "*+" << src1Bst.hexToStr2() << ""
-                     << dstBst.hexToStr2());
+        DEBUG("MAC " << src0->hexToStr2() << "*+" << src1->hexToStr2() << "" << dst->hexToStr2());
+    }
+    else if (pimPrecision_ == BF16)
+    {
+        bf16Kernels_->mad(dst->u16Data_, src0->u16Data_, src1->u16Data_, dst->u16Data_,
+                          numBlocks);
     }
     else if (pimPrecision_ == FP32)
     {
-        for (int i = 0; i < 8; i++)
+        for (int pb = 0; pb < numBlocks; pb++)
         {
-            dstBst.fp32Data_[i] = src0Bst.fp32Data_[i] * src1Bst.fp32Data_[i] + dstBst.fp32Data_[i];
+            for (int i = 0; i < 8; i++)
+                dst[pb].fp32Data_[i] =
+                    src0[pb].fp32Data_[i] * src1[pb].fp32Data_[i] + dst[pb].fp32Data_[i];
         }
     }
+    else if (pimPrecision_ == INT8 || pimPrecision_ == INT4)
+    {
+        intBurstMad(pimPrecision_, dst, src0, src1, dst, numBlocks);
+    }
     else
-        dstBst = src0Bst * src1Bst + dstBst;
+    {
+        for (int pb = 0; pb < numBlocks; pb++) dst[pb] = src0[pb] * src1[pb] + dst[pb];
+    }
 }
 
-void PIMBlock::mad(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst, BurstType& src2Bst)
+void PIMBlock::mad(BurstType* dst, const BurstType* src0, const BurstType* src1,
+                   const BurstType* src2, int numBlocks)
 {
     if (pimPrecision_ == FP16)
     {
-        for (int i = 0; i < 16; i++)
-        {
-            dstBst.fp16Data_[i] =
-                src0Bst.fp16Data_[i] * src1Bst.fp16Data_[i] + src2Bst.fp16Data_[i]; //put srfA or srfM to src2bst
-        }
+        fp16Kernels_->mad(dst->fp16Data_, src0->fp16Data_, src1->fp16Data_, src2->fp16Data_,
+                          numBlocks);
+    }
+    else if (pimPrecision_ == BF16)
+    {
+        bf16Kernels_->mad(dst->u16Data_, src0->u16Data_, src1->u16Data_, src2->u16Data_,
+                          numBlocks);
     }
     else if (pimPrecision_ == FP32)
     {
-        for (int i = 0; i < 8; i++)
+        for (int pb = 0; pb < numBlocks; pb++)
         {
-            dstBst.fp32Data_[i] =
-                src0Bst.fp32Data_[i] * src1Bst.fp32Data_[i] + src2Bst.fp32Data_[i];
+            for (int i = 0; i < 8; i++)
+                dst[pb].fp32Data_[i] =
+                    src0[pb].fp32Data_[i] * src1[pb].fp32Data_[i] + src2[pb].fp32Data_[i];
         }
     }
+    else if (pimPrecision_ == INT8 || pimPrecision_ == INT4)
+    {
+        intBurstMad(pimPrecision_, dst, src0, src1, src2, numBlocks);
+    }
     else
-        dstBst = src0Bst * src1Bst + src2Bst;
+    {
+        for (int pb = 0; pb < numBlocks; pb++) dst[pb] = src0[pb] * src1[pb] + src2[pb];
+    }
 }
 
-void PIMBlock::burstmax(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
+void PIMBlock::burstmax(BurstType* dst, const BurstType* src0, const BurstType* src1, int numBlocks)
 {
     if (pimPrecision_ == FP16)
     {
-        for (int i = 0; i < 16; i++)
+        for (int i = 0; i < 16 * numBlocks; i++)
+        {
+            const fp16& a = src0[i / 16].fp16Data_[i % 16];
+            const fp16& b = src1[i / 16].fp16Data_[i % 16];
+            dst[i / 16].fp16Data_[i % 16] = (a > b) ? a : b;
+        }
+    }
+    else if (pimPrecision_ == BF16)
+    {
+        for (int i = 0; i < 16 * numBlocks; i++)
         {
-            dstBst.fp16Data_[i] = (src0Bst.fp16Data_[i] > src1Bst.fp16Data_[i])?src0Bst.fp16Data_[i]:src1Bst.fp16Data_[i];
+            uint16_t a = src0[i / 16].u16Data_[i % 16];
+            uint16_t b = src1[i / 16].u16Data_[i % 16];
+            dst[i / 16].u16Data_[i % 16] = (convertBF2F(a) > convertBF2F(b)) ? a : b;
         }
     }
+    // only FP16 and BF16 have a max unit, other precisions leave dst unchanged
 }
+
+void PIMBlock::relu(BurstType* dst, int numBlocks)
+{
+    if (pimPrecision_ == INT8 || pimPrecision_ == INT4)
+    {
+        intBurstRelu(pimPrecision_, dst, numBlocks);
+        return;
+    }
+    for (int i = 0; i < 16 * numBlocks; i++)
+    {
+        uint16_t& v = dst[i / 16].u16Data_[i % 16];
+        v = (v & (1 << 15)) ? 0 : v;
+    }
+}
+
 void PIMBlock::reducesum(BurstType& dstBst)
 {
     if(pimPrecision_ == FP16)
@@ -132,17 +196,3 @@ void PIMBlock::reducesum(BurstType& dstBst)
         }
     }
 }
-
-std::string PIMBlock::print()
-{
-    stringstream ss;
-    ss << "[SRF]" << srf.binToStr();
-    ss << "[GRF_A]";
-    for (int i = 0; i < 8; i++) ss << grfA[i].binToStr();
-    ss << "[GRF_B]";
-    for (int i = 0; i < 8; i++) ss << grfB[i].binToStr();
-    ss << "[M_OUT]" << mOut.binToStr();
-    ss << "[A_OUT]" << aOut.binToStr();
-
-    return ss.str();
-}
@@ -19,39 +19,47 @@
 #include <string>
 
 #include "Burst.h"
+#include "FP16Simd.h"
 #include "SystemConfiguration.h"
 
 using namespace std;
 
 namespace DRAMSim
 {
+/*
+ * ALU of the PIM blocks of a rank. Their registers live in PIMRegisterFile, one array per
+ * register across blocks, so each operation is applied to numBlocks consecutive bursts in
+ * a single call. dst may alias a source array.
+ */
 class PIMBlock
 {
   public:
     PIMBlock()
     {
         pimPrecision_ = PIMConfiguration::getPIMPrecision();
+        fp16Kernels_ = &getFP16BurstKernels();
+        bf16Kernels_ = &getBF16BurstKernels();
     }
-    PIMBlock(const PIMPrecision& pimPrecision) : pimPrecision_(pimPrecision) {}
-
-    BurstType srf; // srf has A part and M part each consists of 8 scalas each
-    BurstType grfA[8];  // FIXME: hard coding shcha
-    BurstType grfB[8];  // use as subarray block, too
-    BurstType mOut;
-    BurstType aOut;
-
-    void add(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst);
-    void mac(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst);
-    void mul(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst);
-    void mad(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst, BurstType& src2Bst);
-    void div(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst);
-    void burstmax(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst);
+    PIMBlock(const PIMPrecision& pimPrecision)
+        : pimPrecision_(pimPrecision),
+          fp16Kernels_(&getFP16BurstKernels()),
+          bf16Kernels_(&getBF16BurstKernels())
+    {
+    }
+
+    void add(BurstType* dst, const BurstType* src0, const BurstType* src1, int numBlocks);
+    void mac(BurstType* dst, const BurstType* src0, const BurstType* src1, int numBlocks);
+    void mul(BurstType* dst, const BurstType* src0, const BurstType* src1, int numBlocks);
+    void mad(BurstType* dst, const BurstType* src0, const BurstType* src1, const BurstType* src2,
+             int numBlocks);
+    void burstmax(BurstType* dst, const BurstType* src0, const BurstType* src1, int numBlocks);
+    void relu(BurstType* dst, int numBlocks);
     void reducesum(BurstType& dstBst);
-    void ldexpf(BurstType& dstBst, BurstType& src0Bst);
-    std::string print();
 
   private:
     PIMPrecision pimPrecision_;
+    const FP16BurstKernels* fp16Kernels_;
+    const BF16BurstKernels* bf16Kernels_;
 };
 
 }  // namespace DRAMSim
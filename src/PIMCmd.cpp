@@ -78,6 +78,8 @@ void PIMCmd::fromInt(uint32_t val)
             src1Idx_ = fromBit(val, 4, 0);
             break;
         case PIMCmdType::MAX:
+        case PIMCmdType::GELU:
+        case PIMCmdType::EXP:
             dst_ = PIMOpdType(fromBit(val, 3, 25));
             src0_ = PIMOpdType(fromBit(val, 3, 22));
             src1_ = PIMOpdType(fromBit(val, 3, 19));
@@ -186,6 +188,8 @@ uint32_t PIMCmd::toInt() const
             val |= toBit(src1Idx_, 4, 0);
             break;
         case PIMCmdType::MAX:
+        case PIMCmdType::GELU:
+        case PIMCmdType::EXP:
             val |= toBit(int(dst_), 3, 25);
             val |= toBit(int(src0_), 3, 22);
             val |= toBit(int(src1_), 3, 19);
@@ -247,8 +251,15 @@ std::string PIMCmd::toStr() const
                 ss << ", relu";
             break;
 
+        case PIMCmdType::GELU:
+            ss << opdToStr(dst_, dstIdx_) << ", ";
+            ss << opdToStr(src0_, src0Idx_);
+            break;
+
         case PIMCmdType::ADD:
         case PIMCmdType::MUL:
+        case PIMCmdType::MAX:
+        case PIMCmdType::EXP:
         case PIMCmdType::MAC:
             ss << opdToStr(dst_, dstIdx_) << ", ";
             ss << opdToStr(src0_, src0Idx_) << ", ";
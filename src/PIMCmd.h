@@ -30,9 +30,9 @@ enum class PIMCmdType
     MUL,
     MAC,
     MAD,
-    REV0,
-    REV1,
-    REV2,
+    MAX,  // a CRF entry has 4 opcode bits, so MAX takes the first reserved slot
+    GELU,  // GELU and EXP look up the table loaded through WRIO_TO_LUT_, see PIMRank::writeLut()
+    EXP,
     MOV,
     FILL,
     REV3,
@@ -42,8 +42,7 @@ enum class PIMCmdType
     JUMP,
     EXIT,
     LDEXPF,
-    COPY,
-    MAX
+    COPY
 };
 
 enum class PIMOpdType
@@ -88,7 +87,8 @@ class PIMCmd
           isAuto_(0),
           dstIdx_(0),
           src0Idx_(0),
-          src1Idx_(0)
+          src1Idx_(0),
+          isRelu_(0)
     {
     }
 
@@ -255,6 +255,10 @@ class PIMCmd
                 return "MUL";
             case PIMCmdType::MAX:
                 return "MAX";
+            case PIMCmdType::GELU:
+                return "GELU";
+            case PIMCmdType::EXP:
+                return "EXP";
             case PIMCmdType::MAC:
                 return "MAC";
             case PIMCmdType::MAD:
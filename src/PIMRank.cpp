@@ -10,10 +10,12 @@
  * only)
  **************************************************************************************************/
 
+#include <algorithm>
 #include <bitset>
 #include <iostream>
 
 #include "AddressMapping.h"
+#include "Checkpoint.h"
 #include "PIMCmd.h"
 #include "PIMRank.h"
 
@@ -29,17 +31,69 @@ PIMRank::PIMRank(ostream& simLog, Configuration& configuration, bool is_salp)
       numJumpToBeTaken_(-1),
       lastRepeatIdx_(-1),
       numRepeatToBeDone_(-1),
+      pimOpMode_(false),
+      pimOpMode_single_(false),
+      toggleEvenBank_(false),
+      toggleOddBank_(false),
+      toggleRa12h_(false),
       useAllGrf_(true),
       crfExit_(false),
       config(configuration),
-      pimBlocks(getConfigParam(UINT, "NUM_PIM_BLOCKS"),
-                PIMBlock(PIMConfiguration::getPIMPrecision())),
+      pimAlu(PIMConfiguration::getPIMPrecision()),
+      pimRegs(getConfigParam(UINT, "NUM_PIM_BLOCKS")),
+      lutAlu_(PIMConfiguration::getPIMPrecision()),
+      lutFill_(0),
       sblocks(getConfigParam(UINT, "NUM_S_BLOCKS"),
                 SBlock(PIMConfiguration::getPIMPrecision())),
       is_salp_(is_salp)
 {
     currentClockCycle = 0;
     rank = nullptr;
+    cmdTrace = nullptr;
+    crfDirty_ = true;
+    for (auto& scratch : opdScratch_) scratch.resize(pimRegs.getNumBlocks());
+}
+
+void PIMRank::decodeCrf()
+{
+    for (int pc = 0; pc <= CRF_SIZE; pc++)
+    {
+        CrfMicroOp& op = crfOps_[pc];
+        op.raw = (pc < CRF_SIZE) ? crf.data[pc] : PIMCmd(PIMCmdType::EXIT, 0).toInt();
+        op.cmd = PIMCmd();
+        op.cmd.fromInt(op.raw);
+        op.repeats = false;
+        op.repeatCount = 0;
+        op.jumpTarget = pc;
+
+        switch (op.cmd.type_)
+        {
+            case PIMCmdType::JUMP:
+                op.repeatCount = op.cmd.loopCounter_;
+                op.jumpTarget = pc - op.cmd.loopOffset_;
+                break;
+            case PIMCmdType::EXIT:
+                break;
+            case PIMCmdType::MOV:
+            case PIMCmdType::NOP:
+                op.repeats = true;
+                op.repeatCount = op.cmd.loopCounter_;
+                break;
+            default:
+                if (op.cmd.type_ == PIMCmdType::FILL || op.cmd.isAuto_)
+                {
+                    op.repeats = true;
+                    op.repeatCount = 8 - 1; //not always doing 8 loops.. tricky one should exists..
+                }
+                break;
+        }
+    }
+    crfDirty_ = false;
+}
+
+void PIMRank::attachCmdTrace(CmdTraceSink* sink)
+{
+    cmdTrace = sink;
 }
 
 void PIMRank::attachRank(Rank* r)
@@ -82,27 +136,21 @@ void PIMRank::controlPIM(BusPacket* packet) //make salp-control pim
         uint8_t grf_a_zeroize = packet->data->u8Data_[20];
         if (grf_a_zeroize)
         {
-            if (DEBUG_CMD_TRACE)
-            {
-                PRINTC(RED, OUTLOG_CH_RA("GRF_A_ZEROIZE"));
-            }
+            TRACE_CH_RA(TRACE_GRF_A_ZEROIZE);
             BurstType burst_zero;
             for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
             {
-                for (int i = 0; i < 8; i++) pimBlocks[pb].grfA[i] = burst_zero;
+                for (int i = 0; i < 8; i++) pimRegs.grfA(i)[pb] = burst_zero;
             }
         }
         uint8_t grf_b_zeroize = packet->data->u8Data_[21];
         if (grf_b_zeroize)
         {
-            if (DEBUG_CMD_TRACE)
-            {
-                PRINTC(RED, OUTLOG_CH_RA("GRF_B_ZEROIZE"));
-            }
+            TRACE_CH_RA(TRACE_GRF_B_ZEROIZE);
             BurstType burst_zero;
             for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
             {
-                for (int i = 0; i < 8; i++) pimBlocks[pb].grfB[i] = burst_zero; //set idx..
+                for (int i = 0; i < 8; i++) pimRegs.grfB(i)[pb] = burst_zero; //set idx..
             }
         }
     }
@@ -110,10 +158,7 @@ void PIMRank::controlPIM(BusPacket* packet) //make salp-control pim
         uint8_t grf_zeroize = packet->data->u8Data_[20];
         if(grf_zeroize)
         {
-            if (DEBUG_CMD_TRACE)
-            {
-                PRINTC(RED, OUTLOG_CH_RA("GRF_ZEROIZE"));
-            }
+            TRACE_CH_RA(TRACE_GRF_ZEROIZE);
             BurstType burst_zero;
             for (int sb = 0; sb < config.NUM_S_BLOCKS; sb++)
             {
@@ -136,12 +181,12 @@ void PIMRank::controlPIM(BusPacket* packet) //make salp-control pim
         pimPC_ = 0;
         lastJumpIdx_ = numJumpToBeTaken_ = lastRepeatIdx_ = numRepeatToBeDone_ = -1;
         crfExit_ = false;
-        PRINTC(RED, OUTLOG_CH_RA("HAB_PIM"));
+        TRACE_CH_RA(TRACE_HAB_PIM);
     }
     else
     {
         rank->mode_ = dramMode::HAB;
-        PRINTC(RED, OUTLOG_CH_RA("HAB mode"));
+        TRACE_CH_RA(TRACE_HAB_MODE);
     }
 }
 
@@ -179,11 +224,11 @@ void PIMRank::readHab(BusPacket* packet)
 {
     if (packet->row & (1 << 12))  // ignored
     {
-        PRINTC(GRAY, OUTLOG_ALL("READ"));
+        TRACE_CMD(TRACE_READ);
     }
     else
     {
-        PRINTC(GRAY, OUTLOG_ALL("BANK_TO_PIM"));
+        TRACE_CMD(TRACE_BANK_TO_PIM);
 #ifndef NO_STORAGE
         int grf_id;
         int grf_id_sub;
@@ -198,9 +243,9 @@ void PIMRank::readHab(BusPacket* packet)
                     {
                         rank->banks[pb * 2 + packet->bank].read(packet);
                         if (grf_id < 8)
-                            pimBlocks[pb].grfA[grf_id] = *(packet->data);
+                            pimRegs.grfA(grf_id)[pb] = *(packet->data);
                         else
-                            pimBlocks[pb].grfB[grf_id - 8] = *(packet->data);
+                            pimRegs.grfB(grf_id - 8)[pb] = *(packet->data);
                     }
                 }
             }
@@ -224,7 +269,7 @@ void PIMRank::readHab(BusPacket* packet)
                 for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
                 {
                     rank->banks[pb * 2 + packet->bank].read(packet);
-                    pimBlocks[pb].grfB[grf_id] = *(packet->data);
+                    pimRegs.grfB(grf_id)[pb] = *(packet->data);
                 }
             }
             else
@@ -242,6 +287,31 @@ void PIMRank::readHab(BusPacket* packet)
 }
 
 
+/*
+ * WRIO_TO_LUT_: column 0x2 takes lut_table::getHeader() and restarts the table, column 0x3 takes
+ * the bursts of lut_table::sets one after another. The GELU and EXP commands use the table once
+ * its last burst is in.
+ */
+void PIMRank::writeLut(BusPacket* packet)
+{
+    TRACE_CH_RA(TRACE_BWRITE_LUT);
+    if (packet->column == 0x2)
+    {
+        lutHeader_ = *(packet->data);
+        lutRegs_.assign(lutHeader_.u16Data_[0] / 4, BurstType());
+        lutFill_ = 0;
+        return;
+    }
+    if (lutFill_ >= lutRegs_.size())
+    {
+        PRINT("Warning, WRIO_TO_LUT_ past the end of the table, header missing?");
+        return;
+    }
+    lutRegs_[lutFill_++] = *(packet->data);
+    if (lutFill_ == lutRegs_.size())
+        lutAlu_.load(lutHeader_, lutRegs_.data());
+}
+
 void PIMRank::writeHab(BusPacket* packet)
 {
     //cout<<"[pimrank] control pim and clock is "<<currentClockCycle<<" and row is "<<packet->row<<" and col is "<<packet->column<<" and data is " <<packet->data<<endl;
@@ -254,13 +324,10 @@ void PIMRank::writeHab(BusPacket* packet)
         if ((0x08 <= packet->column && packet->column <= 0x0f) ||
             (0x18 <= packet->column && packet->column <= 0x1f)) //GRFA = 0X08~0X0F / GRFB = 0X18~0X1F
         {
-            if (DEBUG_CMD_TRACE)
-            {
-                if (packet->column - 8 < 8)
-                    PRINTC(GREEN, OUTLOG_B_GRF_A("BWRITE_GRF_A"));
-                else
-                    PRINTC(GREEN, OUTLOG_B_GRF_B("BWRITE_GRF_B"));
-            }
+            if (packet->column - 8 < 8)
+                TRACE_REG(TRACE_BWRITE_GRF_A);
+            else
+                TRACE_REG(TRACE_BWRITE_GRF_B);
 #ifndef NO_STORAGE
             if(!is_salp_)
             {    
@@ -268,10 +335,10 @@ void PIMRank::writeHab(BusPacket* packet)
                 {
                     if (packet->column - 8 < 8)
                     {
-                        pimBlocks[pb].grfA[packet->column - 0x8] = *(packet->data);
+                        pimRegs.grfA(packet->column - 0x8)[pb] = *(packet->data);
                     }
                     else
-                        pimBlocks[pb].grfB[packet->column - 0x18] = *(packet->data);
+                        pimRegs.grfB(packet->column - 0x18)[pb] = *(packet->data);
                 }
             }
             else
@@ -294,24 +361,27 @@ void PIMRank::writeHab(BusPacket* packet)
         }
         else if (0x04 <= packet->column && packet->column <= 0x07)
         {
-            if (DEBUG_CMD_TRACE)
-                PRINTC(GREEN, OUTLOG_B_CRF("BWRITE_CRF"));
+            TRACE_REG(TRACE_BWRITE_CRF);
             crf.bst[packet->column - 0x04] = *(packet->data); //same for salpim and 
+            crfDirty_ = true;
         }
         else if (packet->column == 0x1)
         {
-            if (DEBUG_CMD_TRACE)
-                PRINTC(GREEN, OUTLOG_CH_RA("BWRITE_SRF"));
-            for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++) pimBlocks[pb].srf = *(packet->data);
+            TRACE_CH_RA(TRACE_BWRITE_SRF);
+            for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++) pimRegs.srf()[pb] = *(packet->data);
+        }
+        else if (packet->column == 0x2 || packet->column == 0x3)
+        {
+            writeLut(packet);
         }
     }
     else if (packet->row & 1 << 12)
     {
-        PRINTC(GRAY, OUTLOG_ALL("WRITE"));
+        TRACE_CMD(TRACE_WRITE);
     }
     else  // PIM (only GRF) to Bank Move
     {
-        PRINTC(GREEN, OUTLOG_ALL("PIM_TO_BANK"));
+        TRACE_CMD(TRACE_PIM_TO_BANK);
 
 #ifndef NO_STORAGE
         int grf_id = packet->column & 0xf;
@@ -321,9 +391,9 @@ void PIMRank::writeHab(BusPacket* packet)
             for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
             {
                 if (grf_id < 8)
-                    *(packet->data) = pimBlocks[pb].grfA[grf_id];
+                    *(packet->data) = pimRegs.grfA(grf_id)[pb];
                 else
-                    *(packet->data) = pimBlocks[pb].grfB[grf_id - 8];
+                    *(packet->data) = pimRegs.grfB(grf_id - 8)[pb];
                 //*(packet->data) = sblocks[pb].grf[grf_id_sub];
                 rank->banks[pb * 2 + packet->bank].write(packet);
                 //rank->banks_sub[pb][grf_id].write(packet);
@@ -337,12 +407,12 @@ void PIMRank::writeHab(BusPacket* packet)
                 {
                     if (packet->bank == 0)
                     {
-                        *(packet->data) = pimBlocks[pb].grfA[grf_id];
+                        *(packet->data) = pimRegs.grfA(grf_id)[pb];
                         rank->banks[pb * 2].write(packet);  // basically read from bank;
                     }
                     else if (packet->bank == 1)
                     {
-                        *(packet->data) = pimBlocks[pb].grfB[grf_id];
+                        *(packet->data) = pimRegs.grfB(grf_id)[pb];
                         rank->banks[pb * 2 + 1].write(packet);  // basically read from bank.
                     }
                 }
@@ -371,10 +441,10 @@ void PIMRank::readOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packet
     switch (type)
     {
         case PIMOpdType::A_OUT:
-            bst = pimBlocks[pb].aOut;
+            bst = pimRegs.aOut()[pb];
             return;
         case PIMOpdType::M_OUT:
-            bst = pimBlocks[pb].mOut;
+            bst = pimRegs.mOut()[pb];
             return;
         case PIMOpdType::BANK:
             if(is_salp_)
@@ -393,13 +463,13 @@ void PIMRank::readOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packet
             return;
         case PIMOpdType::GRF_A:
             if (is_auto)
-                bst = pimBlocks[pb].grfA[(is_mac) ? getGrfIdxHigh(packet->row, packet->column)
-                                                  : getGrfIdx(packet->column)];
+                bst = pimRegs.grfA((is_mac) ? getGrfIdxHigh(packet->row, packet->column)
+                                                  : getGrfIdx(packet->column))[pb];
             else
-                bst = pimBlocks[pb].grfA[idx];
+                bst = pimRegs.grfA(idx)[pb];
             return;
         case PIMOpdType::GRF_B: //why 
-            bst = pimBlocks[pb].grfB[(is_auto) ? getGrfIdx(packet->column) : idx];
+            bst = pimRegs.grfB((is_auto) ? getGrfIdx(packet->column) : idx)[pb];
             return;
         case PIMOpdType::GRF: //no auto mode indeed
             //cout<<"[pimrank] read grf and clock is "<<currentClockCycle<<" and idx is "<<idx<<" and pb is "<<pb<<endl;
@@ -410,10 +480,10 @@ void PIMRank::readOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packet
             bst.set(sblocks[pb].blf.fp16Data_[idx]);
         }
         case PIMOpdType::SRF_M:
-            bst.set(pimBlocks[pb].srf.fp16Data_[idx]);
+            bst.set(pimRegs.srf()[pb].fp16Data_[idx]);
             return;
         case PIMOpdType::SRF_A:
-            bst.set(pimBlocks[pb].srf.fp16Data_[idx + 8]);
+            bst.set(pimRegs.srf()[pb].fp16Data_[idx + 8]);
             return;
         case PIMOpdType::EVEN_BANK:
             if(!is_salp_)
@@ -447,10 +517,10 @@ void PIMRank::writeOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packe
     switch (type)
     {
         case PIMOpdType::A_OUT:
-            pimBlocks[pb].aOut = bst; //which means a_out
+            pimRegs.aOut()[pb] = bst; //which means a_out
             return;
         case PIMOpdType::M_OUT:
-            pimBlocks[pb].mOut = bst;
+            pimRegs.mOut()[pb] = bst;
             return;
         case PIMOpdType::BANK:
             //cout<<"[pimrank] write bank and clock is "<<currentClockCycle<<" and pb is "<<pb<<" and idx is "<<idx<<" and sub is "<<sub<<" and banks_sub size is "<<
@@ -466,19 +536,19 @@ void PIMRank::writeOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packe
             if(!is_salp_)
             {
                 if (is_auto)
-                    pimBlocks[pb].grfA[(is_mac) ? getGrfIdxHigh(packet->row, packet->column)
-                                                : getGrfIdx(packet->column)] = bst;
+                    pimRegs.grfA((is_mac) ? getGrfIdxHigh(packet->row, packet->column)
+                                                : getGrfIdx(packet->column))[pb] = bst;
                 else
-                    pimBlocks[pb].grfA[idx] = bst;
+                    pimRegs.grfA(idx)[pb] = bst;
             }
             return;
         case PIMOpdType::GRF_B:
             if(!is_salp_)
             {
                 if (is_auto)
-                    pimBlocks[pb].grfB[getGrfIdx(packet->column)] = bst;
+                    pimRegs.grfB(getGrfIdx(packet->column))[pb] = bst;
                 else
-                    pimBlocks[pb].grfB[idx] = bst;
+                    pimRegs.grfB(idx)[pb] = bst;
             }
             return;
         case PIMOpdType::GRF:
@@ -496,10 +566,10 @@ void PIMRank::writeOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packe
             sblocks[pb].blf = bst;
             return;
         case PIMOpdType::SRF_M:
-            pimBlocks[pb].srf = bst;
+            pimRegs.srf()[pb] = bst;
             return;
         case PIMOpdType::SRF_A:
-            pimBlocks[pb].srf = bst;
+            pimRegs.srf()[pb] = bst;
             return;
         case PIMOpdType::EVEN_BANK:
             if(!is_salp_)
@@ -531,53 +601,248 @@ void PIMRank::writeOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packe
     return;
 }
 
-void PIMRank::doPIM(BusPacket* packet)
+/*
+ * Operand access of the wide (non-SALP) path. Each resolves an operand once for all PIM blocks
+ * with the same rules as readOpd()/writeOpd(): GRF_A/GRF_B/A_OUT/M_OUT map straight onto a
+ * register array of pimRegs, scalars and bank reads are gathered into a scratch array.
+ */
+BurstType* PIMRank::regOpdAll(PIMOpdType type, BusPacket* packet, int idx, bool is_auto,
+                              bool is_mac)
 {
-    PIMCmd cCmd;
-    //cout<<"[pimrank] do pim and clock is "<<currentClockCycle<<" and row is "<<packet->row<<" and col is "<<packet->column<<endl;
-    //packet->row = packet->row & ((1 << 16) - 1); //which is 0x7fff
-    //cout<<"[pimrank] do pim and clock is "<<currentClockCycle<<" and row is "<<packet->row<<" and col is "<<packet->column<<" and cmd type is " <<cCmd.type_<<endl;
-    do
+    idx = getGrfIdx(idx);
+    switch (type)
+    {
+        case PIMOpdType::A_OUT:
+            return pimRegs.aOut();
+        case PIMOpdType::M_OUT:
+            return pimRegs.mOut();
+        case PIMOpdType::GRF_A:
+            if (is_auto)
+                return pimRegs.grfA((is_mac) ? getGrfIdxHigh(packet->row, packet->column)
+                                             : getGrfIdx(packet->column));
+            return pimRegs.grfA(idx);
+        case PIMOpdType::GRF_B:
+            return pimRegs.grfB((is_auto) ? getGrfIdx(packet->column) : idx);
+        default:
+            return nullptr;
+    }
+}
+
+const BurstType* PIMRank::readOpdAll(BurstType* scratch, PIMOpdType type, BusPacket* packet,
+                                     int idx, bool is_auto, bool is_mac)
+{
+    if (BurstType* regs = regOpdAll(type, packet, idx, is_auto, is_mac))
+        return regs;
+
+    idx = getGrfIdx(idx);
+    switch (type)
+    {
+        case PIMOpdType::GRF:  // readOpd() falls through GRF and BLF into SRF_M
+        case PIMOpdType::BLF:
+        case PIMOpdType::SRF_M:
+            for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
+                scratch[pb].set(pimRegs.srf()[pb].fp16Data_[idx]);
+            break;
+        case PIMOpdType::SRF_A:
+            for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
+                scratch[pb].set(pimRegs.srf()[pb].fp16Data_[idx + 8]);
+            break;
+        case PIMOpdType::EVEN_BANK:
+        case PIMOpdType::ODD_BANK:
+        {
+            int odd = (type == PIMOpdType::ODD_BANK) ? 1 : 0;
+            if (packet->bank % 2 != odd)
+                PRINT("Warning, CRF bank coding and bank id from packet are inconsistent");
+            for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
+            {
+                rank->banks[pb * 2 + odd].read(packet);  // basically read from bank.
+                scratch[pb] = *(packet->data);
+            }
+            break;
+        }
+        default:  // BANK is backed by subarrays only in SALP mode
+            fill_n(scratch, config.NUM_PIM_BLOCKS, BurstType());
+            break;
+    }
+    return scratch;
+}
+
+void PIMRank::writeOpdAll(const BurstType* bst, PIMOpdType type, BusPacket* packet)
+{
+    switch (type)
+    {
+        case PIMOpdType::SRF_M:
+        case PIMOpdType::SRF_A:
+            copy_n(bst, config.NUM_PIM_BLOCKS, pimRegs.srf());
+            return;
+        case PIMOpdType::BLF:
+            for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++) sblocks[pb].blf = bst[pb];
+            return;
+        case PIMOpdType::EVEN_BANK:
+            if (packet->bank % 2 != 0)
+                PRINT("CRF bank coding and bank id from packet are inconsistent");
+            for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
+            {
+                *(packet->data) = bst[pb];
+                rank->banks[pb * 2].write(packet);
+            }
+            return;
+        case PIMOpdType::ODD_BANK:
+            if (packet->bank % 2 == 0)
+            {
+                PRINT("CRF bank coding and bank id from packet are inconsistent");
+                exit(-1);
+            }
+            for (int pb = 0; pb < config.NUM_PIM_BLOCKS; pb++)
+            {
+                *(packet->data) = bst[pb];
+                rank->banks[pb * 2 + 1].write(packet);
+            }
+            return;
+        default:  // BANK and GRF are only written in SALP mode
+            return;
+    }
+}
+
+// one CRF command on every PIM block of the rank, same semantics as doPIMBlock() per block
+void PIMRank::doPIMAllBlocks(BusPacket* packet, const PIMCmd& cCmd)
+{
+    int numBlocks = config.NUM_PIM_BLOCKS;
+    BurstType* scratch[4] = {opdScratch_[0].data(), opdScratch_[1].data(),
+                             opdScratch_[2].data(), opdScratch_[3].data()};
+    bool is_auto = cCmd.isAuto_;
+    bool is_mac = false;
+    switch (cCmd.type_)
+    {
+        case PIMCmdType::FILL:
+        case PIMCmdType::MOV:
+            is_auto = (cCmd.type_ == PIMCmdType::FILL);
+            break;
+        case PIMCmdType::MAC:
+            is_mac = true;
+            break;
+        case PIMCmdType::ADD:
+        case PIMCmdType::MUL:
+        case PIMCmdType::MAX:
+        case PIMCmdType::MAD:
+        case PIMCmdType::GELU:
+        case PIMCmdType::EXP:
+            break;
+        case PIMCmdType::NOP:
+            if (packet->busPacketType == WRITE && packet->bank < 2)
+            {
+                BurstType* grf = (packet->bank == 0) ? pimRegs.grfA(getGrfIdx(packet->column))
+                                                     : pimRegs.grfB(getGrfIdx(packet->column));
+                for (int pb = 0; pb < numBlocks; pb++)
+                {
+                    *(packet->data) = grf[pb];
+                    rank->banks[pb * 2 + packet->bank].write(packet);
+                }
+            }
+            return;
+        default:
+            return;
+    }
+
+    const BurstType* src0 =
+        readOpdAll(scratch[0], cCmd.src0_, packet, cCmd.src0Idx_, is_auto, is_mac);
+    BurstType* dst = regOpdAll(cCmd.dst_, packet, cCmd.dstIdx_, is_auto, is_mac);
+    bool dst_is_reg = (dst != nullptr);
+    if (!dst_is_reg)
+        dst = scratch[3];
+
+    if (cCmd.type_ == PIMCmdType::FILL || cCmd.type_ == PIMCmdType::MOV)
     {
-        cCmd.fromInt(crf.data[pimPC_]);
-        if (DEBUG_CMD_TRACE)
+        if (dst != src0)
+            copy_n(src0, numBlocks, dst);
+        if (cCmd.isRelu_)
+            pimAlu.relu(dst, numBlocks);
+    }
+    else if (cCmd.type_ == PIMCmdType::GELU)
+    {
+        if (dst != src0)
+            copy_n(src0, numBlocks, dst);
+        for (int pb = 0; pb < numBlocks; pb++) lutAlu_.lut(dst[pb], layerType::GELU);
+    }
+    else
+    {
+        const BurstType* src1 =
+            readOpdAll(scratch[1], cCmd.src1_, packet, cCmd.src1Idx_, is_auto, is_mac);
+        if (cCmd.type_ == PIMCmdType::ADD)
+            pimAlu.add(dst, src0, src1, numBlocks);
+        else if (cCmd.type_ == PIMCmdType::MUL)
+            pimAlu.mul(dst, src0, src1, numBlocks);
+        else if (cCmd.type_ == PIMCmdType::MAX)
+            pimAlu.burstmax(dst, src0, src1, numBlocks);
+        else if (cCmd.type_ == PIMCmdType::EXP)
         {
-            PRINTC(CYAN, string((packet->busPacketType == READ) ? "READ ch" : "WRITE ch")
-                             << getChanId() << " ra" << getRankId() << " bg"
-                             << config.addrMapping.bankgroupId(packet->bank) << " b" << packet->bank
-                             << " r" << packet->row << " c" << packet->column << "|| [" << pimPC_
-                             << "] " << cCmd.toStr() << " @ " << currentClockCycle);
+            // exp(src0 + src1), src1 is the shift, e.g. -max of a softmax row in SRF_M
+            pimAlu.add(dst, src0, src1, numBlocks);
+            for (int pb = 0; pb < numBlocks; pb++) lutAlu_.lut(dst[pb], layerType::EXP);
         }
+        else if (cCmd.type_ == PIMCmdType::MAC)
+        {
+            const BurstType* acc =
+                readOpdAll(scratch[2], cCmd.dst_, packet, cCmd.dstIdx_, is_auto, is_mac);
+            if (acc != dst)
+                copy_n(acc, numBlocks, dst);
+            pimAlu.mac(dst, src0, src1, numBlocks);
+        }
+        else
+        {
+            // MAD takes the src2 index from the src1 field, as doPIMBlock() does
+            const BurstType* src2 =
+                readOpdAll(scratch[2], cCmd.src2_, packet, cCmd.src1Idx_, is_auto, is_mac);
+            pimAlu.mad(dst, src0, src1, src2, numBlocks);
+        }
+    }
+
+    if (!dst_is_reg)
+        writeOpdAll(dst, cCmd.dst_, packet);
+}
+
+void PIMRank::doPIM(BusPacket* packet)
+{
+    if (crfDirty_)
+        decodeCrf();
+
+    bool isJump;
+    do
+    {
+        const CrfMicroOp& op = crfOps_[pimPC_];
+        const PIMCmd& cCmd = op.cmd;
+        isJump = (cCmd.type_ == PIMCmdType::JUMP);
+        CMD_TRACE(cmdTrace, (packet->busPacketType == READ) ? TRACE_PIM_READ : TRACE_PIM_WRITE,
+                  currentClockCycle, getChanId(), getRankId(),
+                  config.addrMapping.bankgroupId(packet->bank), packet->bank, packet->row,
+                  packet->column, op.raw, pimPC_);
 
         if (cCmd.type_ == PIMCmdType::EXIT)
         {
             crfExit_ = true;
             break;
         }
-        else if (cCmd.type_ == PIMCmdType::JUMP)
+        else if (isJump)
         {
-            if (lastJumpIdx_ != pimPC_)
+            if (lastJumpIdx_ != pimPC_ && op.repeatCount > 0)
             {
-                if (cCmd.loopCounter_ > 0)
-                {
-                    lastJumpIdx_ = pimPC_;
-                    numJumpToBeTaken_ = cCmd.loopCounter_;
-                }
+                lastJumpIdx_ = pimPC_;
+                numJumpToBeTaken_ = op.repeatCount;
             }
             if (numJumpToBeTaken_ > 0)
             {
-                pimPC_ -= cCmd.loopOffset_;
+                pimPC_ = op.jumpTarget;
                 numJumpToBeTaken_--;
             }
         }
         else
         {
-            if (cCmd.type_ == PIMCmdType::FILL || cCmd.isAuto_)
+            if (op.repeats)
             {
                 if (lastRepeatIdx_ != pimPC_)
                 {
                     lastRepeatIdx_ = pimPC_;
-                    numRepeatToBeDone_ = 8 - 1; //not always doing 8 loops.. tricky one should exists..
+                    numRepeatToBeDone_ = op.repeatCount;
                 }
 
                 if (numRepeatToBeDone_ > 0)
@@ -588,55 +853,21 @@ void PIMRank::doPIM(BusPacket* packet)
                 else
                     lastRepeatIdx_ = -1;
             }
-            else if(cCmd.type_ == PIMCmdType::MOV)
+            if (!is_salp_)
             {
-                if (lastRepeatIdx_!=pimPC_)
+                if (DEBUG_PIM_BLOCK)
                 {
-                    lastRepeatIdx_ = pimPC_;
-                    numRepeatToBeDone_ = cCmd.loopCounter_;
+                    PRINT(pimRegs.print(0));
+                    PRINT("[BANK_R]" << packet->data->binToStr());
+                    PRINT("[CMD]" << bitset<32>(cCmd.toInt()) << "(" << cCmd.toStr() << ")");
                 }
 
-                if (numRepeatToBeDone_ > 0)
-                {
-                    pimPC_ -= 1;
-                    numRepeatToBeDone_--;
-                }
-                else
-                    lastRepeatIdx_ = -1;
-            }
-            else if (cCmd.type_ == PIMCmdType::NOP)
-            {
-                if (lastRepeatIdx_ != pimPC_)
-                {
-                    lastRepeatIdx_ = pimPC_;
-                    numRepeatToBeDone_ = cCmd.loopCounter_;
-                }
+                doPIMAllBlocks(packet, cCmd);
 
-                if (numRepeatToBeDone_ > 0)
+                if (DEBUG_PIM_BLOCK)
                 {
-                    pimPC_ -= 1;
-                    numRepeatToBeDone_--;
-                }
-                else
-                    lastRepeatIdx_ = -1;
-            }
-            if(!is_salp_){
-                for (int pimblock_id = 0; pimblock_id < config.NUM_PIM_BLOCKS; pimblock_id++)
-                {
-                    if (DEBUG_PIM_BLOCK && pimblock_id == 0)
-                    {
-                        PRINT(pimBlocks[pimblock_id].print());
-                        PRINT("[BANK_R]" << packet->data->binToStr());
-                        PRINT("[CMD]" << bitset<32>(cCmd.toInt()) << "(" << cCmd.toStr() << ")");
-                    }
-
-                    doPIMBlock(packet, cCmd, pimblock_id);
-
-                    if (DEBUG_PIM_BLOCK && pimblock_id == 0)
-                    {
-                        PRINT(pimBlocks[pimblock_id].print());
-                        PRINT("----------");
-                    }
+                    PRINT(pimRegs.print(0));
+                    PRINT("----------");
                 }
             }
             else
@@ -665,14 +896,12 @@ void PIMRank::doPIM(BusPacket* packet)
         }
         pimPC_++;
         // EXIT check
-        PIMCmd next_cmd;
-        next_cmd.fromInt(crf.data[pimPC_]);
-        if (next_cmd.type_ == PIMCmdType::EXIT)
+        if (crfOps_[pimPC_ < CRF_SIZE ? pimPC_ : CRF_SIZE].cmd.type_ == PIMCmdType::EXIT)
             crfExit_ = true;
-    } while (cCmd.type_ == PIMCmdType::JUMP);
+    } while (isJump);
 }
 
-void PIMRank::doPIMBlock(BusPacket* packet, PIMCmd cCmd, int pimblock_id) //how to avoid all pim mode
+void PIMRank::doPIMBlock(BusPacket* packet, const PIMCmd& cCmd, int pimblock_id) //how to avoid all pim mode
 {
     if (cCmd.type_ == PIMCmdType::FILL || cCmd.type_ == PIMCmdType::MOV) //how about use move term
     {
@@ -682,10 +911,7 @@ void PIMRank::doPIMBlock(BusPacket* packet, PIMCmd cCmd, int pimblock_id) //how
         //pimblock_id<<endl; 
         readOpd(pimblock_id, bst, cCmd.src0_, packet, cCmd.src0Idx_, is_auto, false); //16x logic...
         if (cCmd.isRelu_)
-        {
-            for (int i = 0; i < 16; i++)
-                bst.u16Data_[i] = (bst.u16Data_[i] & (1 << 15)) ? 0 : bst.u16Data_[i];
-        }
+            pimAlu.relu(&bst, 1);
         writeOpd(pimblock_id, bst, cCmd.dst_, packet, cCmd.dstIdx_, is_auto, false); //16x logic...
     }
     else if (cCmd.type_ == PIMCmdType::ADD || cCmd.type_ == PIMCmdType::MUL || cCmd.type_ == PIMCmdType::MAX)
@@ -700,23 +926,37 @@ void PIMRank::doPIMBlock(BusPacket* packet, PIMCmd cCmd, int pimblock_id) //how
         if (cCmd.type_ == PIMCmdType::ADD)
         {
             // dstBst = src0Bst + src1Bst;
-            if(!is_salp_)   pimBlocks[pimblock_id].add(dstBst, src0Bst, src1Bst);
+            if(!is_salp_)   pimAlu.add(&dstBst, &src0Bst, &src1Bst, 1);
             else    sblocks[pimblock_id].add(dstBst, src0Bst, src1Bst);
         }
         else if (cCmd.type_ == PIMCmdType::MUL)
         {
             // dstBst = src0Bst * src1Bst;
-            if(!is_salp_)   pimBlocks[pimblock_id].mul(dstBst, src0Bst, src1Bst);
+            if(!is_salp_)   pimAlu.mul(&dstBst, &src0Bst, &src1Bst, 1);
             else    sblocks[pimblock_id].mul(dstBst, src0Bst, src1Bst);
         }
         else if (cCmd.type_ == PIMCmdType::MAX)
         {
             // dstBst = max(src0Bst, src1Bst);
-            if(!is_salp_)   pimBlocks[pimblock_id].burstmax(dstBst, src0Bst, src1Bst);
+            if(!is_salp_)   pimAlu.burstmax(&dstBst, &src0Bst, &src1Bst, 1);
             else    sblocks[pimblock_id].burstmax(dstBst, src0Bst, src1Bst);
         }
         writeOpd(pimblock_id, dstBst, cCmd.dst_, packet, cCmd.dstIdx_, cCmd.isAuto_, false);
     }
+    else if (cCmd.type_ == PIMCmdType::GELU || cCmd.type_ == PIMCmdType::EXP)
+    {
+        BurstType dstBst;
+        BurstType src1Bst;
+        readOpd(pimblock_id, dstBst, cCmd.src0_, packet, cCmd.src0Idx_, cCmd.isAuto_, false);
+        if (cCmd.type_ == PIMCmdType::EXP)
+        {
+            readOpd(pimblock_id, src1Bst, cCmd.src1_, packet, cCmd.src1Idx_, cCmd.isAuto_, false);
+            if(!is_salp_)   pimAlu.add(&dstBst, &dstBst, &src1Bst, 1);
+            else    sblocks[pimblock_id].add(dstBst, dstBst, src1Bst);
+        }
+        lutAlu_.lut(dstBst, (cCmd.type_ == PIMCmdType::GELU) ? layerType::GELU : layerType::EXP);
+        writeOpd(pimblock_id, dstBst, cCmd.dst_, packet, cCmd.dstIdx_, cCmd.isAuto_, false);
+    }
     else if (cCmd.type_ == PIMCmdType::MAC || cCmd.type_ == PIMCmdType::MAD)
     {
         BurstType dstBst;
@@ -730,7 +970,7 @@ void PIMRank::doPIMBlock(BusPacket* packet, PIMCmd cCmd, int pimblock_id) //how
         {
             readOpd(pimblock_id, dstBst, cCmd.dst_, packet, cCmd.dstIdx_, cCmd.isAuto_, is_mac);
             // dstBst = src0Bst * src1Bst + dstBst;
-            if(!is_salp_)    pimBlocks[pimblock_id].mac(dstBst, src0Bst, src1Bst);
+            if(!is_salp_)    pimAlu.mac(&dstBst, &src0Bst, &src1Bst, 1);
             else    sblocks[pimblock_id].mac(dstBst, src0Bst, src1Bst);
         }
         else
@@ -738,7 +978,7 @@ void PIMRank::doPIMBlock(BusPacket* packet, PIMCmd cCmd, int pimblock_id) //how
             BurstType src2Bst;
             readOpd(pimblock_id, src2Bst, cCmd.src2_, packet, cCmd.src1Idx_, cCmd.isAuto_, is_mac);
             // dstBst = src0Bst * src1Bst + src2Bst;
-            pimBlocks[pimblock_id].mad(dstBst, src0Bst, src1Bst, src2Bst);
+            pimAlu.mad(&dstBst, &src0Bst, &src1Bst, &src2Bst, 1);
             //nothing to do in sblock beacuse it did not have such function...
         }
         writeOpd(pimblock_id, dstBst, cCmd.dst_, packet, cCmd.dstIdx_, cCmd.isAuto_, is_mac);
@@ -751,12 +991,12 @@ void PIMRank::doPIMBlock(BusPacket* packet, PIMCmd cCmd, int pimblock_id) //how
         if(!is_salp_){    
             if (packet->bank == 0)
             {
-                *(packet->data) = pimBlocks[pimblock_id].grfA[grf_id];
+                *(packet->data) = pimRegs.grfA(grf_id)[pimblock_id];
                 rank->banks[pimblock_id * 2].write(packet);  
             }
             else if (packet->bank == 1)
             {
-                *(packet->data) = pimBlocks[pimblock_id].grfB[grf_id];
+                *(packet->data) = pimRegs.grfB(grf_id)[pimblock_id];
                 rank->banks[pimblock_id * 2 + 1].write(packet);
             }
         }
@@ -769,3 +1009,85 @@ void PIMRank::doPIMBlock(BusPacket* packet, PIMCmd cCmd, int pimblock_id) //how
     }
 }
 //we need some store logic, but this risc-v form has only load logic(fill) --> need to prove
+
+// CRF, GRF, SRF, LUT and the sequencer state of the PIM unit
+void PIMRank::saveState(ostream& out)
+{
+    ckptWrite(out, currentClockCycle);
+    ckptWrite(out, pimPC_);
+    ckptWrite(out, lastJumpIdx_);
+    ckptWrite(out, numJumpToBeTaken_);
+    ckptWrite(out, lastRepeatIdx_);
+    ckptWrite(out, numRepeatToBeDone_);
+    ckptWrite(out, pimOpMode_);
+    ckptWrite(out, pimOpMode_single_);
+    ckptWrite(out, toggleEvenBank_);
+    ckptWrite(out, toggleOddBank_);
+    ckptWrite(out, toggleRa12h_);
+    ckptWrite(out, useAllGrf_);
+    ckptWrite(out, crfExit_);
+    ckptWrite(out, crf.data);
+
+    // block by block, in the layout of the per-block register files this replaced
+    ckptWrite(out, static_cast<uint64_t>(pimRegs.getNumBlocks()));
+    for (unsigned pb = 0; pb < pimRegs.getNumBlocks(); pb++)
+    {
+        ckptWrite(out, pimRegs.srf()[pb]);
+        for (int i = 0; i < PIMRegisterFile::NUM_GRF; i++) ckptWrite(out, pimRegs.grfA(i)[pb]);
+        for (int i = 0; i < PIMRegisterFile::NUM_GRF; i++) ckptWrite(out, pimRegs.grfB(i)[pb]);
+        ckptWrite(out, pimRegs.mOut()[pb]);
+        ckptWrite(out, pimRegs.aOut()[pb]);
+    }
+    ckptWrite(out, static_cast<uint64_t>(sblocks.size()));
+    for (auto& sb : sblocks)
+    {
+        ckptWrite(out, sb.grf);
+        ckptWrite(out, sb.blf);
+    }
+    ckptWrite(out, lutHeader_);
+    ckptWrite(out, lutRegs_);
+    ckptWrite(out, lutFill_);
+}
+
+void PIMRank::loadState(istream& in)
+{
+    ckptRead(in, currentClockCycle);
+    ckptRead(in, pimPC_);
+    ckptRead(in, lastJumpIdx_);
+    ckptRead(in, numJumpToBeTaken_);
+    ckptRead(in, lastRepeatIdx_);
+    ckptRead(in, numRepeatToBeDone_);
+    ckptRead(in, pimOpMode_);
+    ckptRead(in, pimOpMode_single_);
+    ckptRead(in, toggleEvenBank_);
+    ckptRead(in, toggleOddBank_);
+    ckptRead(in, toggleRa12h_);
+    ckptRead(in, useAllGrf_);
+    ckptRead(in, crfExit_);
+    ckptRead(in, crf.data);
+    crfDirty_ = true;
+
+    ckptCheckSize(in, pimRegs.getNumBlocks());
+    for (unsigned pb = 0; pb < pimRegs.getNumBlocks(); pb++)
+    {
+        ckptRead(in, pimRegs.srf()[pb]);
+        for (int i = 0; i < PIMRegisterFile::NUM_GRF; i++) ckptRead(in, pimRegs.grfA(i)[pb]);
+        for (int i = 0; i < PIMRegisterFile::NUM_GRF; i++) ckptRead(in, pimRegs.grfB(i)[pb]);
+        ckptRead(in, pimRegs.mOut()[pb]);
+        ckptRead(in, pimRegs.aOut()[pb]);
+    }
+    ckptCheckSize(in, sblocks.size());
+    for (auto& sb : sblocks)
+    {
+        ckptRead(in, sb.grf);
+        ckptRead(in, sb.blf);
+    }
+    ckptRead(in, lutHeader_);
+    uint64_t num_lut_bst;
+    ckptRead(in, num_lut_bst);
+    lutRegs_.resize(num_lut_bst);
+    for (auto& bst : lutRegs_) ckptRead(in, bst);
+    ckptRead(in, lutFill_);
+    if (lutFill_ != 0 && lutFill_ == lutRegs_.size())
+        lutAlu_.load(lutHeader_, lutRegs_.data());
+}
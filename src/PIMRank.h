@@ -17,8 +17,11 @@
 
 #include "AddressMapping.h"
 #include "BusPacket.h"
+#include "C_ALU.h"
+#include "CmdTrace.h"
 #include "Configuration.h"
 #include "PIMBlock.h"
+#include "PIMRegisterFile.h"
 #include "PIMCmd.h"
 #include "Rank.h"
 #include "SimulatorObject.h"
@@ -29,31 +32,27 @@ using namespace DRAMSim;
 
 namespace DRAMSim
 {
-#define OUTLOG_ALL(msg)                                                                 \
-    msg << " ch" << getChanId() << " ra" << getRankId() << " bg"                        \
-        << config.addrMapping.bankgroupId(packet->bank) << " b" << packet->bank << " r" \
-        << packet->row << " c" << packet->column << " @" << currentClockCycle
-#define OUTLOG_CH_RA(msg) \
-    msg << " ch" << getChanId() << " ra" << getRankId() << " @" << currentClockCycle
-#define OUTLOG_PRECHARGE(msg)                                                           \
-    msg << " ch" << getChanId() << " ra" << getRankId() << " bg"                        \
-        << config.addrMapping.bankgroupId(packet->bank) << " b" << packet->bank << " r" \
-        << bankStates[packet->bank].openRowAddress << " @" << currentClockCycle
-#define OUTLOG_GRF_A(msg)                                                                      \
-    msg << " ch" << getChanId() << " ra" << getRankId() << " pb" << packet->bank / 2 << " reg" \
-        << packet->column - 0x8 << " @" << currentClockCycle
-#define OUTLOG_GRF_B(msg)                                                                      \
-    msg << " ch" << getChanId() << " ra" << getRankId() << " pb" << packet->bank / 2 << " reg" \
-        << packet->column - 0x18 << " @" << currentClockCycle
-#define OUTLOG_B_GRF_A(msg)                                                                       \
-    msg << " ch" << getChanId() << " ra" << getRankId() << " reg" << packet->column - 0x8 << " @" \
-        << currentClockCycle
-#define OUTLOG_B_GRF_B(msg)                                                                        \
-    msg << " ch" << getChanId() << " ra" << getRankId() << " reg" << packet->column - 0x18 << " @" \
-        << currentClockCycle
-#define OUTLOG_B_CRF(msg)                                                                         \
-    msg << " ch" << getChanId() << " ra" << getRankId() << " idx" << packet->column - 0x4 << " @" \
-        << currentClockCycle
+// command trace call sites, see CmdTrace.h
+#define TRACE_CMD(event)                                                                   \
+    CMD_TRACE(cmdTrace, event, currentClockCycle, getChanId(), getRankId(),                \
+              config.addrMapping.bankgroupId(packet->bank), packet->bank, packet->row,     \
+              packet->column)
+#define TRACE_CMD_TAG(event)                                                               \
+    CMD_TRACE(cmdTrace, event, currentClockCycle, getChanId(), getRankId(),                \
+              config.addrMapping.bankgroupId(packet->bank), packet->bank, packet->row,     \
+              packet->column, cmdTrace->internTag(packet->tag))
+#define TRACE_PRECHARGE(event)                                                             \
+    CMD_TRACE(cmdTrace, event, currentClockCycle, getChanId(), getRankId(),                \
+              config.addrMapping.bankgroupId(packet->bank), packet->bank,                  \
+              bankStates[packet->bank].openRowAddress, 0)
+#define TRACE_CH_RA(event) \
+    CMD_TRACE(cmdTrace, event, currentClockCycle, getChanId(), getRankId(), 0, 0, 0, 0)
+#define TRACE_CH_RA_TAG(event)                                                        \
+    CMD_TRACE(cmdTrace, event, currentClockCycle, getChanId(), getRankId(), 0, 0, 0, 0, \
+              cmdTrace->internTag(packet->tag))
+#define TRACE_REG(event)                                                                   \
+    CMD_TRACE(cmdTrace, event, currentClockCycle, getChanId(), getRankId(), 0, packet->bank, \
+              0, packet->column)
 
 class Rank;  // forward declaration
 
@@ -72,6 +71,7 @@ class PIMRank : public SimulatorObject
     ~PIMRank() {}
 
     void attachRank(Rank* r);
+    void attachCmdTrace(CmdTraceSink* sink);
     int getChanId() const;
     void setChanId(int id);
     int getRankId() const;
@@ -80,16 +80,32 @@ class PIMRank : public SimulatorObject
     void readHab(BusPacket* packet);
     //void readSab(BusPacket* packet); //use single level pim block logic to.... after double bank...
     void writeHab(BusPacket* packet);
+    void writeLut(BusPacket* packet);
     //void writeSab(BusPacket* packet);
     void doPIM(BusPacket* packet);
-    void doPIMBlock(BusPacket* packet, PIMCmd curCmd, int pimblock_id);
+    void doPIMBlock(BusPacket* packet, const PIMCmd& curCmd, int pimblock_id);
+    void doPIMAllBlocks(BusPacket* packet, const PIMCmd& curCmd);
     void controlPIM(BusPacket* packet);
     void controlPIMsub(BusPacket* packet);
     void readOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packet, int idx, bool is_auto,
                  bool is_mac);
     void writeOpd(int pb, BurstType& bst, PIMOpdType type, BusPacket* packet, int idx, bool is_auto,
                   bool is_mac);
+    BurstType* regOpdAll(PIMOpdType type, BusPacket* packet, int idx, bool is_auto, bool is_mac);
+    const BurstType* readOpdAll(BurstType* scratch, PIMOpdType type, BusPacket* packet, int idx,
+                                bool is_auto, bool is_mac);
+    void writeOpdAll(const BurstType* bst, PIMOpdType type, BusPacket* packet);
     bool isToggleCond(BusPacket* packet);
+    void saveState(ostream& out);
+    void loadState(istream& in);
+    int getPimPC() const
+    {
+        return pimPC_;
+    }
+    bool isCrfExit() const
+    {
+        return crfExit_;
+    }
 
     union crf_t
     {
@@ -101,6 +117,24 @@ class PIMRank : public SimulatorObject
         }
     } crf; //crt is 32x8x4, 4 burst logic
 
+    /*
+     * CRF program decoded once after the CRF is written, so a triggering READ/WRITE only
+     * indexes this table instead of decoding the command (and the next one) again.
+     * Entry CRF_SIZE is an EXIT so running off the end of the program stops it.
+     */
+    static const int CRF_SIZE = 32;
+    struct CrfMicroOp
+    {
+        PIMCmd cmd;
+        uint32_t raw;
+        bool repeats;     // FILL, MOV, NOP and auto-incremented commands repeat in place
+        int repeatCount;  // times a repeating command is re-executed
+        int jumpTarget;   // JUMP: PC before the increment that starts the next iteration
+    };
+    CrfMicroOp crfOps_[CRF_SIZE + 1];
+    bool crfDirty_;
+    void decodeCrf();
+
     unsigned inline getGrfIdx(unsigned idx)
     {
         return idx & 0x7; //get under low 3 bits
@@ -118,7 +152,14 @@ class PIMRank : public SimulatorObject
         return; //calculate....((r & 0x1) << 2 | ((c >> 3) & 0x3))
     }*/
     Rank* rank; 
-    vector<PIMBlock> pimBlocks; 
+    CmdTraceSink* cmdTrace;
+    PIMBlock pimAlu;
+    PIMRegisterFile pimRegs;
+    vector<BurstType> opdScratch_[4];  // per-block operands of doPIMAllBlocks()
+    C_ALU lutAlu_;                     // table of GELU and EXP, shared by the PIM blocks
+    BurstType lutHeader_;              // lut_table::getHeader() of the table being loaded
+    vector<BurstType> lutRegs_;        // lut_table::sets in write order
+    unsigned lutFill_;                 // table bursts written since the header
     vector<SBlock> sblocks;
     bool is_salp_;
 };
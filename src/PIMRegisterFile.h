@@ -0,0 +1,93 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __PIM_REGISTER_FILE_HPP__
+#define __PIM_REGISTER_FILE_HPP__
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Burst.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+/*
+ * SRF, GRF_A, GRF_B, M_OUT and A_OUT of every PIM block of a rank, stored register-major:
+ * grfA(i)[pb] is GRF_A[i] of block pb, and the same register of all blocks is one
+ * contiguous array. A PIM command then resolves its operands once and runs the ALU across
+ * all blocks in one loop instead of once per block.
+ */
+class PIMRegisterFile
+{
+  public:
+    static const int NUM_GRF = 8;
+
+    PIMRegisterFile(unsigned numBlocks)
+        : numBlocks_(numBlocks), regs_((2 * NUM_GRF + NUM_SPECIAL) * numBlocks)
+    {
+    }
+
+    unsigned getNumBlocks() const
+    {
+        return numBlocks_;
+    }
+    BurstType* grfA(int idx)
+    {
+        return row(idx);
+    }
+    BurstType* grfB(int idx)
+    {
+        return row(NUM_GRF + idx);
+    }
+    BurstType* srf()
+    {
+        return row(2 * NUM_GRF);
+    }
+    BurstType* mOut()
+    {
+        return row(2 * NUM_GRF + 1);
+    }
+    BurstType* aOut()
+    {
+        return row(2 * NUM_GRF + 2);
+    }
+
+    std::string print(unsigned pb)
+    {
+        stringstream ss;
+        ss << "[SRF]" << srf()[pb].binToStr();
+        ss << "[GRF_A]";
+        for (int i = 0; i < NUM_GRF; i++) ss << grfA(i)[pb].binToStr();
+        ss << "[GRF_B]";
+        for (int i = 0; i < NUM_GRF; i++) ss << grfB(i)[pb].binToStr();
+        ss << "[M_OUT]" << mOut()[pb].binToStr();
+        ss << "[A_OUT]" << aOut()[pb].binToStr();
+        return ss.str();
+    }
+
+  private:
+    static const int NUM_SPECIAL = 3;  // SRF, M_OUT, A_OUT
+
+    BurstType* row(int r)
+    {
+        return &regs_[r * numBlocks_];
+    }
+
+    unsigned numBlocks_;
+    vector<BurstType> regs_;
+};
+
+}  // namespace DRAMSim
+#endif
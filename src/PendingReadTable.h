@@ -0,0 +1,101 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __PENDING_READ_TABLE_HPP__
+#define __PENDING_READ_TABLE_HPP__
+
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "Transaction.h"
+
+using namespace std;
+
+namespace DRAMSim
+{
+/*
+ * Read transactions that were issued to the command queue and wait for their data, indexed by
+ * address so a returning read is matched in O(1). Reads to the same address are matched in the
+ * order they were issued. Each entry keeps the rank/bank/subarray decoded when the read was
+ * scheduled so the latency histogram does not have to map the address again.
+ */
+class PendingReadTable
+{
+  public:
+    struct Entry
+    {
+        Transaction* trans;
+        unsigned rank;
+        unsigned bank;
+        unsigned sub;
+    };
+
+    PendingReadTable() : count_(0) {}
+
+    void reserve(size_t numAddresses)
+    {
+        table_.reserve(numAddresses);
+    }
+
+    void insert(Transaction* trans, unsigned rank, unsigned bank, unsigned sub)
+    {
+        table_[trans->address].push_back(Entry{trans, rank, bank, sub});
+        count_++;
+    }
+
+    // removes the oldest read to address into entry, false if there is none
+    bool take(uint64_t address, Entry& entry)
+    {
+        auto it = table_.find(address);
+        if (it == table_.end())
+            return false;
+
+        vector<Entry>& reads = it->second;
+        entry = reads.front();
+        if (reads.size() == 1)
+            table_.erase(it);
+        else
+            reads.erase(reads.begin());
+        count_--;
+        return true;
+    }
+
+    // deletes every transaction still waiting
+    void clear()
+    {
+        for (auto& it : table_)
+        {
+            for (auto& entry : it.second) delete entry.trans;
+        }
+        table_.clear();
+        count_ = 0;
+    }
+
+    bool empty() const
+    {
+        return count_ == 0;
+    }
+
+    size_t size() const
+    {
+        return count_;
+    }
+
+  private:
+    unordered_map<uint64_t, vector<Entry>> table_;
+    size_t count_;
+};
+}  // namespace DRAMSim
+
+#endif
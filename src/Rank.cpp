@@ -31,6 +31,7 @@
 #include <iostream>
 
 #include "AddressMapping.h"
+#include "Checkpoint.h"
 #include "MemoryController.h"
 #include "Rank.h"
 
@@ -43,15 +44,16 @@ Rank::Rank(ostream& simLog, Configuration& configuration)
       dramsimLog(simLog),
       isPowerDown(false),
       refreshWaiting(false),
-      readReturnCountdown(0),
       banks(getConfigParam(UINT, "NUM_BANKS"), Bank(simLog)),
       bankStates(getConfigParam(UINT, "NUM_BANKS"), BankState(simLog)),
       config(configuration),
       outgoingDataPacket(NULL),
+      storageFile(NULL),
       dataCyclesLeft(0),
       mode_(dramMode::SB)
 {
     memoryController = NULL;
+    cmdTrace = NULL;
     currentClockCycle = 0;
     abmr1Even_ = abmr1Odd_ = abmr2Even_ = abmr2Odd_ = sbmr1_ = sbmr2_ = false;
 
@@ -65,23 +67,22 @@ Rank::Rank(ostream& simLog, Configuration& configuration, bool is_salp)
       dramsimLog(simLog),
       isPowerDown(false),
       refreshWaiting(false),
-      readReturnCountdown(0),
       banks(getConfigParam(UINT, "NUM_BANKS"), Bank(simLog)),
       bankStates(getConfigParam(UINT, "NUM_BANKS"), BankState(simLog)),
       banks_sub(getConfigParam(UINT, "NUM_BANKS")*4, Bank(simLog)),
       bankStates_SUB(getConfigParam(UINT, "NUM_BANKS")*4, BankState(simLog)),
       config(configuration),
       outgoingDataPacket(NULL),
+      storageFile(NULL),
       dataCyclesLeft(0),
       mode_(dramMode::SB),
       is_salp_(is_salp)
 {
     memoryController = NULL;
+    cmdTrace = NULL;
     currentClockCycle = 0;
     abmr1Even_ = abmr1Odd_ = abmr2Even_ = abmr2Odd_ = sbmr1_ = sbmr2_ = false;
 
-    readReturnCountdown.clear();
-    readReturnCountdown.reserve(32);
     //banks_sub = vector<vector<Bank>>(16*4);
     //bankStates_SUB = vector<vector<BankState>>(16, vector<BankState>(4, dramsimLog));
     pimRank = new PIMRank(dramsimLog, config, is_salp_);
@@ -114,12 +115,121 @@ void Rank::attachMemoryController(MemoryController* mc)
     this->memoryController = mc;
 }
 
+// commands executed by this rank and its PIM blocks are logged to sink
+void Rank::attachCmdTrace(CmdTraceSink* sink)
+{
+    cmdTrace = sink;
+    pimRank->attachCmdTrace(sink);
+}
+
 Rank::~Rank()
 {
-    for (size_t i = 0; i < readReturnPacket.size(); i++) delete readReturnPacket[i];
+    for (size_t i = 0; i < readReturnQueue.size(); i++) delete readReturnQueue.at(i);
 
-    readReturnPacket.clear();
+    readReturnQueue.clear();
     delete outgoingDataPacket;
+    delete storageFile;
+}
+
+// back banks with one sparse mmap'd file, see BankStorageFile; banks_sub stay on the heap
+// since MultiChannelMemorySystem rejects BANK_STORAGE=mmap together with SALP
+void Rank::attachStorageFile(const string& path)
+{
+    storageFile = new BankStorageFile(path, banks.size(), getConfigParam(UINT, "NUM_ROWS"),
+                                      getConfigParam(UINT, "NUM_COLS"));
+    for (size_t i = 0; i < banks.size(); i++)
+    {
+        banks[i].attachStorage(storageFile->getBankBase(i));
+    }
+}
+
+bool Rank::isStoragePreloaded(const string& tag) const
+{
+    return storageFile != NULL && storageFile->isPreloaded(tag);
+}
+
+void Rank::markStoragePreloaded(const string& tag)
+{
+    if (storageFile != NULL)
+        storageFile->markPreloaded(tag);
+}
+
+// nothing on the data bus and no read waiting for its RL countdown
+bool Rank::isDrained() const
+{
+    return readReturnQueue.empty() && outgoingDataPacket == NULL;
+}
+
+// earliest cycle whose update() puts read data on the bus or takes it off again
+uint64_t Rank::nextEventCycle() const
+{
+    uint64_t next = UINT64_MAX;
+    if (outgoingDataPacket != NULL)
+        next = dataCyclesLeft > 0 ? currentClockCycle + dataCyclesLeft - 1 : currentClockCycle;
+    if (!readReturnQueue.empty())
+        next = min(next, max(readReturnQueue.frontReadyCycle(), currentClockCycle));
+    return next;
+}
+
+// same as calling update()/step() "cycles" times, cycles must not go past nextEventCycle()
+void Rank::fastForward(uint64_t cycles)
+{
+    if (outgoingDataPacket != NULL)
+        dataCyclesLeft -= cycles;
+    pimRank->currentClockCycle += cycles;
+    currentClockCycle += cycles;
+}
+
+void Rank::saveState(ostream& out)
+{
+    ckptWrite(out, currentClockCycle);
+    ckptWrite(out, isPowerDown);
+    ckptWrite(out, refreshWaiting);
+    ckptWrite(out, dataCyclesLeft);
+    ckptWrite(out, mode_);
+    ckptWrite(out, abmr1Even_);
+    ckptWrite(out, abmr1Odd_);
+    ckptWrite(out, abmr2Even_);
+    ckptWrite(out, abmr2Odd_);
+    ckptWrite(out, sbmr1_);
+    ckptWrite(out, sbmr2_);
+
+    ckptWrite(out, static_cast<uint64_t>(banks.size()));
+    for (auto& bank : banks) bank.saveState(out);
+    ckptWrite(out, static_cast<uint64_t>(banks_sub.size()));
+    for (auto& bank : banks_sub) bank.saveState(out);
+    ckptWrite(out, static_cast<uint64_t>(bankStates.size()));
+    for (auto& state : bankStates) state.saveState(out);
+    ckptWrite(out, static_cast<uint64_t>(bankStates_SUB.size()));
+    for (auto& state : bankStates_SUB) state.saveState(out);
+
+    pimRank->saveState(out);
+}
+
+void Rank::loadState(istream& in)
+{
+    ckptRead(in, currentClockCycle);
+    ckptRead(in, isPowerDown);
+    ckptRead(in, refreshWaiting);
+    ckptRead(in, dataCyclesLeft);
+    ckptRead(in, mode_);
+    ckptRead(in, abmr1Even_);
+    ckptRead(in, abmr1Odd_);
+    ckptRead(in, abmr2Even_);
+    ckptRead(in, abmr2Odd_);
+    ckptRead(in, sbmr1_);
+    ckptRead(in, sbmr2_);
+
+    ckptCheckSize(in, banks.size());
+    for (auto& bank : banks) bank.loadState(in);
+    ckptCheckSize(in, banks_sub.size());
+    for (auto& bank : banks_sub) bank.loadState(in);
+    ckptCheckSize(in, bankStates.size());
+    for (auto& state : bankStates) state.loadState(in);
+    ckptCheckSize(in, bankStates_SUB.size());
+    for (auto& state : bankStates_SUB) state.loadState(in);
+
+    pimRank->loadState(in);
 }
 
 void Rank::receiveFromBus(BusPacket* packet) //outgoingcmdpacket -->comes from poppedbuspacket
@@ -295,7 +405,7 @@ void Rank::check(BusPacket* packet)
     }
     else
     {
-        cout<<"[rank]:check and mode_ is hab_pim and cycle is "<<currentClockCycle<<endl;
+        //cout<<"[rank]:check and mode_ is hab_pim and cycle is "<<currentClockCycle<<endl;
         if(is_salp_)
         {
             for (int bank = 0; bank < config.NUM_BANKS; bank++)
@@ -344,7 +454,8 @@ void Rank::updateState(BusPacket* packet)
                             addrMapping.isSameBankgroup(bank, packet->bank), targetsub == sub);
                 }
             }
-            else updateBank(packet->busPacketType, bank, packet->row, bank == packet->bank, addrMapping.isSameBankgroup(bank, packet->bank));
+            else updateBank(packet->busPacketType, bank, packet->row, bank == packet->bank, addrMapping.isSameBankgroup(bank, packet->bank),
+                            packet->autoPrecharge);
         }
     }
     else //drawmode all pim or something
@@ -485,7 +596,8 @@ void Rank::updateBank(BusPacketType type, int bank, int row, int sub, bool targe
             break;
     }
 }
-void Rank::updateBank(BusPacketType type, int bank, int row, bool targetBank, bool targetBankgroup)
+void Rank::updateBank(BusPacketType type, int bank, int row, bool targetBank, bool targetBankgroup,
+                      bool autoPrecharge)
 {
     switch (type)
     {
@@ -508,7 +620,13 @@ void Rank::updateBank(BusPacketType type, int bank, int row, bool targetBank, bo
             }
             bankStates[bank].nextWrite =
                 max(bankStates[bank].nextWrite, currentClockCycle + config.READ_TO_WRITE_DELAY);
-
+            if (targetBank && autoPrecharge)
+            {
+                bankStates[bank].currentBankState = Idle;
+                bankStates[bank].nextActivate =
+                    max({bankStates[bank].nextActivate, currentClockCycle + config.READ_AUTOPRE_DELAY,
+                         bankStates[bank].nextPrecharge + config.tRP});
+            }
             break;
         case WRITE:
             // update state table
@@ -533,6 +651,13 @@ void Rank::updateBank(BusPacketType type, int bank, int row, bool targetBank, bo
                     max(bankStates[bank].nextWrite,
                         currentClockCycle + max(config.BL / 2, config.tCCDS));
             }
+            if (targetBank && autoPrecharge)
+            {
+                bankStates[bank].currentBankState = Idle;
+                bankStates[bank].nextActivate =
+                    max({bankStates[bank].nextActivate, currentClockCycle + config.WRITE_AUTOPRE_DELAY,
+                         bankStates[bank].nextPrecharge + config.tRP});
+            }
             break;
         case ACTIVATE:
             if (targetBank)
@@ -574,42 +699,27 @@ void Rank::updateBank(BusPacketType type, int bank, int row, bool targetBank, bo
 void Rank::readSb(BusPacket* packet)
 {
     int sub = (packet->row<0x2000)?0:(packet->row<0x4000)?1:(packet->row<0x6000)?2:3;
-    if (DEBUG_CMD_TRACE)
+    if (packet->row == 0x3fff)
     {
-        if (packet->row == 0x3fff)
-        {
-            if(!is_salp_)
-            {
-                if (0x08 <= packet->column && packet->column <= 0x0f)
-                {
-                    PRINT(OUTLOG_GRF_A("READ_GRF_A"));
-                }
-                else if (0x18 <= packet->column && packet->column <= 0x1f)
-                {
-                    PRINT(OUTLOG_GRF_B("READ_GRF_B"));
-                }
-            }
-            else
-            {
-                if (0x08 <= packet->column && packet->column <= 0x11)
-                {
-                    PRINT(OUTLOG_GRF_A("READ_GRF_A"));
-                }
-                else if(packet->column == 0x12)
-                {
-                    PRINT(OUTLOG_B_GRF_B("READ_GRF_B"));
-                }
-            }
-        }
-        else if (packet->row & (1 << 12))
+        if(!is_salp_)
         {
-            PRINTC(GRAY, OUTLOG_ALL("READ"));
+            if (0x08 <= packet->column && packet->column <= 0x0f)
+                TRACE_REG(TRACE_READ_GRF_A);
+            else if (0x18 <= packet->column && packet->column <= 0x1f)
+                TRACE_REG(TRACE_READ_GRF_B);
         }
         else
         {
-            PRINT(OUTLOG_ALL("READ"));
+            if (0x08 <= packet->column && packet->column <= 0x11)
+                TRACE_REG(TRACE_READ_GRF_A);
+            else if(packet->column == 0x12)
+                TRACE_REG(TRACE_READ_SBLOCK_GRF_B);
         }
     }
+    else
+    {
+        TRACE_CMD(TRACE_READ);
+    }
 
 #ifndef NO_STORAGE
     if (packet->row == 0x3fff)
@@ -617,9 +727,9 @@ void Rank::readSb(BusPacket* packet)
         if(!is_salp_)
         {
             if (0x08 <= packet->column && packet->column <= 0x0f)
-            *(packet->data) = pimRank->pimBlocks[packet->bank / 2].grfA[packet->column - 0x8];
+            *(packet->data) = pimRank->pimRegs.grfA(packet->column - 0x8)[packet->bank / 2];
             else if (0x18 <= packet->column && packet->column <= 0x1f)
-                *(packet->data) = pimRank->pimBlocks[packet->bank / 2].grfB[packet->column - 0x18];
+                *(packet->data) = pimRank->pimRegs.grfB(packet->column - 0x18)[packet->bank / 2];
             else
                 banks[packet->bank].read(packet);
         }
@@ -651,17 +761,7 @@ void Rank::readSb(BusPacket* packet)
 
 void Rank::writeSb(BusPacket* packet)
 {
-    if (DEBUG_CMD_TRACE)
-    {
-        if (packet->row == 0x3fff || packet->row & (1 << 12))
-        {
-            PRINTC(GRAY, OUTLOG_ALL("WRITE"));
-        }
-        else
-        {
-            PRINT(OUTLOG_ALL("WRITE"));
-        }
-    }
+    TRACE_CMD(TRACE_WRITE);
 
 #ifndef NO_STORAGE
     if (!(packet->row == 0x3fff) && !(packet->row & (1 << 12)))
@@ -687,6 +787,51 @@ void Rank::writeSb(BusPacket* packet)
 #endif
 }
 
+// the data side of a READ/WRITE, the same for the timed and the functional path
+void Rank::accessData(BusPacket* packet)
+{
+    bool isRead = (packet->busPacketType == READ);
+    if (mode_ == dramMode::SB)
+    {
+        if (isRead)
+            readSb(packet);
+        else
+            writeSb(packet);
+    }
+    else if (mode_ == dramMode::HAB_PIM && pimRank->isToggleCond(packet))
+        pimRank->doPIM(packet);
+    else if (isRead)
+        pimRank->readHab(packet);
+    else
+        pimRank->writeHab(packet);
+}
+
+/*
+ * Functional model (PIM_FUNCTIONAL): apply a command to the bank storage and PIM units right
+ * away. Nothing is checked against or added to the bank timing state and read data is left in
+ * packet->data instead of going back over the bus. Mode changes (ABMR/SBMR) are the same as
+ * in execute().
+ */
+void Rank::executeFunctional(BusPacket* packet)
+{
+    switch (packet->busPacketType)
+    {
+        case READ:
+        case WRITE:
+            accessData(packet);
+            delete (packet);
+            break;
+        case ACTIVATE:
+        case PRECHARGE:
+            execute(packet);
+            break;
+        default:
+            ERROR("== Error - Unknown BusPacketType in functional mode: " << packet->busPacketType);
+            exit(-1);
+            break;
+    }
+}
+
 void Rank::execute(BusPacket* packet)
 {
     //if(mode_ == dramMode::HAB_PIM)   cout<<"[rank]:execute and cycle is "<<currentClockCycle<<" and bank is "<<packet->bank<<" and row is "<<packet->row
@@ -695,50 +840,17 @@ void Rank::execute(BusPacket* packet)
     switch (packet->busPacketType)
     {
         case READ:
-            if (mode_ == dramMode::SB)
-            {
-                //cout<<"[rank]:execute for read cycle is "<<currentClockCycle<<" and bank is "<<packet->bank<<" and row is "<<packet->row
-                //<<" and col is" <<packet->column<<endl;
-                readSb(packet);  //packets come and subarray acting possible...
-            }
-            else if (mode_ == dramMode::HAB_PIM && pimRank->isToggleCond(packet)) //hab_pim mode
-            {
-                //cout<<"clock is "<<currentClockCycle<<" and row is "<<packet->row<<endl;
-                pimRank->doPIM(packet);
-            }
-            /*else if (mode_ == dramMode::HAB_PIM && is_salp_)
-            {
-                //cout<<"[rank]:execute for read cycle is "<<currentClockCycle<<" and bank is "<<packet->bank<<" and row is "<<packet->row
-                //<<" and col is" <<packet->column<<endl;
-                //packet = packet;
-                pimRank->doPIM(packet);
-            }*/
-            else
-                pimRank->readHab(packet);
+            accessData(packet);
             packet->busPacketType = DATA;
-            if(readReturnPacket.capacity() == readReturnPacket.size())  readReturnPacket.reserve(readReturnPacket.size() + 32);
-            readReturnPacket.push_back(packet);
-            if(readReturnCountdown.capacity() == readReturnCountdown.size())
-                readReturnCountdown.reserve(readReturnCountdown.size() + 32);
-            readReturnCountdown.push_back(config.RL); 
+            readReturnQueue.push(currentClockCycle + config.RL, packet);
             //delete(packet); 
             break;
         case WRITE:
-            if (mode_ == dramMode::SB)
-                writeSb(packet);
-            else if (mode_ == dramMode::HAB_PIM && pimRank->isToggleCond(packet))
-                pimRank->doPIM(packet);
-            /*else if(mode_ == dramMode::HAB_PIM && is_salp_)
-                pimRank->doPIM(packet);*/
-            else
-                pimRank->writeHab(packet);
+            accessData(packet);
             //delete (packet);
             break;
         case ACTIVATE:
-            if (DEBUG_CMD_TRACE)
-            {
-                PRINTC(getModeColor(), OUTLOG_ALL("ACTIVATE") << " tag : " << packet->tag);
-            }
+            TRACE_CMD_TAG(TRACE_ACTIVATE);
             if (mode_ == dramMode::SB && packet->row == 0x17ff && packet->column == 0x1f) //avoid selecting these ones
             { //need mode change for sb_pim
                 abmr1Even_ = (packet->bank == 0) ? true : abmr1Even_; //nothing to bother....
@@ -752,26 +864,13 @@ void Rank::execute(BusPacket* packet)
                     //cout<<"[rank]: execute and mode is hab and cycle is "<<currentClockCycle<<endl;
                     abmr1Even_ = abmr1Odd_ = abmr2Even_ = abmr2Odd_ = false;
                     mode_ = dramMode::HAB;
-                    if (DEBUG_CMD_TRACE)
-                    {
-                        PRINTC(RED, OUTLOG_CH_RA("HAB") << " tag : " << packet->tag);
-                    }
+                    TRACE_CH_RA_TAG(TRACE_HAB);
                 }
             }
             delete (packet);
             break;
         case PRECHARGE:
-            if (DEBUG_CMD_TRACE)
-            {
-                if (mode_ == dramMode::SB || packet->bank < 2)
-                {
-                    PRINTC(getModeColor(), OUTLOG_PRECHARGE("PRECHARGE"));
-                }
-                else
-                {
-                    PRINTC(GRAY, OUTLOG_PRECHARGE("PRECHARGE"));
-                }
-            }
+            TRACE_PRECHARGE(TRACE_PRECHARGE);
 
             if (mode_ == dramMode::HAB && packet->row == 0x1fff)
             {
@@ -783,10 +882,7 @@ void Rank::execute(BusPacket* packet)
                     //cout<<"[rank]: execute and mode is sb and cycle is "<<currentClockCycle<<endl;
                     sbmr1_ = sbmr2_ = false;
                     mode_ = dramMode::SB;
-                    if (DEBUG_CMD_TRACE)
-                    {
-                        PRINTC(RED, OUTLOG_CH_RA("SB mode"));
-                    }
+                    TRACE_CH_RA(TRACE_SB_MODE);
                 }
             }
 
@@ -795,10 +891,7 @@ void Rank::execute(BusPacket* packet)
 
         case REF:
             refreshWaiting = false;
-            if (DEBUG_CMD_TRACE)
-            {
-                PRINT(OUTLOG_CH_RA("REF"));
-            }
+            TRACE_CH_RA(TRACE_REF);
             delete (packet);
             break;
 
@@ -833,27 +926,16 @@ void Rank::update()
         }
     }
 
-    // decrement the counter for all packets waiting to be sent back
-    //auto it = readReturnCountdown.begin();
-    if (readReturnCountdown.size() > 0){
-        for (int i = 0; i < readReturnCountdown.size(); i++) {
-            if(readReturnCountdown[i]>0){
-                /*if(readReturnCountdown.size() > 10000000000)
-                    cout<<"[READ] "<<"readReturnCountdown["<<i<<"]: "<<readReturnCountdown[i]<<endl;*/
-                readReturnCountdown[i]--;
-            }
-        }
-    }
-    if (readReturnCountdown.size() > 0 /*&& readReturnCountdown.size() < 100*/ && readReturnCountdown[0] == 0)
+    // send the oldest read once RL has passed since it was issued
+    if (readReturnQueue.isReady(currentClockCycle))
     {
         // RL time has passed since the read was issued; this packet is
         // ready to go out on the bus
-        outgoingDataPacket = readReturnPacket[0];
+        outgoingDataPacket = readReturnQueue.front();
         dataCyclesLeft = config.BL / 2;
 
         // remove the packet from the ranks
-        readReturnPacket.erase(readReturnPacket.begin());
-        readReturnCountdown.erase(readReturnCountdown.begin());
+        readReturnQueue.pop();
 
         if (DEBUG_BUS)
         {
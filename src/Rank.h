@@ -36,9 +36,11 @@
 #include "AddressMapping.h"
 #include "Bank.h"
 #include "BankState.h"
+#include "BankStorage.h"
 #include "BusPacket.h"
 #include "Configuration.h"
 #include "PIMRank.h"
+#include "ReadyQueue.h"
 #include "SimulatorObject.h"
 //#include "Subarray.h"
 
@@ -59,6 +61,8 @@ class Rank : public SimulatorObject
     Configuration& config;
     bool is_salp_;
 
+    void accessData(BusPacket* packet);
+
   public:
     // functions
     Rank(ostream& simLog, Configuration& configuration);
@@ -69,12 +73,15 @@ class Rank : public SimulatorObject
     void check(BusPacket* packet);
     void updateState(BusPacket* packet);
     void execute(BusPacket* packet);
+    void executeFunctional(BusPacket* packet);
 
     void checkBank(BusPacketType type, int bank, int row); 
     void checkBank(BusPacketType type, int bank, int sub, int row);
-    void updateBank(BusPacketType type, int bank, int row, bool targetBank, bool targetBankgroup); //how about use this function to regulate subarray model
+    void updateBank(BusPacketType type, int bank, int row, bool targetBank, bool targetBankgroup,
+                    bool autoPrecharge = false); //how about use this function to regulate subarray model
     void updateBank(BusPacketType type, int bank, int sub, int row, bool targetBank, bool targetBankgroup, bool targetSubarray);
     void attachMemoryController(MemoryController* mc);
+    void attachCmdTrace(CmdTraceSink* sink);
     int getChanId() const;
     void setChanId(int id);
     int getRankId() const;
@@ -82,6 +89,14 @@ class Rank : public SimulatorObject
     void update();
     void powerUp();
     void powerDown();
+    void attachStorageFile(const string& path);
+    bool isStoragePreloaded(const string& tag) const;
+    void markStoragePreloaded(const string& tag);
+    bool isDrained() const;
+    uint64_t nextEventCycle() const;
+    void fastForward(uint64_t cycles);
+    void saveState(ostream& out);
+    void loadState(istream& in);
     int controlsubarray(BusPacket* packet);
     
     void readSb(BusPacket* packet);
@@ -89,14 +104,15 @@ class Rank : public SimulatorObject
 
     // fields
     MemoryController* memoryController;
+    CmdTraceSink* cmdTrace;
     BusPacket* outgoingDataPacket;
     PIMRank* pimRank;
+    BankStorageFile* storageFile;
     unsigned dataCyclesLeft;
     bool refreshWaiting;
 
-    // these are vectors so that each element is per-bank
-    vector<BusPacket*> readReturnPacket;
-    vector<unsigned> readReturnCountdown;
+    // read data waiting out RL before it goes on the bus, keyed by the cycle it is due
+    ReadyQueue<BusPacket*> readReturnQueue;
 
     //vector<vector<Bank>> banks_sub; //which to modify...
     vector<Bank> banks;
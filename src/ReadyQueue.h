@@ -0,0 +1,118 @@
+/***************************************************************************************************
+ * Copyright (C) 2021 Samsung Electronics Co. LTD
+ *
+ * This software is a property of Samsung Electronics.
+ * No part of this software, either material or conceptual may be copied or distributed,
+ * transmitted, transcribed, stored in a retrieval system, or translated into any human
+ * or computer language in any form by any means,electronic, mechanical, manual or otherwise,
+ * or disclosed to third parties without the express written permission of Samsung Electronics.
+ * (Use of the Software is restricted to non-commercial, personal or academic, research purpose
+ * only)
+ **************************************************************************************************/
+
+#ifndef __READY_QUEUE_HPP__
+#define __READY_QUEUE_HPP__
+
+#include <stdint.h>
+
+#include <vector>
+
+using namespace std;
+
+namespace DRAMSim
+{
+/*
+ * FIFO of items that become ready at an absolute clock cycle, used for fixed delays (RL, WL)
+ * so items arrive in ready order. Replaces a vector of countdowns that had to be decremented
+ * entry by entry every cycle: push, pop and the ready check are O(1).
+ *
+ * Ring buffer with a power of two capacity; it only grows when more items are in flight than
+ * it was sized for.
+ */
+template <typename T>
+class ReadyQueue
+{
+  public:
+    explicit ReadyQueue(size_t capacity = 32) : head_(0), count_(0)
+    {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+    }
+
+    void push(uint64_t readyCycle, const T& item)
+    {
+        if (count_ == slots_.size())
+            grow();
+        Slot& slot = slots_[(head_ + count_) & (slots_.size() - 1)];
+        slot.readyCycle = readyCycle;
+        slot.item = item;
+        count_++;
+    }
+
+    // true if the oldest item is due at (or before) the given cycle
+    bool isReady(uint64_t cycle) const
+    {
+        return count_ > 0 && slots_[head_].readyCycle <= cycle;
+    }
+
+    T& front()
+    {
+        return slots_[head_].item;
+    }
+
+    uint64_t frontReadyCycle() const
+    {
+        return slots_[head_].readyCycle;
+    }
+
+    void pop()
+    {
+        head_ = (head_ + 1) & (slots_.size() - 1);
+        count_--;
+    }
+
+    // i-th oldest item
+    T& at(size_t i)
+    {
+        return slots_[(head_ + i) & (slots_.size() - 1)].item;
+    }
+
+    bool empty() const
+    {
+        return count_ == 0;
+    }
+
+    size_t size() const
+    {
+        return count_;
+    }
+
+    void clear()
+    {
+        head_ = 0;
+        count_ = 0;
+    }
+
+  private:
+    struct Slot
+    {
+        uint64_t readyCycle;
+        T item;
+    };
+
+    void grow()
+    {
+        vector<Slot> slots(slots_.size() * 2);
+        for (size_t i = 0; i < count_; i++) slots[i] = slots_[(head_ + i) & (slots_.size() - 1)];
+        slots_.swap(slots);
+        head_ = 0;
+    }
+
+    vector<Slot> slots_;
+    size_t head_;
+    size_t count_;
+};
+}  // namespace DRAMSim
+
+#endif
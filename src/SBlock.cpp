@@ -1,6 +1,7 @@
 #include <sstream>
 #include <string>
 
+#include "IntBurst.h"
 #include "SBlock.h"
 #include "PrintMacros.h"
 #include "SystemConfiguration.h"
@@ -12,10 +13,11 @@ void SBlock::add(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
 {
     if (pimPrecision_ == FP16)
     {
-        for (int i = 0; i < 16; i++)
-        {
-            dstBst.fp16Data_[i] = src0Bst.fp16Data_[i] + src1Bst.fp16Data_[i];
-        }
+        fp16Kernels_->add(dstBst.fp16Data_, src0Bst.fp16Data_, src1Bst.fp16Data_, 1);
+    }
+    else if (pimPrecision_ == BF16)
+    {
+        bf16Kernels_->add(dstBst.u16Data_, src0Bst.u16Data_, src1Bst.u16Data_, 1);
     }
     else if (pimPrecision_ == FP32)
     {
@@ -24,6 +26,8 @@ void SBlock::add(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
             dstBst.fp32Data_[i] = src0Bst.fp32Data_[i] + src1Bst.fp32Data_[i];
         }
     }
+    else if (pimPrecision_ == INT8 || pimPrecision_ == INT4)
+        intBurstAdd(pimPrecision_, &dstBst, &src0Bst, &src1Bst, 1);
     else
         dstBst = src0Bst + src1Bst;
 }
@@ -32,10 +36,11 @@ void SBlock::mul(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
 {
     if (pimPrecision_ == FP16)
     {
-        for (int i = 0; i < 16; i++)
-        {
-            dstBst.fp16Data_[i] = src0Bst.fp16Data_[i] * src1Bst.fp16Data_[i];
-        }
+        fp16Kernels_->mul(dstBst.fp16Data_, src0Bst.fp16Data_, src1Bst.fp16Data_, 1);
+    }
+    else if (pimPrecision_ == BF16)
+    {
+        bf16Kernels_->mul(dstBst.u16Data_, src0Bst.u16Data_, src1Bst.u16Data_, 1);
     }
     else if (pimPrecision_ == FP32)
     {
@@ -44,6 +49,8 @@ void SBlock::mul(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
             dstBst.fp32Data_[i] = src0Bst.fp32Data_[i] * src1Bst.fp32Data_[i];
         }
     }
+    else if (pimPrecision_ == INT8 || pimPrecision_ == INT4)
+        intBurstMul(pimPrecision_, &dstBst, &src0Bst, &src1Bst, 1);
     else
         dstBst = src0Bst * src1Bst;
 }
@@ -52,14 +59,16 @@ void SBlock::mac(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
 {
     if (pimPrecision_ == FP16)
     {
-        for (int i = 0; i < 16; i++)
-        {
-            dstBst.fp16Data_[i] = src0Bst.fp16Data_[i] * src1Bst.fp16Data_[i] + dstBst.fp16Data_[i];
-        }
+        fp16Kernels_->mad(dstBst.fp16Data_, src0Bst.fp16Data_, src1Bst.fp16Data_,
+                          dstBst.fp16Data_, 1);
 
         DEBUG("MAC " << src0Bst.hexToStr2() << "*+" << src1Bst.hexToStr2() << ""
                      << dstBst.hexToStr2());
     }
+    else if (pimPrecision_ == BF16)
+    {
+        bf16Kernels_->mad(dstBst.u16Data_, src0Bst.u16Data_, src1Bst.u16Data_, dstBst.u16Data_, 1);
+    }
     else if (pimPrecision_ == FP32)
     {
         for (int i = 0; i < 8; i++)
@@ -67,6 +76,8 @@ void SBlock::mac(BurstType& dstBst, BurstType& src0Bst, BurstType& src1Bst)
             dstBst.fp32Data_[i] = src0Bst.fp32Data_[i] * src1Bst.fp32Data_[i] + dstBst.fp32Data_[i];
         }
     }
+    else if (pimPrecision_ == INT8 || pimPrecision_ == INT4)
+        intBurstMad(pimPrecision_, &dstBst, &src0Bst, &src1Bst, &dstBst, 1);
     else
         dstBst = src0Bst * src1Bst + dstBst;
 }
@@ -7,6 +7,7 @@
 #include <string>
 
 #include "Burst.h"
+#include "FP16Simd.h"
 #include "SystemConfiguration.h"
 
 using namespace std;
@@ -17,8 +18,15 @@ class SBlock{
     SBlock()
     {
         pimPrecision_ = PIMConfiguration::getPIMPrecision();
+        fp16Kernels_ = &getFP16BurstKernels();
+        bf16Kernels_ = &getBF16BurstKernels();
+    }
+    SBlock(const PIMPrecision& pimPrecision)
+        : pimPrecision_(pimPrecision),
+          fp16Kernels_(&getFP16BurstKernels()),
+          bf16Kernels_(&getBF16BurstKernels())
+    {
     }
-    SBlock(const PIMPrecision& pimPrecision) : pimPrecision_(pimPrecision) {}
 
     BurstType grf[4];
     BurstType blf;
@@ -30,6 +38,8 @@ class SBlock{
     std::string print();
   private:
     PIMPrecision pimPrecision_;
+    const FP16BurstKernels* fp16Kernels_;
+    const BF16BurstKernels* bf16Kernels_;
 };
 
 }
@@ -28,8 +28,6 @@
  *  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *********************************************************************************/
 
-#include <memory>
-
 #include "Subarray.h"
 #include "BusPacket.h"
 
@@ -37,56 +35,30 @@ using namespace std;
 using namespace DRAMSim;
 
 Subarray::Subarray(ostream& simLog)
-    : currentState(simLog), rowEntries(getConfigParam(UINT, "NUM_COLS")), dramsimLog(simLog)
+    : currentState(simLog),
+      storage(getConfigParam(UINT, "NUM_ROWS"), getConfigParam(UINT, "NUM_COLS")),
+      dramsimLog(simLog)
 {
     numCols = getConfigParam(UINT, "NUM_COLS");
 }
 
-/* The bank class is just a glorified sparse storage data structure
- * that keeps track of written data in case the simulator wants a
- * function DRAM model
- *
- * A vector of size NUM_COLS keeps a linked list of rows and their
- * associated values.
+/* Same sparse storage as the Bank class, see Bank.cpp and BankStorage.h
  *
- * write() adds an entry to the proper linked list or replaces the
- *     value in a row that was already written
+ * write() stores the burst, allocating its page on first touch
  *
- * read() searches for a node with the right row value, if not found
- *     returns the tracer value 0xDEADBEEF
- *
- *    TODO: if anyone wants to actually store data, see the 'data_storage'
- *branch and perhaps try to merge that into master
+ * read() copies the stored burst into the packet, if the burst was
+ *     never written the packet data is left untouched
  */
 
-shared_ptr<Subarray::DataStruct> Subarray::searchForRow(unsigned row, shared_ptr<DataStruct> head)
-{
-    while (head != NULL)
-    {
-        if (head->row == row)
-        {
-            // found it
-            return head;
-        }
-        // keep looking
-        head = head->next;
-    }
-    // if we get here, didn't find it
-    return NULL; 
-}
 //how about subarray model to array 
 void Subarray::read(BusPacket* busPacket)
 {
-    shared_ptr<DataStruct> rowHeadNode = rowEntries[busPacket->column];
-    shared_ptr<DataStruct> foundNode = NULL;
     cout<<"subarray read"<<" and row is "<<busPacket->row<<" and col is "<<busPacket->column<<endl;
-    if ((foundNode = Subarray::searchForRow(busPacket->row, rowHeadNode)) == NULL)
-    {
-    }
-    else  // found it
+    if (busPacket->column >= numCols)
     {
-        *(busPacket->data) = foundNode->data;
+        return;
     }
+    storage.read(busPacket->row, busPacket->column, busPacket->data);
 }
 //i'd like to use this logic same as subarray....
 void Subarray::write(const BusPacket* busPacket)
@@ -101,34 +73,16 @@ void Subarray::write(const BusPacket* busPacket)
         exit(-1);
     }
 
-    // head of the list we need to search
-    shared_ptr<DataStruct> rowHeadNode = rowEntries[busPacket->column]; //such row groups that contains such column...
-    shared_ptr<DataStruct> foundNode = NULL;
-    if ((foundNode = Subarray::searchForRow(busPacket->row, rowHeadNode)) == NULL) //for certain row, no data 
-    {
-        // not found
-        shared_ptr<DataStruct> newRowNode = make_shared<DataStruct>();
-        // DataStruct* newRowNode = (DataStruct*)malloc(sizeof(DataStruct));
-
-        // insert at the head for speed
-        // TODO: Optimize this data structure for speedier lookups?
-        newRowNode->row = busPacket->row;
-        if (busPacket->data) //not null_bst_
-            newRowNode->data = *(busPacket->data);
-        newRowNode->next = rowHeadNode;
-        rowEntries[busPacket->column] = newRowNode;
-    }
+    if (busPacket->data) //not null_bst_
+        storage.write(busPacket->row, busPacket->column, *(busPacket->data));
     else
+        storage.write(busPacket->row, busPacket->column, BurstType());
+    if (DEBUG_BANKS)
     {
-        // found it, just plaster in the new data
-        foundNode->data = *(busPacket->data);
-        if (DEBUG_BANKS)
-        {
-            PRINTN(" -- Subarray " << busPacket->bank << " writing to physical address 0x" << hex
+        PRINTN(" -- Subarray " << busPacket->bank << " writing to physical address 0x" << hex
                                << busPacket->physicalAddress << dec << ":");
-            busPacket->printData();
-            PRINT("");
-        }
+        busPacket->printData();
+        PRINT("");
     }
 }
 //nothing to change ildan...
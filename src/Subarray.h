@@ -31,10 +31,10 @@
 #define SUBARRAY_H
 
 #include <iostream>
-#include <memory>
 #include <vector>
 
 #include "BankState.h"
+#include "BankStorage.h"
 #include "Burst.h"
 #include "BusPacket.h"
 #include "SimulatorObject.h"
@@ -44,13 +44,6 @@ namespace DRAMSim
 {
 class Subarray //x4
 {
-    typedef struct _DataStruct
-    {
-        unsigned row;
-        BurstType data; //16x16
-        std::shared_ptr<struct _DataStruct> next; //points to next datastruct
-    } DataStruct;
-    //how about use this in subarray level logic?
   public:
     // functions
     Subarray(ostream& simLog);
@@ -62,9 +55,8 @@ class Subarray //x4
 
   private:
     // private member
-    std::vector<std::shared_ptr<DataStruct>> rowEntries;
+    BankStorage storage;
     ostream& dramsimLog;
-    static std::shared_ptr<DataStruct> searchForRow(unsigned row, std::shared_ptr<DataStruct> head); //memory leak/dealloc easily
     unsigned numCols; 
 };
 } 
@@ -95,7 +95,8 @@ enum AddressMappingScheme
 enum RowBufferPolicy
 {
     OpenPage,
-    ClosePage
+    ClosePage,
+    AdaptivePage
 };
 
 // Only used in CommandQueue
@@ -109,7 +110,9 @@ enum SchedulingPolicy
 {
     RankThenBankRoundRobin,
     BankThenRankRoundRobin,
-    RankThenBankThenSubarrayRoundRobin
+    RankThenBankThenSubarrayRoundRobin,
+    FrFcfs,    // ready column commands first, then the oldest request of each bank
+    FrFcfsCap  // row hits first, capped at TOTAL_ROW_ACCESSES while a row conflict waits
 };
 
 enum PIMMode
@@ -124,6 +127,13 @@ enum PIMPrecision
     FP16,
     INT8,
     FP32,
+    BF16,
+};
+
+enum BankStorageMode
+{
+    HeapStorage,
+    MmapStorage
 };
 
 enum class dramMode
@@ -365,8 +375,11 @@ class PIMConfiguration
         }
         else if (param == "close_page")
         {
-            //return ClosePage;
-            throw invalid_argument("Close page policy is not supported");
+            return ClosePage;
+        }
+        else if (param == "adaptive")
+        {
+            return AdaptivePage;
         }
         throw invalid_argument("Invalid row buffer policy");
     }
@@ -387,6 +400,14 @@ class PIMConfiguration
         {
             return RankThenBankThenSubarrayRoundRobin;
         }
+        else if (param == "fr_fcfs")
+        {
+            return FrFcfs;
+        }
+        else if (param == "fr_fcfs_cap")
+        {
+            return FrFcfsCap;
+        }
         throw invalid_argument("Invalid scheduling policy");
     }
 
@@ -423,6 +444,20 @@ class PIMConfiguration
         throw invalid_argument("Invalid queueing structure");
     }
 
+    static BankStorageMode getBankStorageMode()
+    {
+        string param = getConfigParam(STRING, "BANK_STORAGE");
+        if (param == "heap")
+        {
+            return HeapStorage;  // default
+        }
+        else if (param == "mmap")
+        {
+            return MmapStorage;
+        }
+        throw invalid_argument("Invalid bank storage");
+    }
+
     static PIMMode getPIMMode()
     {
         string param = getConfigParam(STRING, "PIM_MODE");
@@ -456,6 +491,10 @@ class PIMConfiguration
         {
             return INT4;
         }
+        else if (param == "BF16")
+        {
+            return BF16;
+        }
         throw invalid_argument("Invalid PIM precision");
     }
 
@@ -474,6 +513,10 @@ class PIMConfiguration
         {
             return 4;
         }
+        else if (param == "BF16")
+        {
+            return 2;
+        }
         throw invalid_argument("Invalid PIM data length");
     }
 };
@@ -67,7 +67,11 @@ Transaction::Transaction(const Transaction& t)
       address(t.address),
       data(NULL),
       timeAdded(t.timeAdded),
-      timeReturned(t.timeReturned)
+      timeReturned(t.timeReturned),
+      rank(t.rank),
+      bank(t.bank),
+      row(t.row),
+      col(t.col)
 {
     if(transactionType != DATA_READ && transactionType != DATA_WRITE && transactionType != RETURN_DATA)
     {
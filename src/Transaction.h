@@ -34,6 +34,7 @@
 #include <string>
 
 #include "BusPacket.h"
+#include "ObjectPool.h"
 #include "SystemConfiguration.h"
 
 using std::ostream;
@@ -59,6 +60,8 @@ class Transaction
     uint64_t timeAdded;
     uint64_t timeReturned;
     std::string tag;
+    // address decoded once by MemoryController::addTransaction
+    unsigned rank, bank, row, col;
 
     friend ostream& operator<<(ostream& os, const Transaction& t);
     // functions
@@ -85,11 +88,14 @@ class Transaction
         }
     }
 
+    // one per request, recycled through ObjectPool
+    DECLARE_POOLED_NEW(Transaction)
+
   private:
     RowBufferPolicy rowBufferPolicy;
     bool isAllowedRowBufferPolicy(const RowBufferPolicy& policy)
     {
-        return (policy == OpenPage);
+        return (policy == OpenPage || policy == ClosePage || policy == AdaptivePage);
     }
 };
 
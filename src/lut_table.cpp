@@ -1,57 +1,33 @@
+#include <stdexcept>
+
 #include "lut_table.h"
 
 #define GELU(x) 0.5 * x * (1 + tanhf(sqrtf(2/M_PI) * (x + 0.044715*pow(x, 3))))
 
 using namespace DRAMSim;
 using namespace std;
+
+// the chord of f over every segment, computed in FP32 and rounded once
 void lut_table::fill(layerType layertype, PIMPrecision pimprecision){
+    if (pimprecision != FP16)
+        throw invalid_argument("lut_table holds FP16 slopes and intercepts");
+
     int size = sec_num / 16;
-    fp16 former = convertF2H(float(0));
-    fp16 latter = convertF2H(float(0));
-    fp16 slope  = convertF2H(float(0));
-    fp16 intercept = convertF2H(float(0));
-    int b_idx = 0;
-    for(int s = 0; s<size; s++)
+    int offset = getSlopeOffset(layertype);
+    float low = convertH2F((layertype == layerType::GELU) ? low_bound_gelu : low_bound_exp);
+    float up = convertH2F((layertype == layerType::GELU) ? up_bound_gelu : up_bound_exp);
+    float width = (up - low) / sec_num;
+
+    for (int b_idx = 0; b_idx < sec_num; b_idx++)
     {
-        for(int bst  = 0; bst < 16; bst++)
-        {
-            b_idx  = bst+16*s;
-            former = (layertype==layerType::GELU)?b_idx * (up_bound_gelu- low_bound_gelu) / convertF2H(float(sec_num)): b_idx * (up_bound_exp - low_bound_exp) / convertF2H(float(sec_num));
-            latter = (layertype == layerType::GELU)?former + (up_bound_gelu - low_bound_gelu) / convertF2H(float(sec_num)) : former + (up_bound_exp - low_bound_exp) /convertF2H(float(sec_num));
-            if(b_idx == 0){
-                sets[0]->fp16Data_[0] = convertF2H(float(0.0));
-                sets[size]->fp16Data_[0] = convertF2H(float(-65504.0));
-                sets[2*size]->fp16Data_[0] = convertF2H(float(0.0));
-                sets[3*size]->fp16Data_[0] = convertF2H(float(-65504.0));
-            }
-            else if(b_idx == sec_num){
-                sets[s]->fp16Data_[15] = convertF2H(float(0));
-                sets[s+ size]->fp16Data_[15] = convertF2H(float(65504.0));
-                sets[s+ 2* size]->fp16Data_[15] =convertF2H(float(0.0));
-                sets[s + 3*size]->fp16Data_[15] = convertF2H(float(65504.0));
-            }
-            else{
-                switch (layertype)
-                {
-                case layerType::GELU: //scope as -4, 4 
-                    slope =  convertF2H((GELU(convertH2F(latter)) - GELU(convertH2F(former))) / pow((convertH2F(latter)-convertH2F(former)), 2));
-                    intercept = convertF2H(expf(former)) - slope * former;
-                    sets[s]->fp16Data_[bst] = slope;
-                    sets[s+size]->fp16Data_[bst] = intercept;
-                    break;
-                case layerType::EXP: //scope as -11.0898, 11.0898 
-                    slope = convertF2H((expf(convertH2F(latter)) - expf(convertH2F(former))) / pow((convertH2F(latter) - convertH2F(former)), 2));
-                    intercept = convertF2H(expf(former)) - slope * former;
-                    sets[s + 2*size]->fp16Data_[bst] = slope;
-                    sets[s + 3*size]->fp16Data_[bst] = intercept;
-                    break;
-                default:
-                    break;
-                }
-            } 
-        }
+        float former = low + b_idx * width;
+        float latter = former + width;
+        float f_former = (layertype == layerType::GELU) ? GELU(former) : expf(former);
+        float f_latter = (layertype == layerType::GELU) ? GELU(latter) : expf(latter);
+        float slope = (f_latter - f_former) / width;
+        float intercept = f_former - slope * former;
+
+        sets[offset + b_idx / 16]->fp16Data_[b_idx % 16] = convertF2H(slope);
+        sets[offset + size + b_idx / 16]->fp16Data_[b_idx % 16] = convertF2H(intercept);
     }
 }
-
-//slope/intercept model seems like 
-//make lut_table as numpyburst how?
@@ -5,18 +5,33 @@
 #include <string>
 #include <vector>
 
-#include "tests/KernelAddrGen.h"
 #include "FP16.h"
 #include "half.h"
 #include "Burst.h"
+#include "SystemConfiguration.h"
 
 using namespace DRAMSim;
 using namespace std;
+
+// piecewise-linear functions of lut_table
+enum class layerType
+{
+    GELU,
+    EXP
+};
+
+/*
+ * Piecewise-linear GELU and exp. Each function splits [low, up) into sec_num segments and
+ * segment k holds a slope and an intercept, f(x) ~ slope[k] * x + intercept[k].
+ * sets keeps them as the bursts that are staged in the banks: GELU slopes, GELU intercepts,
+ * exp slopes, exp intercepts, sec_num / 16 bursts each.
+ */
 class lut_table
 {
 private:
 public:
     lut_table()
+        : sec_num(0)
     {};
     lut_table(int secnum, fp16 lowerbound, fp16 lowerbound_, fp16 upperbound, fp16 upperbound_){
         sec_num = secnum;
@@ -34,9 +49,27 @@ public:
         }
         sets.clear();
     };
+    lut_table(const lut_table&) = delete;
+    lut_table& operator=(const lut_table&) = delete;
+
     void fill(layerType layertype, PIMPrecision pim_cmds);
+    // first burst of the slopes of layertype in sets, the intercepts follow sec_num / 16 later
+    int getSlopeOffset(layerType layertype) const
+    {
+        return (layertype == layerType::GELU) ? 0 : 2 * (sec_num / 16);
+    }
+    // the register write that precedes sets: sec_num in u16Data_[0], then the four bounds
+    BurstType getHeader() const
+    {
+        BurstType header;
+        header.u16Data_[0] = sec_num;
+        header.fp16Data_[1] = low_bound_gelu;
+        header.fp16Data_[2] = up_bound_gelu;
+        header.fp16Data_[3] = low_bound_exp;
+        header.fp16Data_[4] = up_bound_exp;
+        return header;
+    }
     //void change(vector<fp16> slopes, vector<fp16> intercepts);
-    //vector<fp16> slopes, intercepts;
     vector<BurstType*> sets;
     int sec_num;
     fp16 low_bound_gelu, up_bound_gelu, low_bound_exp, up_bound_exp;
@@ -25,33 +25,8 @@ unsigned PIMAddrManager::maskByBit(unsigned value, int start, int end)
 uint64_t PIMAddrManager::addrGen(unsigned chan, unsigned rank, unsigned bankgroup, unsigned bank,
                                  unsigned row, unsigned col)
 {
-    uint64_t addr = 0;
-    if (address_mapping_scheme_ == Scheme8)
-    {
-        addr = rank;
-
-        addr <<= num_row_bits_;
-        addr |= row;
-
-        addr <<= num_col_bits_;
-        addr |= col;
-
-        addr <<= num_bankgroup_bits_;
-        addr |= bankgroup;
-
-        addr <<= num_bank_bits_;
-        addr |= bank;
-
-        addr <<= num_chan_bits_;
-        addr |= chan;
-
-        addr <<= num_offset_bits_;
-    }
-    else
-    {
-        cerr << "Fatal: Not supported address scheme for PIM controller" << endl;
-    }
-    return addr;
+    // bank is the bank within its bank group, col counts bursts
+    return addr_mapping_.encode(chan, rank, (bankgroup << num_bank_bits_) | bank, row, col);
 }
 
 uint64_t PIMAddrManager::addrGenSafe(unsigned chan, unsigned rank, unsigned bankgroup,
@@ -52,35 +52,14 @@ class PIMAddrManager
         num_rows_ = getConfigParam(UINT, "NUM_ROWS");
         num_cols_ = getConfigParam(UINT, "NUM_COLS");
 
-        num_bankgroup_bits_ = uLog2(num_bank_groups_);
         num_bank_bits_ = uLog2(num_banks_) - uLog2(num_bank_groups_);
-        num_row_bits_ = uLog2(num_rows_);
-        num_chan_bits_ = uLog2(num_chans_);
-        num_col_bits_ = uLog2(num_cols_ / getConfigParam(UINT, "BL"));
-        num_rank_bits_ = uLog2(num_ranks_);
-        num_offset_bits_ =
-            uLog2(getConfigParam(UINT, "BL") * getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") / 8);
-
-        num_col_low_bits_ = 2;
-        num_col_high_bits_ = num_col_bits_ - num_col_low_bits_;
         num_cols_per_bl_ = num_cols_ / getConfigParam(UINT, "BL");
-
-        address_mapping_scheme_ = PIMConfiguration::getAddressMappingScheme();
     }
 
   private:
-    int num_chan_bits_;
-    int num_rank_bits_;
-    int num_col_bits_;
-    int num_row_bits_;
     int num_bank_bits_;
-    int num_bankgroup_bits_;
-    int num_offset_bits_;
-
-    int num_col_low_bits_;
-    int num_col_high_bits_;
 
-    AddressMappingScheme address_mapping_scheme_;
+    AddrMapping addr_mapping_;
 };
 
 enum class KernelType
@@ -90,6 +69,13 @@ enum class KernelType
     RELU,
     GEMV,
     MUL,
-    GEMVTREE
+    GEMVTREE,
+    ADD_RELU,
+    MUL_ADD,
+    SCALE_SHIFT,
+    SOFTMAX,
+    GELU,
+    LAYERNORM,
+    RMSNORM
 };
 #endif
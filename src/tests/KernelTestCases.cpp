@@ -12,6 +12,9 @@
 
 #include "tests/KernelTestCases.h"
 
+#include <chrono>
+
+#include "IntBurst.h"
 #include "gtest/gtest.h"
 #include "tests/PIMKernel.h"
 
@@ -82,6 +85,29 @@ TEST_F(PIMKernelFixture, gemv)
     delete dim_data;
 }
 
+TEST_F(PIMKernelFixture, gemv_batch)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel();
+
+    uint32_t batch_size = 4;
+    uint32_t output_dim = 1024;
+    uint32_t input_dim = 256;
+
+    DataDim *dim_data = new DataDim(KernelType::GEMV, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::GEMV);
+
+    reduced_result_ = new BurstType[dim_data->dimTobShape(output_dim) * batch_size];
+    result_ = getResultPIM(KernelType::GEMV, dim_data, kernel, result_);
+
+    testStatsClear();
+    expectAccuracy(KernelType::GEMV, output_dim * batch_size, dim_data->output_npbst_,
+                   dim_data->getNumElementsPerBlocks());
+
+    delete[] result_;
+    delete[] reduced_result_;
+    delete dim_data;
+}
+
 TEST_F(PIMKernelFixture, mul)
 {
     shared_ptr<PIMKernel> kernel = make_pim_kernel();
@@ -124,6 +150,72 @@ TEST_F(PIMKernelFixture, add)
     delete dim_data;
 }
 
+TEST_F(PIMKernelFixture, add_relu)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel();
+
+    uint32_t batch_size = 1;
+    uint32_t output_dim = 1024 * 1024;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::ADD, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::ADD);
+
+    result_ = getResultPIM(KernelType::ADD_RELU, dim_data, kernel, result_);
+    kernel->runPIM();
+
+    testStatsClear();
+    expectAccuracy(KernelType::ADD_RELU, dim_data->dimTobShape(output_dim),
+                   getFusedEltwiseGolden(KernelType::ADD_RELU, dim_data));
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, mul_add)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel();
+
+    uint32_t batch_size = 1;
+    uint32_t output_dim = 1024 * 1024;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::MUL, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::MUL);
+
+    result_ = getResultPIM(KernelType::MUL_ADD, dim_data, kernel, result_);
+    kernel->runPIM();
+
+    testStatsClear();
+    expectAccuracy(KernelType::MUL_ADD, dim_data->dimTobShape(output_dim),
+                   getFusedEltwiseGolden(KernelType::MUL_ADD, dim_data));
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, scale_shift)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel();
+
+    uint32_t batch_size = 1;
+    uint32_t output_dim = 1024 * 1024;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::ADD, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::ADD);
+
+    result_ = getResultPIM(KernelType::SCALE_SHIFT, dim_data, kernel, result_);
+    kernel->runPIM();
+
+    testStatsClear();
+    expectAccuracy(KernelType::SCALE_SHIFT, dim_data->dimTobShape(output_dim),
+                   getFusedEltwiseGolden(KernelType::SCALE_SHIFT, dim_data));
+
+    delete[] result_;
+    delete dim_data;
+}
+
 TEST_F(PIMKernelFixture, relu)
 {
     shared_ptr<PIMKernel> kernel = make_pim_kernel();
@@ -142,3 +234,287 @@ TEST_F(PIMKernelFixture, relu)
     delete[] result_;
     delete dim_data;
 }
+
+TEST_F(PIMKernelFixture, softmax)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel();
+
+    uint32_t batch_size = 64;
+    uint32_t output_dim = 4096;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::SOFTMAX, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::SOFTMAX);
+
+    result_ = getResultPIM(KernelType::SOFTMAX, dim_data, kernel, result_);
+
+    testStatsClear();
+    expectAccuracy(KernelType::SOFTMAX, batch_size * dim_data->dimTobShape(output_dim),
+                   dim_data->output_npbst_);
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, layernorm)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel();
+
+    uint32_t batch_size = 64;
+    uint32_t output_dim = 4096;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::LAYERNORM, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::LAYERNORM);
+
+    result_ = getResultPIM(KernelType::LAYERNORM, dim_data, kernel, result_);
+
+    testStatsClear();
+    expectAccuracy(KernelType::LAYERNORM, batch_size * dim_data->dimTobShape(output_dim),
+                   dim_data->output_npbst_);
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, rmsnorm)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel();
+
+    uint32_t batch_size = 64;
+    uint32_t output_dim = 4096;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::RMSNORM, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::RMSNORM);
+
+    result_ = getResultPIM(KernelType::RMSNORM, dim_data, kernel, result_);
+
+    testStatsClear();
+    expectAccuracy(KernelType::RMSNORM, batch_size * dim_data->dimTobShape(output_dim),
+                   dim_data->output_npbst_);
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, gelu)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel();
+    uint32_t output_dim = 256 * 1024;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::GELU, 1, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::GELU);
+
+    result_ = getResultPIM(KernelType::GELU, dim_data, kernel, result_);
+
+    testStatsClear();
+    expectAccuracy(KernelType::GELU, dim_data->dimTobShape(output_dim), dim_data->output_npbst_);
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, gemv_bf16)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel("system_hbm_64ch_bf16.ini");
+
+    uint32_t batch_size = 1;
+    uint32_t output_dim = 4096;
+    uint32_t input_dim = 256;
+
+    DataDim *dim_data = new DataDim(KernelType::GEMV, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::GEMV);
+
+    reduced_result_ = new BurstType[dim_data->dimTobShape(output_dim)];
+    result_ = getResultPIM(KernelType::GEMV, dim_data, kernel, result_);
+
+    testStatsClear();
+    expectAccuracy(KernelType::GEMV, output_dim, dim_data->output_npbst_,
+                   dim_data->getNumElementsPerBlocks());
+
+    delete[] result_;
+    delete[] reduced_result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, add_bf16)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel("system_hbm_64ch_bf16.ini");
+
+    uint32_t batch_size = 1;
+    uint32_t output_dim = 256 * 1024;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::ADD, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::ADD);
+
+    result_ = getResultPIM(KernelType::ADD, dim_data, kernel, result_);
+
+    testStatsClear();
+    expectAccuracy(KernelType::ADD, dim_data->dimTobShape(output_dim), dim_data->output_npbst_);
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, mul_bf16)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel("system_hbm_64ch_bf16.ini");
+
+    uint32_t batch_size = 1;
+    uint32_t output_dim = 256 * 1024;
+    uint32_t input_dim = output_dim;
+
+    DataDim *dim_data = new DataDim(KernelType::MUL, batch_size, output_dim, input_dim, true);
+    dim_data->printDim(KernelType::MUL);
+
+    result_ = getResultPIM(KernelType::MUL, dim_data, kernel, result_);
+
+    testStatsClear();
+    expectAccuracy(KernelType::MUL, dim_data->dimTobShape(output_dim), dim_data->output_npbst_);
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, bf16_timed_matches_functional)
+{
+    for (KernelType kn_type : {KernelType::GEMV, KernelType::ADD, KernelType::MUL})
+    {
+        bool gemv = (kn_type == KernelType::GEMV);
+        uint32_t output_dim = gemv ? 4096 : 256 * 1024;
+        uint32_t input_dim = gemv ? 256 : output_dim;
+
+        // the timed kernel first, so DataDim loads the BF16 operands of its configuration
+        shared_ptr<PIMKernel> kernel = make_pim_kernel("system_hbm_64ch_bf16.ini");
+        DataDim *dim_data = new DataDim(kn_type, 1, output_dim, input_dim, true);
+        unsigned num_bursts = gemv ? output_dim : dim_data->dimTobShape(output_dim);
+
+        BurstType *timed = getResultPIM(kn_type, dim_data, kernel, nullptr);
+        EXPECT_GT(kernel->getCycle(), 0);
+        kernel.reset();
+
+        kernel = make_pim_kernel("system_hbm_64ch_bf16.ini", true);
+        BurstType *functional = getResultPIM(kn_type, dim_data, kernel, nullptr);
+        EXPECT_EQ(kernel->getCycle(), 0);
+        kernel.reset();
+
+        result_ = timed;
+        reduced_result_ = gemv ? new BurstType[dim_data->dimTobShape(output_dim)] : nullptr;
+        testStatsClear();
+        if (gemv)
+            expectAccuracy(kn_type, output_dim, dim_data->output_npbst_,
+                           dim_data->getNumElementsPerBlocks());
+        else
+            expectAccuracy(kn_type, num_bursts, dim_data->output_npbst_);
+        EXPECT_TRUE(equal(timed, timed + num_bursts, functional)) << "kernel " << int(kn_type);
+
+        delete[] timed;
+        delete[] functional;
+        delete[] reduced_result_;
+        delete dim_data;
+    }
+}
+
+TEST_F(PIMKernelFixture, gemv_int8)
+{
+    shared_ptr<PIMKernel> kernel = make_pim_kernel("system_hbm_64ch_int8.ini");
+    uint32_t output_dim = 4096;
+    uint32_t input_dim = 1024;
+
+    // 32 INT8 lanes per burst: a weight burst holds 32 inputs of one output row, the input burst
+    // the same 32 inputs
+    DataDim *dim_data = new DataDim(KernelType::GEMV, 1, output_dim, input_dim, false);
+    NumpyBurstType &weight = dim_data->weight_npbst_;
+    NumpyBurstType &input = dim_data->input_npbst_;
+    ASSERT_EQ(weight.bShape[1], input_dim / 32);
+    mt19937 gen(15);
+    uniform_int_distribution<int> dis(-128, 127);
+    weight.bData.resize(weight.bShape[0] * weight.bShape[1]);
+    for (auto &bst : weight.bData)
+        for (int i = 0; i < 32; i++) setIntLane(bst, INT8, i, dis(gen));
+    for (auto &bst : input.bData)
+        for (int i = 0; i < 32; i++) setIntLane(bst, INT8, i, dis(gen));
+
+    result_ = getResultPIM(KernelType::GEMV, dim_data, kernel, nullptr);
+
+    // MAC folds lanes 4j..4j+3 of each product into INT32 lane j of the output row's GRF_B burst,
+    // so every result burst holds eight partial dot products that the host adds up
+    for (uint32_t y = 0; y < output_dim; y++)
+    {
+        int64_t expected = 0;
+        for (unsigned x = 0; x < weight.bShape[1]; x++)
+        {
+            for (int i = 0; i < 32; i++)
+                expected += getIntLane(weight.bData[y * weight.bShape[1] + x], INT8, i) *
+                            getIntLane(input.bData[x], INT8, i);
+        }
+        EXPECT_EQ(result_[y].i32ReduceSum(), expected) << "output " << y;
+    }
+
+    delete[] result_;
+    delete dim_data;
+}
+
+TEST_F(PIMKernelFixture, fp16_timed_matches_functional)
+{
+    cout << ">> FP16 timed vs functional (64ch)" << endl;
+    for (KernelType kn_type : {KernelType::GEMV, KernelType::ADD, KernelType::MUL})
+    {
+        bool gemv = (kn_type == KernelType::GEMV);
+        uint32_t output_dim = gemv ? 4096 : 1024 * 1024;
+        uint32_t input_dim = gemv ? 1024 : output_dim;
+
+        // the kernel first, so DataDim sees the precision of its configuration
+        shared_ptr<PIMKernel> kernel = make_pim_kernel("system_hbm_64ch.ini");
+        // the FP16 GEMV weights of this size are not checked in, generate them instead
+        DataDim *dim_data = new DataDim(kn_type, 1, output_dim, input_dim, !gemv);
+        if (gemv)
+        {
+            mt19937 gen(17);
+            uniform_real_distribution<float> dis(-0.5f, 0.5f);
+            NumpyBurstType &weight = dim_data->weight_npbst_;
+            weight.bData.resize(weight.bShape[0] * weight.bShape[1]);
+            for (auto &bst : weight.bData)
+                for (int j = 0; j < 16; j++) bst.fp16Data_[j] = convertF2H(dis(gen));
+            for (auto &bst : dim_data->input_npbst_.bData)
+                for (int j = 0; j < 16; j++) bst.fp16Data_[j] = convertF2H(dis(gen));
+        }
+        unsigned num_bursts = gemv ? output_dim : dim_data->dimTobShape(output_dim);
+
+        double wall[2];
+        uint64_t cycles[2];
+        BurstType *result[2];
+        for (int functional = 0; functional < 2; functional++)
+        {
+            if (functional)
+                kernel = make_pim_kernel("system_hbm_64ch.ini", true);
+            auto start = chrono::steady_clock::now();
+            result[functional] = getResultPIM(kn_type, dim_data, kernel, nullptr);
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+            wall[functional] = elapsed.count();
+            cycles[functional] = kernel->getCycle();
+            kernel.reset();
+        }
+        EXPECT_GT(cycles[0], 0);
+        EXPECT_EQ(cycles[1], 0);
+        EXPECT_TRUE(equal(result[0], result[0] + num_bursts, result[1]))
+            << "kernel " << int(kn_type);
+        cout << "  kernel: " << (gemv ? "GEMV" : kn_type == KernelType::ADD ? "ADD" : "MUL")
+             << " cycles: " << cycles[0] << " timed wall (s): " << wall[0]
+             << " functional wall (s): " << wall[1] << " speedup: " << wall[0] / wall[1] << endl;
+
+        if (!gemv)
+        {
+            result_ = result[0];
+            testStatsClear();
+            expectAccuracy(kn_type, num_bursts, dim_data->output_npbst_);
+        }
+
+        delete[] result[0];
+        delete[] result[1];
+        delete dim_data;
+    }
+}
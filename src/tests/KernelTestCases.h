@@ -26,6 +26,18 @@ using namespace DRAMSim;
                                               DRAMSim::BurstType mb, DRAMSim::BurstType nb);
 #define EXPECT_FP16_BST_EQ(val1, val2) EXPECT_PRED_FORMAT2(fp16BstEqualHelper, val1, val2)
 #define EXPECT_FP16_EQ(val1, val2) EXPECT_PRED_FORMAT2(fp16EqualHelper, val1, val2)
+::testing::AssertionResult bf16EqualHelper(const char* m_expr, const char* n_expr, uint16_t m,
+                                           uint16_t n);
+::testing::AssertionResult bf16BstEqualHelper(const char* m_expr, const char* n_expr,
+                                              DRAMSim::BurstType mb, DRAMSim::BurstType nb);
+#define EXPECT_BF16_BST_EQ(val1, val2) EXPECT_PRED_FORMAT2(bf16BstEqualHelper, val1, val2)
+#define EXPECT_BF16_EQ(val1, val2) EXPECT_PRED_FORMAT2(bf16EqualHelper, val1, val2)
+::testing::AssertionResult fp16BstNearHelper(const char* m_expr, const char* n_expr,
+                                             const char* atol_expr, const char* rtol_expr,
+                                             DRAMSim::BurstType mb, DRAMSim::BurstType nb,
+                                             float atol, float rtol);
+#define EXPECT_FP16_BST_NEAR(val1, val2, atol, rtol) \
+    EXPECT_PRED_FORMAT4(fp16BstNearHelper, val1, val2, atol, rtol)
 
 class TestStats
 {
@@ -98,7 +110,12 @@ TestStats testStats;
 class PIMKernelFixture : public testing::Test
 {
   public:
-    PIMKernelFixture() {}
+    PIMKernelFixture()
+        : lut_(64, convertF2H(-4.0f), convertF2H(-11.0898f), convertF2H(4.0f), convertF2H(0.0f))
+    {
+        lut_.fill(layerType::GELU, FP16);
+        lut_.fill(layerType::EXP, FP16);
+    }
     ~PIMKernelFixture() {}
 
     virtual void SetUp()
@@ -121,11 +138,15 @@ class PIMKernelFixture : public testing::Test
             {
                 kernel->preloadGemv(&dim_data->weight_npbst_);
                 kernel->executeGemv(&dim_data->weight_npbst_, &dim_data->input_npbst_, false);
-                unsigned end_col = kernel->getResultColGemv(
-                    dim_data->dimTobShape(dim_data->input_dim_), dim_data->output_dim_);
                 result = new BurstType[dim_data->output_dim_ * dim_data->batch_size_];
-                kernel->readResult(result, pimBankType::ODD_BANK,
-                                   dim_data->output_dim_ * dim_data->batch_size_, 0, 0, end_col);
+                for (uint32_t b = 0; b < dim_data->batch_size_; b++)
+                {
+                    unsigned end_col = kernel->getResultColGemv(
+                        dim_data->dimTobShape(dim_data->input_dim_), dim_data->output_dim_, b);
+                    kernel->readResult(result + b * dim_data->output_dim_,
+                                       pimBankType::ODD_BANK, dim_data->output_dim_, 0, 0,
+                                       end_col);
+                }
                 break;
             }
             case KernelType::ADD:
@@ -144,6 +165,81 @@ class PIMKernelFixture : public testing::Test
                                  0);
                 break;
             }
+            case KernelType::ADD_RELU:
+            case KernelType::MUL_ADD:
+            {
+                // MUL_ADD reuses input0 as its addend from a third row: in0 * in1 + in0
+                int input_row0 = 0;
+                int input_row1 = 128;
+                int input_row2 = 384;
+                int result_row = 256;
+                kernel->preloadNoReplacement(&dim_data->input_npbst_, input_row0, 0);
+                kernel->preloadNoReplacement(&dim_data->input1_npbst_, input_row1, 0);
+                if (kn_type == KernelType::MUL_ADD)
+                    kernel->preloadNoReplacement(&dim_data->input_npbst_, input_row2, 0);
+                kernel->executeEltwise(dim_data->dimTobShape(dim_data->output_dim_),
+                                       pimBankType::ALL_BANK, kn_type, input_row0, result_row,
+                                       input_row1, input_row2);
+                result = new BurstType[dim_data->output_dim_];
+                kernel->readData(result, dim_data->dimTobShape(dim_data->output_dim_), result_row,
+                                 0);
+                break;
+            }
+            case KernelType::SCALE_SHIFT:
+            {
+                int input_row0 = 0;
+                int result_row = 256;
+                kernel->preloadNoReplacement(&dim_data->input_npbst_, input_row0, 0);
+                kernel->executeScaleShift(dim_data->dimTobShape(dim_data->output_dim_),
+                                          pimBankType::ALL_BANK, fused_scale_, fused_shift_,
+                                          input_row0, result_row);
+                result = new BurstType[dim_data->output_dim_];
+                kernel->readData(result, dim_data->dimTobShape(dim_data->output_dim_), result_row,
+                                 0);
+                break;
+            }
+            case KernelType::SOFTMAX:
+            {
+                int input_row0 = 0;
+                int result_row = 256;
+                int row_dim = dim_data->dimTobShape(dim_data->input_dim_);
+                kernel->preloadLut(&lut_);
+                kernel->preloadSoftmax(&dim_data->input_npbst_, row_dim, input_row0);
+                kernel->executeSoftmax(dim_data->batch_size_, row_dim, input_row0, result_row);
+                result = new BurstType[dim_data->batch_size_ * row_dim];
+                kernel->readResultSoftmax(result, dim_data->batch_size_, row_dim, result_row);
+                break;
+            }
+            case KernelType::LAYERNORM:
+            case KernelType::RMSNORM:
+            {
+                int input_row0 = 0;
+                int result_row = 256;
+                int param_row = 512;
+                int row_dim = dim_data->dimTobShape(dim_data->input_dim_);
+                kernel->preloadSoftmax(&dim_data->input_npbst_, row_dim, input_row0);
+                kernel->preloadNormParam(&dim_data->weight_npbst_, param_row);
+                if (kn_type == KernelType::LAYERNORM)  // beta right after gamma
+                    kernel->preloadNormParam(&dim_data->input1_npbst_, param_row, row_dim);
+                kernel->executeNorm(kn_type, dim_data->batch_size_, row_dim, input_row0,
+                                    result_row, param_row);
+                result = new BurstType[dim_data->batch_size_ * row_dim];
+                kernel->readResultSoftmax(result, dim_data->batch_size_, row_dim, result_row);
+                break;
+            }
+            case KernelType::GELU:
+            {
+                int input_row0 = 0;
+                int result_row = 256;
+                kernel->preloadLut(&lut_);
+                kernel->preloadNoReplacement(&dim_data->input_npbst_, input_row0, 0);
+                kernel->executeGelu(dim_data->dimTobShape(dim_data->output_dim_), input_row0,
+                                    result_row);
+                result = new BurstType[dim_data->output_dim_];
+                kernel->readData(result, dim_data->dimTobShape(dim_data->output_dim_), result_row,
+                                 0);
+                break;
+            }
             case KernelType::RELU:
             {
                 int input_row0 = 0;
@@ -170,12 +266,20 @@ class PIMKernelFixture : public testing::Test
     void expectAccuracy(KernelType kn_type, int num_tests, NumpyBurstType precalculated_result,
                         uint32_t stride = 16)
     {
+        bool is_bf16 = (PIMConfiguration::getPIMPrecision() == BF16);
         switch (kn_type)
         {
             case KernelType::GEMV:
             {
                 for (int i = 0; i < num_tests; i++)
                 {
+                    if (is_bf16)
+                    {
+                        uint16_t sum = convertF2BF(result_[i].bf16ReduceSum());
+                        EXPECT_BF16_EQ(sum, precalculated_result.getBurst(0).u16Data_[i]);
+                        reduced_result_[i / stride].u16Data_[i % stride] = sum;
+                        continue;
+                    }
                     EXPECT_FP16_EQ(result_[i].fp16ReduceSum(),
                                    precalculated_result.getBurst(0).fp16Data_[i]);
                     reduced_result_[i / stride].fp16Data_[i % stride] = result_[i].fp16ReduceSum();
@@ -185,13 +289,36 @@ class PIMKernelFixture : public testing::Test
             case KernelType::ADD:
             case KernelType::MUL:
             case KernelType::RELU:
+            case KernelType::ADD_RELU:
+            case KernelType::MUL_ADD:
+            case KernelType::SCALE_SHIFT:
             {
                 for (int i = 0; i < num_tests; i++)
                 {
-                    EXPECT_FP16_BST_EQ(result_[i], precalculated_result.getBurst(i));
+                    if (is_bf16)
+                        EXPECT_BF16_BST_EQ(result_[i], precalculated_result.getBurst(i));
+                    else
+                        EXPECT_FP16_BST_EQ(result_[i], precalculated_result.getBurst(i));
                 }
                 return;
             }
+            case KernelType::SOFTMAX:
+            case KernelType::GELU:
+            {
+                // the C_ALU interpolates exp and GELU linearly, numpy evaluates them exactly
+                float atol = (kn_type == KernelType::SOFTMAX) ? 1e-5 : 4e-3;
+                for (int i = 0; i < num_tests; i++)
+                    EXPECT_FP16_BST_NEAR(result_[i], precalculated_result.getBurst(i), atol, 2e-2);
+                return;
+            }
+            case KernelType::LAYERNORM:
+            case KernelType::RMSNORM:
+            {
+                // the PIM blocks apply the row statistics in FP16, numpy in FP32
+                for (int i = 0; i < num_tests; i++)
+                    EXPECT_FP16_BST_NEAR(result_[i], precalculated_result.getBurst(i), 1e-2, 2e-2);
+                return;
+            }
             default:
             {
                 ERROR("== Error - Unknown KernelType trying to run");
@@ -200,11 +327,53 @@ class PIMKernelFixture : public testing::Test
         }
     }
 
-    shared_ptr<PIMKernel> make_pim_kernel()
+    // host reference of the fused element-wise kernels, rounded after every op like the PIM ALU
+    NumpyBurstType getFusedEltwiseGolden(KernelType kn_type, DataDim* dim_data)
+    {
+        bool is_bf16 = (PIMConfiguration::getPIMPrecision() == BF16);
+        auto toFloat = [is_bf16](BurstType& bst, int j) {
+            return is_bf16 ? convertBF2F(bst.u16Data_[j]) : convertH2F(bst.fp16Data_[j]);
+        };
+        auto round = [is_bf16](float x) {
+            return is_bf16 ? convertBF2F(convertF2BF(x)) : convertH2F(convertF2H(x));
+        };
+
+        NumpyBurstType golden = (kn_type == KernelType::ADD_RELU) ? dim_data->output_npbst_
+                                                                  : dim_data->input_npbst_;
+        for (size_t i = 0; i < golden.bData.size(); i++)
+        {
+            for (int j = 0; j < 16; j++)
+            {
+                if (kn_type == KernelType::ADD_RELU)
+                {
+                    uint16_t& v = golden.bData[i].u16Data_[j];
+                    v = (v & (1 << 15)) ? 0 : v;
+                    continue;
+                }
+                float x = toFloat(dim_data->input_npbst_.bData[i], j);
+                float y;
+                if (kn_type == KernelType::MUL_ADD)
+                    y = round(round(x * toFloat(dim_data->input1_npbst_.bData[i], j)) + x);
+                else
+                    y = round(round(x * fused_scale_) + fused_shift_);
+
+                if (is_bf16)
+                    golden.bData[i].u16Data_[j] = convertF2BF(y);
+                else
+                    golden.bData[i].fp16Data_[j] = convertF2H(y);
+            }
+        }
+        return golden;
+    }
+
+    // the precision of the kernel follows PIM_PRECISION in sys_ini
+    shared_ptr<PIMKernel> make_pim_kernel(const string& sys_ini = "system_hbm_64ch.ini",
+                                          bool functional = false)
     {
         shared_ptr<MultiChannelMemorySystem> mem = make_shared<MultiChannelMemorySystem>(
-            "ini/HBM2_samsung_2M_16B_x64.ini", "system_hbm_64ch.ini", ".", "example_app",
-            256 * 64 * 2);
+            "ini/HBM2_samsung_2M_16B_x64.ini", sys_ini, ".", "example_app", 256 * 64 * 2);
+        if (functional)
+            mem->setFunctionalMode(true);
         int numPIMChan = 64;
         int numPIMRank = 1;
         shared_ptr<PIMKernel> kernel = make_shared<PIMKernel>(mem, numPIMChan, numPIMRank);
@@ -216,6 +385,13 @@ class PIMKernelFixture : public testing::Test
     BurstType* result_;
     BurstType* reduced_result_;
 
+    /* SOFTMAX and GELU table, 64 segments each */
+    lut_table lut_;
+
+    /* SCALE_SHIFT operands */
+    const float fused_scale_ = 0.5f;
+    const float fused_shift_ = -0.25f;
+
     /* stats */
     void testStatsClear()
     {
@@ -306,4 +482,73 @@ class PIMKernelFixture : public testing::Test
 
     return ::testing::AssertionSuccess();
 }
+
+// |sim - npy| <= atol + rtol * |npy| on every lane
+::testing::AssertionResult fp16BstNearHelper(const char* m_expr, const char* n_expr,
+                                             const char* atol_expr, const char* rtol_expr,
+                                             BurstType mb, BurstType nb, float atol, float rtol)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        float m = convertH2F(mb.fp16Data_[i]);
+        float n = convertH2F(nb.fp16Data_[i]);
+
+        if (fabs(m - n) <= atol + rtol * fabs(n))
+        {
+            INC_NUM_PASSED();
+        }
+        else
+        {
+            INC_NUM_FAILED();
+            INSERT_TO_FAILED_VECTOR(m, n);
+            return ::testing::AssertionFailure() << m_expr << " and " << n_expr << " (" << m
+                                                 << " and " << n << ") are not within "
+                                                 << atol_expr << " + " << rtol_expr;
+        }
+    }
+
+    return ::testing::AssertionSuccess();
+}
+
+// BF16 keeps 3 fewer significand bits than FP16, so the ULP bounds are 8x tighter
+::testing::AssertionResult bf16EqualHelper(const char* m_expr, const char* n_expr, uint16_t m,
+                                           uint16_t n)
+{
+    unsigned cur_idx = GET_NUM_TESTS();
+    if (bf16Equal(m, n, 1, 0.01) || bf16Equal(m, n, 32, 0.7))
+    {
+        INC_NUM_PASSED();
+        return ::testing::AssertionSuccess();
+    }
+    INSERT_TO_FAILED_VECTOR(convertBF2F(m), convertBF2F(n));
+    INC_NUM_FAILED();
+    return ::testing::AssertionFailure() << cur_idx << m_expr << " and " << n_expr << " ("
+                                         << convertBF2F(m) << " and " << convertBF2F(n)
+                                         << ") are not same " << m << " " << n;
+}
+
+::testing::AssertionResult bf16BstEqualHelper(const char* m_expr, const char* n_expr, BurstType mb,
+                                              BurstType nb)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        uint16_t m = mb.u16Data_[i];
+        uint16_t n = nb.u16Data_[i];
+
+        if (bf16Equal(m, n, 1, 0.01) || bf16Equal(m, n, 32, 0.7))
+        {
+            INC_NUM_PASSED();
+        }
+        else
+        {
+            INC_NUM_FAILED();
+            INSERT_TO_FAILED_VECTOR(convertBF2F(m), convertBF2F(n));
+            return ::testing::AssertionFailure()
+                   << m_expr << " and " << n_expr << " (" << convertBF2F(m) << " and "
+                   << convertBF2F(n) << ") are not same " << m << " " << n;
+        }
+    }
+
+    return ::testing::AssertionSuccess();
+}
 #endif
@@ -18,6 +18,7 @@
 #include <random>
 
 #include "Burst.h"
+#include "CmdTrace.h"
 #include "MultiChannelMemorySystem.h"
 #include "gtest/gtest.h"
 #include "tests/PIMKernel.h"
@@ -27,6 +28,12 @@ using namespace std;
 
 int main(int argc, char* argv[])
 {
+    const string decodeOption = "--decode-cmd-trace=";
+    if (argc > 1 && string(argv[1]).compare(0, decodeOption.size(), decodeOption) == 0)
+    {
+        return DRAMSim::decodeCmdTrace(string(argv[1]).substr(decodeOption.size()), cout) ? 0 : 1;
+    }
+
     if (argc > 1)
     {
         ::testing::InitGoogleTest(&argc, argv);
@@ -10,6 +10,20 @@
  * only)
  **************************************************************************************************/
 
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "BankStorage.h"
+#include "CmdTrace.h"
+#include "FP16Simd.h"
+#include "IntBurst.h"
+#include "PIMBlock.h"
+#include "SBlock.h"
+#include "PendingReadTable.h"
+#include "ReadyQueue.h"
 #include "gtest/gtest.h"
 #include "tests/TestCases.h"
 
@@ -20,6 +34,43 @@
 
 using namespace DRAMSim;
 
+TEST_F(basicFixture, pim_cmd_max_encoding)
+{
+    // a CRF entry keeps 4 opcode bits, MAX has to come back as MAX and not as another opcode
+    PIMCmd max_cmd(PIMCmdType::MAX, PIMOpdType::GRF_B, PIMOpdType::GRF_B, PIMOpdType::EVEN_BANK, 1,
+                   3, 3, 0);
+    EXPECT_LT(static_cast<int>(PIMCmdType::MAX), 16);
+
+    PIMCmd decoded;
+    decoded.fromInt(max_cmd.toInt());
+    EXPECT_EQ(decoded.type_, PIMCmdType::MAX);
+    EXPECT_EQ(decoded.dst_, PIMOpdType::GRF_B);
+    EXPECT_EQ(decoded.src0_, PIMOpdType::GRF_B);
+    EXPECT_EQ(decoded.src1_, PIMOpdType::EVEN_BANK);
+    EXPECT_EQ(decoded.isAuto_, 1);
+    EXPECT_EQ(decoded.dstIdx_, 3);
+    EXPECT_EQ(decoded.src0Idx_, 3);
+    EXPECT_TRUE(decoded == max_cmd);
+}
+
+TEST_F(basicFixture, pim_cmd_lut_encoding)
+{
+    // GELU and EXP sit in the next reserved slots with the operand fields of ADD
+    for (PIMCmdType type : {PIMCmdType::GELU, PIMCmdType::EXP})
+    {
+        PIMCmd cmd(type, PIMOpdType::GRF_A, PIMOpdType::ODD_BANK, PIMOpdType::SRF_M, 1, 0, 0, 2);
+        EXPECT_LT(static_cast<int>(type), 16);
+
+        PIMCmd decoded;
+        decoded.fromInt(cmd.toInt());
+        EXPECT_EQ(decoded.type_, type);
+        EXPECT_EQ(decoded.src0_, PIMOpdType::ODD_BANK);
+        EXPECT_EQ(decoded.src1_, PIMOpdType::SRF_M);
+        EXPECT_EQ(decoded.src1Idx_, 2);
+        EXPECT_TRUE(decoded == cmd);
+    }
+}
+
 TEST_F(MemBandwidthFixture, hbm_read_bandwidth)
 {
     setDataSize(128 * 1024 * 64);  // in bytes
@@ -35,3 +86,1418 @@ TEST_F(MemBandwidthFixture, hbm_write_bandwidth)
     float effective_bw_ratio = 0.8;
     EXPECT_TRUE(bw > 256 * effective_bw_ratio);
 }
+
+TEST_F(MemBandwidthFixture, hbm_bandwidth_per_scheduling_policy)
+{
+    // policy and the TOTAL_ROW_ACCESSES cap it runs with
+    vector<pair<string, string>> policies = {{"rank_then_bank_round_robin", "65535"},
+                                             {"bank_then_rank_round_robin", "65535"},
+                                             {"fr_fcfs", "65535"},
+                                             {"fr_fcfs_cap", "16"}};
+    float effective_bw_ratio = 0.8;
+
+    for (bool random : {false, true})
+    {
+        for (bool is_write : {false, true})
+        {
+            for (auto& policy : policies)
+            {
+                resetMemory({{"SCHEDULING_POLICY", policy.first},
+                             {"TOTAL_ROW_ACCESSES", policy.second}});
+                setDataSize(128 * 1024 * 16);
+                setRandomTraffic(random);
+                uint64_t cycle = measureCycle(is_write);
+                uint32_t bw = getBandwidth(cycle);
+                cout << "> " << (random ? "random " : "sequential ")
+                     << (is_write ? "write " : "read ") << policy.first << " BW (GB/s): " << bw
+                     << endl;
+                if (!random)
+                {
+                    EXPECT_TRUE(bw > 256 * effective_bw_ratio);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(MemBandwidthFixture, hbm_bandwidth_per_row_buffer_policy)
+{
+    vector<string> policies = {"open_page", "close_page", "adaptive"};
+    float effective_bw_ratio = 0.8;
+
+    for (bool random : {false, true})
+    {
+        for (bool is_write : {false, true})
+        {
+            for (auto& policy : policies)
+            {
+                resetMemory({{"ROW_BUFFER_POLICY", policy}});
+                setDataSize(128 * 1024 * 16);
+                setRandomTraffic(random);
+                uint64_t cycle = measureCycle(is_write);
+                uint32_t bw = getBandwidth(cycle);
+                pair<uint64_t, uint64_t> commands = getRowCommands();
+                cout << "> " << (random ? "random " : "sequential ")
+                     << (is_write ? "write " : "read ") << policy << " BW (GB/s): " << bw
+                     << " ACT/PRE: " << commands.first << "/" << commands.second << endl;
+                // open rows can outlive the traffic, except under close_page
+                EXPECT_LE(commands.second, commands.first);
+                if (policy == "close_page")
+                {
+                    EXPECT_EQ(commands.first, commands.second);
+                }
+                if (!random)
+                {
+                    EXPECT_TRUE(bw > 256 * effective_bw_ratio);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(MemBandwidthFixture, address_mapping_round_trip)
+{
+    // ADDRESS_MAPPING_SCHEME, ADDRESS_MAPPING, ADDRESS_XOR_HASH
+    vector<vector<string>> mappings;
+    for (int scheme = Scheme1; scheme < SCHEME_MAX; scheme++)
+        mappings.push_back({"Scheme" + to_string(scheme), "", ""});
+    mappings.push_back({"Scheme8", "rank:row:col3:bg:bank:col2:chan", "chan^row,bg^row>>4"});
+    mt19937_64 gen(0);
+
+    for (auto& mapping : mappings)
+    {
+        resetMemory({{"ADDRESS_MAPPING_SCHEME", mapping[0]},
+                     {"ADDRESS_MAPPING", mapping[1]},
+                     {"ADDRESS_XOR_HASH", mapping[2]}});
+        AddrMapping am;
+        unsigned num_cols = getConfigParam(UINT, "NUM_COLS") / getConfigParam(UINT, "BL");
+        for (int i = 0; i < 1024; i++)
+        {
+            unsigned chan = gen() % getConfigParam(UINT, "NUM_CHANS");
+            unsigned rank = gen() % getConfigParam(UINT, "NUM_RANKS");
+            unsigned bank = gen() % getConfigParam(UINT, "NUM_BANKS");
+            unsigned row = gen() % getConfigParam(UINT, "NUM_ROWS");
+            unsigned col = gen() % num_cols;
+            uint64_t addr = am.encode(chan, rank, bank, row, col);
+            unsigned c, r, b, ro, co;
+            am.addressMapping(addr, c, r, b, ro, co);
+            EXPECT_EQ(c, chan);
+            EXPECT_EQ(am.channel(addr), chan);
+            EXPECT_EQ(r, rank);
+            EXPECT_EQ(b, bank);
+            EXPECT_EQ(ro, row);
+            EXPECT_EQ(co, col);
+        }
+    }
+
+    // Scheme8 is the layout the PIM kernels were written for:
+    // |<-rank->|<-row->|<-col high->|<-bg->|<-bank->|<-chan->|<-col low->|<-offset ->|
+    resetMemory({});
+    AddrMapping am;
+    EXPECT_EQ(am.encode(1, 0, 0, 0, 0), 1ull << 5);
+    EXPECT_EQ(am.encode(0, 0, 1, 0, 0), 1ull << 9);
+    EXPECT_EQ(am.encode(0, 0, 4, 0, 0), 1ull << 11);
+    EXPECT_EQ(am.encode(0, 0, 0, 0, 1), 1ull << 13);
+    EXPECT_EQ(am.encode(0, 0, 0, 1, 0), 1ull << 18);
+}
+
+TEST_F(MemBandwidthFixture, hbm_bandwidth_per_address_mapping)
+{
+    // ADDRESS_MAPPING_SCHEME, ADDRESS_MAPPING, ADDRESS_XOR_HASH
+    vector<vector<string>> mappings;
+    for (int scheme = Scheme1; scheme < SCHEME_MAX; scheme++)
+        mappings.push_back({"Scheme" + to_string(scheme), "", ""});
+    mappings.push_back({"Scheme8", "", "chan^row,bank^row>>4"});
+    // stride of one Scheme8 row: every access goes to the next row of the same bank
+    uint64_t row_stride = getConfigParam(UINT, "NUM_CHANS") * getConfigParam(UINT, "NUM_BANKS") *
+                          getConfigParam(UINT, "NUM_COLS") / getConfigParam(UINT, "BL");
+    float effective_bw_ratio = 0.8;
+    uint32_t scheme8_strided_bw = 0;
+
+    for (auto& mapping : mappings)
+    {
+        for (uint64_t stride : {uint64_t(1), row_stride})
+        {
+            resetMemory({{"ADDRESS_MAPPING_SCHEME", mapping[0]},
+                         {"ADDRESS_MAPPING", mapping[1]},
+                         {"ADDRESS_XOR_HASH", mapping[2]}});
+            setDataSize(stride == 1 ? 128 * 1024 * 16 : 128 * 1024);
+            setStride(stride);
+            uint64_t cycle = measureCycle(false);
+            uint32_t bw = getBandwidth(cycle);
+            cout << "> " << AddrMapping().toString() << (stride == 1 ? " sequential" : " strided")
+                 << " read BW (GB/s): " << bw << endl;
+            if (mapping[0] == "Scheme8" && mapping[2].empty())
+            {
+                if (stride == 1)
+                {
+                    EXPECT_TRUE(bw > 256 * effective_bw_ratio);
+                }
+                else
+                {
+                    scheme8_strided_bw = bw;
+                }
+            }
+            // hashing the row into the channel and bank spreads the strided rows out
+            if (!mapping[2].empty() && stride != 1)
+            {
+                EXPECT_TRUE(bw > scheme8_strided_bw);
+                EXPECT_TRUE(bw > 256 * effective_bw_ratio / 2);
+            }
+        }
+    }
+}
+
+TEST_F(MemBandwidthFixture, hbm_mixed_bandwidth_write_drain)
+{
+    // write watermarks high/low, "0" keeps the arrival order
+    vector<pair<string, string>> watermarks = {{"0", "0"}, {"32", "8"}, {"64", "0"}};
+    uint64_t ref_turnarounds = 0;
+    double ref_utilization = 0;
+
+    for (auto& watermark : watermarks)
+    {
+        resetMemory({{"WRITE_HIGH_WATERMARK", watermark.first},
+                     {"WRITE_LOW_WATERMARK", watermark.second}});
+        setDataSize(128 * 1024 * 16);
+        uint64_t cycle = measureMixedCycle(4);
+        uint64_t turnarounds = getTurnarounds();
+        double utilization = getBusUtilization(cycle);
+        cout << "> write watermarks " << watermark.first << "/" << watermark.second
+             << " BW (GB/s): " << getBandwidth(cycle) << " turnarounds: " << turnarounds
+             << " bus utilization: " << utilization << endl;
+
+        if (watermark.first == "0")
+        {
+            ref_turnarounds = turnarounds;
+            ref_utilization = utilization;
+            continue;
+        }
+        EXPECT_GT(utilization, ref_utilization);
+        // the command queue already groups what it holds, only a drain of the whole write
+        // buffer turns the bus around less often than the arrival order
+        if (watermark.second == "0")
+        {
+            EXPECT_LT(turnarounds, ref_turnarounds);
+        }
+    }
+}
+
+TEST_F(basicFixture, checkpoint_restore)
+{
+    string ckpt_file = "checkpoint_test.ckpt";
+    BurstType bst(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+    {
+        auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm.ini", ".", "example_app",
+                                                         256 * 16);
+        Rank* rank = mem->channels[1]->ranks->front();
+        BusPacket packet(DATA, 0, 3, 42, 0, 5, &bst, mem->getLogFile());
+        rank->banks[5].write(&packet);
+        rank->pimRank->pimRegs.grfA(1)[2] = bst;
+        rank->bankStates[5].nextActivate = 1234;
+        EXPECT_TRUE(mem->saveCheckpoint(ckpt_file));
+    }
+
+    auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                     "system_hbm.ini", ".", "example_app",
+                                                     256 * 16);
+    EXPECT_TRUE(mem->loadCheckpoint(ckpt_file));
+    Rank* rank = mem->channels[1]->ranks->front();
+    BurstType read_bst;
+    BusPacket packet(READ, 0, 3, 42, 0, 5, &read_bst, mem->getLogFile());
+    rank->banks[5].read(&packet);
+    EXPECT_EQ(read_bst, bst);
+    EXPECT_EQ(rank->pimRank->pimRegs.grfA(1)[2], bst);
+    EXPECT_EQ(rank->bankStates[5].nextActivate, 1234);
+    remove(ckpt_file.c_str());
+}
+
+TEST_F(basicFixture, checkpoint_restore_continues_run)
+{
+    // the same two phases of traffic once straight through, and once checkpointed between them
+    // and continued in a fresh system
+    const unsigned num_trans = 1024, idle_cycles = 5000;
+    string ckpt_file = "checkpoint_continue_test.ckpt";
+    auto make_mem = []() {
+        return make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                     "system_hbm.ini", ".", "example_app",
+                                                     256 * 16);
+    };
+    auto run_phase = [&](shared_ptr<MultiChannelMemorySystem> mem, unsigned phase,
+                         vector<BurstType>& data, vector<BurstType>& read_back) {
+        const Configuration& config = mem->getConfiguration();
+        uint64_t stride = config.JEDEC_DATA_BUS_BITS * config.BL / 8;
+        mt19937_64 gen(phase);
+        for (unsigned i = 0; i < num_trans; i++)
+        {
+            uint64_t addr = (gen() % (1 << 12)) * stride;
+            data[i].set(static_cast<uint32_t>(phase * num_trans + i + 1));
+            while (!mem->willAcceptTransaction(addr)) mem->update();
+            if (gen() % 2)
+                mem->addTransaction(false, addr, &read_back[i]);
+            else
+                mem->addTransaction(true, addr, &data[i]);
+        }
+        while (mem->hasPendingTransactions()) mem->update();
+        // run on idle so the refresh schedule is somewhere in the middle at the checkpoint
+        for (unsigned i = 0; i < idle_cycles; i++) mem->update();
+    };
+    auto get_stats = [](shared_ptr<MultiChannelMemorySystem> mem) {
+        vector<uint64_t> stats;
+        for (auto chan : mem->channels)
+        {
+            MemoryController* mc = chan->memoryController;
+            stats.push_back(chan->currentClockCycle);
+            stats.push_back(mc->totalReads);
+            stats.push_back(mc->totalWrites);
+            stats.push_back(mc->totalActivates);
+            stats.push_back(mc->totalPrecharges);
+            stats.insert(stats.end(), mc->backgroundEnergy.begin(), mc->backgroundEnergy.end());
+            stats.insert(stats.end(), mc->burstEnergy.begin(), mc->burstEnergy.end());
+            stats.insert(stats.end(), mc->actpreEnergy.begin(), mc->actpreEnergy.end());
+            stats.insert(stats.end(), mc->refreshEnergy.begin(), mc->refreshEnergy.end());
+        }
+        return stats;
+    };
+    // a drained system saved to a checkpoint holds its bank contents, registers and stats
+    auto get_state = [&](shared_ptr<MultiChannelMemorySystem> mem) {
+        EXPECT_TRUE(mem->saveCheckpoint(ckpt_file));
+        ifstream in(ckpt_file.c_str(), ios::in | ios::binary);
+        return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    };
+
+    vector<BurstType> data[2][2], read_back[2][2];
+    for (auto& run : data)
+        for (auto& phase : run) phase.resize(num_trans);
+    for (auto& run : read_back)
+        for (auto& phase : run) phase.resize(num_trans);
+
+    auto straight = make_mem();
+    run_phase(straight, 0, data[0][0], read_back[0][0]);
+    run_phase(straight, 1, data[0][1], read_back[0][1]);
+
+    {
+        auto first_half = make_mem();
+        run_phase(first_half, 0, data[1][0], read_back[1][0]);
+        EXPECT_TRUE(first_half->saveCheckpoint(ckpt_file));
+    }
+    auto resumed = make_mem();
+    EXPECT_TRUE(resumed->loadCheckpoint(ckpt_file));
+    run_phase(resumed, 1, data[1][1], read_back[1][1]);
+
+    EXPECT_EQ(resumed->channels[0]->currentClockCycle, straight->channels[0]->currentClockCycle);
+    EXPECT_EQ(get_stats(resumed), get_stats(straight));
+    EXPECT_TRUE(read_back[1][0] == read_back[0][0]);
+    EXPECT_TRUE(read_back[1][1] == read_back[0][1]);
+    EXPECT_TRUE(get_state(resumed) == get_state(straight));
+    remove(ckpt_file.c_str());
+}
+
+TEST_F(basicFixture, channel_thread_scaling)
+{
+    const uint64_t num_trans = 64 * 1024;
+    uint64_t ref_cycle = 0;
+    vector<uint64_t> ref_stats;
+    vector<BurstType> data(num_trans), ref_read_back;
+    for (uint64_t i = 0; i < num_trans; i++) data[i].set(static_cast<uint32_t>(i + 1));
+
+    cout << ">> Channel thread scaling (16ch, " << num_trans << " transactions)" << endl;
+    for (unsigned num_threads : {1, 2, 4, 8})
+    {
+        auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm.ini", ".", "example_app",
+                                                         256 * 16);
+        mem->setNumSimThreads(num_threads);
+        uint64_t stride = getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") * getConfigParam(UINT, "BL") / 8;
+        // every third transaction reads back the burst written two transactions before
+        vector<BurstType> read_back(num_trans);
+        for (uint64_t i = 0; i < num_trans; i++)
+        {
+            if (i % 3 == 2)
+                mem->addTransaction(false, (i - 2) * stride, &read_back[i]);
+            else
+                mem->addTransaction(true, i * stride, &data[i]);
+        }
+
+        auto start = chrono::steady_clock::now();
+        uint64_t cycle = 0;
+        while (mem->hasPendingTransactions())
+        {
+            mem->update();
+            cycle++;
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        vector<uint64_t> stats;
+        for (auto chan : mem->channels)
+        {
+            stats.push_back(chan->memoryController->totalReads);
+            stats.push_back(chan->memoryController->totalWrites);
+        }
+        cout << "  threads: " << num_threads << " cycles: " << cycle
+             << " wall (s): " << elapsed.count() << endl;
+
+        if (num_threads == 1)
+        {
+            ref_cycle = cycle;
+            ref_stats = stats;
+            ref_read_back = read_back;
+            for (uint64_t i = 2; i < num_trans; i += 3) EXPECT_EQ(read_back[i], data[i - 2]);
+        }
+        EXPECT_EQ(cycle, ref_cycle);
+        EXPECT_EQ(stats, ref_stats);
+        EXPECT_TRUE(read_back == ref_read_back);
+    }
+}
+
+TEST_F(basicFixture, idle_fast_forward)
+{
+    // sparse row-missing writes leave the channels waiting on tRP/tRCD/tWR and refresh
+    const unsigned num_rounds = 256;
+    vector<uint64_t> ref_stats;
+    uint64_t ref_cycle = 0;
+    BurstType bst(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+
+    for (bool skip_idle : {false, true})
+    {
+        auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm.ini", ".", "example_app",
+                                                         256 * 16);
+        uint64_t cycle = 0;
+        uint64_t skipped = 0;
+        for (unsigned i = 0; i < num_rounds; i++)
+        {
+            mem->addTransaction(true, (uint64_t)i * 0x12345 * 32, &bst);
+            while (mem->hasPendingTransactions())
+            {
+                mem->update();
+                cycle++;
+                if (skip_idle)
+                    skipped += mem->skipIdleCycles();
+            }
+        }
+        cycle += skipped;
+
+        vector<uint64_t> stats;
+        for (auto chan : mem->channels)
+        {
+            MemoryController* mc = chan->memoryController;
+            stats.push_back(chan->currentClockCycle);
+            stats.push_back(mc->totalWrites);
+            stats.insert(stats.end(), mc->burstEnergy.begin(), mc->burstEnergy.end());
+            stats.insert(stats.end(), mc->actpreEnergy.begin(), mc->actpreEnergy.end());
+            stats.insert(stats.end(), mc->refreshEnergy.begin(), mc->refreshEnergy.end());
+        }
+        cout << "  skip idle: " << skip_idle << " cycles: " << cycle << " skipped: " << skipped
+             << endl;
+
+        if (!skip_idle)
+        {
+            ref_cycle = cycle;
+            ref_stats = stats;
+        }
+        else
+        {
+            EXPECT_GT(skipped, 0);
+        }
+        EXPECT_EQ(cycle, ref_cycle);
+        EXPECT_EQ(stats, ref_stats);
+    }
+}
+
+TEST_F(basicFixture, idle_fast_forward_mixed_traffic)
+{
+    // rounds of up to 32 random reads and writes in flight at once, spread over all channels
+    const unsigned num_rounds = 128;
+    vector<uint64_t> ref_stats;
+    vector<BurstType> ref_read_back;
+    uint64_t ref_cycle = 0;
+
+    for (bool skip_idle : {false, true})
+    {
+        auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm.ini", ".", "example_app",
+                                                         256 * 16);
+        const Configuration& config = mem->getConfiguration();
+        uint64_t stride = config.JEDEC_DATA_BUS_BITS * config.BL / 8;
+        mt19937_64 gen(17);
+        vector<BurstType> data(num_rounds * 32), read_back(num_rounds * 32);
+        uint64_t cycle = 0;
+        uint64_t skipped = 0;
+        for (unsigned i = 0; i < num_rounds; i++)
+        {
+            unsigned num_trans = 1 + gen() % 32;
+            for (unsigned j = 0; j < num_trans; j++)
+            {
+                unsigned idx = i * 32 + j;
+                uint64_t addr = (gen() % (1 << 16)) * stride;
+                data[idx].set(static_cast<uint32_t>(idx));
+                if (gen() % 2)
+                    mem->addTransaction(false, addr, &read_back[idx]);
+                else
+                    mem->addTransaction(true, addr, &data[idx]);
+            }
+            while (mem->hasPendingTransactions())
+            {
+                mem->update();
+                cycle++;
+                if (skip_idle)
+                    skipped += mem->skipIdleCycles();
+            }
+        }
+        cycle += skipped;
+
+        vector<uint64_t> stats;
+        for (auto chan : mem->channels)
+        {
+            MemoryController* mc = chan->memoryController;
+            stats.push_back(chan->currentClockCycle);
+            stats.push_back(mc->totalReads);
+            stats.push_back(mc->totalWrites);
+            stats.insert(stats.end(), mc->burstEnergy.begin(), mc->burstEnergy.end());
+            stats.insert(stats.end(), mc->actpreEnergy.begin(), mc->actpreEnergy.end());
+            stats.insert(stats.end(), mc->refreshEnergy.begin(), mc->refreshEnergy.end());
+        }
+        cout << "  skip idle: " << skip_idle << " cycles: " << cycle << " skipped: " << skipped
+             << endl;
+
+        if (!skip_idle)
+        {
+            ref_cycle = cycle;
+            ref_stats = stats;
+            ref_read_back = read_back;
+        }
+        else
+        {
+            EXPECT_GT(skipped, 0);
+        }
+        EXPECT_EQ(cycle, ref_cycle);
+        EXPECT_EQ(stats, ref_stats);
+        EXPECT_TRUE(read_back == ref_read_back);
+    }
+}
+
+TEST_F(basicFixture, cmd_queue_bank_index_benchmark)
+{
+    // random bursts on one channel keep the 64-deep queue full of requests to all 16 banks
+    const uint64_t num_trans = 32 * 1024;
+    vector<uint64_t> ref_stats;
+    uint64_t ref_cycle = 0;
+    BurstType bst(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+
+    cout << ">> Command queue bank index (CMD_QUEUE_DEPTH=64, 16 banks, " << num_trans
+         << " random transactions)" << endl;
+    for (string use_index : {"false", "true"})
+    {
+        vector<pair<string, string>> overrides = {{"CMD_QUEUE_DEPTH", "64"},
+                                                  {"CMD_QUEUE_BANK_INDEX", use_index}};
+        auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm_1ch.ini", ".", "example_app",
+                                                         256, nullptr, false, &overrides);
+        const Configuration& config = mem->getConfiguration();
+        uint64_t stride = config.JEDEC_DATA_BUS_BITS * config.BL / 8;
+        mt19937_64 gen(5);
+        for (uint64_t i = 0; i < num_trans; i++)
+        {
+            mem->addTransaction(false, (gen() % (1 << 20)) * stride, &bst);
+        }
+
+        auto start = chrono::steady_clock::now();
+        uint64_t cycle = 0;
+        while (mem->hasPendingTransactions())
+        {
+            mem->update();
+            cycle++;
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+        MemoryController* mem_ctrl = mem->channels[0]->memoryController;
+        vector<uint64_t> stats = {mem_ctrl->totalReads, mem_ctrl->totalWrites};
+        cout << "  index: " << use_index << " cycles: " << cycle
+             << " ns/cycle: " << elapsed.count() * 1e9 / cycle << endl;
+
+        // the timings are informational only, a loaded host can reorder them
+        if (use_index == "false")
+        {
+            ref_cycle = cycle;
+            ref_stats = stats;
+        }
+        // the index only skips banks that cannot issue, the schedule stays the same
+        EXPECT_EQ(cycle, ref_cycle);
+        EXPECT_EQ(stats, ref_stats);
+    }
+}
+
+TEST_F(basicFixture, bank_storage_sparse_pages)
+{
+    const unsigned num_rows = 16384, num_cols = 32;
+    BankStorage storage(num_rows, num_cols);
+    BurstType a(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+    BurstType b(-1.0f, -2.0f, -3.0f, -4.0f, -5.0f, -6.0f, -7.0f, -8.0f);
+    BurstType untouched(9.0f, 9.0f, 9.0f, 9.0f, 9.0f, 9.0f, 9.0f, 9.0f);
+
+    // an unwritten burst reads as a miss and leaves the destination alone
+    BurstType bst = untouched;
+    EXPECT_FALSE(storage.read(0, 0, &bst));
+    EXPECT_TRUE(bst == untouched);
+    EXPECT_EQ(storage.getNumPages(), 0);
+
+    // sparse writes only allocate the pages they touch
+    storage.write(0, 0, a);
+    storage.write(BankStorage::ROWS_PER_PAGE - 1, num_cols - 1, b);
+    storage.write(num_rows - 1, 7, b);
+    EXPECT_EQ(storage.getNumPages(), 2);
+    EXPECT_TRUE(storage.read(0, 0, &bst) && bst == a);
+    EXPECT_TRUE(storage.read(BankStorage::ROWS_PER_PAGE - 1, num_cols - 1, &bst) && bst == b);
+    EXPECT_TRUE(storage.read(num_rows - 1, 7, &bst) && bst == b);
+
+    // neighbours of a written burst in the same page are still unwritten
+    bst = untouched;
+    EXPECT_FALSE(storage.read(0, 1, &bst));
+    EXPECT_FALSE(storage.read(1, 0, &bst));
+    EXPECT_FALSE(storage.read(num_rows - 2, 7, &bst));
+    EXPECT_TRUE(bst == untouched);
+
+    // an overwrite replaces the burst in place
+    storage.write(0, 0, b);
+    EXPECT_TRUE(storage.read(0, 0, &bst) && bst == b);
+    EXPECT_EQ(storage.getNumPages(), 2);
+
+    // copies are deep
+    BankStorage copy(storage);
+    copy.write(0, 0, a);
+    EXPECT_TRUE(storage.read(0, 0, &bst) && bst == b);
+    EXPECT_TRUE(copy.read(0, 0, &bst) && bst == a);
+
+    // a column past the row misses instead of reading the next row or past the last one
+    EXPECT_FALSE(storage.read(BankStorage::ROWS_PER_PAGE - 2, num_cols, &bst));
+    EXPECT_FALSE(storage.read(num_rows - 1, num_cols, &bst));
+    vector<uint8_t> mapping(BankStorage::getMappedBytes(num_rows, num_cols));
+    BankStorage mapped(num_rows, num_cols);
+    mapped.attachMapping(mapping.data());
+    mapped.write(1, 0, a);
+    EXPECT_TRUE(mapped.read(1, 0, &bst) && bst == a);
+    EXPECT_FALSE(mapped.read(0, num_cols, &bst));
+    EXPECT_FALSE(mapped.read(num_rows - 1, num_cols, &bst));
+}
+
+TEST_F(basicFixture, bank_storage_file_warm_reuse)
+{
+    const int num_bursts = 64;
+    const string path = "bank_storage_warm_test";
+    vector<pair<string, string>> overrides = {{"BANK_STORAGE", "mmap"},
+                                              {"BANK_STORAGE_PATH", path}};
+    NumpyBurstType input;
+    input.bShape = {num_bursts};
+    input.bData.resize(num_bursts);
+    for (uint32_t i = 0; i < num_bursts; i++) input.bData[i].set(i * 0x10001 + 1);
+
+    auto make_mem = [&]() {
+        return make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                     "system_hbm_1ch.ini", ".", "example_app",
+                                                     256, nullptr, false, &overrides);
+    };
+    auto expect_input = [&](shared_ptr<PIMKernel> kernel) {
+        vector<BurstType> result(num_bursts);
+        kernel->readData(result.data(), num_bursts, 0, 0);
+        kernel->runPIM();
+        for (int i = 0; i < num_bursts; i++) EXPECT_EQ(result[i], input.bData[i]);
+    };
+
+    // cold: nothing to reuse, preload and mark it once the writes were simulated
+    {
+        auto mem = make_mem();
+        auto kernel = make_shared<PIMKernel>(mem, 1, 1);
+        EXPECT_FALSE(kernel->isPreloaded("input"));
+        kernel->preloadNoReplacement(&input, 0, 0);
+        kernel->runPIM();
+        kernel->markPreloaded("input");
+        EXPECT_TRUE(kernel->isPreloaded("input"));
+    }
+
+    // warm: the preload is skipped and the bursts come back from the file
+    {
+        auto mem = make_mem();
+        auto kernel = make_shared<PIMKernel>(mem, 1, 1);
+        EXPECT_TRUE(kernel->isPreloaded("input"));
+        EXPECT_FALSE(kernel->isPreloaded("other"));
+        expect_input(kernel);
+    }
+
+    // reopening cleared the completion flag, the contents are kept but no longer vouched for
+    {
+        auto mem = make_mem();
+        auto kernel = make_shared<PIMKernel>(mem, 1, 1);
+        EXPECT_FALSE(kernel->isPreloaded("input"));
+        expect_input(kernel);
+    }
+
+    EXPECT_THROW(make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                       "system_hbm_1ch.ini", ".", "example_app",
+                                                       256, nullptr, true, &overrides),
+                 invalid_argument);
+
+    for (int ra = 0; ra < 4; ra++) remove((path + "/bank_ch0_ra" + to_string(ra) + ".bin").c_str());
+    remove(path.c_str());
+}
+
+TEST_F(basicFixture, object_pool_reuse)
+{
+    ofstream null_log;
+    PoolStats before = ObjectPool<BusPacket>::getStats();
+    for (int i = 0; i < 100000; i++)
+    {
+        BusPacket* packet = new BusPacket(ACTIVATE, i, 0, i, 0, 0, nullptr, null_log);
+        delete packet;
+    }
+    vector<BusPacket*> packets;
+    for (int i = 0; i < 10000; i++)
+        packets.push_back(new BusPacket(PRECHARGE, i, 0, i, 0, 0, nullptr, null_log));
+    for (auto packet : packets) delete packet;
+    PoolStats after = ObjectPool<BusPacket>::getStats();
+
+    EXPECT_EQ(after.allocations - before.allocations, 110000);
+    EXPECT_EQ(after.frees - before.frees, 110000);
+    // freed packets are handed out again instead of growing the pool
+    EXPECT_LE((after.chunks - before.chunks) * after.objectsPerChunk, 16384);
+}
+
+TEST_F(basicFixture, ready_queue_microbenchmark)
+{
+    // keeps "occupancy" entries in flight, each due "latency" cycles after it was queued
+    const unsigned occupancy = 256;
+    const unsigned latency = occupancy;
+    const uint64_t num_cycles = 1000000;
+
+    auto start = chrono::steady_clock::now();
+    vector<unsigned> countdown_items, countdowns;
+    uint64_t countdown_sum = 0;
+    for (uint64_t cycle = 0; cycle < num_cycles; cycle++)
+    {
+        for (size_t i = 0; i < countdowns.size(); i++) countdowns[i]--;
+        if (!countdowns.empty() && countdowns[0] == 0)
+        {
+            countdown_sum += countdown_items[0] * cycle;
+            countdown_items.erase(countdown_items.begin());
+            countdowns.erase(countdowns.begin());
+        }
+        countdown_items.push_back(cycle);
+        countdowns.push_back(latency);
+    }
+    chrono::duration<double> countdown_time = chrono::steady_clock::now() - start;
+
+    start = chrono::steady_clock::now();
+    ReadyQueue<unsigned> queue;
+    uint64_t queue_sum = 0;
+    for (uint64_t cycle = 0; cycle < num_cycles; cycle++)
+    {
+        if (queue.isReady(cycle))
+        {
+            queue_sum += queue.front() * cycle;
+            queue.pop();
+        }
+        queue.push(cycle + latency, cycle);
+    }
+    chrono::duration<double> queue_time = chrono::steady_clock::now() - start;
+
+    cout << ">> Ready queue (" << occupancy << " in flight, " << num_cycles << " cycles)" << endl;
+    cout << "  countdown vector wall (s): " << countdown_time.count() << endl;
+    cout << "  ready queue wall (s): " << queue_time.count() << endl;
+
+    // the timings are informational only, a loaded host can reorder them
+    EXPECT_EQ(queue_sum, countdown_sum);
+    EXPECT_EQ(queue.size(), countdowns.size());
+}
+
+TEST_F(basicFixture, pending_read_matching)
+{
+    PendingReadTable table;
+    vector<Transaction*> reads;
+    for (unsigned i = 0; i < 4; i++)
+    {
+        // two reads to each address
+        reads.push_back(new Transaction(DATA_READ, (i % 2) * 0x40, nullptr));
+        table.insert(reads.back(), 0, i, 0);
+    }
+    EXPECT_EQ(table.size(), 4);
+
+    PendingReadTable::Entry entry;
+    EXPECT_FALSE(table.take(0x80, entry));
+    // reads to the same address come back in issue order
+    for (unsigned i : {0, 2, 1, 3})
+    {
+        ASSERT_TRUE(table.take(reads[i]->address, entry));
+        EXPECT_EQ(entry.trans, reads[i]);
+        EXPECT_EQ(entry.bank, i);
+    }
+    EXPECT_TRUE(table.empty());
+    EXPECT_FALSE(table.take(0x0, entry));
+    for (auto read : reads) delete read;
+}
+
+TEST_F(basicFixture, pending_read_round_trip)
+{
+    // repeated reads of a few addresses with writes in between, through the whole controller
+    const unsigned num_addrs = 4, num_rounds = 16;
+    auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                     "system_hbm_1ch.ini", ".", "example_app",
+                                                     256);
+    const Configuration& config = mem->getConfiguration();
+    uint64_t stride = config.JEDEC_DATA_BUS_BITS * config.BL / 8;
+    vector<BurstType> data(num_addrs * num_rounds), read_back(2 * num_addrs * num_rounds);
+
+    for (unsigned r = 0; r < num_rounds; r++)
+    {
+        for (unsigned a = 0; a < num_addrs; a++)
+        {
+            unsigned idx = r * num_addrs + a;
+            data[idx].set(static_cast<uint32_t>(idx + 1));
+            mem->addTransaction(true, a * stride, &data[idx]);
+            // two reads in flight for the same address
+            mem->addTransaction(false, a * stride, &read_back[2 * idx]);
+            mem->addTransaction(false, a * stride, &read_back[2 * idx + 1]);
+        }
+        while (mem->hasPendingTransactions()) mem->update();
+    }
+
+    for (unsigned idx = 0; idx < num_addrs * num_rounds; idx++)
+    {
+        EXPECT_EQ(read_back[2 * idx], data[idx]);
+        EXPECT_EQ(read_back[2 * idx + 1], data[idx]);
+    }
+    EXPECT_EQ(mem->channels[0]->memoryController->totalReads, 2 * num_addrs * num_rounds);
+}
+
+TEST_F(basicFixture, write_drain_keeps_same_address_order)
+{
+    // a two-deep command queue fills up while one type is held back, a request behind the
+    // blocked one must not pass an older held request to the same address
+    vector<pair<string, string>> overrides = {{"CMD_QUEUE_DEPTH", "2"},
+                                              {"WRITE_HIGH_WATERMARK", "8"},
+                                              {"WRITE_LOW_WATERMARK", "2"}};
+    auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                     "system_hbm_1ch.ini", ".", "example_app",
+                                                     256, nullptr, false, &overrides);
+    const Configuration& config = mem->getConfiguration();
+    uint64_t stride = config.JEDEC_DATA_BUS_BITS * config.BL / 8;
+    const unsigned num_addrs = 16, num_requests = 4096;
+    mt19937 gen(3);
+    vector<uint64_t> addrs(num_addrs);
+    for (auto& addr : addrs) addr = (gen() % 1024) * stride;
+
+    // every address is written first, so each read has a write to expect
+    vector<BurstType> data(num_addrs + num_requests), read_back(num_requests + num_addrs);
+    vector<int> last_write(num_addrs), expected(num_requests + num_addrs, -1);
+    for (unsigned i = 0; i < num_addrs + num_requests; i++)
+    {
+        unsigned a = (i < num_addrs) ? i : gen() % num_addrs;
+        data[i].set(static_cast<uint32_t>(i + 1));
+        while (!mem->willAcceptTransaction()) mem->update();
+        if (i < num_addrs || gen() % 2)
+        {
+            mem->addTransaction(true, addrs[a], &data[i]);
+            last_write[a] = i;
+        }
+        else
+        {
+            mem->addTransaction(false, addrs[a], &read_back[i - num_addrs]);
+            expected[i - num_addrs] = last_write[a];
+        }
+    }
+    while (mem->hasPendingTransactions()) mem->update();
+    EXPECT_GT(mem->channels[0]->memoryController->totalWriteDrains, 0);
+
+    // and the last write to each address is the one left in the bank
+    for (unsigned a = 0; a < num_addrs; a++)
+    {
+        mem->addTransaction(false, addrs[a], &read_back[num_requests + a]);
+        expected[num_requests + a] = last_write[a];
+    }
+    while (mem->hasPendingTransactions()) mem->update();
+
+    for (unsigned i = 0; i < num_requests + num_addrs; i++)
+    {
+        if (expected[i] >= 0)
+        {
+            EXPECT_EQ(read_back[i], data[expected[i]]) << "request " << i;
+        }
+    }
+}
+
+TEST_F(basicFixture, no_config_lookup_while_simulating)
+{
+    BurstType bst(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+    // poison: overwrite every numeric ConfigurationDB parameter once the system is built, a
+    // simulation that still reads the DB would then time differently or return other data
+    auto run = [&](bool poison, vector<BurstType>& read_back) {
+        auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm.ini", ".", "example_app",
+                                                         256 * 16);
+        const Configuration& config = mem->getConfiguration();
+        uint64_t stride = config.JEDEC_DATA_BUS_BITS * config.BL / 8;
+        if (poison)
+        {
+            for (unsigned i = 0; !defaultConfiguration[i].name.empty(); i++)
+            {
+                const ConfigurationData& param = defaultConfiguration[i];
+                if (param.variableType == UINT)
+                    setUINTConfig(param.name, getUINTConfig(param.name) * 3 + 1,
+                                  param.parameterType);
+                else if (param.variableType == UINT64)
+                    setUINT64Config(param.name, getUINT64Config(param.name) * 3 + 1,
+                                    param.parameterType);
+            }
+        }
+
+#ifdef CONFIG_LOOKUP_COUNT
+        ConfigurationDB& configDB = ConfigurationDB::getDB();
+        uint64_t lookups = configDB.getNumLookups();
+#endif
+        // scattered over many rows so activates, precharges and refreshes all come up
+        for (uint64_t i = 0; i < 4096; i++)
+        {
+            uint64_t addr = (i * 2654435761ULL % (1 << 18)) * stride;
+            mem->addTransaction(true, addr, &bst);
+            mem->addTransaction(false, addr, &read_back[i]);
+        }
+        while (mem->hasPendingTransactions())
+        {
+            mem->update();
+            mem->skipIdleCycles();
+        }
+#ifdef CONFIG_LOOKUP_COUNT
+        EXPECT_EQ(configDB.getNumLookups(), lookups);
+#endif
+        return mem->channels[0]->currentClockCycle;
+    };
+
+    vector<BurstType> read_back(4096), poisoned_read_back(4096);
+    uint64_t cycles = run(false, read_back);
+    EXPECT_EQ(run(true, poisoned_read_back), cycles);
+    for (unsigned i = 0; i < 4096; i++)
+    {
+        EXPECT_EQ(read_back[i], bst) << "request " << i;
+        EXPECT_EQ(poisoned_read_back[i], bst) << "request " << i;
+    }
+}
+
+TEST_F(basicFixture, cmd_trace_decode)
+{
+    const string path = "cmd_trace_test.ch3";
+    ofstream null_log;
+    PIMCmd cmd(PIMCmdType::EXIT, 0);
+
+    CmdTraceSink sink;
+    sink.open(path, null_log);
+    ASSERT_TRUE(sink.isEnabled());
+    sink.record(TRACE_ACTIVATE, 42, 3, 0, 1, 5, 100, 2, sink.internTag("BAR"));
+    sink.record(TRACE_PRECHARGE, 43, 3, 0, 1, 5, 100, 0);
+    sink.record(TRACE_REF, 44, 3, 0, 0, 0, 0, 0);
+    sink.record(TRACE_BWRITE_GRF_B, 45, 3, 0, 0, 0, 0, 0x1a);
+    // enough records to go through the buffer more than once
+    for (unsigned i = 0; i < 5000; i++) sink.record(TRACE_WRITE, 46 + i, 3, 0, 1, 5, 100, i);
+    sink.record(TRACE_PIM_READ, 6000, 3, 0, 1, 5, 100, 2, cmd.toInt(), 7);
+    EXPECT_EQ(sink.getNumRecords(), 5005);
+    sink.close();
+
+    stringstream decoded;
+    ASSERT_TRUE(decodeCmdTrace(path, decoded));
+    remove(path.c_str());
+
+    vector<string> lines;
+    for (string line; getline(decoded, line);) lines.push_back(line);
+    ASSERT_EQ(lines.size(), 5005);
+    EXPECT_EQ(lines[0], "ACTIVATE ch3 ra0 bg1 b5 r100 c2 @42 tag : BAR");
+    EXPECT_EQ(lines[1], "PRECHARGE ch3 ra0 bg1 b5 r100 @43");
+    EXPECT_EQ(lines[2], "REF ch3 ra0 @44");
+    EXPECT_EQ(lines[3], "BWRITE_GRF_B ch3 ra0 reg2 @45");
+    EXPECT_EQ(lines[5003], "WRITE ch3 ra0 bg1 b5 r100 c4999 @5045");
+    EXPECT_EQ(lines[5004], "READ ch3 ra0 bg1 b5 r100 c2|| [7] " + cmd.toStr() + " @ 6000");
+}
+
+TEST_F(basicFixture, crf_micro_op_cache)
+{
+    auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                     "system_hbm.ini", ".", "example_app",
+                                                     256 * 16);
+    PIMRank* pimRank = mem->channels[0]->ranks->front()->pimRank;
+    BurstType crf_bst, ctrl_bst, bank_bst;
+    ctrl_bst.u8Data_[0] = 1;  // enter HAB_PIM, resets pc
+    BusPacket crf_packet(WRITE, 0, 0x04, 0x3fff, 0, 0, &crf_bst, mem->getLogFile());
+    BusPacket ctrl_packet(WRITE, 0, 0x00, 0x3fff, 0, 0, &ctrl_bst, mem->getLogFile());
+    BusPacket read_packet(READ, 0, 0, 0, 0, 0, &bank_bst, mem->getLogFile());
+
+    // NOP x2, NOP, JUMP back to the second NOP once, EXIT
+    crf_bst.u32Data_[0] = PIMCmd(PIMCmdType::NOP, 1).toInt();
+    crf_bst.u32Data_[1] = PIMCmd(PIMCmdType::NOP, 0).toInt();
+    crf_bst.u32Data_[2] = PIMCmd(PIMCmdType::JUMP, 1, 2).toInt();
+    crf_bst.u32Data_[3] = PIMCmd(PIMCmdType::EXIT, 0).toInt();
+    pimRank->writeHab(&crf_packet);
+    pimRank->writeHab(&ctrl_packet);
+
+    const int expected_pc[] = {0, 1, 2, 2, 3};
+    for (int i = 0; i < 5; i++)
+    {
+        EXPECT_FALSE(pimRank->isCrfExit());
+        pimRank->doPIM(&read_packet);
+        EXPECT_EQ(pimRank->getPimPC(), expected_pc[i]);
+    }
+    EXPECT_TRUE(pimRank->isCrfExit());
+
+    // rewriting the CRF must invalidate the decoded program
+    crf_bst.u32Data_[0] = PIMCmd(PIMCmdType::EXIT, 0).toInt();
+    pimRank->writeHab(&crf_packet);
+    pimRank->writeHab(&ctrl_packet);
+    EXPECT_FALSE(pimRank->isCrfExit());
+    pimRank->doPIM(&read_packet);
+    EXPECT_TRUE(pimRank->isCrfExit());
+    EXPECT_EQ(pimRank->getPimPC(), 0);
+}
+
+TEST_F(basicFixture, fp16_simd_equivalence)
+{
+    const FP16BurstKernels& scalar = *getFP16BurstKernels(FP16_ISA_SCALAR);
+    mt19937 gen(12345);
+    uniform_int_distribution<int> bits(0, 0xffff);
+    const int num_bursts = 200000;
+
+    for (int isa = FP16_ISA_SCALAR + 1; isa < FP16_ISA_MAX; isa++)
+    {
+        const FP16BurstKernels* simd = getFP16BurstKernels(static_cast<FP16KernelIsa>(isa));
+        if (simd == nullptr)
+            continue;
+
+        // random bit patterns cover subnormals, infinities and NaNs as well as normal values
+        for (int n = 0; n < num_bursts / 8; n++)
+        {
+            BurstType src0[8], src1[8], src2[8], expected[8], actual[8];
+            for (int b = 0; b < 8; b++)
+            {
+                for (int i = 0; i < 16; i++)
+                {
+                    src0[b].u16Data_[i] = bits(gen);
+                    src1[b].u16Data_[i] = bits(gen);
+                    src2[b].u16Data_[i] = bits(gen);
+                }
+            }
+            scalar.add(expected->fp16Data_, src0->fp16Data_, src1->fp16Data_, 8);
+            simd->add(actual->fp16Data_, src0->fp16Data_, src1->fp16Data_, 8);
+            ASSERT_EQ(memcmp(expected, actual, sizeof(expected)), 0) << simd->name << " add";
+
+            scalar.mul(expected->fp16Data_, src0->fp16Data_, src1->fp16Data_, 8);
+            simd->mul(actual->fp16Data_, src0->fp16Data_, src1->fp16Data_, 8);
+            ASSERT_EQ(memcmp(expected, actual, sizeof(expected)), 0) << simd->name << " mul";
+
+            scalar.mad(expected->fp16Data_, src0->fp16Data_, src1->fp16Data_, src2->fp16Data_, 8);
+            simd->mad(actual->fp16Data_, src0->fp16Data_, src1->fp16Data_, src2->fp16Data_, 8);
+            ASSERT_EQ(memcmp(expected, actual, sizeof(expected)), 0) << simd->name << " mad";
+
+            // in-place accumulate, as PIMBlock::mac does
+            copy_n(src2, 8, expected);
+            copy_n(src2, 8, actual);
+            scalar.mad(expected->fp16Data_, src0->fp16Data_, src1->fp16Data_, expected->fp16Data_,
+                       8);
+            simd->mad(actual->fp16Data_, src0->fp16Data_, src1->fp16Data_, actual->fp16Data_, 8);
+            ASSERT_EQ(memcmp(expected, actual, sizeof(expected)), 0) << simd->name << " mac";
+        }
+    }
+
+    // BF16 kernels against the scalar ones and the FP32 reference rounded once
+    const BF16BurstKernels& bf16_scalar = *getBF16BurstKernels(FP16_ISA_SCALAR);
+    for (int isa = FP16_ISA_SCALAR; isa < FP16_ISA_MAX; isa++)
+    {
+        const BF16BurstKernels* k = getBF16BurstKernels(static_cast<FP16KernelIsa>(isa));
+        if (k == nullptr)
+            continue;
+        for (int n = 0; n < num_bursts / 8; n++)
+        {
+            BurstType src0[8], src1[8], src2[8], expected[8], actual[8];
+            for (int b = 0; b < 8; b++)
+            {
+                for (int i = 0; i < 16; i++)
+                {
+                    src0[b].u16Data_[i] = bits(gen);
+                    src1[b].u16Data_[i] = bits(gen);
+                    src2[b].u16Data_[i] = bits(gen);
+                    float sum =
+                        convertBF2F(src0[b].u16Data_[i]) + convertBF2F(src1[b].u16Data_[i]);
+                    expected[b].u16Data_[i] = convertF2BF(sum);
+                }
+            }
+            k->add(actual->u16Data_, src0->u16Data_, src1->u16Data_, 8);
+            ASSERT_EQ(memcmp(expected, actual, sizeof(expected)), 0) << k->name << " bf16 add";
+
+            bf16_scalar.mul(expected->u16Data_, src0->u16Data_, src1->u16Data_, 8);
+            k->mul(actual->u16Data_, src0->u16Data_, src1->u16Data_, 8);
+            ASSERT_EQ(memcmp(expected, actual, sizeof(expected)), 0) << k->name << " bf16 mul";
+
+            bf16_scalar.mad(expected->u16Data_, src0->u16Data_, src1->u16Data_, src2->u16Data_, 8);
+            copy_n(src2, 8, actual);
+            k->mad(actual->u16Data_, src0->u16Data_, src1->u16Data_, actual->u16Data_, 8);
+            ASSERT_EQ(memcmp(expected, actual, sizeof(expected)), 0) << k->name << " bf16 mac";
+        }
+    }
+
+    // throughput of every supported variant on small, NaN-free operands
+    BurstType a, b, acc;
+    for (int i = 0; i < 16; i++)
+    {
+        a.fp16Data_[i] = convertF2H(0.001f * i);
+        b.fp16Data_[i] = convertF2H(0.5f - 0.01f * i);
+    }
+    for (int isa = FP16_ISA_SCALAR; isa < FP16_ISA_MAX; isa++)
+    {
+        const FP16BurstKernels* k = getFP16BurstKernels(static_cast<FP16KernelIsa>(isa));
+        if (k == nullptr)
+            continue;
+        acc = BurstType();
+        auto start = chrono::steady_clock::now();
+        for (int n = 0; n < 1000000; n++)
+            k->mad(acc.fp16Data_, a.fp16Data_, b.fp16Data_, acc.fp16Data_, 1);
+        chrono::duration<double> wall = chrono::steady_clock::now() - start;
+        cout << "  fp16 " << k->name << ": " << wall.count() * 1000 << " ns/mac-burst"
+             << (k == &getFP16BurstKernels() ? " (selected)" : "") << endl;
+    }
+}
+
+TEST_F(basicFixture, pim_int_alu)
+{
+    mt19937 gen(4321);
+    for (PIMPrecision precision : {INT8, INT4})
+    {
+        const int lanes = getIntLanes(precision);
+        const int max = (precision == INT8) ? 127 : 7;
+        uniform_int_distribution<int> dis(-max - 1, max);
+        PIMBlock alu(precision);
+        SBlock sblock(precision);
+
+        BurstType a[2], b[2], acc[2], sum[2], prod[2], mac[2], sb_mac;
+        for (int pb = 0; pb < 2; pb++)
+        {
+            for (int i = 0; i < lanes; i++)
+            {
+                setIntLane(a[pb], precision, i, dis(gen));
+                setIntLane(b[pb], precision, i, dis(gen));
+            }
+            for (int j = 0; j < 8; j++) acc[pb].i32Data_[j] = (j == 7) ? INT32_MAX - 1 : j - 4;
+        }
+        alu.add(sum, a, b, 2);
+        alu.mul(prod, a, b, 2);
+        copy_n(acc, 2, mac);
+        alu.mac(mac, a, b, 2);
+        sb_mac = acc[1];
+        sblock.mac(sb_mac, a[1], b[1]);
+        EXPECT_EQ(sb_mac, mac[1]);
+
+        for (int pb = 0; pb < 2; pb++)
+        {
+            for (int i = 0; i < lanes; i++)
+            {
+                int x = getIntLane(a[pb], precision, i), y = getIntLane(b[pb], precision, i);
+                EXPECT_EQ(getIntLane(sum[pb], precision, i), min(max, std::max(-max - 1, x + y)));
+                EXPECT_EQ(getIntLane(prod[pb], precision, i), min(max, std::max(-max - 1, x * y)));
+            }
+            for (int j = 0; j < 8; j++)
+            {
+                int64_t expected = acc[pb].i32Data_[j];
+                for (int i = j * lanes / 8; i < (j + 1) * lanes / 8; i++)
+                    expected += getIntLane(a[pb], precision, i) * getIntLane(b[pb], precision, i);
+                expected = min<int64_t>(INT32_MAX, std::max<int64_t>(INT32_MIN, expected));
+                EXPECT_EQ(mac[pb].i32Data_[j], expected);
+            }
+        }
+
+        // integer blocks have no max unit, MAX leaves the destination as it was
+        BurstType max_dst[2] = {acc[0], acc[1]};
+        alu.burstmax(max_dst, a, b, 2);
+        EXPECT_EQ(max_dst[0], acc[0]);
+        EXPECT_EQ(max_dst[1], acc[1]);
+
+        alu.relu(a, 2);
+        for (int i = 0; i < lanes; i++) EXPECT_GE(getIntLane(a[0], precision, i), 0);
+    }
+}
+
+TEST_F(basicFixture, pim_register_file_all_blocks)
+{
+    auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                     "system_hbm.ini", ".", "example_app",
+                                                     256 * 16);
+    PIMRank* pimRank = mem->channels[0]->ranks->front()->pimRank;
+    PIMRegisterFile& regs = pimRank->pimRegs;
+    const unsigned num_blocks = regs.getNumBlocks();
+
+    // distinct registers per block, so mixing up blocks or registers shows in the result
+    mt19937 gen(7);
+    uniform_int_distribution<int> dis(-64, 64);
+    for (unsigned pb = 0; pb < num_blocks; pb++)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            regs.grfA(1)[pb].fp16Data_[i] = convertF2H(dis(gen) / 8.0f);
+            regs.grfB(0)[pb].fp16Data_[i] = convertF2H(dis(gen) / 8.0f);
+            regs.srf()[pb].fp16Data_[i] = convertF2H(dis(gen) / 8.0f);
+        }
+    }
+    vector<BurstType> grf_a1(regs.grfA(1), regs.grfA(1) + num_blocks);
+    vector<BurstType> grf_b0(regs.grfB(0), regs.grfB(0) + num_blocks);
+    vector<BurstType> srf(regs.srf(), regs.srf() + num_blocks);
+
+    // GRF_B[0] += GRF_A[1] * SRF_M[3]; GRF_A[2] = GRF_A[1] + GRF_B[0]; EXIT
+    BurstType crf_bst, ctrl_bst, bank_bst;
+    crf_bst.u32Data_[0] =
+        PIMCmd(PIMCmdType::MAC, PIMOpdType::GRF_B, PIMOpdType::GRF_A, PIMOpdType::SRF_M, 0, 0, 1, 3)
+            .toInt();
+    crf_bst.u32Data_[1] =
+        PIMCmd(PIMCmdType::ADD, PIMOpdType::GRF_A, PIMOpdType::GRF_A, PIMOpdType::GRF_B, 0, 2, 1, 0)
+            .toInt();
+    crf_bst.u32Data_[2] = PIMCmd(PIMCmdType::EXIT, 0).toInt();
+    ctrl_bst.u8Data_[0] = 1;
+    BusPacket crf_packet(WRITE, 0, 0x04, 0x3fff, 0, 0, &crf_bst, mem->getLogFile());
+    BusPacket ctrl_packet(WRITE, 0, 0x00, 0x3fff, 0, 0, &ctrl_bst, mem->getLogFile());
+    BusPacket read_packet(READ, 0, 0, 0, 0, 0, &bank_bst, mem->getLogFile());
+    pimRank->writeHab(&crf_packet);
+    pimRank->writeHab(&ctrl_packet);
+    pimRank->doPIM(&read_packet);
+    pimRank->doPIM(&read_packet);
+    EXPECT_TRUE(pimRank->isCrfExit());
+
+    for (unsigned pb = 0; pb < num_blocks; pb++)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            fp16 b0 = grf_a1[pb].fp16Data_[i] * srf[pb].fp16Data_[3] + grf_b0[pb].fp16Data_[i];
+            fp16 a2 = grf_a1[pb].fp16Data_[i] + b0;
+            EXPECT_EQ(fp16i(regs.grfB(0)[pb].fp16Data_[i]).ival, fp16i(b0).ival);
+            EXPECT_EQ(fp16i(regs.grfA(2)[pb].fp16Data_[i]).ival, fp16i(a2).ival);
+        }
+        EXPECT_EQ(regs.grfA(1)[pb], grf_a1[pb]);
+    }
+}
+
+TEST_F(basicFixture, pim_all_blocks_matches_per_block)
+{
+    // the wide doPIMAllBlocks() path against doPIMBlock() called block by block, on random CRF
+    // commands over random registers and bank data
+    auto mem_all = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm.ini", ".", "example_app",
+                                                         256 * 16);
+    auto mem_blk = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm.ini", ".", "example_app",
+                                                         256 * 16);
+    Rank* ranks[2] = {mem_all->channels[0]->ranks->front(), mem_blk->channels[0]->ranks->front()};
+    const unsigned num_blocks = ranks[0]->pimRank->pimRegs.getNumBlocks();
+    const unsigned num_rows = 4, num_cols = 32, num_progs = 64, prog_len = 32;
+
+    mt19937 gen(13);
+    uniform_int_distribution<int> dis(-64, 64);
+    auto random_burst = [&]() {
+        BurstType bst;
+        for (int i = 0; i < 16; i++) bst.fp16Data_[i] = convertF2H(dis(gen) / 16.0f);
+        return bst;
+    };
+    for (unsigned pb = 0; pb < num_blocks; pb++)
+    {
+        vector<BurstType> regs(2 * PIMRegisterFile::NUM_GRF + 1);
+        for (auto& bst : regs) bst = random_burst();
+        for (auto rank : ranks)
+        {
+            PIMRegisterFile& pimRegs = rank->pimRank->pimRegs;
+            for (int i = 0; i < PIMRegisterFile::NUM_GRF; i++)
+            {
+                pimRegs.grfA(i)[pb] = regs[i];
+                pimRegs.grfB(i)[pb] = regs[PIMRegisterFile::NUM_GRF + i];
+            }
+            pimRegs.srf()[pb] = regs.back();
+        }
+    }
+    for (unsigned bank = 0; bank < 2 * num_blocks; bank++)
+    {
+        for (unsigned row = 0; row < num_rows; row++)
+        {
+            for (unsigned col = 0; col < num_cols; col++)
+            {
+                BurstType bst = random_burst();
+                BusPacket packet(WRITE, 0, col, row, 0, bank, &bst, mem_all->getLogFile());
+                for (auto rank : ranks) rank->banks[bank].write(&packet);
+            }
+        }
+    }
+
+    const PIMCmdType types[] = {PIMCmdType::FILL, PIMCmdType::MOV, PIMCmdType::ADD,
+                                PIMCmdType::MUL,  PIMCmdType::MAX, PIMCmdType::MAC,
+                                PIMCmdType::MAD,  PIMCmdType::NOP};
+    const PIMOpdType srcs[] = {PIMOpdType::GRF_A, PIMOpdType::GRF_B, PIMOpdType::SRF_M,
+                               PIMOpdType::SRF_A, PIMOpdType::EVEN_BANK, PIMOpdType::ODD_BANK};
+    const PIMOpdType dsts[] = {PIMOpdType::GRF_A, PIMOpdType::GRF_B, PIMOpdType::EVEN_BANK,
+                               PIMOpdType::ODD_BANK};
+    auto pick = [&](unsigned n) { return static_cast<unsigned>(gen() % n); };
+    // a command only names the bank of its own parity, the packet has to agree with it
+    auto is_bank = [](PIMOpdType opd) {
+        return opd == PIMOpdType::EVEN_BANK || opd == PIMOpdType::ODD_BANK;
+    };
+
+    for (unsigned prog = 0; prog < num_progs; prog++)
+    {
+        PIMOpdType bank_opd = (gen() % 2) ? PIMOpdType::EVEN_BANK : PIMOpdType::ODD_BANK;
+        auto pick_opd = [&](const PIMOpdType* opds, unsigned n) {
+            PIMOpdType opd = opds[pick(n)];
+            return is_bank(opd) ? bank_opd : opd;
+        };
+        for (unsigned pc = 0; pc < prog_len; pc++)
+        {
+            PIMCmd cmd(types[pick(8)], pick_opd(dsts, 4), pick_opd(srcs, 6), pick_opd(srcs, 6),
+                       pick_opd(srcs, 6), pick(2), pick(8), pick(8), pick(8));
+            cmd.isRelu_ = (cmd.type_ == PIMCmdType::MOV) ? pick(2) : 0;
+            // through the CRF encoding, as doPIM() sees it
+            PIMCmd crf_cmd;
+            crf_cmd.fromInt(cmd.toInt());
+
+            bool is_write = (crf_cmd.type_ == PIMCmdType::NOP);
+            unsigned row = pick(num_rows), col = pick(num_cols);
+            unsigned bank = (bank_opd == PIMOpdType::ODD_BANK) ? 1 : 0;
+            BurstType data[2];
+            data[0] = data[1] = random_burst();
+            BusPacket packet_all(is_write ? WRITE : READ, 0, col, row, 0, bank, &data[0],
+                                 mem_all->getLogFile());
+            BusPacket packet_blk(is_write ? WRITE : READ, 0, col, row, 0, bank, &data[1],
+                                 mem_blk->getLogFile());
+            ranks[0]->pimRank->doPIMAllBlocks(&packet_all, crf_cmd);
+            for (unsigned pb = 0; pb < num_blocks; pb++)
+                ranks[1]->pimRank->doPIMBlock(&packet_blk, crf_cmd, pb);
+        }
+
+        PIMRegisterFile& regs_all = ranks[0]->pimRank->pimRegs;
+        PIMRegisterFile& regs_blk = ranks[1]->pimRank->pimRegs;
+        for (unsigned pb = 0; pb < num_blocks; pb++)
+        {
+            for (int i = 0; i < PIMRegisterFile::NUM_GRF; i++)
+            {
+                ASSERT_EQ(regs_all.grfA(i)[pb], regs_blk.grfA(i)[pb])
+                    << "program " << prog << " block " << pb << " GRF_A " << i;
+                ASSERT_EQ(regs_all.grfB(i)[pb], regs_blk.grfB(i)[pb])
+                    << "program " << prog << " block " << pb << " GRF_B " << i;
+            }
+            ASSERT_EQ(regs_all.srf()[pb], regs_blk.srf()[pb]) << "program " << prog;
+        }
+    }
+
+    for (unsigned bank = 0; bank < 2 * num_blocks; bank++)
+    {
+        for (unsigned row = 0; row < num_rows; row++)
+        {
+            for (unsigned col = 0; col < num_cols; col++)
+            {
+                BurstType bst[2];
+                BusPacket packet_all(READ, 0, col, row, 0, bank, &bst[0], mem_all->getLogFile());
+                BusPacket packet_blk(READ, 0, col, row, 0, bank, &bst[1], mem_blk->getLogFile());
+                ranks[0]->banks[bank].read(&packet_all);
+                ranks[1]->banks[bank].read(&packet_blk);
+                EXPECT_EQ(bst[0], bst[1]) << "bank " << bank << " row " << row << " col " << col;
+            }
+        }
+    }
+}
+
+TEST_F(basicFixture, pim_functional_mode)
+{
+    const int num_bursts = 256;  // two tiles on a single channel
+    mt19937 gen(11);
+    uniform_int_distribution<int> dis(-64, 64);
+    NumpyBurstType input0, input1;
+    for (NumpyBurstType* t : {&input0, &input1})
+    {
+        t->bShape = {num_bursts};
+        t->bData.resize(num_bursts);
+        for (auto& bst : t->bData)
+            for (int i = 0; i < 16; i++) bst.fp16Data_[i] = convertF2H(dis(gen) / 8.0f);
+    }
+
+    auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                     "system_hbm_1ch.ini", ".", "example_app",
+                                                     256);
+    mem->setFunctionalMode(true);
+    auto kernel = make_shared<PIMKernel>(mem, 1, 1);
+    vector<BurstType> sum(num_bursts), relu(num_bursts);
+
+    kernel->preloadNoReplacement(&input0, 0, 0);
+    kernel->preloadNoReplacement(&input1, 128, 0);
+    kernel->executeEltwise(num_bursts, pimBankType::ALL_BANK, KernelType::ADD, 0, 256, 128);
+    kernel->executeEltwise(num_bursts, pimBankType::ALL_BANK, KernelType::RELU, 0, 384);
+    kernel->readData(sum.data(), num_bursts, 256, 0);
+    kernel->readData(relu.data(), num_bursts, 384, 0);
+
+    // every transaction already ran inside addTransaction, nothing is left to simulate
+    EXPECT_EQ(mem->hasPendingTransactions(), 0);
+    kernel->runPIM();
+    EXPECT_EQ(kernel->getCycle(), 0);
+    EXPECT_EQ(mem->channels[0]->ranks->front()->mode_, dramMode::SB);
+
+    for (int i = 0; i < num_bursts; i++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            fp16 a = input0.bData[i].fp16Data_[j];
+            fp16 expected_sum = a + input1.bData[i].fp16Data_[j];
+            fp16 expected_relu = (a > 0) ? a : convertF2H(0.0f);
+            EXPECT_EQ(fp16i(sum[i].fp16Data_[j]).ival, fp16i(expected_sum).ival);
+            EXPECT_EQ((float)relu[i].fp16Data_[j], (float)expected_relu);
+        }
+    }
+}
+
+TEST_F(basicFixture, pim_functional_matches_timed)
+{
+    const int num_bursts = 256;
+    const unsigned num_rows = 512;
+    mt19937 gen(13);
+    uniform_int_distribution<int> dis(-64, 64);
+    NumpyBurstType input0, input1;
+    for (NumpyBurstType* t : {&input0, &input1})
+    {
+        t->bShape = {num_bursts};
+        t->bData.resize(num_bursts);
+        for (auto& bst : t->bData)
+            for (int i = 0; i < 16; i++) bst.fp16Data_[i] = convertF2H(dis(gen) / 8.0f);
+    }
+
+    // the whole bank array of the rank after the same kernels, once timed and once functional
+    vector<BurstType> contents[2];
+    for (bool functional : {false, true})
+    {
+        auto mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                         "system_hbm_1ch.ini", ".", "example_app",
+                                                         256);
+        mem->setFunctionalMode(functional);
+        auto kernel = make_shared<PIMKernel>(mem, 1, 1);
+        kernel->preloadNoReplacement(&input0, 0, 0);
+        kernel->preloadNoReplacement(&input1, 128, 0);
+        kernel->executeEltwise(num_bursts, pimBankType::ALL_BANK, KernelType::ADD, 0, 256, 128);
+        kernel->executeEltwise(num_bursts, pimBankType::ALL_BANK, KernelType::MUL, 0, 384, 128);
+        kernel->executeEltwise(num_bursts, pimBankType::ALL_BANK, KernelType::RELU, 256, 448);
+        kernel->runPIM();
+        EXPECT_EQ(kernel->getCycle() == 0, functional);
+
+        Rank* rank = mem->channels[0]->ranks->front();
+        unsigned num_cols = mem->getConfiguration().NUM_COLS;
+        for (size_t bank = 0; bank < rank->banks.size(); bank++)
+        {
+            for (unsigned row = 0; row < num_rows; row++)
+            {
+                for (unsigned col = 0; col < num_cols; col++)
+                {
+                    BurstType bst;
+                    BusPacket packet(READ, 0, col, row, 0, bank, &bst, mem->getLogFile());
+                    rank->banks[bank].read(&packet);
+                    contents[functional].push_back(bst);
+                }
+            }
+        }
+    }
+    ASSERT_EQ(contents[0].size(), contents[1].size());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < contents[0].size(); i++)
+        mismatches += !(contents[0][i] == contents[1][i]);
+    EXPECT_EQ(mismatches, 0);
+}
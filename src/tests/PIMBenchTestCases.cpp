@@ -29,6 +29,41 @@ TEST_F(PIMBenchFixture, gemv)
     expectPIMBench(2.0);
 }
 
+TEST_F(PIMBenchFixture, gemv_batch)
+{
+    // a batch runs under one kernel launch and has to beat a launch per batch
+    uint64_t batch1_cycle = 0;
+    for (unsigned batch = 1; batch <= 8; batch++)
+    {
+        setPIMBenchTestCase(KernelType::GEMV, 4096, 4096, batch);
+        executeKernel();
+        executePIMKernel();
+        printResult(getPIMBenchGain());
+        if (batch == 1)
+            batch1_cycle = getPIMCycle();
+        else
+            EXPECT_LT(getPIMCycle(), batch * batch1_cycle) << "batch " << batch;
+    }
+}
+
+TEST_F(PIMBenchFixture, gemv_int8)
+{
+    setPIMBenchTestCase(KernelType::GEMV, 4096, 4096, 1, "system_hbm_64ch_int8.ini");
+    executeKernel();
+    executePIMKernel();
+    expectPIMBench(2.0);
+}
+
+TEST_F(PIMBenchFixture, gemv_int8_vs_fp16)
+{
+    // INT8 packs 32 weights per burst, FP16 16, so the same GEMV needs half the MAC columns
+    setPIMBenchTestCase(KernelType::GEMV, 4096, 4096);
+    executeBaselinePIMKernel();  // FP16 w/ PIM
+    setPIMBenchTestCase(KernelType::GEMV, 4096, 4096, 1, "system_hbm_64ch_int8.ini");
+    executePIMKernel();          // INT8 w/ PIM
+    expectPIMBench(1.5);
+}
+
 TEST_F(PIMBenchFixture, mul)
 {
     setPIMBenchTestCase(KernelType::MUL, 2 * 1024 * 1024, 2 * 1024 * 1024);
@@ -52,3 +87,69 @@ TEST_F(PIMBenchFixture, relu)
     executePIMKernel();
     expectPIMBench(2.0);
 }
+
+TEST_F(PIMBenchFixture, add_relu_fused)
+{
+    // ADD then RELU writes the sum to the banks and reads it back, the fused kernel keeps it in GRF
+    setFusedPIMBenchTestCase(KernelType::ADD_RELU, 1024 * 1024, false);
+    executeBaselinePIMKernel();  // ADD and RELU back to back w/ PIM
+    setFusedPIMBenchTestCase(KernelType::ADD_RELU, 1024 * 1024, true);
+    executePIMKernel();          // fused w/ PIM
+    expectPIMBench(1.2);
+}
+
+TEST_F(PIMBenchFixture, mul_add_fused)
+{
+    setFusedPIMBenchTestCase(KernelType::MUL_ADD, 1024 * 1024, false);
+    executeBaselinePIMKernel();
+    setFusedPIMBenchTestCase(KernelType::MUL_ADD, 1024 * 1024, true);
+    executePIMKernel();
+    expectPIMBench(1.2);
+}
+
+TEST_F(PIMBenchFixture, scale_shift_fused)
+{
+    // the fused kernel reads only the input, the chain also reads a scale and a shift tensor
+    setFusedPIMBenchTestCase(KernelType::SCALE_SHIFT, 1024 * 1024, false);
+    executeBaselinePIMKernel();
+    setFusedPIMBenchTestCase(KernelType::SCALE_SHIFT, 1024 * 1024, true);
+    executePIMKernel();
+    expectPIMBench(2.0);
+}
+
+TEST_F(PIMBenchFixture, softmax)
+{
+    // 256 rows of 4096: a max reduction, an exp pass that also sums the row and the scaling,
+    // against the 3 reads and the write of the host
+    setPIMBenchTestCase(KernelType::SOFTMAX, 4096, 4096, 256);
+    executeKernel();
+    executePIMKernel();
+    expectPIMBench(1.05);
+}
+
+TEST_F(PIMBenchFixture, layernorm)
+{
+    // the sum and the sum of squares in one pass, gamma and beta read from one open row
+    setPIMBenchTestCase(KernelType::LAYERNORM, 4096, 4096, 256);
+    executeKernel();
+    executePIMKernel();
+    expectPIMBench(1.0);
+}
+
+TEST_F(PIMBenchFixture, rmsnorm)
+{
+    // one reduction and the beta column less than LAYERNORM
+    setPIMBenchTestCase(KernelType::RMSNORM, 4096, 4096, 256);
+    executeKernel();
+    executePIMKernel();
+    expectPIMBench(1.1);
+}
+
+TEST_F(PIMBenchFixture, gelu)
+{
+    // the same dataflow as RELU with the table lookup in place of the FILL
+    setPIMBenchTestCase(KernelType::GELU, 4 * 1024 * 1024, 4 * 1024 * 1024);
+    executeKernel();
+    executePIMKernel();
+    expectPIMBench(2.0);
+}
@@ -23,14 +23,13 @@ using namespace DRAMSim;
 class PIMBenchTestCase
 {
   public:
-    PIMBenchTestCase(KernelType k, unsigned b, unsigned out, unsigned in)
+    PIMBenchTestCase(KernelType k, unsigned b, unsigned out, unsigned in, const string& sys_ini)
         : kernel_type_(k), batch_(b), out_(out), in_(in)
     {
-        mem_ = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
-                                                     "system_hbm_64ch.ini", ".", "example_app",
-                                                     256 * 64 * 2);
+        mem_ = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini", sys_ini,
+                                                     ".", "example_app", 256 * 64 * 2);
         pim_mem_ = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
-                                                         "system_hbm_64ch.ini", ".", "example_app",
+                                                         sys_ini, ".", "example_app",
                                                          256 * 64 * 2);
         // # of pim channel = 64, # of pim rank = 1
         kernel_ = make_shared<PIMKernel>(pim_mem_, 64, 1);
@@ -52,14 +51,15 @@ class PIMBenchTestCase
         {
             mem_->update();
             (*cycle)++;
+            *cycle += mem_->skipIdleCycles();
         }
     }
 
     uint64_t genMemTraffic(shared_ptr<MultiChannelMemorySystem> mem_, bool is_write,
                            uint32_t data_size_in_bytes, uint64_t starting_addr)
     {
-        unsigned basic_stride =
-            (getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") * getConfigParam(UINT, "BL") / 8);
+        const Configuration& config = mem_->getConfiguration();
+        unsigned basic_stride = config.JEDEC_DATA_BUS_BITS * config.BL / 8;
         BurstType null_bst;
         uint64_t addr;
 
@@ -88,6 +88,34 @@ class PIMBenchTestCase
         {
             return string{"RELU"};
         }
+        else if (k == KernelType::ADD_RELU)
+        {
+            return string{"ADD_RELU"};
+        }
+        else if (k == KernelType::MUL_ADD)
+        {
+            return string{"MUL_ADD"};
+        }
+        else if (k == KernelType::SCALE_SHIFT)
+        {
+            return string{"SCALE_SHIFT"};
+        }
+        else if (k == KernelType::SOFTMAX)
+        {
+            return string{"SOFTMAX"};
+        }
+        else if (k == KernelType::GELU)
+        {
+            return string{"GELU"};
+        }
+        else if (k == KernelType::LAYERNORM)
+        {
+            return string{"LAYERNORM"};
+        }
+        else if (k == KernelType::RMSNORM)
+        {
+            return string{"RMSNORM"};
+        }
         else
         {
             throw invalid_argument("Invalid kernel type");
@@ -96,7 +124,8 @@ class PIMBenchTestCase
 
     void printTestMessage(bool is_pim_)
     {
-        cout << "  " << kernelTypetoStr(kernel_type_) << " (PIM "
+        cout << "  " << kernelTypetoStr(kernel_type_) << " "
+             << getConfigParam(STRING, "PIM_PRECISION") << " (PIM "
              << (is_pim_ ? "enabled)" : "disabled)") << endl;
         dim_data_->printDim(kernel_type_);
     }
@@ -116,8 +145,8 @@ class PIMBenchTestCase
 class GemvPIMBenchTest : public PIMBenchTestCase
 {
   public:
-    GemvPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in)
-        : PIMBenchTestCase(k, b, out, in)
+    GemvPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in, const string& sys_ini)
+        : PIMBenchTestCase(k, b, out, in, sys_ini)
     {
     }
 
@@ -153,8 +182,8 @@ class GemvPIMBenchTest : public PIMBenchTestCase
 class EltPIMBenchTest : public PIMBenchTestCase
 {
   public:
-    EltPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in)
-        : PIMBenchTestCase(k, b, out, in)
+    EltPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in, const string& sys_ini)
+        : PIMBenchTestCase(k, b, out, in, sys_ini)
     {
         input_row0_ = 0;
         input_row1_ = 128;
@@ -200,8 +229,8 @@ class EltPIMBenchTest : public PIMBenchTestCase
 class ActPIMBenchTest : public PIMBenchTestCase
 {
   public:
-    ActPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in)
-        : PIMBenchTestCase(k, b, out, in)
+    ActPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in, const string& sys_ini)
+        : PIMBenchTestCase(k, b, out, in, sys_ini)
     {
         input_row0_ = 0;
         result_row_ = 256;
@@ -239,6 +268,230 @@ class ActPIMBenchTest : public PIMBenchTestCase
     unsigned result_row_;
 };
 
+/*
+ * Fused element-wise chains. With is_fused = false the PIM case runs the same chain as
+ * back-to-back single-op kernels, which write the intermediate to the banks and read it back.
+ */
+class FusedEltPIMBenchTest : public PIMBenchTestCase
+{
+  public:
+    FusedEltPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in, const string& sys_ini,
+                         bool is_fused)
+        : PIMBenchTestCase(k, b, out, in, sys_ini), is_fused_(is_fused)
+    {
+        input_row0_ = 0;
+        input_row1_ = 128;
+        input_row2_ = 384;
+        result_row_ = 256;
+        temp_row_ = 512;
+    }
+
+    uint64_t measureCycle(bool is_pim_ = false)
+    {
+        uint64_t cycle = 0;
+        uint64_t starting_addr = 0;
+
+        if (is_pim_ == true)
+        {
+            if (is_fused_)
+                executeFused();
+            else
+                executeChain();
+            kernel_->runPIM();
+            cycle = kernel_->getCycle();
+            printBankTraffic(pim_mem_);
+        }
+        else
+        {
+            int num_inputs = (kernel_type_ == KernelType::SCALE_SHIFT) ? 1
+                             : (kernel_type_ == KernelType::MUL_ADD)   ? 3
+                                                                       : 2;
+            uint32_t input_data_size_in_byte =
+                dim_data_->getDataSize(dim_data_->input_dim_, dim_data_->batch_size_);
+            uint32_t output_data_size_in_byte =
+                dim_data_->getDataSize(dim_data_->output_dim_, dim_data_->batch_size_);
+            for (int i = 0; i < num_inputs; i++)
+                starting_addr = genMemTraffic(mem_, false, input_data_size_in_byte, starting_addr);
+            run(mem_, &cycle);
+            genMemTraffic(mem_, true, output_data_size_in_byte, starting_addr);  // result-vec
+            run(mem_, &cycle);
+            printBankTraffic(mem_);
+        }
+        return cycle;
+    }
+
+  private:
+    void executeFused()
+    {
+        unsigned dim = dim_data_->output_npbst_.getTotalDim();
+        if (kernel_type_ == KernelType::SCALE_SHIFT)
+            kernel_->executeScaleShift(dim, pimBankType::ALL_BANK, 0.5f, -0.25f, input_row0_,
+                                       result_row_);
+        else
+            kernel_->executeEltwise(dim, pimBankType::ALL_BANK, kernel_type_, input_row0_,
+                                    result_row_, input_row1_, input_row2_);
+    }
+
+    // SCALE_SHIFT without fusion needs the scale and the shift as full tensors in input1/input2
+    void executeChain()
+    {
+        unsigned dim = dim_data_->output_npbst_.getTotalDim();
+        if (kernel_type_ == KernelType::ADD_RELU)
+        {
+            kernel_->executeEltwise(dim, pimBankType::ALL_BANK, KernelType::ADD, input_row0_,
+                                    temp_row_, input_row1_);
+            kernel_->executeEltwise(dim, pimBankType::ALL_BANK, KernelType::RELU, temp_row_,
+                                    result_row_);
+        }
+        else
+        {
+            kernel_->executeEltwise(dim, pimBankType::ALL_BANK, KernelType::MUL, input_row0_,
+                                    temp_row_, input_row1_);
+            kernel_->executeEltwise(dim, pimBankType::ALL_BANK, KernelType::ADD, temp_row_,
+                                    result_row_, input_row2_);
+        }
+    }
+
+    void printBankTraffic(shared_ptr<MultiChannelMemorySystem> mem)
+    {
+        uint64_t reads = 0, writes = 0;
+        for (MemorySystem* channel : mem->channels)
+        {
+            reads += channel->memoryController->totalReads;
+            writes += channel->memoryController->totalWrites;
+        }
+        cout << "> Column commands : " << reads << " reads, " << writes << " writes" << endl;
+    }
+
+    bool is_fused_;
+    // for PIM
+    unsigned input_row0_;
+    unsigned input_row1_;
+    unsigned input_row2_;
+    unsigned result_row_;
+    unsigned temp_row_;
+};
+
+/*
+ * Kernels that evaluate the lut_table in the PIM units. The host baseline of SOFTMAX is the 3-pass
+ * safe softmax (max, sum, normalize), GELU is a read and a write of the tensor. The table is
+ * loaded before the measurement like the weights of the other cases.
+ */
+class LutPIMBenchTest : public PIMBenchTestCase
+{
+  public:
+    LutPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in, const string& sys_ini)
+        : PIMBenchTestCase(k, b, out, in, sys_ini),
+          lut_(64, convertF2H(-4.0f), convertF2H(-11.0898f), convertF2H(4.0f), convertF2H(0.0f))
+    {
+        input_row0_ = 0;
+        result_row_ = 256;
+        lut_.fill(layerType::GELU, FP16);
+        lut_.fill(layerType::EXP, FP16);
+    }
+
+    uint64_t measureCycle(bool is_pim_ = false)
+    {
+        uint64_t cycle = 0;
+        uint64_t starting_addr = 0;
+
+        if (is_pim_ == true)
+        {
+            uint64_t preload_cycle = 0;
+            kernel_->preloadLut(&lut_);
+            run(pim_mem_, &preload_cycle);
+
+            int row_dim = dim_data_->dimTobShape(dim_data_->input_dim_);
+            if (kernel_type_ == KernelType::SOFTMAX)
+                kernel_->executeSoftmax(dim_data_->batch_size_, row_dim, input_row0_,
+                                        result_row_);
+            else
+                kernel_->executeGelu(dim_data_->output_npbst_.getTotalDim(), input_row0_,
+                                     result_row_);
+            kernel_->runPIM();
+            cycle = kernel_->getCycle();
+        }
+        else
+        {
+            uint32_t input_data_size_in_byte =
+                dim_data_->getDataSize(dim_data_->input_dim_, dim_data_->batch_size_);
+            uint32_t output_data_size_in_byte =
+                dim_data_->getDataSize(dim_data_->output_dim_, dim_data_->batch_size_);
+            int num_read_passes = (kernel_type_ == KernelType::SOFTMAX) ? 3 : 1;
+            for (int i = 0; i < num_read_passes; i++)
+            {
+                genMemTraffic(mem_, false, input_data_size_in_byte, 0);
+                run(mem_, &cycle);
+            }
+            starting_addr += input_data_size_in_byte;
+            genMemTraffic(mem_, true, output_data_size_in_byte, starting_addr);  // result-vec
+            run(mem_, &cycle);
+        }
+        return cycle;
+    }
+
+  private:
+    lut_table lut_;
+    // for PIM
+    unsigned input_row0_;
+    unsigned result_row_;
+};
+
+/*
+ * Row normalizations. The host baseline reads the tensor once for the row statistics and once
+ * more to apply them and writes the result; gamma and beta stay in the host cache. gamma and
+ * beta share param_row_ and are staged in the banks before the measurement like the weights of
+ * the other cases.
+ */
+class NormPIMBenchTest : public PIMBenchTestCase
+{
+  public:
+    NormPIMBenchTest(KernelType k, unsigned b, unsigned out, unsigned in, const string& sys_ini)
+        : PIMBenchTestCase(k, b, out, in, sys_ini)
+    {
+        input_row0_ = 0;
+        result_row_ = 256;
+        param_row_ = 512;
+    }
+
+    uint64_t measureCycle(bool is_pim_ = false)
+    {
+        uint64_t cycle = 0;
+        uint64_t starting_addr = 0;
+
+        if (is_pim_ == true)
+        {
+            int row_dim = dim_data_->dimTobShape(dim_data_->input_dim_);
+            kernel_->executeNorm(kernel_type_, dim_data_->batch_size_, row_dim, input_row0_,
+                                 result_row_, param_row_);
+            kernel_->runPIM();
+            cycle = kernel_->getCycle();
+        }
+        else
+        {
+            uint32_t input_data_size_in_byte =
+                dim_data_->getDataSize(dim_data_->input_dim_, dim_data_->batch_size_);
+            uint32_t output_data_size_in_byte =
+                dim_data_->getDataSize(dim_data_->output_dim_, dim_data_->batch_size_);
+            for (int i = 0; i < 2; i++)
+            {
+                genMemTraffic(mem_, false, input_data_size_in_byte, 0);
+                run(mem_, &cycle);
+            }
+            starting_addr += input_data_size_in_byte;
+            genMemTraffic(mem_, true, output_data_size_in_byte, starting_addr);  // result-vec
+            run(mem_, &cycle);
+        }
+        return cycle;
+    }
+
+  private:
+    // for PIM
+    unsigned input_row0_;
+    unsigned result_row_;
+    unsigned param_row_;
+};
+
 class PIMBenchFixture : public testing::Test
 {
   public:
@@ -256,19 +509,35 @@ class PIMBenchFixture : public testing::Test
         delete perfTest;
     }
 
-    void setPIMBenchTestCase(KernelType k, unsigned out, unsigned in, unsigned batch = 1)
+    // the precision of the case follows PIM_PRECISION in sys_ini
+    void setPIMBenchTestCase(KernelType k, unsigned out, unsigned in, unsigned batch = 1,
+                             const string& sys_ini = "system_hbm_64ch.ini")
     {
+        delete perfTest;
         if (k == KernelType::GEMV)
         {
-            perfTest = new GemvPIMBenchTest(k, batch, out, in);
+            perfTest = new GemvPIMBenchTest(k, batch, out, in, sys_ini);
         }
         else if (k == KernelType::MUL || k == KernelType::ADD)
         {
-            perfTest = new EltPIMBenchTest(k, batch, out, in);
+            perfTest = new EltPIMBenchTest(k, batch, out, in, sys_ini);
         }
         else if (k == KernelType::RELU)
         {
-            perfTest = new ActPIMBenchTest(k, batch, out, in);
+            perfTest = new ActPIMBenchTest(k, batch, out, in, sys_ini);
+        }
+        else if (k == KernelType::ADD_RELU || k == KernelType::MUL_ADD ||
+                 k == KernelType::SCALE_SHIFT)
+        {
+            perfTest = new FusedEltPIMBenchTest(k, batch, out, in, sys_ini, true);
+        }
+        else if (k == KernelType::SOFTMAX || k == KernelType::GELU)
+        {
+            perfTest = new LutPIMBenchTest(k, batch, out, in, sys_ini);
+        }
+        else if (k == KernelType::LAYERNORM || k == KernelType::RMSNORM)
+        {
+            perfTest = new NormPIMBenchTest(k, batch, out, in, sys_ini);
         }
         else
         {
@@ -276,6 +545,14 @@ class PIMBenchFixture : public testing::Test
         }
     }
 
+    // is_fused = false runs the chain of a fused kernel as back-to-back single-op kernels
+    void setFusedPIMBenchTestCase(KernelType k, unsigned dim, bool is_fused,
+                                  const string& sys_ini = "system_hbm_64ch.ini")
+    {
+        delete perfTest;
+        perfTest = new FusedEltPIMBenchTest(k, 1, dim, dim, sys_ini, is_fused);
+    }
+
     void executePIMKernel(void)
     {
         perfTest->printTestMessage(true);
@@ -290,6 +567,24 @@ class PIMBenchFixture : public testing::Test
         printStats(non_pim_cycle_);
     }
 
+    // baseline for comparing two PIM cases (e.g. two precisions) instead of PIM against no PIM
+    void executeBaselinePIMKernel(void)
+    {
+        perfTest->printTestMessage(true);
+        non_pim_cycle_ = perfTest->measureCycle(true);
+        printStats(non_pim_cycle_);
+    }
+
+    float getPIMBenchGain()
+    {
+        return (float)non_pim_cycle_ / pim_cycle_;
+    }
+
+    uint64_t getPIMCycle()
+    {
+        return pim_cycle_;
+    }
+
     void expectPIMBench(float expected_perf_gain)
     {
         EXPECT_TRUE((float)non_pim_cycle_ / pim_cycle_ > expected_perf_gain)
@@ -27,6 +27,8 @@ vector<PIMCmd> PIMCmdGen::getPIMCmds(KernelType ktype, int num_jump_to_be_taken,
             break;
         */
         case KernelType::RELU:
+        case KernelType::GELU:
+        case KernelType::SOFTMAX:  // the exp pass, the reductions come from getReduceCmds()
             pim_kernel = make_unique<ActPIMKernel>(ktype);
             break;
         case KernelType::MUL:
@@ -41,9 +43,33 @@ vector<PIMCmd> PIMCmdGen::getPIMCmds(KernelType ktype, int num_jump_to_be_taken,
         case KernelType::GEMVTREE:
             pim_kernel = make_unique<GemvPIMKernel>(ktype);
             break;
+        case KernelType::ADD_RELU:
+        case KernelType::MUL_ADD:
+        case KernelType::SCALE_SHIFT:
+        case KernelType::LAYERNORM:
+        case KernelType::RMSNORM:
+            pim_kernel = make_unique<FusedEltwisePIMKernel>(ktype);
+            break;
         default:
             throw invalid_argument("Invalid kernel type");
     }
     return pim_kernel->generateKernel(num_jump_to_be_taken, num_jump_to_be_taken_odd_bank,
                                       num_jump_to_be_taken_even_bank);
 }
+
+vector<PIMCmd> PIMCmdGen::getReduceCmds(KernelType ktype, PIMCmdType reduce_type,
+                                        int num_jump_to_be_taken_odd_bank,
+                                        int num_jump_to_be_taken_even_bank)
+{
+    ReducePIMKernel pim_kernel(ktype, reduce_type);
+    return pim_kernel.generateKernel(0, num_jump_to_be_taken_odd_bank,
+                                     num_jump_to_be_taken_even_bank);
+}
+
+vector<PIMCmd> PIMCmdGen::getMomentCmds(KernelType ktype, int num_jump_to_be_taken_odd_bank,
+                                        int num_jump_to_be_taken_even_bank)
+{
+    MomentPIMKernel pim_kernel(ktype);
+    return pim_kernel.generateKernel(0, num_jump_to_be_taken_odd_bank,
+                                     num_jump_to_be_taken_even_bank);
+}
@@ -73,6 +73,15 @@ class EltwisePIMKernel : public IPIMCmd
     }
 };
 
+/*
+ * Activations applied on the way from the banks to the GRF, written back by the NOPs.
+ *   RELU    : FILL with relu
+ *   GELU    : table lookup in the PIM unit, see PIMRank::writeLut()
+ *   SOFTMAX : exp(x + SRF_M[0]) of one row per unit, the host puts -max of the row in SRF_M[0].
+ *             Both bank halves go through GRF_A like SCALE_SHIFT, so GRF_B can add up the row
+ *             while it is written back. Each ADD takes 8 more trigger reads, after the last
+ *             tile GRF_B is folded into GRF_B[0] and NOP writes it to the odd bank.
+ */
 class ActPIMKernel : public IPIMCmd
 {
   public:
@@ -91,6 +100,30 @@ class ActPIMKernel : public IPIMCmd
                 PIMCmd(PIMCmdType::NOP, 7)};
             pim_cmds.assign(tmp_cmds.begin(), tmp_cmds.end());
         }
+        else if (kernelType == KernelType::GELU)
+        {
+            vector<PIMCmd> tmp_cmds{
+                PIMCmd(PIMCmdType::GELU, PIMOpdType::GRF_A, PIMOpdType::EVEN_BANK,
+                       PIMOpdType::A_OUT, 1),
+                PIMCmd(PIMCmdType::NOP, 7),
+                PIMCmd(PIMCmdType::GELU, PIMOpdType::GRF_B, PIMOpdType::ODD_BANK,
+                       PIMOpdType::A_OUT, 1),
+                PIMCmd(PIMCmdType::NOP, 7)};
+            pim_cmds.assign(tmp_cmds.begin(), tmp_cmds.end());
+        }
+        else if (kernelType == KernelType::SOFTMAX)
+        {
+            vector<PIMCmd> tmp_cmds{
+                PIMCmd(PIMCmdType::EXP, PIMOpdType::GRF_A, PIMOpdType::EVEN_BANK,
+                       PIMOpdType::SRF_M, 1),
+                PIMCmd(PIMCmdType::ADD, PIMOpdType::GRF_B, PIMOpdType::GRF_B, PIMOpdType::GRF_A, 1),
+                PIMCmd(PIMCmdType::NOP, 7),
+                PIMCmd(PIMCmdType::EXP, PIMOpdType::GRF_A, PIMOpdType::ODD_BANK,
+                       PIMOpdType::SRF_M, 1),
+                PIMCmd(PIMCmdType::ADD, PIMOpdType::GRF_B, PIMOpdType::GRF_B, PIMOpdType::GRF_A, 1),
+                PIMCmd(PIMCmdType::FILL, PIMOpdType::ODD_BANK, PIMOpdType::GRF_A)};
+            pim_cmds.assign(tmp_cmds.begin(), tmp_cmds.end());
+        }
         else
         {
             throw invalid_argument("Not supported activation");
@@ -99,11 +132,208 @@ class ActPIMKernel : public IPIMCmd
         {
             pim_cmds.push_back(PIMCmd(PIMCmdType::JUMP, num_jump_to_be_taken, pim_cmds.size() + 1));
         }
+        if (kernelType == KernelType::SOFTMAX)
+        {
+            for (int g = 1; g < num_fold_cmds + 1; g++)
+            {
+                pim_cmds.push_back(PIMCmd(PIMCmdType::ADD, PIMOpdType::GRF_B, PIMOpdType::GRF_B,
+                                          PIMOpdType::GRF_B, 0, 0, 0, g));
+            }
+            pim_cmds.push_back(PIMCmd(PIMCmdType::NOP, 0));
+        }
+        pim_cmds.push_back(PIMCmd(PIMCmdType::EXIT, 0));
+        return pim_cmds;
+    }
+
+    // SOFTMAX: trigger reads of the GRF_B fold between the last tile and the write-back
+    static const int num_fold_cmds = 7;
+};
+
+/*
+ * Element-wise chains that keep the intermediate in the GRF, so only the final result goes back
+ * to the banks.
+ *   ADD_RELU    : relu(in0 + in1), the write-back FILL applies the ReLU
+ *   MUL_ADD     : in0 * in1 + in2
+ *   SCALE_SHIFT : in0 * SRF_M[0] + GRF_B, the host broadcasts the shift into every GRF_B register
+ *                 and both bank halves go through GRF_A
+ *   LAYERNORM   : (in0 * SRF_M[0] + GRF_B) * in1 + in2, rstd in SRF_M[0], -mean * rstd in GRF_B
+ *   RMSNORM     : (in0 * SRF_M[0] + GRF_B) * in1, GRF_B holds zeros
+ */
+class FusedEltwisePIMKernel : public IPIMCmd
+{
+  public:
+    FusedEltwisePIMKernel(KernelType ktype) : IPIMCmd(ktype) {}
+    virtual vector<PIMCmd> generateKernel(int num_jump_to_be_taken,
+                                          int num_jump_to_be_taken_odd_bank = 0,
+                                          int num_jump_to_be_taken_even_bank = 0) override
+    {
+        vector<PIMCmd> pim_cmds;
+        if (kernelType == KernelType::SCALE_SHIFT)
+        {
+            vector<PIMCmd> tmp_cmds{
+                PIMCmd(PIMCmdType::MAD, PIMOpdType::GRF_A, PIMOpdType::EVEN_BANK,
+                       PIMOpdType::SRF_M, PIMOpdType::GRF_B, 1),
+                PIMCmd(PIMCmdType::NOP, 7),
+                PIMCmd(PIMCmdType::MAD, PIMOpdType::GRF_A, PIMOpdType::ODD_BANK,
+                       PIMOpdType::SRF_M, PIMOpdType::GRF_B, 1),
+                PIMCmd(PIMCmdType::FILL, PIMOpdType::ODD_BANK, PIMOpdType::GRF_A)};
+            pim_cmds.assign(tmp_cmds.begin(), tmp_cmds.end());
+        }
+        else if (kernelType == KernelType::ADD_RELU || kernelType == KernelType::MUL_ADD)
+        {
+            const PIMOpdType banks[2] = {PIMOpdType::EVEN_BANK, PIMOpdType::ODD_BANK};
+            const PIMOpdType grfs[2] = {PIMOpdType::GRF_A, PIMOpdType::GRF_B};
+            for (int b = 0; b < 2; b++)  // for even/odd banks, respectively
+            {
+                pim_cmds.push_back(PIMCmd(PIMCmdType::FILL, grfs[b], banks[b]));
+                if (kernelType == KernelType::ADD_RELU)
+                {
+                    pim_cmds.push_back(PIMCmd(PIMCmdType::ADD, grfs[b], grfs[b], banks[b], 1));
+                    pim_cmds.push_back(PIMCmd(PIMCmdType::FILL, banks[b], grfs[b], 1, 0, 0, 0, 1));
+                }
+                else
+                {
+                    pim_cmds.push_back(PIMCmd(PIMCmdType::MUL, grfs[b], grfs[b], banks[b], 1));
+                    pim_cmds.push_back(PIMCmd(PIMCmdType::ADD, grfs[b], grfs[b], banks[b], 1));
+                    pim_cmds.push_back(PIMCmd(PIMCmdType::NOP, 7));
+                }
+            }
+        }
+        else if (kernelType == KernelType::LAYERNORM || kernelType == KernelType::RMSNORM)
+        {
+            // the shift sits in GRF_B like SCALE_SHIFT's, so both bank halves go through GRF_A
+            const PIMOpdType banks[2] = {PIMOpdType::EVEN_BANK, PIMOpdType::ODD_BANK};
+            for (int b = 0; b < 2; b++)  // for even/odd banks, respectively
+            {
+                pim_cmds.push_back(PIMCmd(PIMCmdType::MAD, PIMOpdType::GRF_A, banks[b],
+                                          PIMOpdType::SRF_M, PIMOpdType::GRF_B, 1));
+                pim_cmds.push_back(
+                    PIMCmd(PIMCmdType::MUL, PIMOpdType::GRF_A, PIMOpdType::GRF_A, banks[b], 1));
+                if (kernelType == KernelType::LAYERNORM)
+                    pim_cmds.push_back(
+                        PIMCmd(PIMCmdType::ADD, PIMOpdType::GRF_A, PIMOpdType::GRF_A, banks[b], 1));
+                if (b == 0)
+                    pim_cmds.push_back(PIMCmd(PIMCmdType::NOP, 7));
+                else
+                    pim_cmds.push_back(
+                        PIMCmd(PIMCmdType::FILL, PIMOpdType::ODD_BANK, PIMOpdType::GRF_A));
+            }
+        }
+        else
+        {
+            throw invalid_argument("Not supported fused element-wise operation");
+        }
+        if (num_jump_to_be_taken != 0)
+        {
+            pim_cmds.push_back(PIMCmd(PIMCmdType::JUMP, num_jump_to_be_taken, pim_cmds.size() + 1));
+        }
         pim_cmds.push_back(PIMCmd(PIMCmdType::EXIT, 0));
         return pim_cmds;
     }
 };
 
+/*
+ * Row reduction of one unit. Each PIM block folds the columns of its even bank into GRF_A and of
+ * its odd bank into GRF_B, then GRF_B into GRF_A and GRF_A[1..7] into GRF_A[0], one non-auto
+ * command per trigger read. NOP writes GRF_A[0] of every block back to its even bank, where the
+ * channel-level C_ALU finishes the reduction over the PIM blocks.
+ *   MAX : row max (SOFTMAX)
+ *   ADD : row sum
+ *   MAC : row sum of squares, the column loops square the bank data (RMSNORM)
+ * The GRFs have to hold the identity of the op before the first column is read.
+ */
+class ReducePIMKernel : public IPIMCmd
+{
+  public:
+    ReducePIMKernel(KernelType ktype, PIMCmdType reduce_type)
+        : IPIMCmd(ktype), reduceType_(reduce_type)
+    {
+        if (reduce_type != PIMCmdType::MAX && reduce_type != PIMCmdType::ADD &&
+            reduce_type != PIMCmdType::MAC)
+            throw invalid_argument("Not supported reduction");
+    }
+    virtual vector<PIMCmd> generateKernel(int num_jump_to_be_taken,
+                                          int num_jump_to_be_taken_odd_bank,
+                                          int num_jump_to_be_taken_even_bank) override
+    {
+        vector<PIMCmd> pim_cmds;
+        pim_cmds.push_back(getColumnCmd(PIMOpdType::GRF_A, PIMOpdType::EVEN_BANK));
+        if (num_jump_to_be_taken_even_bank != 0)
+            pim_cmds.push_back(PIMCmd(PIMCmdType::JUMP, num_jump_to_be_taken_even_bank, 2));
+        pim_cmds.push_back(getColumnCmd(PIMOpdType::GRF_B, PIMOpdType::ODD_BANK));
+        if (num_jump_to_be_taken_odd_bank != 0)
+            pim_cmds.push_back(PIMCmd(PIMCmdType::JUMP, num_jump_to_be_taken_odd_bank, 2));
+
+        // partial squares are added up like partial sums
+        PIMCmdType foldType = (reduceType_ == PIMCmdType::MAC) ? PIMCmdType::ADD : reduceType_;
+        for (int g = 0; g < 8; g++)
+        {
+            pim_cmds.push_back(
+                PIMCmd(foldType, PIMOpdType::GRF_A, PIMOpdType::GRF_A, PIMOpdType::GRF_B, 0, g, g, g));
+        }
+        for (int g = 1; g < 8; g++)
+        {
+            pim_cmds.push_back(
+                PIMCmd(foldType, PIMOpdType::GRF_A, PIMOpdType::GRF_A, PIMOpdType::GRF_A, 0, 0, 0, g));
+        }
+        pim_cmds.push_back(PIMCmd(PIMCmdType::NOP, 0));
+        pim_cmds.push_back(PIMCmd(PIMCmdType::EXIT, 0));
+        return pim_cmds;
+    }
+
+    // trigger reads of the fold commands between the column loops and the write-back
+    static const int num_fold_cmds = 15;
+
+  private:
+    PIMCmd getColumnCmd(PIMOpdType grf, PIMOpdType bank)
+    {
+        if (reduceType_ == PIMCmdType::MAC)
+            return PIMCmd(PIMCmdType::MAC, grf, bank, bank, 1);
+        return PIMCmd(reduceType_, grf, grf, bank, 1);
+    }
+
+    PIMCmdType reduceType_;
+};
+
+/*
+ * Row sum and row sum of squares of one unit in one pass (LAYERNORM). Both bank halves add into
+ * GRF_A and square into GRF_B, so every column is read twice while its row is open: once for the
+ * ADD and once for the MAC. GRF_A[1..7] and GRF_B[1..7] are folded into slot 0 and NOP writes
+ * GRF_A[0] to the even bank and GRF_B[0] to the odd bank. The GRFs have to start from zero.
+ */
+class MomentPIMKernel : public IPIMCmd
+{
+  public:
+    MomentPIMKernel(KernelType ktype) : IPIMCmd(ktype) {}
+    virtual vector<PIMCmd> generateKernel(int num_jump_to_be_taken,
+                                          int num_jump_to_be_taken_odd_bank,
+                                          int num_jump_to_be_taken_even_bank) override
+    {
+        vector<PIMCmd> pim_cmds;
+        const PIMOpdType banks[2] = {PIMOpdType::EVEN_BANK, PIMOpdType::ODD_BANK};
+        const int num_jumps[2] = {num_jump_to_be_taken_even_bank, num_jump_to_be_taken_odd_bank};
+        for (int b = 0; b < 2; b++)  // for even/odd banks, respectively
+        {
+            pim_cmds.push_back(
+                PIMCmd(PIMCmdType::ADD, PIMOpdType::GRF_A, PIMOpdType::GRF_A, banks[b], 1));
+            pim_cmds.push_back(PIMCmd(PIMCmdType::MAC, PIMOpdType::GRF_B, banks[b], banks[b], 1));
+            if (num_jumps[b] != 0)
+                pim_cmds.push_back(PIMCmd(PIMCmdType::JUMP, num_jumps[b], 3));
+        }
+        for (PIMOpdType grf : {PIMOpdType::GRF_A, PIMOpdType::GRF_B})
+        {
+            for (int g = 1; g < 8; g++)
+                pim_cmds.push_back(PIMCmd(PIMCmdType::ADD, grf, grf, grf, 0, 0, 0, g));
+        }
+        pim_cmds.push_back(PIMCmd(PIMCmdType::NOP, 1));
+        pim_cmds.push_back(PIMCmd(PIMCmdType::EXIT, 0));
+        return pim_cmds;
+    }
+
+    // trigger reads of the fold commands between the column loops and the write-back
+    static const int num_fold_cmds = 14;
+};
+
 class GemvPIMKernel : public IPIMCmd
 {
   public:
@@ -163,6 +393,11 @@ class PIMCmdGen
     static vector<PIMCmd> getPIMCmds(KernelType ktype, int num_jump_to_be_taken,
                                      int num_jump_to_be_taken_odd_bank,
                                      int num_jump_to_be_taken_even_bank);
+    static vector<PIMCmd> getReduceCmds(KernelType ktype, PIMCmdType reduce_type,
+                                        int num_jump_to_be_taken_odd_bank,
+                                        int num_jump_to_be_taken_even_bank);
+    static vector<PIMCmd> getMomentCmds(KernelType ktype, int num_jump_to_be_taken_odd_bank,
+                                        int num_jump_to_be_taken_even_bank);
 };
 
 #endif  // __PIM_KERNEL_GEN_H__
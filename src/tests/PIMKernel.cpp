@@ -24,7 +24,9 @@ void PIMKernel::runPIM()
     {
         cycle_++;
         mem_->update();
+        cycle_ += mem_->skipIdleCycles();
     }
+    crf_bst_.clear();
 }
 
 uint64_t PIMKernel::getCycle()
@@ -32,6 +34,18 @@ uint64_t PIMKernel::getCycle()
     return cycle_;
 }
 
+// with BANK_STORAGE=mmap a preload left in the bank files by an earlier run can be skipped,
+// mark it only after runPIM() so the tag never covers bursts still in flight
+bool PIMKernel::isPreloaded(const string& tag)
+{
+    return mem_->isStoragePreloaded(tag);
+}
+
+void PIMKernel::markPreloaded(const string& tag)
+{
+    mem_->markStoragePreloaded(tag);
+}
+
 void PIMKernel::parkIn()
 {
     addBarrier();
@@ -50,7 +64,7 @@ void PIMKernel::parkIn()
                         str = "END_" + str;
                     mem_->addTransaction(
                         false,
-                        pim_addr_mgr_->addrGen(ch_idx, ra_idx, bg_idx, bank_idx, (1 << 13), 0), str,
+                        pim_addr_mgr_->addrGen(ch_idx, ra_idx, bg_idx, bank_idx, pim_park_ra, 0), str,
                         &null_bst_);
                 }
             }
@@ -76,7 +90,7 @@ void PIMKernel::parkOut()
                         str = "END_" + str;
                     mem_->addTransaction(
                         false,
-                        pim_addr_mgr_->addrGen(ch_idx, ra_idx, bg_idx, bank_idx, (1 << 13), 0), str,
+                        pim_addr_mgr_->addrGen(ch_idx, ra_idx, bg_idx, bank_idx, pim_park_ra, 0), str,
                         &null_bst_);
                 }
             }
@@ -223,15 +237,17 @@ void PIMKernel::programCrf(vector<PIMCmd>& cmds)
     {
         if (i * 8 >= cmds.size())
             break;
-        crf_bst_[i].set(nop_cmd.toInt(), nop_cmd.toInt(), nop_cmd.toInt(), nop_cmd.toInt(),
-                        nop_cmd.toInt(), nop_cmd.toInt(), nop_cmd.toInt(), nop_cmd.toInt());
+        // a new burst per program, so a kernel queued behind this one cannot overwrite it
+        crf_bst_.emplace_back(nop_cmd.toInt(), nop_cmd.toInt(), nop_cmd.toInt(), nop_cmd.toInt(),
+                              nop_cmd.toInt(), nop_cmd.toInt(), nop_cmd.toInt(), nop_cmd.toInt());
+        BurstType& crf_bst = crf_bst_.back();
         for (int j = 0; j < 8; j++)
         {
             if (i * 8 + j >= cmds.size())
                 break;
-            crf_bst_[i].u32Data_[j] = cmds[i * 8 + j].toInt();
+            crf_bst.u32Data_[j] = cmds[i * 8 + j].toInt();
         }
-        addTransactionAll(true, 0, 1, pim_reg_ra, 0x4 + i, "PROGRAM_CRF", &(crf_bst_[i]));
+        addTransactionAll(true, 0, 1, pim_reg_ra, 0x4 + i, "PROGRAM_CRF", &crf_bst);
     }
     addBarrier();
 }
@@ -245,12 +261,14 @@ void PIMKernel::setControl(BurstType* bst, bool pim_op, int crf_toggle_cond, boo
     bst->u8Data_[21] = grfB_zero;
 }
 
-unsigned PIMKernel::getResultColGemv(int input_dim, int output_dim)
+// first column of the GRF_B write-back of batch batch_idx, see executeGemv()
+unsigned PIMKernel::getResultColGemv(int input_dim, int output_dim, int batch_idx)
 {
     int num_output_tiles = ceil(((double)output_dim / (num_total_pim_blocks_)) / num_grfB_);
     int num_input_tiles = ceil((double)input_dim / (double)num_grfA_);
 
-    return num_output_tiles * num_input_tiles / 2 * num_grfA_ * num_grfB_;
+    return num_output_tiles * num_input_tiles / 2 * num_grfA_ * num_grfB_ +
+           batch_idx * num_output_tiles * num_grfB_;
 }
 
 void PIMKernel::changeBank(pimBankType pb_type, int& ch_idx, int& ra_idx, int& bg_idx,
@@ -302,9 +320,11 @@ void PIMKernel::preloadGemv(NumpyBurstType* operand, unsigned starting_row, unsi
                 row = (is_odd) ? odd_starting_row : even_starting_row;
                 col = (is_odd) ? odd_starting_col : even_starting_col;
 
-                for (int grfb_idx = 0; grfb_idx < num_grfB_; grfb_idx++)
+                // a MAC on column c accumulates GRF_A[c / 8] * bank into GRF_B[c % 8], so the
+                // output rows of a tile interleave column by column
+                for (int grfa_idx = 0; grfa_idx < num_grfA_; grfa_idx++)
                 {
-                    for (int grfa_idx = 0; grfa_idx < num_grfA_; grfa_idx++, col++)
+                    for (int grfb_idx = 0; grfb_idx < num_grfB_; grfb_idx++, col++)
                     {
                         addr = pim_addr_mgr_->addrGenSafe(ch_idx, ra_idx, bg_idx, bank_idx + is_odd,
                                                           row, col);
@@ -332,6 +352,67 @@ void PIMKernel::preloadNoReplacement(NumpyBurstType* operand, unsigned starting_
         mem_->addTransaction(true, addr, &operand->bData[x]);
     }
 }
+/*
+ * Loads lut into the PIM units of every PIM channel: the header through column 0x2 of the
+ * register row, then the slopes and intercepts through column 0x3 (PIMRank::writeLut()).
+ */
+void PIMKernel::preloadLut(lut_table* lut)
+{
+    if (PIMConfiguration::getPIMPrecision() != FP16)
+        throw invalid_argument("The PIM units evaluate the lut_table in FP16 only");
+
+    // the bursts stay referenced by the queued transactions until runPIM()
+    lut_header_bst_ = lut->getHeader();
+
+    parkIn();
+    changePIMMode(dramMode::SB, dramMode::HAB);
+    for (int& ch_idx : pim_chans_)
+    {
+        for (int& ra_idx : pim_ranks_)
+        {
+            mem_->addTransaction(true, pim_addr_mgr_->addrGen(ch_idx, ra_idx, 0, 1, pim_reg_ra, 0x2),
+                                 "WRIO_TO_LUT_", &lut_header_bst_);
+            for (int i = 0; i < lut->sets.size(); i++)
+            {
+                uint64_t addr = pim_addr_mgr_->addrGen(ch_idx, ra_idx, 0, 1, pim_reg_ra, 0x3);
+                mem_->addTransaction(true, addr, "WRIO_TO_LUT_", lut->sets[i]);
+            }
+        }
+        mem_->addBarrier(ch_idx);
+    }
+    changePIMMode(dramMode::HAB, dramMode::SB);
+    parkOut();
+    lut_ = lut;
+}
+
+/*
+ * Softmax rows stay inside one unit so that their reductions never cross a channel. Row r goes
+ * to unit r % units and DRAM row starting_row + r / units, its burst k to bank k % 16 at column
+ * k / 16, so every PIM block sees row_dim / 8 bursts of it.
+ */
+uint64_t PIMKernel::getSoftmaxAddr(int row, int bst_idx, unsigned starting_row)
+{
+    int num_units = num_pim_chans_ * num_pim_ranks_;
+    int unit = row % num_units;
+    int bank = bst_idx % num_banks_;
+    int num_banks_per_bg = num_banks_ / num_bank_groups_;
+    return pim_addr_mgr_->addrGen(unit / num_pim_ranks_, unit % num_pim_ranks_,
+                                  bank / num_banks_per_bg, bank % num_banks_per_bg,
+                                  starting_row + row / num_units, bst_idx / num_banks_);
+}
+
+void PIMKernel::preloadSoftmax(NumpyBurstType* operand, int row_dim, unsigned starting_row)
+{
+    int num_rows = operand->getTotalDim() / row_dim;
+    for (int r = 0; r < num_rows; r++)
+    {
+        for (int k = 0; k < row_dim; k++)
+        {
+            mem_->addTransaction(true, getSoftmaxAddr(r, k, starting_row),
+                                 &operand->bData[r * row_dim + k]);
+        }
+    }
+}
 /*
 void PIMKernel::preloadEltwise(NumpyBurstType* operand, pimBankType pb_type,
                               unsigned starting_row, unsigned starting_col)
@@ -360,6 +441,12 @@ void PIMKernel::preloadEltwise(NumpyBurstType* operand, pimBankType pb_type,
    }
 }
 */
+/*
+ * The batches of an output tile run back to back under one CRF program, each from its own GRF_A
+ * image into its own result columns. Keeping several batches in the SRF to reuse an open weight
+ * row was slower: an SRF image carries 8 scalars, so every 8 MACs paid a write-to-read bus
+ * turnaround, while 8 GRF_A writes feed 64 MACs.
+ */
 void PIMKernel::executeGemv(NumpyBurstType* w_data, NumpyBurstType* i_data, bool is_tree)
 {
     int num_output_tiles = ceil(((double)w_data->bShape[0] / (num_total_pim_blocks_)) / num_grfB_);
@@ -410,7 +497,7 @@ void PIMKernel::executeGemv(NumpyBurstType* w_data, NumpyBurstType* i_data, bool
             changePIMMode(dramMode::HAB, dramMode::HAB_PIM);  // PC reset.
 
             int col = num_output_tiles * num_input_tiles / 2 * num_grfA_ * num_grfB_ +
-                      (j + b) * num_grfB_;
+                      (b * num_output_tiles + j) * num_grfB_;
             if (is_tree)
             {
                 for (int i = 0; i < num_input_tiles; i++, col += num_grfB_)
@@ -495,8 +582,21 @@ void PIMKernel::readResult(BurstType* resultBst, pimBankType pb_type, int output
     }
 }
 
+void PIMKernel::readResultSoftmax(BurstType* result, int num_rows, int row_dim,
+                                  unsigned starting_row)
+{
+    for (int r = 0; r < num_rows; r++)
+    {
+        for (int k = 0; k < row_dim; k++)
+        {
+            mem_->addTransaction(false, getSoftmaxAddr(r, k, starting_row), "output",
+                                 &result[r * row_dim + k]);
+        }
+    }
+}
+
 void PIMKernel::executeEltwise(int dim, pimBankType pb_type, KernelType ktype, int input0_row,
-                               int result_row, int input1_row)
+                               int result_row, int input1_row, int input2_row)
 {
     int num_tile = dim / (num_banks_ * num_pim_chans_ * num_pim_ranks_ * num_grf_);
     int num_jump_to_be_taken = num_tile - 1;
@@ -510,10 +610,12 @@ void PIMKernel::executeEltwise(int dim, pimBankType pb_type, KernelType ktype, i
     programCrf(pim_cmds);
     changePIMMode(dramMode::HAB, dramMode::HAB_PIM);
 
-    if (ktype == KernelType::ADD || ktype == KernelType::MUL)
+    if (ktype == KernelType::ADD || ktype == KernelType::MUL || ktype == KernelType::ADD_RELU)
         computeAddOrMul(num_tile, input0_row, result_row, input1_row);
-    else if (ktype == KernelType::RELU)
-        computeRelu(num_tile, input0_row, result_row);
+    else if (ktype == KernelType::MUL_ADD)
+        computeMulAdd(num_tile, input0_row, result_row, input1_row, input2_row);
+    else if (ktype == KernelType::RELU || ktype == KernelType::GELU)
+        computeAct(num_tile, input0_row, result_row);
     /*
        else if (ktype == KernelType::BN)
        computeBn(num_tile, input0_row, result_row);
@@ -524,6 +626,380 @@ void PIMKernel::executeEltwise(int dim, pimBankType pb_type, KernelType ktype, i
     parkOut();
 }
 
+/*
+ * y = x * scale + shift over dim elements. The scale goes to SRF_M[0] and the shift to every
+ * GRF_B register of each unit before the first column is read, so the kernel reads the input once
+ * and writes the result once without a second element-wise pass.
+ */
+void PIMKernel::executeScaleShift(int dim, pimBankType pb_type, float scale, float shift,
+                                  int input0_row, int result_row)
+{
+    if (PIMConfiguration::getPIMDataLength() != 2)
+        throw invalid_argument("Scale-shift needs a 16-bit PIM precision for the SRF scalar");
+
+    int num_tile = dim / (num_banks_ * num_pim_chans_ * num_pim_ranks_ * num_grf_);
+    int num_jump_to_be_taken = num_tile - 1;
+    vector<PIMCmd> pim_cmds =
+        PIMCmdGen::getPIMCmds(KernelType::SCALE_SHIFT, num_jump_to_be_taken, 0, 0);
+
+    // the bursts stay referenced by the queued transactions until runPIM()
+    if (PIMConfiguration::getPIMPrecision() == BF16)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            scale_srf_bst_.u16Data_[i] = convertF2BF(scale);
+            shift_grf_bst_.u16Data_[i] = convertF2BF(shift);
+        }
+    }
+    else
+    {
+        scale_srf_bst_.set(convertF2H(scale));
+        shift_grf_bst_.set(convertF2H(shift));
+    }
+
+    setControl(&bst_hab_pim_, true, getToggleCond(pb_type), false, false);
+    setControl(&bst_hab_, false, getToggleCond(pb_type), false, false);
+
+    parkIn();
+    changePIMMode(dramMode::SB, dramMode::HAB);
+    programCrf(pim_cmds);
+    changePIMMode(dramMode::HAB, dramMode::HAB_PIM);
+
+    for (int& ch_idx : pim_chans_)
+    {
+        for (int& ra_idx : pim_ranks_)
+        {
+            mem_->addTransaction(true, pim_addr_mgr_->addrGen(ch_idx, ra_idx, 0, 1, pim_reg_ra, 0x1),
+                                 "WRIO_TO_SRF_", &scale_srf_bst_);
+            for (int gidx = 0; gidx < num_grfB_; gidx++)
+            {
+                uint64_t addr =
+                    pim_addr_mgr_->addrGen(ch_idx, ra_idx, 0, 1, pim_reg_ra, 0x18 + gidx);
+                mem_->addTransaction(true, addr, "WRIO_TO_GRF_", &shift_grf_bst_);
+            }
+        }
+        mem_->addBarrier(ch_idx);
+    }
+    computeScaleShift(num_tile, input0_row, result_row);
+
+    changePIMMode(dramMode::HAB_PIM, dramMode::HAB);
+    changePIMMode(dramMode::HAB, dramMode::SB);
+    parkOut();
+}
+
+/*
+ * PIM part of a row reduction over rows laid out by preloadSoftmax(). Per slot of rows the GRFs
+ * start from identity, ReducePIMKernel folds every row to GRF_A[0] of each PIM block and writes
+ * it to column 0 of the even bank in result_row + slot. Reads of those num_pim_blocks_ partials
+ * per row are queued into partials without running them, so the caller can add its own reads.
+ */
+void PIMKernel::reduceRows(KernelType ktype, PIMCmdType reduce_type, BurstType* identity,
+                           int num_rows, int row_dim, int input0_row, int result_row,
+                           BurstType* partials)
+{
+    int num_units = num_pim_chans_ * num_pim_ranks_;
+    int num_slots = ceil((double)num_rows / num_units);
+    int num_cols = row_dim / num_banks_;
+    if (row_dim % (num_banks_ * num_grf_) != 0 || num_cols > pim_addr_mgr_->num_cols_per_bl_)
+        throw invalid_argument("Reduced rows have to fill whole GRF tiles of one DRAM row");
+    int num_tile = num_cols / num_grf_;
+
+    vector<PIMCmd> pim_cmds =
+        PIMCmdGen::getReduceCmds(ktype, reduce_type, num_tile - 1, num_tile - 1);
+    setControl(&bst_hab_pim_, true, getToggleCond(), false, false);
+    setControl(&bst_hab_, false, getToggleCond(), false, false);
+
+    parkIn();
+    changePIMMode(dramMode::SB, dramMode::HAB);
+    programCrf(pim_cmds);
+    for (int s = 0; s < num_slots; s++)
+    {
+        changePIMMode(dramMode::HAB, dramMode::HAB_PIM);
+        addTransactionAll(true, 0, 1, pim_reg_ra, 0x08, "WRIO_TO_GRF_", identity, false,
+                          num_grfA_);
+        addTransactionAll(true, 0, 1, pim_reg_ra, 0x18, "WRIO_TO_GRF_", identity, true,
+                          num_grfB_);
+        computeRowReduce(num_cols, input0_row + s, result_row + s);
+        changePIMMode(dramMode::HAB_PIM, dramMode::HAB);
+    }
+    changePIMMode(dramMode::HAB, dramMode::SB);
+    parkOut();
+    readRowPartials(num_rows, result_row, 0, partials);
+}
+
+/*
+ * Row sum and row sum of squares in one pass of MomentPIMKernel, rows laid out by
+ * preloadSoftmax(). The partial sums of a row come back in sums and the partial sums of squares
+ * in sqs, num_pim_blocks_ each; the reads are queued like those of reduceRows().
+ */
+void PIMKernel::reduceMoments(KernelType ktype, int num_rows, int row_dim, int input0_row,
+                              int result_row, BurstType* sums, BurstType* sqs)
+{
+    int num_units = num_pim_chans_ * num_pim_ranks_;
+    int num_slots = ceil((double)num_rows / num_units);
+    int num_cols = row_dim / num_banks_;
+    if (row_dim % (num_banks_ * num_grf_) != 0 || num_cols > pim_addr_mgr_->num_cols_per_bl_)
+        throw invalid_argument("Reduced rows have to fill whole GRF tiles of one DRAM row");
+    int num_tile = num_cols / num_grf_;
+
+    vector<PIMCmd> pim_cmds = PIMCmdGen::getMomentCmds(ktype, num_tile - 1, num_tile - 1);
+    setControl(&bst_hab_pim_, true, getToggleCond(), true, true);
+    setControl(&bst_hab_, false, getToggleCond(), false, false);
+
+    parkIn();
+    changePIMMode(dramMode::SB, dramMode::HAB);
+    programCrf(pim_cmds);
+    for (int s = 0; s < num_slots; s++)
+    {
+        changePIMMode(dramMode::HAB, dramMode::HAB_PIM);
+        computeRowMoments(num_tile, input0_row + s, result_row + s);
+        changePIMMode(dramMode::HAB_PIM, dramMode::HAB);
+    }
+    changePIMMode(dramMode::HAB, dramMode::SB);
+    parkOut();
+    readRowPartials(num_rows, result_row, 0, sums);
+    readRowPartials(num_rows, result_row, 1, sqs);
+}
+
+// column 0 of the even (odd = 0) or odd (odd = 1) bank of every PIM block, per row of a slot
+void PIMKernel::readRowPartials(int num_rows, int row, int odd, BurstType* partials)
+{
+    int num_units = num_pim_chans_ * num_pim_ranks_;
+    int num_banks_per_bg = num_banks_ / num_bank_groups_;
+    for (int r = 0; r < num_rows; r++)
+    {
+        int unit = r % num_units;
+        for (int pb = 0; pb < num_pim_blocks_; pb++)
+        {
+            int bank = pb * 2 + odd;
+            uint64_t addr = pim_addr_mgr_->addrGen(
+                unit / num_pim_ranks_, unit % num_pim_ranks_, bank / num_banks_per_bg,
+                bank % num_banks_per_bg, row + r / num_units, 0);
+            mem_->addTransaction(false, addr, "PARTIAL_", &partials[r * num_pim_blocks_ + pb]);
+        }
+    }
+}
+
+/*
+ * Row-wise softmax over num_rows rows of row_dim bursts laid out by preloadSoftmax(), with the
+ * exp table loaded by preloadLut(). Per slot of rows the PIM blocks reduce each row to one
+ * partial max per block (ReducePIMKernel) and the C_ALU of the channel takes the max of the
+ * partials. The EXP pass of ActPIMKernel gets -max in SRF_M, writes exp to result_row and leaves
+ * one partial sum per block in the odd bank of the rows after the result (result_row + num_slots
+ * on). A SCALE_SHIFT pass multiplies the row by 1 / sum in place.
+ */
+void PIMKernel::executeSoftmax(int num_rows, int row_dim, int input0_row, int result_row)
+{
+    if (lut_ == NULL)
+        throw invalid_argument("Softmax needs a lut_table loaded by preloadLut()");
+
+    int num_units = num_pim_chans_ * num_pim_ranks_;
+    int num_slots = ceil((double)num_rows / num_units);
+    int num_tile = row_dim / (num_banks_ * num_grf_);
+    int partial_row = result_row + num_slots;
+
+    lowest_bst_.set(convertF2H(-65504.0f));
+    softmax_partial_bst_.resize((size_t)num_rows * num_pim_blocks_);
+    reduceRows(KernelType::SOFTMAX, PIMCmdType::MAX, &lowest_bst_, num_rows, row_dim, input0_row,
+               result_row, softmax_partial_bst_.data());
+    runPIM();
+
+    softmax_srf_bst_.assign((size_t)num_slots * num_units, BurstType());
+    for (int r = 0; r < num_rows; r++)
+    {
+        C_ALU& c_alu = c_alus_[(r % num_units) / num_pim_ranks_];
+        c_alu.zeroize();
+        c_alu.setlowest();
+        for (int pb = 0; pb < num_pim_blocks_; pb++)
+            c_alu.C_max(softmax_partial_bst_[r * num_pim_blocks_ + pb]);
+        c_alu.setmax();
+        softmax_srf_bst_[r].set(convertF2H(-c_alu.S_REG));
+    }
+
+    // exp(x - max) and its partial sums, GRF_B starts from zero in every slot
+    vector<PIMCmd> pim_cmds = PIMCmdGen::getPIMCmds(KernelType::SOFTMAX, num_tile - 1, 0, 0);
+    setControl(&bst_hab_pim_, true, getToggleCond(), false, true);
+
+    parkIn();
+    changePIMMode(dramMode::SB, dramMode::HAB);
+    programCrf(pim_cmds);
+    for (int s = 0; s < num_slots; s++)
+    {
+        changePIMMode(dramMode::HAB, dramMode::HAB_PIM);
+        writeSlotSrf(&softmax_srf_bst_[s * num_units]);
+        computeExpSum(num_tile, input0_row + s, result_row + s, partial_row + s);
+        changePIMMode(dramMode::HAB_PIM, dramMode::HAB);
+    }
+    changePIMMode(dramMode::HAB, dramMode::SB);
+    parkOut();
+
+    readRowPartials(num_rows, partial_row, 1, softmax_partial_bst_.data());
+    runPIM();
+
+    for (int r = 0; r < num_rows; r++)
+    {
+        C_ALU& c_alu = c_alus_[(r % num_units) / num_pim_ranks_];
+        c_alu.zeroize();
+        for (int pb = 0; pb < num_pim_blocks_; pb++)
+            c_alu.accum(softmax_partial_bst_[r * num_pim_blocks_ + pb], false);
+        c_alu.adderTree();
+        softmax_srf_bst_[r].set(convertF2H(1.0f / c_alu.S_REG));
+    }
+
+    // exp * (1 / sum) with the shift of SCALE_SHIFT zeroized
+    pim_cmds = PIMCmdGen::getPIMCmds(KernelType::SCALE_SHIFT, num_tile - 1, 0, 0);
+    setControl(&bst_hab_pim_, true, getToggleCond(), false, true);
+
+    parkIn();
+    changePIMMode(dramMode::SB, dramMode::HAB);
+    programCrf(pim_cmds);
+    for (int s = 0; s < num_slots; s++)
+    {
+        changePIMMode(dramMode::HAB, dramMode::HAB_PIM);
+        writeSlotSrf(&softmax_srf_bst_[s * num_units]);
+        computeScaleShift(num_tile, result_row + s, result_row + s);
+        changePIMMode(dramMode::HAB_PIM, dramMode::HAB);
+    }
+    changePIMMode(dramMode::HAB, dramMode::SB);
+    parkOut();
+}
+
+/*
+ * one SRF burst per unit, srf_bsts holds the units of a slot of rows in row order. grf_b_bsts,
+ * if given, is broadcast into every GRF_B register of its unit the way executeScaleShift() does.
+ */
+void PIMKernel::writeSlotSrf(BurstType* srf_bsts, BurstType* grf_b_bsts)
+{
+    for (int& ch_idx : pim_chans_)
+    {
+        for (int& ra_idx : pim_ranks_)
+        {
+            int unit = ch_idx * num_pim_ranks_ + ra_idx;
+            mem_->addTransaction(true, pim_addr_mgr_->addrGen(ch_idx, ra_idx, 0, 1, pim_reg_ra, 0x1),
+                                 "WRIO_TO_SRF_", &srf_bsts[unit]);
+            for (int gidx = 0; grf_b_bsts != nullptr && gidx < num_grfB_; gidx++)
+            {
+                uint64_t addr =
+                    pim_addr_mgr_->addrGen(ch_idx, ra_idx, 0, 1, pim_reg_ra, 0x18 + gidx);
+                mem_->addTransaction(true, addr, "WRIO_TO_GRF_", &grf_b_bsts[unit]);
+            }
+        }
+        mem_->addBarrier(ch_idx);
+    }
+}
+
+/*
+ * a row_dim vector shared by all rows (gamma, beta), one copy per unit in the softmax row layout
+ * starting at burst bst_offset of the row, so beta can sit in the columns right after gamma
+ */
+void PIMKernel::preloadNormParam(NumpyBurstType* param, unsigned row, unsigned bst_offset)
+{
+    int num_units = num_pim_chans_ * num_pim_ranks_;
+    int row_dim = param->getTotalDim();
+    for (int unit = 0; unit < num_units; unit++)
+    {
+        for (int k = 0; k < row_dim; k++)
+            mem_->addTransaction(true, getSoftmaxAddr(unit, bst_offset + k, row),
+                                 &param->bData[k]);
+    }
+}
+
+/*
+ * LayerNorm (x - mean) * rstd * gamma + beta and RMSNorm x * rstd * gamma over num_rows rows of
+ * row_dim bursts laid out by preloadSoftmax(), gamma staged by preloadNormParam() at param_row and
+ * beta right after it in the same row. MomentPIMKernel reduces every row to per-block partial sums
+ * and sums of squares in one pass (ReducePIMKernel with MAC only for RMSNorm), the C_ALU adds the
+ * partial lanes up in FP32 and turns them into rstd for the SRF and shift = -mean * rstd for
+ * GRF_B, and one fused pass per slot applies the MAD with them and the gamma/beta columns in the
+ * banks. The rows never cross the channel.
+ */
+void PIMKernel::executeNorm(KernelType ktype, int num_rows, int row_dim, int input0_row,
+                            int result_row, int param_row, float eps)
+{
+    if (ktype != KernelType::LAYERNORM && ktype != KernelType::RMSNORM)
+        throw invalid_argument("Not supported normalization");
+    if (PIMConfiguration::getPIMDataLength() != 2)
+        throw invalid_argument("Normalization needs a 16-bit PIM precision for the SRF scalars");
+
+    int num_units = num_pim_chans_ * num_pim_ranks_;
+    int num_slots = ceil((double)num_rows / num_units);
+    int num_tile = row_dim / (num_banks_ * num_grf_);
+    int num_cols = row_dim / num_banks_;
+    bool is_layernorm = (ktype == KernelType::LAYERNORM);
+    if (is_layernorm && 2 * num_cols > pim_addr_mgr_->num_cols_per_bl_)
+        throw invalid_argument("LayerNorm needs gamma and beta in one DRAM row");
+
+    // null_bst_ sinks the data of the PIM reads, the GRFs need a real zero
+    zero_bst_ = BurstType();
+    norm_sum_bst_.resize((size_t)num_rows * num_pim_blocks_);
+    norm_sq_bst_.resize((size_t)num_rows * num_pim_blocks_);
+    if (is_layernorm)
+    {
+        reduceMoments(ktype, num_rows, row_dim, input0_row, result_row, norm_sum_bst_.data(),
+                      norm_sq_bst_.data());
+    }
+    else
+    {
+        reduceRows(ktype, PIMCmdType::MAC, &zero_bst_, num_rows, row_dim, input0_row, result_row,
+                   norm_sq_bst_.data());
+    }
+    runPIM();
+
+    float num_elements = row_dim * 16.0f;
+    norm_srf_bst_.assign((size_t)num_slots * num_units, BurstType());
+    norm_shift_bst_.assign((size_t)num_slots * num_units, BurstType());
+    for (int r = 0; r < num_rows; r++)
+    {
+        C_ALU& c_alu = c_alus_[(r % num_units) / num_pim_ranks_];
+        float mean = 0.0f;
+        if (is_layernorm)
+        {
+            c_alu.zeroize();
+            for (int pb = 0; pb < num_pim_blocks_; pb++)
+                c_alu.accum(norm_sum_bst_[r * num_pim_blocks_ + pb], false);
+            c_alu.adderTree();
+            mean = c_alu.S_REG / num_elements;
+        }
+        c_alu.zeroize();
+        for (int pb = 0; pb < num_pim_blocks_; pb++)
+            c_alu.accum(norm_sq_bst_[r * num_pim_blocks_ + pb], false);
+        c_alu.adderTree();
+        float var = max(c_alu.S_REG / num_elements - mean * mean, 0.0f);
+        float rstd = 1.0f / sqrt(var + eps);
+
+        norm_srf_bst_[r].fp16Data_[0] = convertF2H(rstd);  // SRF_M[0]
+        norm_shift_bst_[r].set(convertF2H(-mean * rstd));
+    }
+
+    vector<PIMCmd> pim_cmds = PIMCmdGen::getPIMCmds(ktype, num_tile - 1, 0, 0);
+    setControl(&bst_hab_pim_, true, getToggleCond(), false, false);
+
+    parkIn();
+    changePIMMode(dramMode::SB, dramMode::HAB);
+    programCrf(pim_cmds);
+    for (int s = 0; s < num_slots; s++)
+    {
+        changePIMMode(dramMode::HAB, dramMode::HAB_PIM);
+        writeSlotSrf(&norm_srf_bst_[s * num_units], &norm_shift_bst_[s * num_units]);
+        if (is_layernorm)
+            computeMulAdd(num_tile, input0_row + s, result_row + s, param_row, param_row,
+                          num_cols);
+        else
+            computeAddOrMul(num_tile, input0_row + s, result_row + s, param_row);
+        changePIMMode(dramMode::HAB_PIM, dramMode::HAB);
+    }
+    changePIMMode(dramMode::HAB, dramMode::SB);
+    parkOut();
+}
+
+// GELU over dim bursts in the element-wise layout, the table loaded by preloadLut()
+void PIMKernel::executeGelu(int dim, int input0_row, int result_row)
+{
+    if (lut_ == NULL)
+        throw invalid_argument("GELU needs a lut_table loaded by preloadLut()");
+    executeEltwise(dim, pimBankType::ALL_BANK, KernelType::GELU, input0_row, result_row);
+}
+
 void PIMKernel::computeAddOrMul(int num_tile, int input0_row, int result_row, int input1_row)
 {
     for (int i = 0; i < num_tile; i++)
@@ -539,6 +1015,90 @@ void PIMKernel::computeAddOrMul(int num_tile, int input0_row, int result_row, in
     }
 }
 
+void PIMKernel::computeMulAdd(int num_tile, int input0_row, int result_row, int input1_row,
+                              int input2_row, int input2_col)
+{
+    for (int i = 0; i < num_tile; i++)
+    {
+        int c = num_grf_ * i;
+        for (int b = 0; b < 2; b++)  // for even/odd banks, respectively
+        {
+            addTransactionAll(false, 0, b, input0_row, c, "BANK_TO_GRF_", &null_bst_, true,
+                              num_grf_);
+            addTransactionAll(false, 0, b, input1_row, c, "MUL", &null_bst_, true, num_grf_);
+            addTransactionAll(false, 0, b, input2_row, input2_col + c, "ADD", &null_bst_, true,
+                              num_grf_);
+            addTransactionAll(true, 0, b, result_row, c, "GRF_TO_BANK", &null_bst_, true, num_grf_);
+        }
+    }
+}
+
+void PIMKernel::computeScaleShift(int num_tile, int input0_row, int result_row)
+{
+    for (int i = 0; i < num_tile; i++)
+    {
+        int c = num_grf_ * i;
+        for (int b = 0; b < 2; b++)  // for even/odd banks, respectively
+        {
+            addTransactionAll(false, 0, b, input0_row, c, "MAD", &null_bst_, true, num_grf_);
+            addTransactionAll(true, 0, b, result_row, c, "GRF_A_TO_BANK", &null_bst_, true,
+                              num_grf_);
+        }
+    }
+}
+
+/*
+ * the SOFTMAX kernel of ActPIMKernel: per bank half the exp reads, the trigger reads of the GRF_B
+ * accumulation and the write-back, then the fold and the write of GRF_B[0] to partial_row
+ */
+void PIMKernel::computeExpSum(int num_tile, int input0_row, int result_row, int partial_row)
+{
+    for (int i = 0; i < num_tile; i++)
+    {
+        int c = num_grf_ * i;
+        for (int b = 0; b < 2; b++)  // for even/odd banks, respectively
+        {
+            addTransactionAll(false, 0, b, input0_row, c, "EXP", &null_bst_, true, num_grf_);
+            addTransactionAll(false, 0, b, input0_row, c, "SUM_", &null_bst_, true, num_grf_);
+            addTransactionAll(true, 0, b, result_row, c, "GRF_A_TO_BANK", &null_bst_, true,
+                              num_grf_);
+        }
+    }
+    addTransactionAll(false, 0, 1, input0_row, 0, "FOLD_", &null_bst_, true,
+                      ActPIMKernel::num_fold_cmds);
+    addTransactionAll(true, 0, 1, partial_row, 0, "GRF_B_TO_ODD_BANK", &null_bst_, true);
+}
+
+// MomentPIMKernel: every column read for the ADD and again for the MAC, folds, two write-backs
+void PIMKernel::computeRowMoments(int num_tile, int input0_row, int result_row)
+{
+    for (int b = 0; b < 2; b++)  // for even/odd banks, respectively
+    {
+        // reads of one bank issue in order, so the half needs only one barrier
+        for (int i = 0; i < num_tile; i++)
+        {
+            int c = num_grf_ * i;
+            addTransactionAll(false, 0, b, input0_row, c, "SUM_", &null_bst_, false, num_grf_);
+            addTransactionAll(false, 0, b, input0_row, c, "SQ_", &null_bst_, false, num_grf_);
+        }
+        addBarrier();
+    }
+    addTransactionAll(false, 0, 0, input0_row, 0, "FOLD_", &null_bst_, true,
+                      MomentPIMKernel::num_fold_cmds);
+    addTransactionAll(true, 0, 0, result_row, 0, "GRF_A_TO_EVEN_BANK", &null_bst_, true);
+    addTransactionAll(true, 0, 1, result_row, 0, "GRF_B_TO_ODD_BANK", &null_bst_, true);
+}
+
+// the row reduction of ReducePIMKernel: column loops, fold triggers, write-back of GRF_A[0]
+void PIMKernel::computeRowReduce(int num_col, int input0_row, int result_row)
+{
+    for (int b = 0; b < 2; b++)  // for even/odd banks, respectively
+        addTransactionAll(false, 0, b, input0_row, 0, "REDUCE_", &null_bst_, true, num_col);
+    addTransactionAll(false, 0, 0, input0_row, 0, "FOLD_", &null_bst_, true,
+                      ReducePIMKernel::num_fold_cmds);
+    addTransactionAll(true, 0, 0, result_row, 0, "GRF_A_TO_EVEN_BANK", &null_bst_, true);
+}
+
 /*
 void PIMKernel::computeBn(int num_tile, int input0_row, int result_row)
 {
@@ -570,15 +1130,18 @@ void PIMKernel::computeBn(int num_tile, int input0_row, int result_row)
 }
 */
 
-void PIMKernel::computeRelu(int num_tile, int input0_row, int result_row)
+// ActPIMKernel: the activation on the way to the GRFs, then the write-back
+void PIMKernel::computeAct(int num_tile, int input0_row, int result_row)
 {
     for (int i = 0; i < num_tile; i++)
     {
         int c = num_grf_ * i;
-        addTransactionAll(false, 0, 0, input0_row, c, "FILL&ReLU", &null_bst_, true, num_grf_);
+        addTransactionAll(false, 0, 0, input0_row, c, "BANK_TO_GRF_ACT_", &null_bst_, true,
+                          num_grf_);
         addTransactionAll(true, 0, 0, result_row, c, "GRF_A_TO_EVEN_BANK", &null_bst_, true,
                           num_grf_);
-        addTransactionAll(false, 0, 1, input0_row, c, "FILL&ReLU", &null_bst_, true, num_grf_);
+        addTransactionAll(false, 0, 1, input0_row, c, "BANK_TO_GRF_ACT_", &null_bst_, true,
+                          num_grf_);
         addTransactionAll(true, 0, 1, result_row, c, "GRF_B_TO_ODD_BANK", &null_bst_, true,
                           num_grf_);
     }
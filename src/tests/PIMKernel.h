@@ -13,11 +13,13 @@
 #ifndef __PIM_KERNEL_HPP__
 #define __PIM_KERNEL_HPP__
 
+#include <deque>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "C_ALU.h"
 #include "MultiChannelMemorySystem.h"
 #include "PIMCmd.h"
 #include "SystemConfiguration.h"
@@ -38,6 +40,7 @@ class PIMKernel
           num_pim_blocks_(getConfigParam(UINT, "NUM_PIM_BLOCKS")),
           num_bank_groups_(getConfigParam(UINT, "NUM_BANK_GROUPS")),
           srf_bst_(NULL),
+          lut_(NULL),
           cycle_(0)
     {
         transaction_size_ = getConfigParam(UINT, "BL") *
@@ -54,6 +57,7 @@ class PIMKernel
         for (int i = 0; i < num_pim_ranks_; i++) pim_ranks_.push_back(i);
 
         pim_addr_mgr_ = make_shared<PIMAddrManager>(num_pim_chan, num_pim_rank);
+        c_alus_.assign(num_pim_chans_, C_ALU(PIMConfiguration::getPIMPrecision()));
     }
 
     int transaction_size_;
@@ -64,6 +68,8 @@ class PIMKernel
     void addBarrier();
     void runPIM();
     uint64_t getCycle();
+    bool isPreloaded(const string& tag);
+    void markPreloaded(const string& tag);
     void parkIn();
     void parkOut();
     void changePIMMode(dramMode mode1, dramMode mode2);
@@ -83,42 +89,76 @@ class PIMKernel
     */
     void programCrf(vector<PIMCmd>& cmds);
     void setControl(BurstType* bst, bool op, int crf_toggle_cond, bool grfA_zero, bool grfB_zero);
-    unsigned getResultColGemv(int input_dim, int output_dim);
+    unsigned getResultColGemv(int input_dim, int output_dim, int batch_idx = 0);
     void changeBank(pimBankType bank_types, int& cidx, int& rank, int& bg, int& bank,
                     unsigned& startingRow, unsigned& startingCol, unsigned& row, unsigned& col);
     void preloadGemv(NumpyBurstType* operand, unsigned starting_row = 0, unsigned starting_col = 0);
     void preloadNoReplacement(NumpyBurstType* operand, unsigned startingRow, unsigned startingCol);
+    void preloadLut(lut_table* lut);
+    void preloadSoftmax(NumpyBurstType* operand, int row_dim, unsigned starting_row);
+    void preloadNormParam(NumpyBurstType* param, unsigned row, unsigned bst_offset = 0);
     /*
     void preloadEltwise(NumpyBurstType* operand, pimBankType bank_types, unsigned startingRow,
                         unsigned startingCol);
     */
     void executeGemv(NumpyBurstType* w_data, NumpyBurstType* i_data, bool is_tree);
     void executeEltwise(int dim, pimBankType bank_types, KernelType ktype, int input0_row,
-                        int result_row, int input1_row = 0);
+                        int result_row, int input1_row = 0, int input2_row = 0);
+    void executeScaleShift(int dim, pimBankType bank_types, float scale, float shift,
+                           int input0_row, int result_row);
+    void executeSoftmax(int num_rows, int row_dim, int input0_row, int result_row);
+    void executeGelu(int dim, int input0_row, int result_row);
+    void executeNorm(KernelType ktype, int num_rows, int row_dim, int input0_row, int result_row,
+                     int param_row, float eps = 1e-5f);
     void computeGemv(NumpyBurstType* data, int num_input_tiles, int num_output_tile, int input_tile,
                      int output_tile, int batch_idx, pimBankType bank_types);
     void computeAddOrMul(int numTile, int input0Row, int resultRow, int input1Row);
-    void computeRelu(int numTile, int input0Row, int resultRow);
+    void computeAct(int numTile, int input0Row, int resultRow);
+    void computeMulAdd(int numTile, int input0Row, int resultRow, int input1Row, int input2Row,
+                       int input2Col = 0);
+    void computeScaleShift(int numTile, int input0Row, int resultRow);
+    void computeRowReduce(int numCol, int input0Row, int resultRow);
+    void computeRowMoments(int numTile, int input0Row, int resultRow);
+    void computeExpSum(int numTile, int input0Row, int resultRow, int partialRow);
     // void computeBn(int numTile, int input0Row, int resultRow);
 
     void readResult(BurstType* resultBst, pimBankType bank_types, int output_dim,
                     uint64_t baseAddr = 0, unsigned startingRow = 0, unsigned startingCol = 0);
+    void readResultSoftmax(BurstType* result, int num_rows, int row_dim, unsigned starting_row);
     void readData(BurstType* bst_data, size_t bst_cnt, unsigned s_row = 0, unsigned s_col = 0);
     void adderTree(BurstType* result, int output_dim, int numTile, int step, fp16* temp);
 
   private:
+    uint64_t getSoftmaxAddr(int row, int bst_idx, unsigned starting_row);
+    void reduceRows(KernelType ktype, PIMCmdType reduce_type, BurstType* identity, int num_rows,
+                    int row_dim, int input0_row, int result_row, BurstType* partials);
+    void reduceMoments(KernelType ktype, int num_rows, int row_dim, int input0_row,
+                       int result_row, BurstType* sums, BurstType* sqs);
+    void readRowPartials(int num_rows, int row, int odd, BurstType* partials);
+    void writeSlotSrf(BurstType* srf_bsts, BurstType* grf_b_bsts = nullptr);
+
     unsigned cycle_;
     unsigned num_banks_, num_pim_blocks_, num_bank_groups_, num_total_pim_blocks_;
     BurstType null_bst_, bst_hab_pim_, bst_hab_;
-    BurstType crf_bst_[4];
+    // one entry per queued CRF burst, the write copies it only when it issues
+    deque<BurstType> crf_bst_;
     BurstType* srf_bst_;
+    BurstType scale_srf_bst_, shift_grf_bst_;
+    BurstType lowest_bst_, zero_bst_;
+    BurstType lut_header_bst_;
+    vector<BurstType> softmax_partial_bst_, softmax_srf_bst_;
+    vector<BurstType> norm_sum_bst_, norm_sq_bst_, norm_srf_bst_, norm_shift_bst_;
+    vector<C_ALU> c_alus_;  // one per PIM channel
+    lut_table* lut_;
     vector<int> pim_chans_;
     vector<int> pim_ranks_;
     PIMMode mode_;
     shared_ptr<MultiChannelMemorySystem> mem_;
+    // reserved rows as Rank decodes them, bit 12 marks a row that never reaches the cells
     const uint32_t pim_reg_ra = 0x3fff;
-    const uint32_t pim_abmr_ra = 0x27ff;
-    const uint32_t pim_sbmr_ra = 0x2fff;
+    const uint32_t pim_abmr_ra = 0x17ff;
+    const uint32_t pim_sbmr_ra = 0x1fff;
+    const uint32_t pim_park_ra = (1 << 12);
 
     int inline getToggleCond(pimBankType pb_type = pimBankType::ALL_BANK)
     {
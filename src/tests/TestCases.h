@@ -17,6 +17,7 @@
 
 #include <iostream>
 #include <memory>
+#include <random>
 #include <string>
 
 #include "Burst.h"
@@ -56,6 +57,16 @@ class MemBandwidthFixture : public testing::Test
         printResult(cur_cycle);
     }
 
+    // rebuild the memory with some system ini keys replaced, e.g. SCHEDULING_POLICY
+    void resetMemory(const vector<pair<string, string>>& overrides)
+    {
+        cur_cycle = 0;
+        mem.reset();
+        mem = make_shared<MultiChannelMemorySystem>("ini/HBM2_samsung_2M_16B_x64.ini",
+                                                    "system_hbm.ini", ".", "example_app", 256 * 16,
+                                                    nullptr, false, &overrides);
+    }
+
     uint64_t measureCycle(bool is_write)
     {
         printTestMessage();
@@ -80,7 +91,65 @@ class MemBandwidthFixture : public testing::Test
         cout << "  Data size (byte): " << data_size_in_byte << endl;
     }
 
-    void printResult(uint64_t cycle)
+    // sequential reads with a sequential write into the upper half of the memory after every
+    // reads_per_write of them, like weight reads with a result write-back
+    uint64_t measureMixedCycle(unsigned reads_per_write)
+    {
+        printTestMessage();
+        int num_trans = 0;
+        BurstType nullBst;
+
+        for (uint64_t i = 0; num_trans < (data_size_in_byte / basic_stride); i++)
+        {
+            mem->addTransaction(false, i * basic_stride, &nullBst);
+            num_trans++;
+            if ((i + 1) % reads_per_write == 0)
+            {
+                mem->addTransaction(true, (mem_size / 2 + i / reads_per_write) * basic_stride,
+                                    &nullBst);
+                num_trans++;
+            }
+        }
+
+        while (mem->hasPendingTransactions())
+        {
+            cur_cycle++;
+            mem->update();
+        }
+
+        return cur_cycle;
+    }
+
+    // read/write turnarounds and data bus utilization summed over the channels
+    uint64_t getTurnarounds()
+    {
+        uint64_t turnarounds = 0;
+        for (size_t i = 0; i < getConfigParam(UINT, "NUM_CHANS"); i++)
+            turnarounds += mem->channels[i]->memoryController->totalTurnarounds;
+        return turnarounds;
+    }
+
+    double getBusUtilization(uint64_t cycle)
+    {
+        uint64_t busCycles = 0;
+        for (size_t i = 0; i < getConfigParam(UINT, "NUM_CHANS"); i++)
+            busCycles += mem->channels[i]->memoryController->dataBusCycles;
+        return (double)busCycles / (cycle * getConfigParam(UINT, "NUM_CHANS"));
+    }
+
+    // activates and precharges (auto-precharges included) of all channels
+    pair<uint64_t, uint64_t> getRowCommands()
+    {
+        pair<uint64_t, uint64_t> commands = {0, 0};
+        for (size_t i = 0; i < getConfigParam(UINT, "NUM_CHANS"); i++)
+        {
+            commands.first += mem->channels[i]->memoryController->totalActivates;
+            commands.second += mem->channels[i]->memoryController->totalPrecharges;
+        }
+        return commands;
+    }
+
+    uint32_t getBandwidth(uint64_t cycle)
     {
         uint64_t totalReads = 0;
         uint64_t totalWrites = 0;
@@ -91,8 +160,13 @@ class MemBandwidthFixture : public testing::Test
             totalReads += mem_ctrl->totalReads;
             totalWrites += mem_ctrl->totalWrites;
         }
-        uint32_t bw = (totalReads + totalWrites) * getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") *
-                      getConfigParam(UINT, "BL") / 8 / (cycle * getConfigParam(FLOAT, "tCK"));
+        return (totalReads + totalWrites) * getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") *
+               getConfigParam(UINT, "BL") / 8 / (cycle * getConfigParam(FLOAT, "tCK"));
+    }
+
+    void printResult(uint64_t cycle)
+    {
+        uint32_t bw = getBandwidth(cycle);
         cout << endl;
         cout << "> Test Result " << endl;
         cout << "> BW (GB/s): " << bw << endl;
@@ -103,10 +177,23 @@ class MemBandwidthFixture : public testing::Test
         data_size_in_byte = size;
     }
 
+    // uniformly random bursts instead of a sequential sweep, most of them miss the open rows
+    void setRandomTraffic(bool random)
+    {
+        random_traffic_ = random;
+    }
+
+    // sequential sweep in steps of stride bursts, like the rows of a strided tensor
+    void setStride(uint64_t stride)
+    {
+        stride_ = stride;
+    }
+
     void generateMemTraffic(bool is_write)
     {
         int num_trans = 0;
         BurstType nullBst;
+        mt19937_64 gen(0);
 
         for (uint64_t i = 0; i < mem_size; ++i)
         {
@@ -114,7 +201,7 @@ class MemBandwidthFixture : public testing::Test
             {
                 break;
             }
-            uint64_t addr = i * basic_stride;
+            uint64_t addr = (random_traffic_ ? gen() % mem_size : i * stride_) * basic_stride;
             mem->addTransaction(is_write, addr, &nullBst);
             num_trans++;
         }
@@ -122,6 +209,8 @@ class MemBandwidthFixture : public testing::Test
 
   private:
     bool write_;
+    bool random_traffic_ = false;
+    uint64_t stride_ = 1;
     uint64_t cur_cycle = 0;
     uint64_t mem_size;
     uint64_t data_size_in_byte;
@@ -132,24 +221,42 @@ class MemBandwidthFixture : public testing::Test
 class DataDim
 {
   private:
-    unsigned getPrecisionToByte()
+    unsigned getPrecisionToBit()
     {
         switch (PIMConfiguration::getPIMPrecision())
         {
+            case INT4:
+                return 4;
             case INT8:
-                return 1;
+                return 8;
             case FP16:
-                return 2;
+            case BF16:
+                return 16;
             case FP32:
-                return 4;
+                return 32;
             default:
                 return 0;
         }
     }
 
+    // BF16 data sets are saved next to the FP16 ones with a "bf16_" infix
+    string getDataPrefix()
+    {
+        return (PIMConfiguration::getPIMPrecision() == BF16) ? "bf16_" : "";
+    }
+
+    void loadNpy(NumpyBurstType& npbst, const string& filename)
+    {
+        if (PIMConfiguration::getPIMPrecision() == BF16)
+            npbst.loadBf16(filename);
+        else
+            npbst.loadFp16(filename);
+    }
+
     void loadData(KernelType kn_type)
     {
         string input_dim_str = to_string(input_dim_);
+        string prefix = getDataPrefix();
 
         switch (kn_type)
         {
@@ -164,18 +271,21 @@ class DataDim
                 {
                     string batch_size_str = to_string(batch_size_);
                     string batch_in_out_dim_str = batch_size_str + "_" + in_out_dim_str;
-                    input_npbst_.loadFp16("data/gemv/gemv_input_batch_" + batch_in_out_dim_str +
-                                          ".npy");
-                    weight_npbst_.loadFp16("data/gemv/gemv_weight_batch_" + batch_in_out_dim_str +
-                                           ".npy");
-                    output_npbst_.loadFp16("data/gemv/gemv_output_batch_" + batch_in_out_dim_str +
-                                           ".npy");
+                    loadNpy(input_npbst_, "data/gemv/gemv_" + prefix + "input_batch_" +
+                            batch_in_out_dim_str + ".npy");
+                    loadNpy(weight_npbst_, "data/gemv/gemv_" + prefix + "weight_batch_" +
+                            batch_in_out_dim_str + ".npy");
+                    loadNpy(output_npbst_, "data/gemv/gemv_" + prefix + "output_batch_" +
+                            batch_in_out_dim_str + ".npy");
                 }
                 else
                 {
-                    input_npbst_.loadFp16("data/gemv/gemv_input_" + in_out_dim_str + ".npy");
-                    weight_npbst_.loadFp16("data/gemv/gemv_weight_" + in_out_dim_str + ".npy");
-                    output_npbst_.loadFp16("data/gemv/gemv_output_" + in_out_dim_str + ".npy");
+                    loadNpy(input_npbst_,
+                            "data/gemv/gemv_" + prefix + "input_" + in_out_dim_str + ".npy");
+                    loadNpy(weight_npbst_,
+                            "data/gemv/gemv_" + prefix + "weight_" + in_out_dim_str + ".npy");
+                    loadNpy(output_npbst_,
+                            "data/gemv/gemv_" + prefix + "output_" + in_out_dim_str + ".npy");
                 }
 
                 // output_dim_ = weight_npbst_.bShape[0];
@@ -186,9 +296,12 @@ class DataDim
             }
             case KernelType::ADD:
             {
-                input_npbst_.loadFp16("data/add/resadd_input0_" + input_dim_str + ".npy");
-                input1_npbst_.loadFp16("data/add/resadd_input1_" + input_dim_str + ".npy");
-                output_npbst_.loadFp16("data/add/resadd_output_" + input_dim_str + ".npy");
+                loadNpy(input_npbst_,
+                        "data/add/resadd_" + prefix + "input0_" + input_dim_str + ".npy");
+                loadNpy(input1_npbst_,
+                        "data/add/resadd_" + prefix + "input1_" + input_dim_str + ".npy");
+                loadNpy(output_npbst_,
+                        "data/add/resadd_" + prefix + "output_" + input_dim_str + ".npy");
 
                 output_dim_ = bShape1ToDim(output_npbst_.getTotalDim());
                 input_dim_ = bShape1ToDim(input_npbst_.getTotalDim());
@@ -198,9 +311,12 @@ class DataDim
             }
             case KernelType::MUL:
             {
-                input_npbst_.loadFp16("data/mul/eltmul_input0_" + input_dim_str + ".npy");
-                input1_npbst_.loadFp16("data/mul/eltmul_input1_" + input_dim_str + ".npy");
-                output_npbst_.loadFp16("data/mul/eltmul_output_" + input_dim_str + ".npy");
+                loadNpy(input_npbst_,
+                        "data/mul/eltmul_" + prefix + "input0_" + input_dim_str + ".npy");
+                loadNpy(input1_npbst_,
+                        "data/mul/eltmul_" + prefix + "input1_" + input_dim_str + ".npy");
+                loadNpy(output_npbst_,
+                        "data/mul/eltmul_" + prefix + "output_" + input_dim_str + ".npy");
 
                 output_dim_ = bShape1ToDim(output_npbst_.getTotalDim());
                 input_dim_ = bShape1ToDim(input_npbst_.getTotalDim());
@@ -210,8 +326,55 @@ class DataDim
             }
             case KernelType::RELU:
             {
-                input_npbst_.loadFp16("data/relu/relu_input_" + input_dim_str + ".npy");
-                output_npbst_.loadFp16("data/relu/relu_output_" + input_dim_str + ".npy");
+                loadNpy(input_npbst_,
+                        "data/relu/relu_" + prefix + "input_" + input_dim_str + ".npy");
+                loadNpy(output_npbst_,
+                        "data/relu/relu_" + prefix + "output_" + input_dim_str + ".npy");
+
+                output_dim_ = bShape1ToDim(output_npbst_.getTotalDim());
+                input_dim_ = bShape1ToDim(input_npbst_.getTotalDim());
+
+                return;
+            }
+            case KernelType::SOFTMAX:
+            {
+                string in_out_dim_str = to_string(batch_size_) + "x" + input_dim_str;
+                loadNpy(input_npbst_,
+                        "data/softmax/softmax_" + prefix + "input_" + in_out_dim_str + ".npy");
+                loadNpy(output_npbst_,
+                        "data/softmax/softmax_" + prefix + "output_" + in_out_dim_str + ".npy");
+
+                output_dim_ = bShape1ToDim(output_npbst_.bShape[1]);
+                input_dim_ = bShape1ToDim(input_npbst_.bShape[1]);
+                batch_size_ = input_npbst_.bShape[0];
+
+                return;
+            }
+            case KernelType::LAYERNORM:
+            case KernelType::RMSNORM:
+            {
+                // gamma goes to weight_npbst_, the LayerNorm beta to input1_npbst_
+                string name = (kn_type == KernelType::LAYERNORM) ? "layernorm" : "rmsnorm";
+                string path = "data/" + name + "/" + name + "_" + prefix;
+                string in_out_dim_str = to_string(batch_size_) + "x" + input_dim_str;
+                loadNpy(input_npbst_, path + "input_" + in_out_dim_str + ".npy");
+                loadNpy(weight_npbst_, path + "gamma_" + input_dim_str + ".npy");
+                if (kn_type == KernelType::LAYERNORM)
+                    loadNpy(input1_npbst_, path + "beta_" + input_dim_str + ".npy");
+                loadNpy(output_npbst_, path + "output_" + in_out_dim_str + ".npy");
+
+                output_dim_ = bShape1ToDim(output_npbst_.bShape[1]);
+                input_dim_ = bShape1ToDim(input_npbst_.bShape[1]);
+                batch_size_ = input_npbst_.bShape[0];
+
+                return;
+            }
+            case KernelType::GELU:
+            {
+                loadNpy(input_npbst_,
+                        "data/gelu/gelu_" + prefix + "input_" + input_dim_str + ".npy");
+                loadNpy(output_npbst_,
+                        "data/gelu/gelu_" + prefix + "output_" + input_dim_str + ".npy");
 
                 output_dim_ = bShape1ToDim(output_npbst_.getTotalDim());
                 input_dim_ = bShape1ToDim(input_npbst_.getTotalDim());
@@ -236,13 +399,13 @@ class DataDim
             {
                 weight_npbst_.shape.push_back(output_dim_);
                 weight_npbst_.shape.push_back(input_dim_);
-                weight_npbst_.loadTobShape(16);
+                weight_npbst_.loadTobShape(getNumElementsPerBlocks());
 
                 input_npbst_.shape.push_back(batch_size_);
                 input_npbst_.shape.push_back(input_dim_);
-                input_npbst_.loadTobShape(16);
+                input_npbst_.loadTobShape(getNumElementsPerBlocks());
 
-                for (int i = 0; i < input_npbst_.bShape[1]; i++)
+                for (int i = 0; i < input_npbst_.bShape[0] * input_npbst_.bShape[1]; i++)
                 {
                     BurstType null_bst;
                     null_bst.set((float)0);
@@ -254,14 +417,21 @@ class DataDim
             case KernelType::ADD:
             case KernelType::MUL:
             case KernelType::RELU:
+            case KernelType::ADD_RELU:
+            case KernelType::MUL_ADD:
+            case KernelType::SCALE_SHIFT:
+            case KernelType::SOFTMAX:
+            case KernelType::GELU:
+            case KernelType::LAYERNORM:
+            case KernelType::RMSNORM:
             {
                 input_npbst_.shape.push_back(batch_size_);
                 input_npbst_.shape.push_back(input_dim_);
-                input_npbst_.loadTobShape(16);
+                input_npbst_.loadTobShape(getNumElementsPerBlocks());
 
                 output_npbst_.shape.push_back(batch_size_);
                 output_npbst_.shape.push_back(output_dim_);
-                output_npbst_.loadTobShape(16);
+                output_npbst_.loadTobShape(getNumElementsPerBlocks());
 
                 return;
             }
@@ -327,7 +497,7 @@ class DataDim
 
     uint32_t getDataSize(uint32_t dim1, uint32_t dim2 = 1, uint32_t dim3 = 1)
     {
-        return dim1 * dim2 * dim3 * getPrecisionToByte();
+        return (uint64_t)dim1 * dim2 * dim3 * getPrecisionToBit() / 8;
     }
 
     void printDim(KernelType kn_type)
@@ -354,10 +524,22 @@ class DataDim
             case KernelType::MUL:
             case KernelType::ADD:
             case KernelType::RELU:
+            case KernelType::ADD_RELU:
+            case KernelType::MUL_ADD:
+            case KernelType::SCALE_SHIFT:
+            case KernelType::GELU:
             {
                 cout << "  Input/output data dimension : " << output_dim_ << endl;
                 break;
             }
+            case KernelType::SOFTMAX:
+            case KernelType::LAYERNORM:
+            case KernelType::RMSNORM:
+            {
+                cout << "  Input/output data dimension : " << batch_size_ << "x" << output_dim_
+                     << endl;
+                break;
+            }
             default:
             {
                 ERROR("== Error - Unknown KernelType trying to load data");
@@ -368,8 +550,8 @@ class DataDim
     }
     uint32_t getNumElementsPerBlocks()
     {
-        return ((getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") * getConfigParam(UINT, "BL") / 8) /
-                getPrecisionToByte());
+        return ((getConfigParam(UINT, "JEDEC_DATA_BUS_BITS") * getConfigParam(UINT, "BL")) /
+                getPrecisionToBit());
     }
 
     uint32_t dimTobShape(int in_dim)
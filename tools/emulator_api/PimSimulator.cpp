@@ -168,6 +168,7 @@ void PimSimulator::run()
     {
         cycle_++;
         mem_->update();
+        cycle_ += mem_->skipIdleCycles();
     }
 }
 